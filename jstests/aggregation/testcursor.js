@@ -0,0 +1,76 @@
+// The aggregate command returns its results through a cursor when asked to, so they aren't limited
+// to the size of a single reply.
+
+var coll = db.getSisterDB("aggdb").cursor;
+coll.drop();
+
+var pad = new Array(1024 * 1024).join("x");
+for (var i = 0; i < 30; i++) {
+    coll.insert({ _id: i, pad: pad });
+}
+assert.eq(null, coll.getDB().getLastError());
+
+function openCursors() {
+    return db.serverStatus().cursors.totalOpen;
+}
+var baseline = openCursors();
+
+// 30MB of results don't fit in the result array
+var res = coll.runCommand("aggregate", { pipeline: [{ $sort: { _id: 1 } }] });
+assert.commandFailed(res);
+
+// but they do come back through a cursor
+res = coll.runCommand("aggregate", { pipeline: [{ $sort: { _id: 1 } }], cursor: {} });
+assert.commandWorked(res);
+assert.eq(coll.getFullName(), res.cursor.ns);
+assert.neq(0, res.cursor.id);
+assert.gt(res.cursor.firstBatch.length, 0);
+assert.lt(res.cursor.firstBatch.length, 30);
+assert.eq(baseline + 1, openCursors());
+
+var docs = new DBCommandCursor(db.getMongo(), res).toArray();
+assert.eq(30, docs.length);
+for (var i = 0; i < docs.length; i++) {
+    assert.eq(i, docs[i]._id);
+}
+// exhausting the cursor closes it
+assert.eq(baseline, openCursors());
+
+// batchSize limits the first batch; the same results come back either way
+var pipeline = [{ $project: { _id: 1 } }, { $sort: { _id: -1 } }];
+var expected = coll.aggregate(pipeline).result;
+res = coll.runCommand("aggregate", { pipeline: pipeline, cursor: { batchSize: 2 } });
+assert.commandWorked(res);
+assert.eq(2, res.cursor.firstBatch.length);
+assert.eq(expected, new DBCommandCursor(db.getMongo(), res, 5).toArray());
+
+// results that fit in the first batch don't leave a cursor open
+res = coll.runCommand("aggregate", { pipeline: pipeline, cursor: {} });
+assert.commandWorked(res);
+assert.eq(0, res.cursor.id);
+assert.eq(expected, res.cursor.firstBatch);
+assert.eq(baseline, openCursors());
+
+// the cursor reads the collection between getMores without holding a lock, so writes go ahead
+res = coll.runCommand("aggregate", { pipeline: [{ $match: { _id: { $gte: 0 } } }],
+                                     cursor: { batchSize: 1 } });
+assert.commandWorked(res);
+coll.insert({ _id: 100 });
+assert.eq(null, coll.getDB().getLastError());
+var cursor = new DBCommandCursor(db.getMongo(), res, 1);
+assert.eq(31, cursor.itcount());
+
+// a cursor whose collection is dropped fails on its next getMore
+res = coll.runCommand("aggregate", { pipeline: [{ $match: { _id: { $gte: 0 } } }],
+                                     cursor: { batchSize: 1 } });
+assert.commandWorked(res);
+cursor = new DBCommandCursor(db.getMongo(), res, 1);
+cursor.next();
+coll.drop();
+assert.throws(function() { cursor.itcount(); });
+assert.eq(baseline, openCursors());
+
+// bad cursor options
+assert.commandFailed(coll.runCommand("aggregate", { pipeline: [], cursor: 1 }));
+assert.commandFailed(coll.runCommand("aggregate", { pipeline: [],
+                                                    cursor: { batchSize: -1 } }));
@@ -172,6 +172,30 @@ testSortLimit(10, -1);
 testSortLimit(100,  1);
 testSortLimit(100, -1);
 
+// the shards' output is read through cursors; a $limit in mongos kills them early
+var limited = db.ts1.aggregate({$skip: 10}, {$limit: 5});
+assert.commandWorked(limited);
+assert.eq(limited.result.length, 5);
+[shardedAggTest.shard0, shardedAggTest.shard1].forEach(function(shard) {
+    assert.soon(function() {
+        return shard.getDB("admin").serverStatus().cursors.totalOpen == 0;
+    }, "shard cursor left open");
+});
+
+// a cursor command through mongos returns the merged results in its first batch
+var cursorResult = db.runCommand({aggregate: "ts1",
+                                  pipeline: [{$match: {counter: {$lte: 100}}},
+                                             {$project: {_id: 0, counter: 1}},
+                                             {$sort: {counter: 1}}],
+                                  cursor: {}});
+assert.commandWorked(cursorResult);
+assert.eq(cursorResult.cursor.id, 0);
+var fromCursor = new DBCommandCursor(db.getMongo(), cursorResult).toArray();
+assert.eq(fromCursor.length, 100);
+for (i = 0; i < fromCursor.length; ++i) {
+    assert.eq(fromCursor[i].counter, i + 1);
+}
+
 
 // shut everything down
 shardedAggTest.stop();
@@ -0,0 +1,68 @@
+// $group and $sort spill to disk when the aggregate command allows it, and give the same
+// results as they do in memory.
+
+var coll = db.getSisterDB("aggdb").spill;
+coll.drop();
+
+var pad = new Array(1024).join("x");
+for (var i = 0; i < 5000; i++) {
+    var doc = { _id: i, key: i % 100, neg: -i, pad: pad };
+    if (i % 7) {
+        doc.missing = i;
+    }
+    coll.insert(doc);
+}
+assert.eq(null, coll.getDB().getLastError());
+
+var oldThreshold = db.adminCommand({ getParameter: 1, aggregationSpillThresholdBytes: 1 })
+    .aggregationSpillThresholdBytes;
+assert.commandWorked(db.adminCommand({ setParameter: 1,
+                                       aggregationSpillThresholdBytes: 64 * 1024 }));
+
+function runBoth(pipeline) {
+    var inMemory = coll.runCommand("aggregate", { pipeline: pipeline });
+    assert.commandWorked(inMemory);
+    assert(!inMemory.spilledBytes, "spilled without allowDiskUsage");
+
+    var spilled = coll.runCommand("aggregate", { pipeline: pipeline, allowDiskUsage: true });
+    assert.commandWorked(spilled);
+    assert.gt(spilled.spilledBytes, 64 * 1024, tojson(pipeline) + " did not spill");
+
+    assert.eq(inMemory.result, spilled.result, tojson(pipeline));
+    return spilled.result;
+}
+
+// a sort larger than the spill threshold
+var sorted = runBoth([{ $sort: { neg: 1 } }, { $project: { neg: 1 } }]);
+assert.eq(5000, sorted.length);
+assert.eq(4999, sorted[0]._id);
+assert.eq(0, sorted[4999]._id);
+
+// compound sort, including documents without the second key
+runBoth([{ $sort: { key: -1, missing: 1, _id: 1 } }, { $project: { key: 1, missing: 1 } }]);
+
+// groups whose partial results are merged across runs; the $sort orders the groups, and
+// $push / $first / $last depend on the input order being kept
+var grouped = runBoth([{ $group: { _id: "$key",
+                                   count: { $sum: 1 },
+                                   avg: { $avg: "$_id" },
+                                   min: { $min: "$missing" },
+                                   max: { $max: "$_id" },
+                                   first: { $first: "$_id" },
+                                   last: { $last: "$_id" },
+                                   ids: { $push: "$_id" },
+                                   pads: { $addToSet: "$pad" } } },
+                       { $sort: { _id: 1 } }]);
+assert.eq(100, grouped.length);
+assert.eq({ _id: 3, count: 50, avg: 2453, min: 3, max: 4903, first: 3, last: 4903 },
+          { _id: grouped[3]._id, count: grouped[3].count, avg: grouped[3].avg,
+            min: grouped[3].min, max: grouped[3].max, first: grouped[3].first,
+            last: grouped[3].last });
+assert.eq(50, grouped[3].ids.length);
+assert.eq(1, grouped[3].pads.length);
+
+// $group with nothing but an _id
+runBoth([{ $group: { _id: { k: "$key", pad: "$pad" } } }, { $sort: { "_id.k": 1 } }]);
+
+assert.commandWorked(db.adminCommand({ setParameter: 1,
+                                       aggregationSpillThresholdBytes: oldThreshold }));
@@ -0,0 +1,47 @@
+// Online compact moves records out of a collection's extents, keeping its indexes in step, and
+// frees the extents it empties.
+
+t = db.jstests_compact_online;
+t.drop();
+
+var pad = new Array( 200 ).toString();
+for( var i = 0; i < 20000; ++i ) {
+    t.insert( { _id:i, a:i % 100, pad:pad } );
+}
+t.ensureIndex( { a:1 } );
+// leave free space spread through every extent
+t.remove( { _id:{ $mod:[ 2, 0 ] } } );
+assert( !db.getLastError() );
+
+var before = t.stats();
+assert.gt( before.numExtents, 2 );
+
+var res = t.runCommand( "compact", { online:true } );
+assert.commandWorked( res );
+assert.gt( res.extentsFreed, 0 );
+assert.gt( res.bytesReclaimed, 0 );
+assert.gt( res.recordsMoved, 0 );
+
+var after = t.stats();
+assert.lt( after.numExtents, before.numExtents );
+assert.lt( after.storageSize, before.storageSize );
+
+// every document is still there, and found through each index
+assert.eq( 10000, t.count() );
+assert.eq( 10000, t.find().hint( { _id:1 } ).itcount() );
+assert.eq( 100, t.find( { a:1 } ).hint( { a:1 } ).itcount() );
+assert.eq( 0, t.find( { _id:{ $mod:[ 2, 0 ] } } ).itcount() );
+assert( t.validate( true ).valid );
+
+// the space freed is reused
+for( var i = 0; i < 20000; i += 2 ) {
+    t.insert( { _id:i, a:i % 100, pad:pad } );
+}
+assert( !db.getLastError() );
+assert.eq( 20000, t.find().hint( { a:1 } ).itcount() );
+assert( t.validate( true ).valid );
+
+// online compact of a capped collection is refused
+db.jstests_compact_online_capped.drop();
+db.createCollection( "jstests_compact_online_capped", { capped:true, size:4096 } );
+assert.commandFailed( db.jstests_compact_online_capped.runCommand( "compact", { online:true } ) );
@@ -0,0 +1,58 @@
+// Scans and multi-updates running alongside an online compact see every document: the compact
+// only moves records while no cursor is open on the collection, rather than killing cursors.
+
+t = db.jstests_compact_online_scan;
+t.drop();
+db.jstests_compact_online_scan_done.drop();
+
+var pad = new Array( 200 ).toString();
+for( var i = 0; i < 20000; ++i ) {
+    t.insert( { _id:i, pad:pad, u:0 } );
+}
+t.remove( { _id:{ $mod:[ 2, 0 ] } } );
+assert( !db.getLastError() );
+var n = t.count();
+
+var old = db.adminCommand( { getParameter:1, onlineCompactBatchSize:1 } ).onlineCompactBatchSize;
+assert.commandWorked( db.adminCommand( { setParameter:1, onlineCompactBatchSize:10 } ) );
+
+var compact = startParallelShell(
+    'var res = db.jstests_compact_online_scan.runCommand( "compact", { online:true } );' +
+    'db.jstests_compact_online_scan_done.insert( { res:res } );' +
+    'db.getLastError();' );
+
+var scans = 0;
+var updates = 0;
+while( db.jstests_compact_online_scan_done.count() == 0 ) {
+    assert.eq( n, t.find().batchSize( 50 ).itcount(), "a scan during online compact missed documents" );
+    scans++;
+    t.update( {}, { $inc:{ u:1 } }, false, true );
+    assert.eq( n, db.getLastErrorObj().n, "a multi-update during online compact missed documents" );
+    updates++;
+    // leave the compact a moment with no cursor open on the collection
+    sleep( 10 );
+}
+compact();
+print( "scans: " + scans + " updates: " + updates );
+
+var res = db.jstests_compact_online_scan_done.findOne().res;
+assert.commandWorked( res );
+assert.gt( res.recordsMoved, 0 );
+assert.eq( n, t.find().itcount() );
+assert.eq( n, t.find( { u:updates } ).itcount() );
+assert( t.validate( true ).valid );
+
+assert.commandWorked( db.adminCommand( { setParameter:1, onlineCompactBatchSize:old } ) );
+
+// a cursor left open makes the compact give up rather than wait for it forever
+assert.commandWorked( db.adminCommand( { setParameter:1, onlineCompactCursorWaitSecs:1 } ) );
+t.remove( { _id:{ $mod:[ 4, 1 ] } } );
+assert( !db.getLastError() );
+var cursor = t.find().batchSize( 2 );
+cursor.next();
+res = t.runCommand( "compact", { online:true } );
+assert.commandFailed( res );
+assert.eq( 16781, res.code );
+cursor.itcount();
+assert( t.validate( true ).valid );
+assert.commandWorked( db.adminCommand( { setParameter:1, onlineCompactCursorWaitSecs:600 } ) );
@@ -0,0 +1,75 @@
+// Test the compressRecords collection option: records are stored compressed, read back whole,
+// and updated, indexed and removed like any other.
+
+var plain = db.jstests_compress_records_plain;
+var t = db.jstests_compress_records;
+plain.drop();
+t.drop();
+
+db.createCollection(t.getName());
+var res = t.runCommand("collMod", {compressRecords: true});
+assert.commandWorked(res);
+assert.eq(false, res.compressRecords_old);
+assert.eq(true, res.compressRecords_new);
+assert.eq(2, t.stats().userFlags & 2);
+
+function logLine(i) {
+    return {_id: i, host: "app-server-" + (i % 4), level: "INFO", n: i,
+            msg: "request handled GET /api/v1/items/" + (i % 10) + " status 200 in 12ms",
+            trace: new Array(10).join("at org.example.Handler.process(Handler.java:42)\n")};
+}
+
+for (var i = 0; i < 5000; ++i) {
+    t.insert(logLine(i));
+    plain.insert(logLine(i));
+}
+assert.eq(null, db.getLastError());
+print("data size compressed " + t.stats().size + " plain " + plain.stats().size);
+assert.lt(t.stats().size, plain.stats().size, "records not compressed");
+
+// reads
+assert.eq(5000, t.count());
+assert.eq(logLine(1234), t.findOne({_id: 1234}));
+t.ensureIndex({host: 1});
+assert.eq(1250, t.find({host: "app-server-1"}).itcount());
+
+// updates that could be done in place, that grow the document, and that replace it
+t.update({_id: 10}, {$inc: {n: 1}});
+t.update({_id: 11}, {$set: {extra: new Array(1000).join("z")}});
+t.update({_id: 12}, {_id: 12, host: "app-server-9"});
+t.update({host: "app-server-2"}, {$set: {level: "WARN"}}, false, true);
+assert.eq(null, db.getLastError());
+assert.eq(11, t.findOne({_id: 10}).n);
+assert.eq(999, t.findOne({_id: 11}).extra.length);
+assert.eq({_id: 12, host: "app-server-9"}, t.findOne({_id: 12}));
+assert.eq(1250, t.find({level: "WARN"}).itcount());
+assert.eq(1, t.find({host: "app-server-9"}).itcount());
+
+// documents without an _id, and small ones that are stored as they are
+t.insert({msg: new Array(500).join("ab")});
+t.insert({_id: "small"});
+assert.eq(null, db.getLastError());
+assert.eq(998, t.findOne({msg: {$exists: true}, _id: {$type: 7}}).msg.length);
+assert.eq({_id: "small"}, t.findOne({_id: "small"}));
+
+t.remove({n: {$lt: 100}});
+assert.eq(null, db.getLastError());
+assert.eq(0, t.find({n: {$lt: 100}}).itcount());
+assert(t.validate(true).valid);
+
+// turning it off leaves compressed records readable
+assert.commandWorked(t.runCommand("collMod", {compressRecords: false}));
+t.insert(logLine(10000));
+assert.eq(logLine(1234), t.findOne({_id: 1234}));
+assert.eq(logLine(10000), t.findOne({_id: 10000}));
+assert(t.validate(true).valid);
+
+// capped collections can't be compressed
+db.jstests_compress_records_capped.drop();
+db.createCollection("jstests_compress_records_capped", {capped: true, size: 10000});
+assert.commandFailed(db.jstests_compress_records_capped.runCommand("collMod",
+                                                                   {compressRecords: true}));
+
+t.drop();
+plain.drop();
+db.jstests_compress_records_capped.drop();
@@ -0,0 +1,26 @@
+// Journal sections are compressed before they are written; check that the dur section of
+// serverStatus reports what the compression saved and what it cost.
+
+var conn = MongoRunner.runMongod({ journal: "" });
+var testDB = conn.getDB("test");
+
+// highly compressible
+var s = new Array(4096).join("a");
+for (var i = 0; i < 1000; i++) {
+    testDB.journal_compression.insert({ i: i, s: s });
+}
+testDB.getLastError(1, true);
+
+// dur stats are reported for the previous ~3 second interval
+assert.soon(function() {
+    var dur = testDB.serverStatus().dur;
+    return dur.journaledMB > 0 && dur.compressionSavedMB > 0;
+}, "no journal compression savings reported", 30000, 500);
+
+var dur = testDB.serverStatus().dur;
+printjson(dur);
+assert.lt(dur.compression, 1);
+assert.gte(dur.timeMs.compress, 0);
+assert.lte(dur.timeMs.compress, dur.timeMs.writeToJournal);
+
+MongoRunner.stopMongod(conn.port);
@@ -0,0 +1,63 @@
+// Test that a collection whose documents are removed and reinserted reuses and coalesces the freed
+// space, and that collStats and storageDetails report it.
+
+t = db.jstests_free_space_map;
+t.drop();
+
+var padding = new Array(500).join("x");
+for (var i = 0; i < 2000; ++i) {
+    t.insert({_id: i, padding: padding});
+}
+assert.eq(null, db.getLastError());
+var storageSize = t.stats().storageSize;
+
+// free runs of neighboring documents, then fill them with documents of another size
+t.remove({_id: {$mod: [4, 0]}});
+t.remove({_id: {$mod: [4, 1]}});
+assert.eq(null, db.getLastError());
+
+var freeSpace = t.stats().freeSpace;
+printjson(freeSpace);
+assert(freeSpace.mapped, "free space not mapped");
+assert.gt(freeSpace.coalesced, 400, "neighboring deleted records not merged");
+assert.gte(freeSpace.records, 1);
+assert.gte(freeSpace.bytes, 1000 * 500);
+assert.gte(freeSpace.fragmentation, 0);
+assert.lte(freeSpace.fragmentation, 1);
+
+var bigPadding = new Array(900).join("y");
+for (var i = 2000; i < 2500; ++i) {
+    t.insert({_id: i, padding: bigPadding});
+}
+assert.eq(null, db.getLastError());
+assert.eq(1500, t.count());
+assert.eq(storageSize, t.stats().storageSize, "merged space not reused");
+
+freeSpace = t.stats().freeSpace;
+assert.gte(freeSpace.allocs, 500);
+assert(isNumber(freeSpace.avgAllocMicros));
+assert.eq(undefined, freeSpace.classes);
+assert(db.runCommand({collstats: t.getName(), verbose: true}).freeSpace.classes instanceof Array);
+
+var result = db.runCommand({storageDetails: t.getName(), analyze: 'freeSpace'});
+if (result["bad cmd"]) {
+    print("storageDetails command not available: skipping");
+}
+else {
+    assert.commandWorked(result);
+    assert(result.mapped);
+    var records = 0;
+    result.classes.forEach(function(c) {
+        assert(isNumber(c.minSize));
+        records += c.records;
+    });
+    assert.eq(result.records, records);
+}
+
+// capped collections don't map their free space
+db.jstests_free_space_map_capped.drop();
+db.createCollection("jstests_free_space_map_capped", {capped: true, size: 10000});
+assert.eq(undefined, db.jstests_free_space_map_capped.stats().freeSpace);
+
+t.drop();
+db.jstests_free_space_map_capped.drop();
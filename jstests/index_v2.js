@@ -0,0 +1,39 @@
+// Test that a v:2 (prefix compressed) index stores and finds keys with a long common prefix, and
+// is smaller than the equivalent v:1 index.
+
+t = db.jstests_index_v2;
+t.drop();
+
+var prefix = new Array(100).join("p");
+for (var i = 0; i < 5000; ++i) {
+    t.insert({a: prefix + i, b: prefix + i});
+}
+t.ensureIndex({a: 1}, {v: 1});
+t.ensureIndex({b: 1}, {v: 2});
+assert.eq(null, db.getLastError());
+assert.eq(2, db.system.indexes.findOne({ns: t.getFullName(), name: "b_1"}).v);
+
+var sizes = t.stats().indexSizes;
+printjson(sizes);
+assert.lt(sizes.b_1, sizes.a_1, "v:2 index not smaller");
+
+assert.eq(1, t.find({b: prefix + 1234}).hint({b: 1}).itcount());
+assert.eq(11, t.find({b: {$gte: prefix + 1000, $lte: prefix + 1010}}).hint({b: 1}).itcount());
+assert.eq(5000, t.find().hint({b: 1}).itcount());
+
+// keys inserted and removed after the build
+for (var i = 5000; i < 6000; ++i) {
+    t.insert({a: prefix + i, b: prefix + i});
+}
+t.remove({b: {$lt: prefix + 2}});
+assert.eq(null, db.getLastError());
+assert.eq(t.count(), t.find().hint({b: 1}).itcount());
+assert.eq(0, t.find({b: prefix + 1234}).hint({b: 1}).itcount());
+assert.eq(1, t.find({b: prefix + 5500}).hint({b: 1}).itcount());
+assert(t.validate(true).valid);
+
+// unknown versions are still refused
+t.ensureIndex({c: 1}, {v: 3});
+assert(db.getLastError());
+
+t.drop();
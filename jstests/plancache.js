@@ -0,0 +1,93 @@
+// The planCache command lists a collection's cached query plans and their counters, and pins
+// plans for a query shape.
+
+t = db.jstests_plancache;
+t.drop();
+
+t.ensureIndex( { a:1 } );
+t.ensureIndex( { b:1 } );
+for( i = 0; i < 200; ++i ) {
+    t.save( { a:i, b:i % 10 } );
+}
+
+function planCache( options ) {
+    var cmd = { planCache:t.getName() };
+    for( var field in options ) {
+        cmd[ field ] = options[ field ];
+    }
+    return db.runCommand( cmd );
+}
+
+function entries() {
+    var res = planCache( {} );
+    assert.commandWorked( res );
+    return res.entries;
+}
+
+var query = { a:{ $gte:50 }, b:5 };
+var pattern = { query:{ a:'LowerBound', b:'Equality' }, sort:{} };
+
+function entry() {
+    var all = entries();
+    for( var i = 0; i < all.length; ++i ) {
+        if ( friendlyEqual( pattern, { query:all[ i ].query, sort:all[ i ].sort } ) ) {
+            return all[ i ];
+        }
+    }
+    return null;
+}
+
+// Racing the plans records the winner, and later queries use it.
+assert.eq( 15, t.find( query ).itcount() );
+assert.eq( { b:1 }, entry().indexKey );
+assert( !entry().pinned );
+for( i = 0; i < 3; ++i ) {
+    assert.eq( 15, t.find( query ).itcount() );
+}
+assert.lte( 3, entry().hits );
+assert.lte( 1, entry().runs );
+assert.lte( 1, entry().avgNScanned );
+
+// Writes don't clear the cache.
+for( i = 200; i < 400; ++i ) {
+    t.save( { a:i, b:i % 10 } );
+}
+assert( t.find( query ).explain( true ).oldPlan );
+assert.eq( { b:1 }, entry().indexKey );
+
+// A pinned plan is used even though it scans more than the recorded one, and isn't replaced.
+assert.commandWorked( planCache( { pin:query, index:{ a:1 } } ) );
+assert( entry().pinned );
+var explain = t.find( query ).explain( true );
+assert.eq( 'BtreeCursor a_1', explain.cursor );
+assert.eq( 1, explain.allPlans.length );
+assert.eq( 35, t.find( query ).itcount() );
+assert.eq( { a:1 }, entry().indexKey );
+
+// Pinning needs an existing index that can be used.
+assert.commandFailed( planCache( { pin:query, index:{ c:1 } } ) );
+assert.commandFailed( planCache( { pin:query } ) );
+
+// Unpinning forgets the plan, so the next query races the plans again.
+assert.commandWorked( planCache( { unpin:query } ) );
+assert.eq( null, entry() );
+assert.commandFailed( planCache( { unpin:query } ) );
+assert.eq( 35, t.find( query ).itcount() );
+assert.eq( { b:1 }, entry().indexKey );
+
+// The cache is bounded, least recently used first.
+var oldSize = db.adminCommand( { getParameter:1, queryPlanCacheSize:1 } ).queryPlanCacheSize;
+assert.commandWorked( db.adminCommand( { setParameter:1, queryPlanCacheSize:1 } ) );
+t.find( { a:5 } ).itcount();
+t.find( { b:5 } ).itcount();
+var res = planCache( {} );
+assert.eq( 1, res.size );
+assert.eq( { b:'Equality' }, res.entries[ 0 ].query );
+assert.lte( 2, res.evictions );
+assert.commandWorked( db.adminCommand( { setParameter:1, queryPlanCacheSize:oldSize } ) );
+
+// clear drops every plan.
+assert.commandWorked( planCache( { clear:true } ) );
+assert.eq( 0, entries().length );
+
+assert.commandFailed( db.runCommand( { planCache:'jstests_plancache_missing' } ) );
@@ -0,0 +1,60 @@
+// Ops on a single collection are spread across the secondary's writers by _id, while each
+// document's ops stay in order and capped / unique-indexed collections stay serialized.
+
+var rt = new ReplSetTest( { name : "apply_partition_by_id" , nodes: 2, oplogSize: 100 } );
+rt.startSet();
+rt.initiate();
+rt.awaitSecondaryNodes();
+
+var primary = rt.getPrimary();
+var secondary = rt.getSecondary();
+var testDB = primary.getDB("test");
+
+// create the collections up front so their batches can be partitioned
+testDB.plain.insert({ _id: -1 });
+testDB.createCollection("capped", { capped: true, size: 1024 * 1024 });
+testDB.uniq.ensureIndex({ k: 1 }, { unique: true });
+testDB.getLastError(2);
+
+for (var i = 0; i < 5000; i++) {
+    testDB.plain.insert({ _id: i, n: 0 });
+    testDB.plain.update({ _id: i }, { $inc: { n: 1 } });
+    if (i % 3 == 0) {
+        testDB.plain.remove({ _id: i });
+    }
+    testDB.capped.insert({ i: i });
+    // moves unique key k from one document to the next
+    testDB.uniq.remove({ k: 1 });
+    testDB.uniq.insert({ _id: i, k: 1 });
+}
+// numerically equal _ids of different types are the same document
+testDB.plain.insert({ _id: NumberLong(6000), n: 0 });
+testDB.plain.remove({ _id: 6000 });
+testDB.plain.insert({ _id: 6000.0, n: 1 });
+assert.eq(null, testDB.getLastError(2));
+
+var sdb = secondary.getDB("test");
+assert.eq(testDB.plain.count(), sdb.plain.count());
+assert.eq(0, sdb.plain.count({ n: { $ne: 1 } }));
+assert.eq(1, sdb.uniq.count());
+assert.eq(4999, sdb.uniq.findOne()._id);
+
+var last = -1;
+sdb.capped.find().sort({ $natural: 1 }).forEach(function(doc) {
+    assert.gt(doc.i, last, "capped collection out of insertion order");
+    last = doc.i;
+});
+
+var writers = sdb.serverStatus().repl.writers;
+printjson(writers);
+assert.gt(writers.applyMicros, 0, "no apply time");
+var busy = 0;
+writers.utilization.forEach(function(w) {
+    assert.lte(w.ratio, 1.0001);
+    if (w.ops > 0) {
+        busy++;
+    }
+});
+assert.gt(busy, 1, "a single collection's ops were not spread across writers");
+
+rt.stopSet();
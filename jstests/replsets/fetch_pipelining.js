@@ -0,0 +1,42 @@
+/**
+ * Test that a secondary fetching the oplog with a getMore in flight, into a small buffer, applies
+ * every op, and reports the fetch and buffer waits in the repl metrics.
+ */
+var rt = new ReplSetTest( { name : "fetch_pipelining" , nodes: 2, oplogSize: 100,
+                            nodeOptions: { setParameter: "replBufferMaxSizeBytes=65536" } } );
+rt.startSet();
+rt.initiate();
+
+rt.awaitSecondaryNodes();
+
+var primary = rt.getPrimary();
+var secondary = rt.getSecondary();
+var testDB = primary.getDB("test");
+
+var padding = new Array(200).join("x");
+for (var i = 0; i < 20000; i++) {
+    testDB.a.insert({ _id : i, padding : padding });
+}
+testDB.getLastError(2);
+
+secondary.setSlaveOk();
+assert.eq(20000, secondary.getDB("test").a.count());
+
+var metrics = secondary.getDB("test").serverStatus().metrics.repl;
+printjson(metrics);
+assert.eq(65536, metrics.buffer.maxSizeBytes);
+assert.gte(metrics.network.ops, 20000);
+assert(metrics.network.getmores.num > 0, "no getmores");
+assert(metrics.network.pipelinedGetmores > 0, "no getmores sent ahead");
+assert(metrics.buffer.pushWait.num > 0, "no batches queued");
+
+// with pipelining off, ops still arrive
+assert.commandWorked(secondary.getDB("admin").runCommand({ setParameter : 1,
+                                                            replFetchPipelining : false }));
+for (var i = 20000; i < 21000; i++) {
+    testDB.a.insert({ _id : i, padding : padding });
+}
+testDB.getLastError(2);
+assert.eq(21000, secondary.getDB("test").a.count());
+
+rt.stopSet();
@@ -0,0 +1,59 @@
+/**
+ * Test that an initial sync cloning several collections at once copies their data and indexes,
+ * and reports each collection's progress in replSetGetStatus.
+ */
+var rt = new ReplSetTest( { name : "initial_sync_parallel" , nodes: 1, oplogSize: 100,
+                            nodeOptions: { setParameter: "initialSyncCloneThreads=3" } } );
+rt.startSet();
+rt.initiate();
+
+var primary = rt.getPrimary();
+var collNames = [ "a", "b", "c", "d", "e" ];
+
+for (var d = 0; d < 2; d++) {
+    var testDB = primary.getDB("test" + d);
+    collNames.forEach(function(name) {
+        var coll = testDB[name];
+        coll.ensureIndex({ x : 1 });
+        coll.ensureIndex({ y : 1 }, { unique : true });
+        for (var i = 0; i < 2000; i++) {
+            coll.insert({ _id : i, x : i % 10, y : i });
+        }
+    });
+    assert.eq(null, testDB.getLastError());
+}
+
+var secondary = rt.add();
+rt.reInitiate();
+rt.awaitSecondaryNodes();
+rt.awaitReplication();
+
+secondary.setSlaveOk();
+for (var d = 0; d < 2; d++) {
+    var secondaryDB = secondary.getDB("test" + d);
+    collNames.forEach(function(name) {
+        var coll = secondaryDB[name];
+        assert.eq(2000, coll.count(), "wrong count for " + coll);
+        assert.eq(3, coll.getIndexes().length, "wrong indexes for " + coll);
+        assert.eq(200, coll.find({ x : 3 }).hint({ x : 1 }).itcount());
+        assert.eq(1, coll.find({ y : 1234 }).hint({ y : 1 }).itcount());
+    });
+}
+
+var status = secondary.getDB("admin").runCommand({ replSetGetStatus : 1 });
+printjson(status.initialSyncStatus);
+assert(status.initialSyncStatus, "no initial sync progress");
+assert.eq(3, status.initialSyncStatus.threads);
+assert.eq(10, status.initialSyncStatus.collections);
+assert.eq(10, status.initialSyncStatus.done);
+status.initialSyncStatus.progress.forEach(function(c) {
+    assert.eq("done", c.state, c.ns);
+    assert.eq(2000, c.docs, c.ns);
+    assert.gte(c.cloneMillis, 0, c.ns);
+    assert.gte(c.indexMillis, 0, c.ns);
+});
+
+// the primary never synced
+assert.eq(undefined, primary.getDB("admin").runCommand({ replSetGetStatus : 1 }).initialSyncStatus);
+
+rt.stopSet();
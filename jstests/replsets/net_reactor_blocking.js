@@ -0,0 +1,51 @@
+// With the epoll listener (netReactorThreads) more getLastError w:2 waiters than there are
+// reactor workers must not keep the secondary's oplog reads from being serviced.
+
+var nWorkers = 16; // netReactorWorkerThreads default
+var nWaiters = nWorkers + 4;
+
+var rt = new ReplSetTest( { name : "net_reactor_blocking" , nodes : 3 ,
+                            nodeOptions : { setParameter : "netReactorThreads=1" } } );
+rt.startSet();
+// the arbiter keeps the primary up while the secondary is down
+var conf = rt.getReplSetConfig();
+conf.members[1].priority = 0;
+conf.members[2].arbiterOnly = true;
+rt.initiate( conf );
+rt.awaitSecondaryNodes();
+
+var primary = rt.getPrimary();
+db = primary.getDB( "test" );
+db.waiters.insert( { _id : "warmup" } );
+assert.eq( null , db.getLastError( 2 , 60000 ) );
+
+// park the waiters while the secondary is down
+var secondaryId = 1;
+rt.stop( secondaryId );
+
+var joins = [];
+for ( var i = 0; i < nWaiters; i++ ) {
+    joins.push( startParallelShell( "db.waiters.insert( { _id : " + i + " } );" +
+                                    "assert.eq( null , db.getLastError( 2 , 120000 ) );" ) );
+}
+
+assert.soon( function() {
+    var waiting = 0;
+    primary.getDB( "admin" ).currentOp().inprog.forEach( function( op ) {
+        if ( op.query && op.query.getlasterror )
+            waiting++;
+    } );
+    return waiting >= nWaiters;
+} , "getLastError waiters not all parked" , 60000 );
+
+// the restarted secondary's oplog reads need workers the waiters are holding
+rt.restart( secondaryId );
+joins.forEach( function( join ) { join(); } );
+
+assert.eq( nWaiters + 1 , db.waiters.count() );
+assert.eq( null , db.getLastError( 2 , 60000 ) );
+var secondary = rt.nodes[ secondaryId ];
+secondary.setSlaveOk();
+assert.eq( nWaiters + 1 , secondary.getDB( "test" ).waiters.count() );
+
+rt.stopSet();
@@ -0,0 +1,33 @@
+// Replication traffic is compressed when both members enable networkMessageCompression.
+
+var rt = new ReplSetTest({ name: "network_compression", nodes: 2, oplogSize: 100,
+                           nodeOptions: { setParameter: "networkMessageCompression=true" } });
+rt.startSet();
+rt.initiate();
+rt.awaitSecondaryNodes();
+
+var primary = rt.getPrimary();
+var secondary = rt.getSecondary();
+var testDB = primary.getDB("test");
+
+var s = new Array(1024).join("compress me ");
+for (var i = 0; i < 1000; i++) {
+    testDB.foo.insert({ i: i, s: s });
+}
+assert.eq(null, testDB.getLastError(2));
+
+var sent = primary.getDB("admin").serverStatus().network.compression;
+var received = secondary.getDB("admin").serverStatus().network.compression;
+printjson(sent);
+printjson(received);
+
+assert.eq("snappy", sent.compressor);
+assert(sent.enabled);
+assert.gt(sent.sent.messages, 0, "primary sent no compressed oplog batches");
+assert.lt(sent.sent.ratio, 0.5);
+assert.gt(received.received.messages, 0, "secondary received no compressed messages");
+
+// the shell doesn't offer compression, so its own requests stay uncompressed
+assert.eq(1000, testDB.foo.count());
+
+rt.stopSet();
@@ -0,0 +1,46 @@
+/**
+ * Test that a secondary prefetching ops ahead of their batch applies them all, and reports the
+ * lookahead in the repl.preload metrics.
+ */
+var rt = new ReplSetTest( { name : "prefetch_lookahead" , nodes: 2, oplogSize: 100,
+                            nodeOptions: { setParameter: "replPrefetchLookahead=true" } } );
+rt.startSet();
+rt.initiate();
+
+rt.awaitSecondaryNodes();
+
+var primary = rt.getPrimary();
+var secondary = rt.getSecondary();
+var testDB = primary.getDB("test");
+
+testDB.a.ensureIndex({ x : 1 });
+testDB.getLastError(2);
+
+for (var i = 0; i < 5000; i++) {
+    testDB.a.insert({ _id : i, x : i });
+}
+testDB.getLastError(2);
+
+// updates prefetch both the index and the record pages
+for (var i = 0; i < 5000; i++) {
+    testDB.a.update({ _id : i }, { $set : { x : -i } });
+}
+testDB.getLastError(2);
+
+secondary.setSlaveOk();
+var secondaryColl = secondary.getDB("test").a;
+assert.eq(5000, secondaryColl.count());
+assert.eq(5000, secondaryColl.find({ x : { $lte : 0 } }).count());
+
+var preload = secondary.getDB("test").serverStatus().metrics.repl.preload;
+printjson(preload);
+assert(preload.lookahead.ops > 0, "no ops prefetched ahead");
+assert.gte(preload.lookahead.hits + preload.lookahead.misses, 10001, "ops not accounted for");
+assert(preload.lookahead.saved.num > 0, "no batches");
+assert(preload.lookahead.saved.totalMillis >= 0, "saved time missing");
+
+// the primary never prefetches
+var primaryPreload = testDB.serverStatus().metrics.repl.preload;
+assert.eq(0, primaryPreload.lookahead.ops);
+
+rt.stopSet();
@@ -237,6 +237,15 @@ doTest = function (signal) {
 
     assert( dbs_match(a,b), "server data sets do not match after rollback, something is wrong");
 
+    // B reports how its rollback went
+    var rollbackStatus = B.runCommand({ replSetGetStatus: 1 }).rollbackStatus;
+    printjson(rollbackStatus);
+    assert.eq("done", rollbackStatus.phase);
+    assert.eq(rollbackStatus.docsToRefetch, rollbackStatus.docsRefetched);
+    assert(rollbackStatus.refetchBatches > 0, "no refetch batches");
+    assert.eq(rollbackStatus.docsToFix, rollbackStatus.docsFixed);
+    assert.eq(undefined, A.runCommand({ replSetGetStatus: 1 }).rollbackStatus);
+
     pause("rollback2.js SUCCESS");
     replTest.stopSet(signal);
 };
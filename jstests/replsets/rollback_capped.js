@@ -0,0 +1,75 @@
+// Rolling back every insert into a capped collection with an _id index has to empty the
+// collection, which rebuilds its indexes and so needs the whole database locked.
+
+function wait(f, msg) {
+    assert.soon(function() {
+        try {
+            return f();
+        }
+        catch (e) {
+            print(e);
+            return false;
+        }
+    }, msg, 200 * 1000);
+}
+
+var replTest = new ReplSetTest({ name: 'rollbackCapped', nodes: 3 });
+var nodes = replTest.nodeList();
+
+var conns = replTest.startSet();
+replTest.initiate({ "_id": "rollbackCapped",
+                    "members": [
+                        { "_id": 0, "host": nodes[0] },
+                        { "_id": 1, "host": nodes[1] },
+                        { "_id": 2, "host": nodes[2], arbiterOnly: true }]
+                  });
+
+var master = replTest.getMaster();
+assert(master == conns[0], "conns[0] assumed to be master");
+
+var a_conn = conns[0];
+var b_conn = conns[1];
+a_conn.setSlaveOk();
+b_conn.setSlaveOk();
+var A = a_conn.getDB("admin");
+var B = b_conn.getDB("admin");
+var a = a_conn.getDB("foo");
+var b = b_conn.getDB("foo");
+
+assert.commandWorked(a.runCommand({ create: "capped", capped: true, size: 64 * 1024,
+                                    autoIndexId: true }));
+a.bar.insert({ q: 1 });
+assert.eq(null, a.getLastError(2));
+wait(function() { return b.capped.getIndexes().length == 1; }, "b didn't get the _id index");
+
+// b becomes primary while a can't see it, and writes to the capped collection only
+A.runCommand({ replSetTest: 1, blind: true });
+wait(function() { return B.isMaster().ismaster; }, "b didn't become primary");
+
+for (var i = 0; i < 10; i++)
+    b.capped.insert({ _id: i, x: i });
+b.bar.insert({ q: 2 });
+assert.eq(null, b.getLastError());
+assert.eq(10, b.capped.count());
+
+// swap: a becomes primary again without ever seeing b's writes
+B.runCommand({ replSetTest: 1, blind: true });
+wait(function() { return !B.isMaster().ismaster; }, "b didn't step down");
+A.runCommand({ replSetTest: 1, blind: false });
+wait(function() { return A.isMaster().ismaster; }, "a didn't become primary");
+
+a.bar.insert({ q: 3 });
+assert.eq(null, a.getLastError());
+
+// b rolls back, emptying its capped collection
+B.runCommand({ replSetTest: 1, blind: false });
+wait(function() {
+    return b.bar.find({ q: 3 }).itcount() == 1;
+}, "b didn't roll back and catch up");
+replTest.awaitReplication();
+
+assert.eq(0, b.capped.count(), "rolled back capped documents are still on b");
+assert.eq(a.capped.getIndexes().length, b.capped.getIndexes().length, "b lost the _id index");
+assert.eq(0, b.bar.find({ q: 2 }).itcount(), "b still has its rolled back insert");
+
+replTest.stopSet(15);
@@ -0,0 +1,40 @@
+// The balancer moves chunks of different collections at the same time when the balancer settings
+// allow it, as long as the migrations have no shard in common.
+
+var s = new ShardingTest({ name: "balance_concurrent", shards: 4, mongos: 1,
+                           other: { chunksize: 1 } });
+s.stopBalancer();
+
+var admin = s.getDB("admin");
+var config = s.getDB("config");
+
+config.settings.update({ _id: "balancer" }, { $set: { maxConcurrentMigrations: 2 } }, true);
+assert.eq(null, config.getLastError());
+
+// two collections whose chunks start out on different shards
+var colls = [{ db: "a", primary: "shard0000" }, { db: "b", primary: "shard0001" }];
+colls.forEach(function(c) {
+    admin.runCommand({ enablesharding: c.db });
+    admin.runCommand({ movePrimary: c.db, to: c.primary });
+    assert.commandWorked(admin.runCommand({ shardcollection: c.db + ".foo", key: { x: 1 } }));
+    for (var i = 1; i < 12; i++) {
+        assert.commandWorked(admin.runCommand({ split: c.db + ".foo", middle: { x: i * 10 } }));
+    }
+    assert.eq(12, s.chunkCounts("foo", c.db)[c.primary]);
+});
+
+s.startBalancer();
+
+assert.soon(function() {
+    var aDiff = s.chunkDiff("foo", "a");
+    var bDiff = s.chunkDiff("foo", "b");
+    print("a: " + aDiff + " b: " + bDiff);
+    return aDiff < 2 && bDiff < 2;
+}, "balance didn't happen", 1000 * 60 * 5, 1000);
+
+s.stopBalancer();
+
+assert(config.changelog.count({ what: "moveChunk.commit", ns: "a.foo" }) > 0);
+assert(config.changelog.count({ what: "moveChunk.commit", ns: "b.foo" }) > 0);
+
+s.stop();
@@ -0,0 +1,80 @@
+//
+// Tests that continue-on-error bulk inserts whose documents alternate between shards are
+// inserted in full, and that their errors are reported.
+//
+
+var st = new ShardingTest({ shards : 2, mongos : 1, verbose : 0 });
+st.stopBalancer();
+
+var mongos = st.s;
+var admin = mongos.getDB("admin");
+var config = mongos.getDB("config");
+var shards = config.shards.find().toArray();
+var coll = mongos.getCollection("foo.bar");
+
+assert.commandWorked(admin.runCommand({ enableSharding : coll.getDB() + "" }));
+printjson(admin.runCommand({ movePrimary : coll.getDB() + "", to : shards[0]._id }));
+coll.ensureIndex({ ukey : 1 }, { unique : true });
+assert.commandWorked(admin.runCommand({ shardCollection : coll + "", key : { ukey : 1 } }));
+
+// even keys on one shard, odd keys on the other
+for (var i = 0; i < 20; i++) {
+    assert.commandWorked(admin.runCommand({ split : coll + "", middle : { ukey : i } }));
+    assert.commandWorked(admin.runCommand({ moveChunk : coll + "",
+                                            find : { ukey : i },
+                                            to : shards[i % 2]._id,
+                                            _waitForDelete : true }));
+}
+
+var shardColl = function(i) {
+    return new Mongo(shards[i].host).getCollection(coll + "");
+};
+
+var docs = [];
+for (var i = 0; i < 20; i++) {
+    docs.push({ ukey : i });
+}
+
+jsTest.log("Interleaved bulk insert with continue on error...");
+
+coll.insert(docs, 1);
+assert.eq(null, coll.getDB().getLastError());
+assert.eq(20, coll.find().itcount());
+assert.eq(10, shardColl(0).find().itcount());
+assert.eq(10, shardColl(1).find().itcount());
+
+jsTest.log("Interleaved bulk insert with duplicates on both shards...");
+
+coll.remove({});
+assert.eq(null, coll.getDB().getLastError());
+coll.insert([{ ukey : 2 }, { ukey : 3 }]);
+assert.eq(null, coll.getDB().getLastError());
+
+coll.insert(docs, 1);
+var gle = coll.getDB().getLastErrorObj();
+printjson(gle);
+assert(/dup key/.test(gle.err + ""), "duplicate not reported");
+assert.eq(20, coll.find().itcount());
+
+jsTest.log("Interleaved bulk insert with a document missing the shard key...");
+
+coll.remove({});
+assert.eq(null, coll.getDB().getLastError());
+
+var badDocs = docs.slice(0, 10).concat([{ notukey : 1 }]).concat(docs.slice(10));
+coll.insert(badDocs, 1);
+assert.neq(null, coll.getDB().getLastError());
+assert.eq(20, coll.find().itcount());
+
+jsTest.log("Interleaved bulk insert without continue on error stops at the first error...");
+
+coll.remove({});
+assert.eq(null, coll.getDB().getLastError());
+coll.insert({ ukey : 10 });
+assert.eq(null, coll.getDB().getLastError());
+
+coll.insert(docs);
+assert(/dup key/.test(coll.getDB().getLastError() + ""));
+assert.eq(11, coll.find().itcount());
+
+st.stop();
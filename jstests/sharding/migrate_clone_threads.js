@@ -0,0 +1,49 @@
+// The recipient of a chunk clones it with several threads, and both ends record how much data
+// each phase moved in the changelog.
+
+var st = new ShardingTest({ name: "migrate_clone_threads", shards: 2, mongos: 1,
+                            other: { chunksize: 100 } });
+st.stopBalancer();
+
+var admin = st.s.getDB("admin");
+var coll = st.s.getCollection("test.foo");
+var config = st.s.getDB("config");
+
+admin.runCommand({ enablesharding: "test" });
+admin.runCommand({ shardcollection: coll + "", key: { _id: 1 } });
+
+var pad = new Array(16 * 1024).join("x");
+var nDocs = 3000; // ~48MB, several _migrateClone batches
+for (var i = 0; i < nDocs; i++) {
+    coll.insert({ _id: i, pad: pad });
+}
+assert.eq(null, coll.getDB().getLastError());
+
+var from = st.getServer("test");
+var to = st.getOther(from);
+
+function moveAndCheck(threads, dest) {
+    assert.commandWorked(dest.getDB("admin").runCommand({ setParameter: 1,
+                                                          migrateCloneThreads: threads }));
+    assert.commandWorked(admin.runCommand({ moveChunk: coll + "", find: { _id: 0 },
+                                            to: dest.name, _waitForDelete: true }));
+    assert.eq(nDocs, coll.find().itcount());
+    assert.eq(nDocs, dest.getCollection(coll + "").count());
+
+    var toEntry = config.changelog.find({ what: "moveChunk.to" }).sort({ time: -1 }).next();
+    printjson(toEntry);
+    assert.eq(nDocs, toEntry.details.clone.docs);
+    assert.gt(toEntry.details.clone.bytes, nDocs * pad.length);
+    assert(toEntry.details.catchup, "no catchup figures");
+    assert(toEntry.details.steady, "no steady figures");
+
+    var fromEntry = config.changelog.find({ what: "moveChunk.from" }).sort({ time: -1 }).next();
+    printjson(fromEntry);
+    assert.gte(fromEntry.details.transfer.docs, nDocs);
+}
+
+moveAndCheck(4, to);
+// one thread clones the same way it always has
+moveAndCheck(1, from);
+
+st.stop();
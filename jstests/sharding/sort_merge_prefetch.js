@@ -0,0 +1,67 @@
+//
+// Tests that sorted queries over several shards merge the shards' results in order when the
+// shards' batches are prefetched, and that explain reports the time spent waiting on each shard.
+//
+
+var st = new ShardingTest({ shards : 3, mongos : 1, verbose : 0 });
+st.stopBalancer();
+
+var mongos = st.s;
+var admin = mongos.getDB("admin");
+var config = mongos.getDB("config");
+var shards = config.shards.find().toArray();
+var coll = mongos.getCollection("foo.bar");
+
+assert.commandWorked(admin.runCommand({ enableSharding : coll.getDB() + "" }));
+printjson(admin.runCommand({ movePrimary : coll.getDB() + "", to : shards[0]._id }));
+assert.commandWorked(admin.runCommand({ shardCollection : coll + "", key : { _id : 1 } }));
+
+var N = 3000;
+for (var i = 0; i < 3; i++) {
+    assert.commandWorked(admin.runCommand({ split : coll + "", middle : { _id : i * N / 3 } }));
+    assert.commandWorked(admin.runCommand({ moveChunk : coll + "",
+                                            find : { _id : i * N / 3 },
+                                            to : shards[i]._id,
+                                            _waitForDelete : true }));
+}
+
+// the sort field is spread over all the shards
+for (var i = 0; i < N; i++) {
+    coll.insert({ _id : i, x : (i * 7919) % N });
+}
+assert.eq(null, coll.getDB().getLastError());
+
+jsTest.log("Sorted query with small batches...");
+
+var checkSorted = function(cursor, dir) {
+    var count = 0;
+    var last = null;
+    while (cursor.hasNext()) {
+        var doc = cursor.next();
+        if (last != null) {
+            assert(dir * (doc.x - last) > 0, "out of order: " + last + " then " + doc.x);
+        }
+        last = doc.x;
+        count++;
+    }
+    return count;
+};
+
+assert.eq(N, checkSorted(coll.find().sort({ x : 1 }).batchSize(10), 1));
+assert.eq(N, checkSorted(coll.find().sort({ x : -1 }).batchSize(7), -1));
+assert.eq(500, checkSorted(coll.find().sort({ x : 1 }).batchSize(10).limit(500), 1));
+assert.eq(N - 20, checkSorted(coll.find().sort({ x : 1 }).batchSize(10).skip(20), 1));
+
+jsTest.log("Unsorted query with small batches...");
+
+assert.eq(N, coll.find().batchSize(10).itcount());
+
+jsTest.log("Explain reports the wait on each shard...");
+
+var explain = coll.find({ x : { $gte : 0 } }).sort({ x : 1 }).explain();
+printjson(explain);
+assert.eq(3, explain.numShards);
+assert.eq(3, Object.keySet(explain.millisShardWait).length);
+assert.gte(explain.millisShardWaitMax, 0);
+
+st.stop();
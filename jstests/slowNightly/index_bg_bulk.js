@@ -0,0 +1,51 @@
+// Test that a background index build that bulk loads the index picks up the inserts, updates and
+// removes made while it runs.
+
+t = db.jstests_index_bg_bulk;
+
+function checkIndex(field) {
+    var hint = {};
+    hint[field] = 1;
+    var viaIndex = t.find({}, {_id: 1}).hint(hint).itcount();
+    var viaScan = t.find({}, {_id: 1}).hint({$natural: 1}).itcount();
+    assert.eq(viaScan, viaIndex, "index doesn't match the collection");
+    for (var v = 0; v < 100; v += 7) {
+        var query = {};
+        query[field] = v;
+        assert.eq(t.find(query).hint({$natural: 1}).itcount(), t.find(query).hint(hint).itcount(),
+                  "wrong results for " + tojson(query));
+    }
+    assert(t.validate(true).valid);
+}
+
+function buildWithWrites(bulkLoad) {
+    t.drop();
+    assert.commandWorked(db.adminCommand({setParameter: 1, bgIndexBulkLoad: bulkLoad}));
+    for (var i = 0; i < 100000; ++i) {
+        t.insert({_id: i, a: i % 100});
+    }
+    assert.eq(null, db.getLastError());
+
+    var build = startParallelShell(
+        "db.jstests_index_bg_bulk.ensureIndex({a: 1}, {background: true}); db.getLastError();");
+
+    // write until the index is published; the build doesn't count until then
+    var i = 100000;
+    while (t.stats().nindexes < 2) {
+        t.insert({_id: i, a: i % 100});
+        t.update({_id: i - 50000}, {$set: {a: [i % 100, (i + 1) % 100]}});
+        t.update({_id: i - 60000}, {$set: {pad: new Array(200).join("x")}});
+        t.remove({_id: i - 70000});
+        ++i;
+    }
+    assert.eq(null, db.getLastError());
+    build();
+    print("writes during build: " + (i - 100000));
+    checkIndex("a");
+}
+
+buildWithWrites(true);
+buildWithWrites(false);
+
+assert.commandWorked(db.adminCommand({setParameter: 1, bgIndexBulkLoad: true}));
+t.drop();
@@ -0,0 +1,41 @@
+// Tests servicing connections through the epoll listener (netReactorThreads) rather than
+// one thread per connection.
+
+var mongo = MongoRunner.runMongod({ setParameter: "netReactorThreads=2" });
+var testDB = mongo.getDB("test");
+var coll = testDB.net_reactor;
+coll.drop();
+
+var baseline = testDB.serverStatus().connections.current;
+
+// many connections, each keeping its own getLastError state across requests
+var conns = [];
+for (var i = 0; i < 200; i++) {
+    var c = new Mongo(mongo.host);
+    conns.push(c);
+}
+
+conns.forEach(function(c, i) {
+    var cdb = c.getDB("test");
+    cdb.net_reactor.insert({ _id: i });
+    assert.eq(null, cdb.getLastError());
+    cdb.net_reactor.insert({ _id: i });
+    assert.neq(null, cdb.getLastError(), "duplicate key not reported on connection " + i);
+});
+
+// the duplicate key errors belong to the connection that caused them
+assert.eq(null, testDB.getLastError());
+assert.eq(conns.length, coll.count());
+
+assert.soon(function() {
+    return testDB.serverStatus().connections.current >= baseline + conns.length;
+}, "connections not counted");
+
+// a large reply goes out through a worker thread
+var big = new Array(1024 * 1024).join("x");
+for (var i = 0; i < 5; i++) {
+    coll.insert({ big: big });
+}
+assert.eq(5, conns[0].getDB("test").net_reactor.find({ big: { $exists: true } }).itcount());
+
+MongoRunner.stopMongod(mongo.port);
@@ -0,0 +1,48 @@
+// An in memory sort buffers documents after they are projected, so a sort returning a few small
+// fields of large documents is not held to the in memory limit by the fields it drops, and explain
+// reports the most bytes the sort buffered.
+
+t = db.jstests_sortn;
+t.drop();
+
+big = new Array( 1024 * 1024 ).toString();
+for( i = 0; i < 40; ++i ) {
+    t.save( {a:i, b:-i, big:big} );
+}
+assert.eq( null, db.getLastError() );
+
+// 40MB of whole documents don't fit in the sort buffer.
+assert.throws( function() { t.find().sort( {b:1} ).itcount(); } );
+
+// Their projections do.
+res = t.find( {}, {a:1, _id:0} ).sort( {b:1} ).toArray();
+assert.eq( 40, res.length );
+assert.eq( {a:39}, res[ 0 ] );
+assert.eq( {a:0}, res[ 39 ] );
+
+// $diskLoc is kept with a projection.
+assert( t.find( {}, {a:1} ).sort( {b:1} ).showDiskLoc().next().$diskLoc );
+
+// Only the top skip + limit documents are buffered.
+explain = t.find( {}, {a:1} ).sort( {b:1} ).explain( true );
+assert( explain.scanAndOrder );
+unlimitedBytes = explain.scanAndOrderBytes;
+assert.gt( unlimitedBytes, 0 );
+assert.lt( unlimitedBytes, 1024 * 1024 );
+
+explain = t.find( {}, {a:1} ).sort( {b:1} ).skip( 2 ).limit( 3 ).explain( true );
+assert.eq( 3, explain.n );
+assert.gt( explain.scanAndOrderBytes, 0 );
+assert.lt( explain.scanAndOrderBytes, unlimitedBytes / 5 );
+
+// A top few of the whole documents fit as well.
+explain = t.find().sort( {b:1} ).limit( 3 ).explain( true );
+assert.eq( 3, explain.n );
+assert.gt( explain.scanAndOrderBytes, 3 * 1024 * 1024 );
+assert.lt( explain.scanAndOrderBytes, 5 * 1024 * 1024 );
+
+// An in order plan doesn't buffer.
+t.ensureIndex( {b:1} );
+explain = t.find( {}, {a:1} ).sort( {b:1} ).explain( true );
+assert( !explain.scanAndOrder );
+assert( !explain.hasOwnProperty( "scanAndOrderBytes" ) );
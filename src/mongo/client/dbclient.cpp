@@ -31,6 +31,7 @@
 #include "mongo/s/stale_exception.h"  // for RecvStaleConfigException
 #include "mongo/util/assert_util.h"
 #include "mongo/util/md5.hpp"
+#include "mongo/util/net/message_compression.h"
 
 #ifdef MONGO_SSL
 // TODO: Remove references to cmdline from the client.
@@ -866,6 +867,14 @@ namespace mongo {
         }
 #endif
 
+        BSONObjBuilder isMaster;
+        isMaster.append( "isMaster" , 1 );
+        if ( appendCompressionOffer( &isMaster ) ) {
+            BSONObj info;
+            if ( runCommand( "admin" , isMaster.obj() , info ) )
+                acceptCompressionReply( info , p.get() );
+        }
+
         return true;
     }
 
@@ -34,15 +34,15 @@ namespace mongo {
         _originalHost = _client->toString();
     }
 
-    int DBClientCursor::nextBatchSize() {
+    int DBClientCursor::_batchSizeFor( int nLeft ) const {
 
-        if ( nToReturn == 0 )
+        if ( nLeft == 0 )
             return batchSize;
 
         if ( batchSize == 0 )
-            return nToReturn;
+            return nLeft;
 
-        return batchSize < nToReturn ? batchSize : nToReturn;
+        return batchSize < nLeft ? batchSize : nLeft;
     }
 
     void DBClientCursor::_assembleInit( Message& toSend ) {
@@ -116,21 +116,30 @@ namespace mongo {
         return ok;
     }
 
+    void DBClientCursor::_assembleGetMore( int nLeft, Message& toSend ) {
+        BufBuilder b;
+        b.appendNum(opts);
+        b.appendStr(ns);
+        b.appendNum(_batchSizeFor(nLeft));
+        b.appendNum(cursorId);
+        toSend.setData(dbGetMore, b.buf(), b.len());
+    }
+
     void DBClientCursor::requestMore() {
         verify( cursorId && batch.pos == batch.nReturned );
 
+        if ( prefetchPending() ) {
+            _receivePrefetched();
+            return;
+        }
+
         if (haveLimit) {
             nToReturn -= batch.nReturned;
             verify(nToReturn > 0);
         }
-        BufBuilder b;
-        b.appendNum(opts);
-        b.appendStr(ns);
-        b.appendNum(nextBatchSize());
-        b.appendNum(cursorId);
 
         Message toSend;
-        toSend.setData(dbGetMore, b.buf(), b.len());
+        _assembleGetMore( nToReturn, toSend );
         auto_ptr<Message> response(new Message());
 
         if ( _client ) {
@@ -150,6 +159,142 @@ namespace mongo {
         }
     }
 
+    bool DBClientCursor::prefetchMore() {
+        if ( prefetchPending() )
+            return true;
+
+        if ( ! cursorId || _client || _scopedHost.empty() ||
+             ( opts & ( QueryOption_CursorTailable | QueryOption_Exhaust ) ) )
+            return false;
+
+        // nToReturn still counts the current batch, see more()
+        if ( haveLimit && nToReturn <= batch.nReturned )
+            return false;
+
+        Message toSend;
+        _assembleGetMore( haveLimit ? nToReturn - batch.nReturned : nToReturn, toSend );
+
+        auto_ptr<ScopedDbConnection> conn;
+        try {
+            conn.reset( new ScopedDbConnection( _scopedHost ) );
+            conn->get()->say( toSend );
+        }
+        catch ( DBException& e ) {
+            // not fatal, the batch is requested again when it is needed
+            LOG(1) << "couldn't prefetch from " << _scopedHost << causedBy( e ) << endl;
+            if ( conn.get() )
+                conn->kill();
+            return false;
+        }
+
+        _prefetchConn = conn.release();
+        return true;
+    }
+
+    bool DBClientCursor::prefetchMoreOnConnection() {
+        if ( prefetchPending() )
+            return true;
+
+        if ( ! cursorId || ! _client || ( opts & QueryOption_Exhaust ) )
+            return false;
+
+        // nToReturn still counts the current batch, see more()
+        if ( haveLimit && nToReturn <= batch.nReturned )
+            return false;
+
+        Message toSend;
+        _assembleGetMore( haveLimit ? nToReturn - batch.nReturned : nToReturn, toSend );
+        try {
+            _client->say( toSend );
+        }
+        catch ( DBException& e ) {
+            // the batch is requested again when it is needed, and fails then if need be
+            LOG(1) << "couldn't prefetch from " << _client->toString() << causedBy( e ) << endl;
+            return false;
+        }
+
+        _prefetchOnClient = true;
+        return true;
+    }
+
+    void DBClientCursor::settlePrefetch() {
+        if ( ! _prefetchConn )
+            return;
+
+        auto_ptr<ScopedDbConnection> conn( _prefetchConn );
+        _prefetchConn = NULL;
+
+        auto_ptr<Message> response(new Message());
+        try {
+            if ( conn->get()->recv( *response ) ) {
+                // let the connection see the reply before it goes back to the pool
+                QueryResult *qr = (QueryResult *) response->singleData();
+                bool retry;
+                string host;
+                conn->get()->checkResponse( qr->data(), qr->nReturned, &retry, &host );
+                conn->done();
+                _prefetched = response;
+                return;
+            }
+        }
+        catch ( DBException& e ) {
+            LOG(1) << "couldn't receive prefetched batch from " << _scopedHost << causedBy( e ) << endl;
+        }
+
+        // reported when the batch is needed
+        conn->kill();
+        _prefetchFailed = true;
+    }
+
+    void DBClientCursor::_receivePrefetched() {
+        if (haveLimit) {
+            nToReturn -= batch.nReturned;
+            verify(nToReturn > 0);
+        }
+
+        if ( _prefetchFailed ) {
+            _prefetchFailed = false;
+            uasserted( 16776, str::stream() << "recv failed while getting more from " << _scopedHost );
+        }
+
+        if ( _prefetched.get() ) {
+            // the connection already saw the reply in settlePrefetch()
+            this->batch.m = _prefetched;
+            dataReceived();
+            return;
+        }
+
+        auto_ptr<Message> response(new Message());
+
+        if ( _prefetchOnClient ) {
+            _prefetchOnClient = false;
+            uassert( 16760, str::stream() << "recv failed while getting more from "
+                                          << _client->toString(),
+                     _client->recv( *response ) );
+            this->batch.m = response;
+            dataReceived();
+            return;
+        }
+
+        auto_ptr<ScopedDbConnection> conn( _prefetchConn );
+        _prefetchConn = NULL;
+
+        uassert( 16759, str::stream() << "recv failed while getting more from " << _scopedHost,
+                 conn->get()->recv( *response ) );
+
+        _client = conn->get();
+        this->batch.m = response;
+        try {
+            dataReceived();
+        }
+        catch ( ... ) {
+            _client = 0;
+            throw;
+        }
+        _client = 0;
+        conn->done();
+    }
+
     /** with QueryOption_Exhaust, the server just blasts data at us (marked at end with cursorid==0). */
     void DBClientCursor::exhaustReceiveMore() {
         verify( cursorId && batch.pos == batch.nReturned );
@@ -190,7 +335,8 @@ namespace mongo {
         batch.pos = 0;
         batch.data = qr->data();
 
-        _client->checkResponse( batch.data, batch.nReturned, &retry, &host ); // watches for "not master"
+        if ( _client )
+            _client->checkResponse( batch.data, batch.nReturned, &retry, &host ); // watches for "not master"
 
         if( qr->resultFlags() & ResultFlag_ShardConfigStale ) {
             BSONObj error;
@@ -289,6 +435,7 @@ namespace mongo {
         verify( _scopedHost.size() == 0 );
         verify( conn );
         verify( conn->get() );
+        verify( ! _prefetchOnClient ); // the reply would be left on the pooled connection
 
         if ( conn->get()->type() == ConnectionString::SET ||
              conn->get()->type() == ConnectionString::SYNC ) {
@@ -314,6 +461,20 @@ namespace mongo {
 
         DESTRUCTOR_GUARD (
 
+        if ( _prefetchConn ) {
+            // the reply isn't wanted, and the connection can't be reused before it is read
+            _prefetchConn->kill();
+            delete _prefetchConn;
+            _prefetchConn = NULL;
+        }
+
+        if ( _prefetchOnClient ) {
+            // the reply has to be read off the connection before anything else can use it
+            _prefetchOnClient = false;
+            Message discarded;
+            _client->recv( discarded );
+        }
+
         if ( cursorId && _ownCursor && ! inShutdown() ) {
             BufBuilder b;
             b.appendNum( (int)0 ); // reserved
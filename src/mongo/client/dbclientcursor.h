@@ -29,6 +29,7 @@
 namespace mongo {
 
     class AScopedConnection;
+    class ScopedDbConnection;
 
     /** for mock purposes only -- do not create variants of DBClientCursor, nor hang code here 
         @see DBClientMockCursor
@@ -144,7 +145,10 @@ namespace mongo {
             resultFlags(0),
             cursorId(),
             _ownCursor( true ),
-            wasError( false ) {
+            wasError( false ),
+            _prefetchConn( NULL ),
+            _prefetchOnClient( false ),
+            _prefetchFailed( false ) {
             _finishConsInit();
         }
 
@@ -160,7 +164,10 @@ namespace mongo {
             resultFlags(0),
             cursorId(_cursorId),
             _ownCursor(true),
-            wasError(false) {
+            wasError(false),
+            _prefetchConn(NULL),
+            _prefetchOnClient(false),
+            _prefetchFailed(false) {
             _finishConsInit();
         }
 
@@ -199,6 +206,34 @@ namespace mongo {
         void initLazy( bool isRetry = false );
         bool initLazyFinish( bool& retry );
 
+        /**
+         * Sends the getMore for the next batch now, while the current batch is still being read.
+         * The reply is only received once the current batch runs out, so cursors on several
+         * servers which all prefetch wait on those servers at the same time rather than in turn.
+         * Only attached cursors prefetch, and never tailable or exhaust ones.
+         * @return true if a getMore is outstanding
+         */
+        bool prefetchMore();
+
+        /**
+         * Like prefetchMore(), but sends the getMore on the cursor's own connection, so tailable
+         * cursors can prefetch too.  Nothing else may use the connection until the reply has been
+         * read, which happens when the current batch runs out (or the cursor is destroyed).
+         * @return true if a getMore is outstanding
+         */
+        bool prefetchMoreOnConnection();
+
+        /**
+         * Receives the reply to an outstanding prefetchMore() now and hands its connection back to
+         * the pool; the batch is kept until the current one runs out.  Call this at the end of a
+         * request so a cursor left idle between requests doesn't pin a connection.
+         */
+        void settlePrefetch();
+
+        bool prefetchPending() const {
+            return _prefetchConn != NULL || _prefetchOnClient || _prefetched.get() || _prefetchFailed;
+        }
+
         class Batch : boost::noncopyable { 
             friend class DBClientCursor;
             auto_ptr<Message> m;
@@ -213,7 +248,8 @@ namespace mongo {
         friend class DBClientBase;
         friend class DBClientConnection;
 
-        int nextBatchSize();
+        int nextBatchSize() { return _batchSizeFor( nToReturn ); }
+        int _batchSizeFor( int nLeft ) const;
         void _finishConsInit();
         
         Batch batch;
@@ -234,10 +270,16 @@ namespace mongo {
         string _scopedHost;
         string _lazyHost;
         bool wasError;
+        ScopedDbConnection* _prefetchConn; // holds the connection of an outstanding getMore
+        bool _prefetchOnClient; // a getMore is outstanding on _client
+        auto_ptr<Message> _prefetched; // a settled reply, see settlePrefetch()
+        bool _prefetchFailed; // settlePrefetch() couldn't receive the reply
 
         void dataReceived() { bool retry; string lazyHost; dataReceived( retry, lazyHost ); }
         void dataReceived( bool& retry, string& lazyHost );
         void requestMore();
+        void _receivePrefetched();
+        void _assembleGetMore( int nLeft, Message& toSend );
         void exhaustReceiveMore(); // for exhaust
 
         // Don't call from a virtual function
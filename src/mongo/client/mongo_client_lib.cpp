@@ -59,6 +59,7 @@
 #include "../util/net/sock.cpp"
 #include "../util/log.cpp"
 #include "../util/password.cpp"
+#include "../util/net/message_compression.cpp"
 #include "../util/net/message_port.cpp"
 #include "../util/concurrency/thread_pool.cpp"
 #include "../util/concurrency/task.cpp"
@@ -293,6 +293,21 @@ namespace mongo {
         b.append( "numQueries" , (int)numExplains );
         b.append( "numShards" , (int)out.size() );
 
+        // Time mongos spent blocked on each shard's reply; with the queries sent in parallel,
+        // the slowest shard is the one that was waited on longest
+        {
+            BSONObjBuilder x( b.subobjStart( "millisShardWait" ) );
+            long long maxWait = 0;
+            for( map<Shard,PCMData>::iterator i = _cursorMap.begin(); i != _cursorMap.end(); ++i ){
+                if( ! i->second.pcState ) continue;
+                long long wait = i->second.pcState->waitMicros / 1000;
+                x.appendNumber( i->first.getAddress().toString(), wait );
+                maxWait = std::max( maxWait, wait );
+            }
+            x.done();
+            b.appendNumber( "millisShardWaitMax" , maxWait );
+        }
+
         if ( out.size() == 1 ) {
             b.append( "indexBounds" , indexBounds );
             if ( ! oldPlan.isEmpty() ) {
@@ -477,6 +492,7 @@ namespace mongo {
         _numServers = _servers.size();
         _lastFrom = 0;
         _cursors = 0;
+        _mergeHeapInit = false;
 
         if( ! _qSpec.isEmpty() ){
 
@@ -611,6 +627,7 @@ namespace mongo {
 
         stateB.append( "count", count );
         stateB.append( "done", done );
+        stateB.append( "waitMicros", waitMicros );
 
         return stateB.obj().getOwned();
     }
@@ -1102,7 +1119,11 @@ namespace mongo {
                     // Mark the cursor as non-retry by default
                     mdata.retryNext = false;
 
-                    if( ! state->cursor->initLazyFinish( mdata.retryNext ) ){
+                    Timer waited;
+                    bool received = state->cursor->initLazyFinish( mdata.retryNext );
+                    state->waitMicros += waited.micros();
+
+                    if( ! received ){
                         if( ! mdata.retryNext ){
                             uassert( 15988, "error querying server", false );
                         }
@@ -1260,6 +1281,10 @@ namespace mongo {
             _cursors[ index ].reset( mdata.pcState->cursor.get(), &mdata );
             _servers.insert( ServerAndQuery( i->first.getConnString(), BSONObj() ) );
 
+            // Ask every shard for its next batch up front, so the shards work on them in
+            // parallel while the first batches are merged
+            mdata.pcState->cursor->prefetchMore();
+
             index++;
         }
 
@@ -1595,56 +1620,138 @@ namespace mongo {
             _needToSkip = n;
         }
 
+        if ( ! _sortKey.isEmpty() ) {
+            _initMergeHeap();
+            return ! _mergeHeap.empty();
+        }
+
         for ( int i=0; i<_numServers; i++ ) {
-            if ( _cursors[i].more() )
+            if ( _more( i ) )
                 return true;
         }
         return false;
     }
 
+    namespace {
+
+        // Orders cursor indexes so that the std heap functions keep the cursor whose next
+        // result sorts first on top
+        class MergeHeapCmp {
+        public:
+            MergeHeapCmp( FilteringClientCursor* cursors, const BSONObj& sortKey )
+                : _cursors( cursors ), _sortKey( sortKey ) {}
+
+            bool operator()( int a, int b ) const {
+                return _cursors[a].peek().woSortOrder( _cursors[b].peek(), _sortKey, true ) > 0;
+            }
+
+        private:
+            FilteringClientCursor* _cursors;
+            const BSONObj& _sortKey;
+        };
+
+    }
+
     BSONObj ParallelSortClusteredCursor::next() {
-        BSONObj best = BSONObj();
-        int bestFrom = -1;
 
-        for( int j = 0; j < _numServers; j++ ){
+        if ( ! _sortKey.isEmpty() ) {
+            _initMergeHeap();
+            uassert( 16780 ,  "no more elements" , ! _mergeHeap.empty() );
+
+            MergeHeapCmp cmp( _cursors, _sortKey );
+            std::pop_heap( _mergeHeap.begin(), _mergeHeap.end(), cmp );
+            int from = _mergeHeap.back();
 
-            // Iterate _numServers times, starting one past the last server we used.
-            // This means we actually start at server #1, not #0, but shouldn't matter
+            BSONObj best = _cursors[from].peek();
+            _advance( from );
+
+            if ( _more( from ) ) {
+                std::push_heap( _mergeHeap.begin(), _mergeHeap.end(), cmp );
+            }
+            else {
+                _mergeHeap.pop_back();
+                if( _cursors[from].rawMData() )
+                    _cursors[from].rawMData()->pcState->done = true;
+            }
+            return best;
+        }
+
+        // Unsorted, so take from each server in turn, starting one past the last one used.
+        // This means we actually start at server #1, not #0, but shouldn't matter
+        for( int j = 0; j < _numServers; j++ ){
 
             int i = ( j + _lastFrom + 1 ) % _numServers;
 
-            if ( ! _cursors[i].more() ){
+            if ( ! _more( i ) ){
                 if( _cursors[i].rawMData() )
                     _cursors[i].rawMData()->pcState->done = true;
                 continue;
             }
 
-            BSONObj me = _cursors[i].peek();
+            _lastFrom = i;
+            BSONObj best = _cursors[i].peek();
+            _advance( i );
+            return best;
+        }
 
-            if ( best.isEmpty() ) {
-                best = me;
-                bestFrom = i;
-                if( _sortKey.isEmpty() ) break;
-                continue;
-            }
+        uasserted( 10019 ,  "no more elements" );
+        return BSONObj();
+    }
 
-            int comp = best.woSortOrder( me , _sortKey , true );
-            if ( comp < 0 )
-                continue;
+    void ParallelSortClusteredCursor::_initMergeHeap() {
+        if ( _mergeHeapInit )
+            return;
+        _mergeHeapInit = true;
 
-            best = me;
-            bestFrom = i;
+        for ( int i = 0; i < _numServers; i++ ) {
+            if ( _more( i ) )
+                _mergeHeap.push_back( i );
+            else if( _cursors[i].rawMData() )
+                _cursors[i].rawMData()->pcState->done = true;
         }
+        std::make_heap( _mergeHeap.begin(), _mergeHeap.end(), MergeHeapCmp( _cursors, _sortKey ) );
+    }
+
+    bool ParallelSortClusteredCursor::_more( int i ) {
+        if ( ! _needsBatch( i ) )
+            return _cursors[i].more();
+
+        Timer waited;
+        bool more = _cursors[i].more();
+        _gotBatch( i, waited );
+        return more;
+    }
+
+    void ParallelSortClusteredCursor::_advance( int i ) {
+        // the next result is read ahead, so this may be what needs a new batch
+        bool needsBatch = _needsBatch( i );
+        Timer waited;
+        _cursors[i].next();
+        if ( needsBatch )
+            _gotBatch( i, waited );
 
-        _lastFrom = bestFrom;
+        if( _cursors[i].rawMData() )
+            _cursors[i].rawMData()->pcState->count++;
+    }
 
-        uassert( 10019 ,  "no more elements" , ! best.isEmpty() );
-        _cursors[bestFrom].next();
+    bool ParallelSortClusteredCursor::_needsBatch( int i ) {
+        DBClientCursor* cursor = _cursors[i].raw();
+        return cursor && _cursors[i].rawMData() &&
+               cursor->objsLeftInBatch() == 0 && ! cursor->isDead();
+    }
 
-        if( _cursors[bestFrom].rawMData() )
-            _cursors[bestFrom].rawMData()->pcState->count++;
+    void ParallelSortClusteredCursor::_gotBatch( int i, const Timer& waited ) {
+        _cursors[i].rawMData()->pcState->waitMicros += waited.micros();
 
-        return best;
+        // keep a batch in flight while this one is merged
+        _cursors[i].raw()->prefetchMore();
+    }
+
+    void ParallelSortClusteredCursor::settlePrefetches() {
+        for ( int i = 0; i < _numServers; i++ ) {
+            if ( _cursors[i].raw() )
+                _cursors[i].raw()->settlePrefetch();
+        }
     }
 
     void ParallelSortClusteredCursor::_explain( map< string,list<BSONObj> >& out ) {
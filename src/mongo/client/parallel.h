@@ -90,6 +90,9 @@ namespace mongo {
 
         virtual void explain(BSONObjBuilder& b) = 0;
 
+        /** receives any batches requested ahead of time, see DBClientCursor::settlePrefetch() */
+        virtual void settlePrefetches() {}
+
     protected:
 
         virtual void _init() = 0;
@@ -266,7 +269,7 @@ namespace mongo {
     public:
 
         ParallelConnectionState() :
-            count( 0 ), done( false ) { }
+            count( 0 ), done( false ), waitMicros( 0 ) { }
 
         ShardConnectionPtr conn;
         DBClientCursorPtr cursor;
@@ -279,6 +282,9 @@ namespace mongo {
         long long count;
         bool done;
 
+        // Time spent blocked on the shard's replies
+        long long waitMicros;
+
         BSONObj toBSON() const;
 
         string toString() const {
@@ -343,6 +349,7 @@ namespace mongo {
         virtual bool more();
         virtual BSONObj next();
         virtual string type() const { return "ParallelSort"; }
+        virtual void settlePrefetches();
 
         void fullInit();
         void startInit();
@@ -392,7 +399,18 @@ namespace mongo {
         FilteringClientCursor * _cursors;
         int _needToSkip;
 
+        // Indexes of the cursors with more results, kept as a heap on their next result when
+        // sorting
+        vector<int> _mergeHeap;
+        bool _mergeHeapInit;
+
     private:
+        void _initMergeHeap();
+        bool _more( int i );
+        void _advance( int i );
+        bool _needsBatch( int i );
+        void _gotBatch( int i, const Timer& waited );
+
         /**
          * Setups the shard version of the connection. When using a replica
          * set connection and the primary cannot be reached, the version
@@ -39,6 +39,8 @@ namespace mongo {
 
     BOOST_STATIC_ASSERT( Record::HeaderSize == 16 );
     BOOST_STATIC_ASSERT( Record::HeaderSize + BtreeData_V1::BucketSize == 8192 );
+    BOOST_STATIC_ASSERT( Record::HeaderSize + BtreeData_V2::BucketSize == 8192 );
+    BOOST_STATIC_ASSERT( BtreeData_V2::PrefixMax <= 0xff );
 
     NOINLINE_DECL void checkFailed(unsigned line) {
         static time_t last;
@@ -324,7 +326,7 @@ namespace mongo {
         KeyNode kn = keyNode(this->n-1);
         recLoc = kn.recordLoc;
         key.assign(kn.key);
-        int keysize = kn.key.dataSize();
+        int keysize = keyDataSize(this->n-1);
 
         massert( 10283 , "rchild not null in btree popBack()", this->nextChild.isNull());
 
@@ -342,15 +344,16 @@ namespace mongo {
     /** add a key.  must be > all existing.  be careful to set next ptr right. */
     template< class V >
     bool BucketBasics<V>::_pushBack(const DiskLoc recordLoc, const Key& key, const Ordering &order, const DiskLoc prevChild) {
-        int bytesNeeded = key.dataSize() + sizeof(_KeyNode);
+        int keySize = storedSize(key);
+        int bytesNeeded = keySize + sizeof(_KeyNode);
         if ( bytesNeeded > this->emptySize )
             return false;
         verify( bytesNeeded <= this->emptySize );
         if( this->n ) {
-            const KeyNode klast = keyNode(this->n-1);
-            if(  klast.key.woCompare(key, order) > 0 ) { 
+            if( compareWithKey(key, this->n-1, order) < 0 ) { 
+                const KeyNode klast = keyNode(this->n-1);
                 log() << "btree bucket corrupt? consider reindexing or running validate command" << endl;
-                log() << "  klast: " << keyNode(this->n-1).key.toString() << endl;
+                log() << "  klast: " << klast.key.toString() << endl;
                 log() << "  key:   " << key.toString() << endl;
                 DEV klast.key.woCompare(key, order);
                 verify(false);
@@ -360,10 +363,10 @@ namespace mongo {
         _KeyNode& kn = k(this->n++);
         kn.prevChildBucket = prevChild;
         kn.recordLoc = recordLoc;
-        kn.setKeyDataOfs( (short) _alloc(key.dataSize()) );
+        kn.setKeyDataOfs( (short) _alloc(keySize) );
         short ofs = kn.keyDataOfs();
         char *p = dataAt(ofs);
-        memcpy(p, key.data(), key.dataSize());
+        writeKey(p, key, keySize);
 
         return true;
     }
@@ -380,7 +383,8 @@ namespace mongo {
     bool BucketBasics<V>::basicInsert(const DiskLoc thisLoc, int &keypos, const DiskLoc recordLoc, const Key& key, const Ordering &order) const {
         check( this->n < 1024 );
         check( keypos >= 0 && keypos <= this->n );
-        int bytesNeeded = key.dataSize() + sizeof(_KeyNode);
+        int keySize = storedSize(key);
+        int bytesNeeded = keySize + sizeof(_KeyNode);
         if ( bytesNeeded > this->emptySize ) {
             _pack(thisLoc, order, keypos);
             if ( bytesNeeded > this->emptySize )
@@ -412,10 +416,10 @@ namespace mongo {
         _KeyNode& kn = b->k(keypos);
         kn.prevChildBucket.Null();
         kn.recordLoc = recordLoc;
-        kn.setKeyDataOfs((short) b->_alloc(key.dataSize()) );
+        kn.setKeyDataOfs((short) b->_alloc(keySize) );
         char *p = b->dataAt(kn.keyDataOfs());
-        getDur().declareWriteIntent(p, key.dataSize());
-        memcpy(p, key.data(), key.dataSize());
+        getDur().declareWriteIntent(p, keySize);
+        b->writeKey(p, key, keySize);
         return true;
     }
 
@@ -486,7 +490,7 @@ namespace mongo {
                 k( i ) = k( j );
             }
             short ofsold = k(i).keyDataOfs();
-            int sz = keyNode(i).key.dataSize();
+            int sz = keyDataSize(i);
             ofs -= sz;
             this->topSize += sz;
             memcpy(temp+ofs, dataAt(ofsold), sz);
@@ -550,7 +554,7 @@ namespace mongo {
         // TODO I think we only want to do the 90% split on the rhs node of the tree.
         int rightSizeLimit = ( this->topSize + sizeof( _KeyNode ) * this->n ) / ( keypos == this->n ? 10 : 2 );
         for( int i = this->n - 1; i > -1; --i ) {
-            rightSize += keyNode( i ).key.dataSize() + sizeof( _KeyNode );
+            rightSize += keyDataSize( i ) + sizeof( _KeyNode );
             if ( rightSize > rightSizeLimit ) {
                 split = i;
                 break;
@@ -582,10 +586,11 @@ namespace mongo {
         _KeyNode &kn = k( i );
         kn.recordLoc = recordLoc;
         kn.prevChildBucket = prevChildBucket;
-        short ofs = (short) _alloc( key.dataSize() );
+        int keySize = storedSize( key );
+        short ofs = (short) _alloc( keySize );
         kn.setKeyDataOfs( ofs );
         char *p = dataAt( ofs );
-        memcpy( p, key.data(), key.dataSize() );
+        writeKey( p, key, keySize );
     }
 
     template< class V >
@@ -598,6 +603,138 @@ namespace mongo {
         _packReadyForMod( order, refpos );
     }
 
+    const char* BtreeData_V2::_expand( const char* stored, char* buf ) const {
+        int shared = (unsigned char) *stored;
+        if ( shared == 0 ) {
+            return stored + 1;
+        }
+        dassert( shared <= prefixLen );
+        memcpy( buf, prefix, shared );
+        // the rest of the key ends before the bucket does; KeyV1 finds where
+        const char* end = (const char*) this + BucketSize;
+        int rest = std::min<int>( BtreeData_V1::KeyMax - shared, end - ( stored + 1 ) );
+        memcpy( buf + shared, stored + 1, rest );
+        return buf;
+    }
+
+    int BtreeData_V2::_sharedBytes( const char* keyData, int len ) const {
+        int max = std::min<int>( prefixLen, len );
+        int i = 0;
+        while ( i < max && keyData[i] == prefix[i] ) {
+            ++i;
+        }
+        return i;
+    }
+
+    void BtreeData_V2::_setPrefix( const char* keyData, int len ) {
+        if ( prefixLen ) {
+            return;
+        }
+        int size = std::min<int>( len, PrefixMax );
+        getDur().declareWriteIntent( &prefixLen, sizeof( prefixLen ) + size );
+        memcpy( prefix, keyData, size );
+        prefixLen = size;
+    }
+
+    template<>
+    KeyV2 BucketBasics<V2>::readKey( short ofs ) const {
+        const char* stored = this->data + ofs;
+        if ( *stored == 0 ) {
+            return KeyV2( stored );
+        }
+        char buf[ V1::KeyMax ];
+        return KeyV2::copyOf( KeyV1( this->_expand( stored, buf ) ) );
+    }
+
+    template<>
+    KeyV2 BucketBasics<V2>::readKey( short ofs, char* buf ) const {
+        const char* stored = this->data + ofs;
+        if ( *stored == 0 ) {
+            return KeyV2( stored );
+        }
+        // a zero byte, as a KeyV2's data starts with, then the decompressed KeyV1 data
+        buf[0] = 0;
+        this->_expand( stored, buf + 1 );
+        return KeyV2::inBuffer( buf );
+    }
+
+    template<>
+    int BucketBasics<V2>::keyDataSize( int i ) const {
+        const char* stored = this->data + k( i ).keyDataOfs();
+        char buf[ V1::KeyMax ];
+        int shared = (unsigned char) *stored;
+        return 1 + KeyV1( this->_expand( stored, buf ) ).dataSize() - shared;
+    }
+
+    template<>
+    int BucketBasics<V2>::storedSize( const KeyV2& key ) const {
+        const KeyV1& v1 = key;
+        int len = v1.dataSize();
+        if ( this->prefixLen == 0 ) {
+            // the key will become the prefix
+            return 1 + len - std::min<int>( len, V2::PrefixMax );
+        }
+        return 1 + len - this->_sharedBytes( v1.data(), len );
+    }
+
+    template<>
+    void BucketBasics<V2>::writeKey( char* p, const KeyV2& key, int size ) {
+        const KeyV1& v1 = key;
+        int len = v1.dataSize();
+        this->_setPrefix( v1.data(), len );
+        int shared = 1 + len - size;
+        dassert( shared == this->_sharedBytes( v1.data(), len ) );
+        *p = (unsigned char) shared;
+        memcpy( p + 1, v1.data() + shared, len - shared );
+    }
+
+    template<>
+    int BucketBasics<V2>::compareWithKey( const KeyV2& key, int i, const Ordering& order ) const {
+        // decompressed to the stack rather than copied to a KeyV2, as find() does this a lot
+        char buf[ V1::KeyMax ];
+        return key.woCompare( KeyV1( this->_expand( this->data + k( i ).keyDataOfs(), buf ) ), order );
+    }
+
+    template<>
+    int BucketBasics<V2>::balanceDataSize() const {
+        return packedDataSize( 0 );
+    }
+
+    template<>
+    bool BucketBasics<V2>::keysGrowWhenMoved() {
+        return true;
+    }
+
+    template<>
+    void BucketBasics<V2>::prepareForKeysFrom( const BucketBasics<V2>& source ) {
+        verify( this->n == 0 );
+        this->prefixLen = source.prefixLen;
+        memcpy( this->prefix, source.prefix, source.prefixLen );
+    }
+
+    /**
+     * Keys moved to another v2 bucket are compressed against its prefix instead, so the size
+     * used to merge and balance buckets is that of the keys uncompressed: their KeyV2::dataSize().
+     */
+    template<>
+    int BucketBasics<V2>::packedDataSize( int refPos ) const {
+        if ( this->flags & Packed ) {
+            int size = V2::BucketSize - this->emptySize - headerSize();
+            for( int j = 0; j < this->n; ++j ) {
+                size += (unsigned char) this->data[ k( j ).keyDataOfs() ];
+            }
+            return size;
+        }
+        int size = 0;
+        for( int j = 0; j < this->n; ++j ) {
+            if ( mayDropKey( j, refPos ) ) {
+                continue;
+            }
+            size += keyDataSize( j ) + (unsigned char) this->data[ k( j ).keyDataOfs() ] + sizeof( _KeyNode );
+        }
+        return size;
+    }
+
     /* - BtreeBucket --------------------------------------------------- */
 
     /** @return largest key in the subtree. */
@@ -684,8 +821,10 @@ namespace mongo {
                     break;
                 const BtreeBucket *bucket = b.btree<V>();
                 const _KeyNode& kn = bucket->k(pos);
-                if ( kn.isUsed() )
-                    return bucket->keyAt(pos).woEqual(key);
+                if ( kn.isUsed() ) {
+                    char buf[ V::KeyMax ];
+                    return bucket->keyAt(pos, buf).woEqual(key);
+                }
             b = bucket->advance(b, pos, 1, "BtreeBucket<V>::exists");
         }
         return false;
@@ -705,7 +844,8 @@ namespace mongo {
             const BtreeBucket *bucket = b.btree<V>();
             const _KeyNode& kn = bucket->k(pos);
             if ( kn.isUsed() ) {
-                if( bucket->keyAt(pos).woEqual(key) )
+                char buf[ V::KeyMax ];
+                if( bucket->keyAt(pos, buf).woEqual(key) )
                     return kn.recordLoc != self;
                 break;
             }
@@ -756,11 +896,11 @@ namespace mongo {
             m = h;
         }
         while ( l <= h ) {
-            KeyNode M = this->keyNode(m);
-            int x = key.woCompare(M.key, order);
+            const _KeyNode& M = k(m);
+            int x = this->compareWithKey(key, m, order);
             if ( x == 0 ) {
                 if( assertIfDup ) {
-                    if( k(m).isUnused() ) {
+                    if( M.isUnused() ) {
                         // ok that key is there if unused.  but we need to check that there aren't other
                         // entries for the key then.  as it is very rare that we get here, we don't put any
                         // coding effort in here to make this particularly fast
@@ -986,7 +1126,7 @@ namespace mongo {
         const BtreeBucket *r = BTREE(this->childForPos( leftIndex + 1 ));
 
         int KNS = sizeof( _KeyNode );
-        int rightSizeLimit = ( l->topSize + l->n * KNS + keyNode( leftIndex ).key.dataSize() + KNS + r->topSize + r->n * KNS ) / 2;
+        int rightSizeLimit = ( l->balanceDataSize() + keyNode( leftIndex ).key.dataSize() + KNS + r->balanceDataSize() ) / 2;
         // This constraint should be ensured by only calling this function
         // if we go below the low water mark.
         verify( rightSizeLimit < BtreeBucket<V>::bodySize() );
@@ -1092,6 +1232,18 @@ namespace mongo {
         if ( canMergeChildren( thisLoc, leftIndex ) ) {
             return false;
         }
+        // The child receiving keys must have room for up to half of both children's bytes and
+        // another key.  That's implied by the other child being below lowWaterMark unless the
+        // children are prefix compressed, when their sizes are of their keys uncompressed.
+        if ( this->keysGrowWhenMoved() ) {
+            const BtreeBucket *l = BTREE( this->childForPos( leftIndex ) );
+            const BtreeBucket *r = BTREE( this->childForPos( leftIndex + 1 ) );
+            int KNS = sizeof( _KeyNode );
+            int half = ( l->balanceDataSize() + keyNode( leftIndex ).key.dataSize() + KNS + r->balanceDataSize() ) / 2;
+            if ( half + V::KeyMax + KNS > BtreeBucket<V>::bodySize() ) {
+                return false;
+            }
+        }
         thisLoc.btreemod<V>()->doBalanceChildren( thisLoc, leftIndex, id, order );
         return true;
     }
@@ -1216,6 +1368,13 @@ namespace mongo {
             return true;
         }
 
+        // Neither balance happened, so the children can be merged, except prefix compressed
+        // ones that are too big to either balance or merge uncompressed.
+        if ( this->keysGrowWhenMoved() ) {
+            mayBalanceRight = mayBalanceRight && p->canMergeChildren( this->parent, parentIdx );
+            mayBalanceLeft = mayBalanceLeft && p->canMergeChildren( this->parent, parentIdx - 1 );
+        }
+
         BtreeBucket *pm = BTREEMOD(this->parent);
         if ( mayBalanceRight ) {
             pm->doMergeChildren( this->parent, parentIdx, id, order );
@@ -1365,6 +1524,7 @@ namespace mongo {
         int split = this->splitPos( keypos );
         DiskLoc rLoc = addBucket(idx);
         BtreeBucket *r = rLoc.btreemod<V>();
+        r->prepareForKeysFrom(*this);
         if ( split_debug )
             out() << "     split:" << split << ' ' << keyNode(split).key.toString() << " n:" << this->n << endl;
         for ( int i = split+1; i < this->n; i++ ) {
@@ -1535,6 +1695,7 @@ namespace mongo {
     template< class V >
     bool BtreeBucket<V>::customFind( int l, int h, const BSONObj &keyBegin, int keyBeginLen, bool afterKey, const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive, const Ordering &order, int direction, DiskLoc &thisLoc, int &keyOfs, pair< DiskLoc, int > &bestParent ) {
         const BtreeBucket<V> * bucket = BTREE(thisLoc);
+        char buf[ V::KeyMax ];
         while( 1 ) {
             if ( l + 1 == h ) {
                 keyOfs = ( direction > 0 ) ? h : l;
@@ -1549,7 +1710,7 @@ namespace mongo {
                 }
             }
             int m = l + ( h - l ) / 2;
-            int cmp = customBSONCmp( bucket->keyNode( m ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
+            int cmp = customBSONCmp( bucket->keyAt( m, buf ).toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
             if ( cmp < 0 ) {
                 l = m;
             }
@@ -1574,17 +1735,18 @@ namespace mongo {
      */
     template< class V >
     void BtreeBucket<V>::advanceTo(DiskLoc &thisLoc, int &keyOfs, const BSONObj &keyBegin, int keyBeginLen, bool afterKey, const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive, const Ordering &order, int direction ) const {
+        char buf[ V::KeyMax ];
         int l,h;
         bool dontGoUp;
         if ( direction > 0 ) {
             l = keyOfs;
             h = this->n - 1;
-            dontGoUp = ( customBSONCmp( keyNode( h ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) >= 0 );
+            dontGoUp = ( customBSONCmp( keyAt( h, buf ).toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) >= 0 );
         }
         else {
             l = 0;
             h = keyOfs;
-            dontGoUp = ( customBSONCmp( keyNode( l ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) <= 0 );
+            dontGoUp = ( customBSONCmp( keyAt( l, buf ).toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) <= 0 );
         }
         pair< DiskLoc, int > bestParent;
         if ( dontGoUp ) {
@@ -1598,12 +1760,12 @@ namespace mongo {
             while( !BTREE(thisLoc)->parent.isNull() ) {
                 thisLoc = BTREE(thisLoc)->parent;
                 if ( direction > 0 ) {
-                    if ( customBSONCmp( BTREE(thisLoc)->keyNode( BTREE(thisLoc)->n - 1 ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) >= 0 ) {
+                    if ( customBSONCmp( BTREE(thisLoc)->keyAt( BTREE(thisLoc)->n - 1, buf ).toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) >= 0 ) {
                         break;
                     }
                 }
                 else {
-                    if ( customBSONCmp( BTREE(thisLoc)->keyNode( 0 ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) <= 0 ) {
+                    if ( customBSONCmp( BTREE(thisLoc)->keyAt( 0, buf ).toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) <= 0 ) {
                         break;
                     }
                 }
@@ -1629,6 +1791,7 @@ namespace mongo {
                                       const Ordering &order, int direction, pair< DiskLoc, int > &bestParent ) {
         dassert( direction == 1 || direction == -1 );
         const BtreeBucket<V> *bucket = BTREE(locInOut);
+        char buf[ V::KeyMax ];
         if ( bucket->n == 0 ) {
             locInOut = DiskLoc();
             return;
@@ -1642,7 +1805,7 @@ namespace mongo {
             int z = (1-direction)/2*h;
 
             // leftmost/rightmost key may possibly be >=/<= search key
-            int res = customBSONCmp( bucket->keyNode( z ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
+            int res = customBSONCmp( bucket->keyAt( z, buf ).toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
             bool firstCheck = direction*res >= 0;
 
             if ( firstCheck ) {
@@ -1666,7 +1829,7 @@ namespace mongo {
                 }
             }
 
-            res = customBSONCmp( bucket->keyNode( h-z ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
+            res = customBSONCmp( bucket->keyAt( h-z, buf ).toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
             bool secondCheck = direction*res < 0;
 
             if ( secondCheck ) {
@@ -1949,8 +2112,10 @@ namespace mongo {
 
     template class BucketBasics<V0>;
     template class BucketBasics<V1>;
+    template class BucketBasics<V2>;
     template class BtreeBucket<V0>;
     template class BtreeBucket<V1>;
+    template class BtreeBucket<V2>;
     template struct __KeyNode<DiskLoc>;
     template struct __KeyNode<DiskLoc56Bit>;
 
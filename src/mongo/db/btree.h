@@ -292,8 +292,73 @@ namespace mongo {
         void _init() { }
     };
 
+    /**
+     * Buckets of v:2 indexes are laid out as BtreeData_V1 buckets are, but prefix compress their
+     * keys.  The header holds a prefix of up to PrefixMax bytes, the leading KeyV1 bytes of the
+     * first key stored in the bucket; a split's new bucket takes its prefix from the bucket split.
+     * Each key's data is a byte counting how many of its leading bytes equal the prefix's,
+     * followed by the remaining bytes of its KeyV1 data, and keys are decompressed as they're
+     * read (see KeyV2).
+     *
+     * Code sizing keys for another bucket uses KeyV2::dataSize(), the size of a key that shares
+     * nothing with the prefix, so it's always enough for the key wherever it's moved.
+     */
+    class BtreeData_V2 {
+    public:
+        typedef DiskLoc56Bit Loc;
+        typedef __KeyNode<Loc> _KeyNode;
+        typedef KeyV2 Key;
+        typedef KeyV2 KeyOwned;
+        enum { BucketSize = 8192-16 }; // leave room for Record header
+        // v1's largest key, plus the byte counting the bytes it shares with the bucket's prefix
+        static const int KeyMax = BtreeData_V1::KeyMax + 1;
+        // longest bucket prefix; must fit the unsigned char count of shared bytes
+        static const int PrefixMax = 128;
+        // A sentinel value sometimes used to identify a deallocated bucket.
+        static const unsigned short INVALID_N_SENTINEL = 0xffff;
+    protected:
+        /** Parent bucket of this bucket, which isNull() for the root bucket. */
+        Loc parent;
+        /** Given that there are n keys, this is the n index child. */
+        Loc nextChild;
+
+        unsigned short flags;
+
+        /** basicInsert() assumes the next three members are consecutive and in this order: */
+
+        /** Size of the empty region. */
+        unsigned short emptySize;
+        /** Size used for key storage, including storage of old keys. */
+        unsigned short topSize;
+        /* Number of keys in the bucket. */
+        unsigned short n;
+
+        /** Length of prefix, zero until the first key is stored. */
+        unsigned char prefixLen;
+        char prefix[PrefixMax];
+
+        /* Beginning of the bucket's body */
+        char data[4];
+
+        void _init() { prefixLen = 0; }
+
+        /**
+         * @return the KeyV1 data of the key stored at 'stored' in this bucket: just past the count
+         * of shared bytes if there are none, otherwise 'buf', which must hold BtreeData_V1::KeyMax
+         * bytes, filled with the shared bytes of the prefix and the rest of the key.
+         */
+        const char* _expand( const char* stored, char* buf ) const;
+
+        /** @return the number of leading bytes the 'len' bytes of 'keyData' share with the prefix. */
+        int _sharedBytes( const char* keyData, int len ) const;
+
+        /** Take the leading bytes of the 'len' bytes of 'keyData' as the prefix, if there's none yet. */
+        void _setPrefix( const char* keyData, int len );
+    };
+
     typedef BtreeData_V0 V0;
     typedef BtreeData_V1 V1;
+    typedef BtreeData_V2 V2;
 
     /**
      * This class adds functionality to BtreeData for managing a single bucket.
@@ -471,6 +536,57 @@ namespace mongo {
         const Loc& childForPos(int p) const { return p == this->n ? this->nextChild : k(p).prevChildBucket; }
         Loc& childForPos(int p) { return p == this->n ? this->nextChild : k(p).prevChildBucket; }
 
+        /**
+         * The functions below are where a bucket's key data is read and written.  They copy
+         * key data as is, except for BtreeData_V2 buckets, which prefix compress it.
+         */
+
+        /** @return the key whose data is at offset 'ofs'. */
+        Key readKey( short ofs ) const { return Key( this->data + ofs ); }
+
+        /**
+         * As above, but a key that has to be decompressed is decompressed to 'buf', which must
+         * hold V::KeyMax bytes, instead of to a copy on the heap.  The key may then be used only
+         * while 'buf' is.
+         */
+        Key readKey( short ofs, char* buf ) const { return readKey( ofs ); }
+
+        /** @return the number of bytes the i-indexed key's data takes in this bucket. */
+        int keyDataSize( int i ) const { return readKey( k( i ).keyDataOfs() ).dataSize(); }
+
+        /** @return the number of bytes 'key' would take in this bucket. */
+        int storedSize( const Key& key ) const { return key.dataSize(); }
+
+        /**
+         * Preconditions: 'size' == storedSize( key ), and 'p' points to that many bytes
+         *  allocated for the key in this bucket, with write intent declared.
+         * Postconditions: 'key' is stored at 'p'.
+         */
+        void writeKey( char* p, const Key& key, int size ) { memcpy( p, key.data(), size ); }
+
+        /** @return key.woCompare() of 'key' and the i-indexed key. */
+        int compareWithKey( const Key& key, int i, const Ordering& order ) const {
+            return key.woCompare( readKey( k( i ).keyDataOfs() ), order );
+        }
+
+        /**
+         * Preconditions: this bucket is new, with no keys.
+         * Postconditions: keys moved here from 'source' fit as they did there.
+         */
+        void prepareForKeysFrom( const BucketBasics& source ) { }
+
+        /**
+         * @return the size of this bucket's keys that rebalancing two buckets splits in half.
+         * For BtreeData_V2 buckets that's packedDataSize(), counting the keys uncompressed.
+         */
+        int balanceDataSize() const { return this->topSize + this->n * sizeof( _KeyNode ); }
+
+        /**
+         * @return true if keys may take more bytes after moving to a sibling bucket than they
+         *  did here, so balancing and merging have to check that they fit.
+         */
+        static bool keysGrowWhenMoved() { return false; }
+
         /** Same as bodySize(). */
         int totalDataSize() const;
         /**
@@ -911,7 +1027,13 @@ namespace mongo {
         Key keyAt(int i) const {
             if( i >= this->n ) 
                 return Key();
-            return Key(this->data + k(i).keyDataOfs());
+            return this->readKey(k(i).keyDataOfs());
+        }
+        /** As above, using 'buf' of V::KeyMax bytes as readKey( ofs, buf ) does. */
+        Key keyAt(int i, char* buf) const {
+            if( i >= this->n ) 
+                return Key();
+            return this->readKey(k(i).keyDataOfs(), buf);
         }
     protected:
 
@@ -1020,7 +1142,19 @@ namespace mongo {
     template< class V >
     BucketBasics<V>::KeyNode::KeyNode(const BucketBasics<V>& bb, const _KeyNode &k) :
         prevChildBucket(k.prevChildBucket),
-        recordLoc(k.recordLoc), key(bb.data+k.keyDataOfs())
+        recordLoc(k.recordLoc), key(bb.readKey(k.keyDataOfs()))
     { }
 
+    template<> KeyV2 BucketBasics<V2>::readKey( short ofs ) const;
+    template<> KeyV2 BucketBasics<V2>::readKey( short ofs, char* buf ) const;
+    template<> int BucketBasics<V2>::keyDataSize( int i ) const;
+    template<> int BucketBasics<V2>::storedSize( const KeyV2& key ) const;
+    template<> void BucketBasics<V2>::writeKey( char* p, const KeyV2& key, int size );
+    template<> int BucketBasics<V2>::compareWithKey( const KeyV2& key, int i,
+                                                     const Ordering& order ) const;
+    template<> void BucketBasics<V2>::prepareForKeysFrom( const BucketBasics<V2>& source );
+    template<> int BucketBasics<V2>::balanceDataSize() const;
+    template<> bool BucketBasics<V2>::keysGrowWhenMoved();
+    template<> int BucketBasics<V2>::packedDataSize( int refPos ) const;
+
 } // namespace mongo;
@@ -37,18 +37,18 @@ namespace mongo {
     template<class V>
     BtreeBuilder<V>::BtreeBuilder(bool _dupsAllowed, IndexDetails& _idx) :
         dupsAllowed(_dupsAllowed),
-        idx(_idx),
+        idx(&_idx),
         n(0),
-        order( idx.keyPattern() ),
-        ordering( Ordering::make(idx.keyPattern()) ) {
-        first = cur = BtreeBucket<V>::addBucket(idx);
+        order( _idx.keyPattern() ),
+        ordering( Ordering::make(_idx.keyPattern()) ) {
+        first = cur = BtreeBucket<V>::addBucket(*idx);
         b = cur.btreemod<V>();
         committed = false;
     }
 
     template<class V>
     void BtreeBuilder<V>::newBucket() {
-        DiskLoc L = BtreeBucket<V>::addBucket(idx);
+        DiskLoc L = BtreeBucket<V>::addBucket(*idx);
         b->setTempNext(L);
         cur = L;
         b = cur.btreemod<V>();
@@ -66,7 +66,7 @@ namespace mongo {
 
         auto_ptr< KeyOwned > key( new KeyOwned(_key) );
         if ( key->dataSize() > BtreeBucket<V>::KeyMax ) {
-            problem() << "Btree::insert: key too large to index, skipping " << idx.indexNamespace() 
+            problem() << "Btree::insert: key too large to index, skipping " << idx->indexNamespace() 
                       << ' ' << key->dataSize() << ' ' << key->toString() << endl;
             return;
         }
@@ -77,7 +77,7 @@ namespace mongo {
                 massert( 10288 ,  "bad key order in BtreeBuilder - server internal error", cmp <= 0 );
                 if( cmp == 0 ) {
                     //if( !dupsAllowed )
-                    uasserted( ASSERT_ID_DUPKEY , BtreeBucket<V>::dupKeyError( idx , *keyLast ) );
+                    uasserted( ASSERT_ID_DUPKEY , BtreeBucket<V>::dupKeyError( *idx , *keyLast ) );
                 }
             }
         }
@@ -98,12 +98,12 @@ namespace mongo {
         while( 1 ) {
             if( loc.btree<V>()->tempNext().isNull() ) {
                 // only 1 bucket at this level. we are done.
-                getDur().writingDiskLoc(idx.head) = loc;
+                getDur().writingDiskLoc(idx->head) = loc;
                 break;
             }
             levels++;
 
-            DiskLoc upLoc = BtreeBucket<V>::addBucket(idx);
+            DiskLoc upLoc = BtreeBucket<V>::addBucket(*idx);
             DiskLoc upStart = upLoc;
             BtreeBucket<V> *up = upLoc.btreemod<V>();
 
@@ -125,7 +125,7 @@ namespace mongo {
 
                 if ( ! up->_pushBack(r, k, ordering, keepLoc) ) {
                     // current bucket full
-                    DiskLoc n = BtreeBucket<V>::addBucket(idx);
+                    DiskLoc n = BtreeBucket<V>::addBucket(*idx);
                     up->setTempNext(n);
                     upLoc = n;
                     up = upLoc.btreemod<V>();
@@ -142,7 +142,7 @@ namespace mongo {
                         ll.btreemod<V>()->parent = upLoc;
                         //(x->nextChild.btreemod<V>())->parent = upLoc;
                     }
-                    x->deallocBucket( xloc, idx );
+                    x->deallocBucket( xloc, *idx );
                 }
                 xloc = nextLoc;
             }
@@ -162,7 +162,15 @@ namespace mongo {
         committed = true;
     }
 
+    template<class V>
+    void BtreeBuilder<V>::yielded(IndexDetails& movedIdx) {
+        idx = &movedIdx;
+        // the bucket may have been remapped
+        b = cur.btreemod<V>();
+    }
+
     template class BtreeBuilder<V0>;
     template class BtreeBuilder<V1>;
+    template class BtreeBuilder<V2>;
 
 }
@@ -29,7 +29,7 @@ namespace mongo {
         typedef typename V::Key Key;
         
         bool dupsAllowed;
-        IndexDetails& idx;
+        IndexDetails* idx;
         /** Number of keys added to btree. */
         unsigned long long n;
         /** Last key passed to addKey(). */
@@ -61,6 +61,13 @@ namespace mongo {
          */
         void commit(bool mayInterrupt);
 
+        /**
+         * Call after yielding between addKey()s.  The buckets built so far aren't reachable
+         * from any index yet, so nothing else touches them while the lock is released.
+         * @param movedIdx the index being built, which may have moved during the yield
+         */
+        void yielded(IndexDetails& movedIdx);
+
         unsigned long long getn() { return n; }
     };
 
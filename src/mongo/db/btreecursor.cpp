@@ -63,12 +63,14 @@ namespace mongo {
                 throw UserException(15850, "keyAt bucket deleted");
             }
             dassert( n >= 0 && n < 10000 );
-            return ofs >= n ? BSONObj() : b->keyNode(ofs).key.toBson();
+            char buf[ V::KeyMax ];
+            return ofs >= n ? BSONObj() : b->keyAt(ofs, buf).toBson();
         }
 
         virtual BSONObj currKey() const { 
             verify( !bucket.isNull() );
-            return bucket.btree<V>()->keyNode(keyOfs).key.toBson();
+            char buf[ V::KeyMax ];
+            return bucket.btree<V>()->keyAt(keyOfs, buf).toBson();
         }
 
         virtual bool curKeyHasChild() { 
@@ -188,12 +190,16 @@ namespace mongo {
 
     template class BtreeCursorImpl<V0>;
     template class BtreeCursorImpl<V1>;
+    template class BtreeCursorImpl<V2>;
 
     BtreeCursor* BtreeCursor::make( NamespaceDetails * nsd , int idxNo , const IndexDetails& indexDetails ) {
         int v = indexDetails.version();
         
         if( v == 1 ) 
             return new BtreeCursorImpl<V1>( nsd , idxNo , indexDetails );
+
+        if( v == 2 ) 
+            return new BtreeCursorImpl<V2>( nsd , idxNo , indexDetails );
         
         if( v == 0 ) 
             return new BtreeCursorImpl<V0>( nsd , idxNo , indexDetails );
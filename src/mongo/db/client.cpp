@@ -62,6 +62,8 @@ namespace mongo {
 #if defined(_DEBUG)
     struct StackChecker;
     ThreadLocalValue<StackChecker *> checker;
+    // the client whose initThread() set up this thread's checker
+    ThreadLocalValue<const Client *> checkerClient;
 
     struct StackChecker { 
 #if defined(_WIN32)
@@ -123,6 +125,9 @@ namespace mongo {
         verify( currentClient.get() == 0 );
         Client *c = new Client(desc, mp);
         currentClient.reset(c);
+#if defined(_DEBUG)
+        checkerClient.set(c);
+#endif
         mongo::lastError.initThread();
         c->setAuthorizationManager(new AuthorizationManager(new AuthExternalStateMongod()));
         return *c;
@@ -134,6 +139,7 @@ namespace mongo {
         _shutdown(false),
         _desc(desc),
         _god(0),
+        _repairIndexBuild(false),
         _lastOp(0)
     {
         _hasWrittenThisPass = false;
@@ -183,7 +189,10 @@ namespace mongo {
     bool Client::shutdown() {
 #if defined(_DEBUG)
         {
-            if( sizeof(void*) == 8 ) {
+            // a connection serviced by a pool of threads (see MessageHandler::supportsDetach())
+            // may be shut down on a thread that never ran initThread(), or ran it for another
+            // client, so only check a stack that was set up for us
+            if( sizeof(void*) == 8 && checkerClient.get() == this ) {
                 StackChecker::check( desc() );
             }
         }
@@ -95,6 +95,8 @@ namespace mongo {
         void appendLastOp( BSONObjBuilder& b ) const;
 
         bool isGod() const { return _god; } /* this is for map/reduce writes */
+        /* index builds on this thread are foreground and drop dups, as in a repair */
+        bool isRepairIndexBuild() const { return _repairIndexBuild; }
         string toString() const;
         void gotHandshake( const BSONObj& o );
         BSONObj getRemoteID() const { return _remoteId; }
@@ -122,6 +124,7 @@ namespace mongo {
         bool _shutdown; // to track if Client::shutdown() gets called
         std::string _desc;
         bool _god;
+        bool _repairIndexBuild;
         OpTime _lastOp;
         BSONObj _handshake;
         BSONObj _remoteId;
@@ -143,6 +146,14 @@ namespace mongo {
             ~GodScope();
         };
 
+        /* set _repairIndexBuild=true temporarily, safely */
+        class RepairIndexBuildScope {
+            bool _prev;
+        public:
+            RepairIndexBuildScope();
+            ~RepairIndexBuildScope();
+        };
+
         //static void assureDatabaseIsOpen(const string& ns, string path=dbpath);
         
         /** "read lock, and set my context, all in one operation" 
@@ -242,6 +253,14 @@ namespace mongo {
     }
     inline Client::GodScope::~GodScope() { cc()._god = _prev; }
 
+    inline Client::RepairIndexBuildScope::RepairIndexBuildScope() {
+        _prev = cc()._repairIndexBuild;
+        cc()._repairIndexBuild = true;
+    }
+    inline Client::RepairIndexBuildScope::~RepairIndexBuildScope() {
+        cc()._repairIndexBuild = _prev;
+    }
+
 
     inline bool haveClient() { return currentClient.get() > 0; }
 
@@ -67,8 +67,9 @@ namespace mongo {
             if ( e.eoo() )
                 break;
 
-            // for now, skip the "v" field so that v:0 indexes will be upgraded to v:1
-            if ( string("v") == e.fieldName() ) {
+            // skip "v" for v:0 indexes so that they are upgraded to the default version; later
+            // versions, e.g. v:2 prefix compressed indexes, are kept as they are
+            if ( string("v") == e.fieldName() && e.numberInt() == 0 ) {
                 continue;
             }
 
@@ -94,13 +95,15 @@ namespace mongo {
         return res;
     }
 
-    Cloner::Cloner() { }
+    Cloner::Cloner() : _docsCloned(NULL) { }
 
     struct Cloner::Fun {
-        Fun() : lastLog(0), _sortersForIndex(NULL) { }
+        Fun() : lastLog(0), docsCloned(NULL), _sortersForIndex(NULL) { }
         time_t lastLog;
         void operator()( DBClientCursorBatchIterator &i ) {
-            Lock::GlobalWrite lk;
+            // only the collection, so that several collections of a database can be cloned at
+            // once (system.indexes locks the database)
+            Lock::DBWrite lk( to_collection, true );
             if ( context ) {
                 context->relocked();
             }
@@ -162,6 +165,9 @@ namespace mongo {
                     if ( logForRepl )
                         logOp("i", to_collection, js);
 
+                    if ( docsCloned )
+                        docsCloned->addAndFetch( 1 );
+
                     getDur().commitIfNeeded();
                 }
                 catch( UserException& e ) {
@@ -185,6 +191,7 @@ namespace mongo {
         Client::Context *context;
         bool _mayYield;
         bool _mayBeInterrupted;
+        AtomicInt64 *docsCloned;
         SortersForIndex *_sortersForIndex;  // sorters that build index keys during query
     };
 
@@ -210,6 +217,7 @@ namespace mongo {
         f._mayBeInterrupted = mayBeInterrupted;
 
         if (!isindex) {
+            f.docsCloned = _docsCloned;
             SortersForNS::iterator it = _sortersForNS.find(to_collection);
             if (it != _sortersForNS.end())
                 f._sortersForIndex = &it->second;
@@ -348,6 +356,7 @@ namespace mongo {
             *errCode = 0;
         }
         massert( 10289 ,  "useReplAuth is not written to replication log", !opts.useReplAuth || !opts.logForRepl );
+        _docsCloned = opts.docsCloned;
 
         string todb = cc().database()->name;
         stringstream a,b;
@@ -471,6 +480,10 @@ namespace mongo {
                 else {
                     LOG(2) << "\t\t not ignoring collection " << from_name << endl;
                 }
+                if( ! opts.collsToClone.empty() &&
+                    opts.collsToClone.find( string( from_name ) ) == opts.collsToClone.end() ){
+                    continue;
+                }
 
                 clonedColls.insert( from_name );
                 toClone.push_back( collection.getOwned() );
@@ -499,6 +512,10 @@ namespace mongo {
                 /* we defer building id index for performance - building it in batch is much faster */
                 userCreateNS(toname, options, err, opts.logForRepl, &wantIdIndex);
             }
+            if( opts.deferIdIndex ) {
+                // copied from system.indexes with the other indexes instead
+                wantIdIndex = false;
+            }
             LOG(1) << "\t\t cloning " << from_name << " -> " << to_name << endl;
             Query q;
             if( opts.snapshot )
@@ -538,8 +555,19 @@ namespace mongo {
             barr.append( opts.collsToIgnore );
             BSONArray arr = barr.arr();
             
-            // Also don't copy the _id_ index
-            BSONObj query = BSON( "name" << NE << "_id_" << "ns" << NIN << arr );
+            BSONObjBuilder queryBuilder;
+            // Also don't copy the _id_ index, unless the data pass left it out
+            if ( ! opts.deferIdIndex )
+                queryBuilder.append( "name", BSON( "$ne" << "_id_" ) );
+            if ( opts.collsToClone.empty() ) {
+                queryBuilder.append( "ns", BSON( "$nin" << arr ) );
+            }
+            else {
+                BSONArrayBuilder inArr;
+                inArr.append( opts.collsToClone );
+                queryBuilder.append( "ns", BSON( "$nin" << arr << "$in" << inArr.arr() ) );
+            }
+            BSONObj query = queryBuilder.obj();
             
             // won't need a snapshot of the query of system.indexes as there can never be very many.
             copy(system_indexes_from.c_str(), system_indexes_to.c_str(), true, opts.logForRepl, masterSameProcess, opts.slaveOk, opts.mayYield, opts.mayBeInterrupted, query );
@@ -20,6 +20,7 @@
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/sort_phase_one.h"
+#include "mongo/platform/atomic_word.h"
 
 namespace mongo {
 
@@ -106,6 +107,7 @@ namespace mongo {
         struct Fun;
         auto_ptr<DBClientBase> _conn;
         SortersForNS _sortersForNS;
+        AtomicInt64* _docsCloned;
     };
 
     struct CloneOptions {
@@ -120,6 +122,8 @@ namespace mongo {
 
             syncData = true;
             syncIndexes = true;
+            deferIdIndex = false;
+            docsCloned = NULL;
         }
             
         string fromDB;
@@ -134,6 +138,15 @@ namespace mongo {
 
         bool syncData;
         bool syncIndexes;
+
+        // if not empty, only these collections are cloned
+        set<string> collsToClone;
+
+        // leave the _id indexes out of the data pass, and build them with the other indexes
+        bool deferIdIndex;
+
+        // if set, counts the documents cloned
+        AtomicInt64* docsCloned;
     };
 
 } // namespace mongo
@@ -21,8 +21,11 @@
 #include "mongo/db/auth/action_set.h"
 #include "mongo/db/auth/action_type.h"
 #include "mongo/db/auth/privilege.h"
+#include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/cursor.h"
 #include "mongo/db/interrupt_status_mongod.h"
+#include "mongo/db/ops/query.h"
 #include "mongo/db/pipeline/accumulator.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/document_source.h"
@@ -30,9 +33,123 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/pipeline_d.h"
 #include "mongo/db/pipeline/pipeline.h"
+#include "mongo/util/paths.h"
 
 namespace mongo {
 
+    /**
+     * Presents the results of a Pipeline as a Cursor, so that they can be held in a ClientCursor
+     * and returned in batches through getMore.  Between batches the Pipeline's
+     * DocumentSourceCursor, if it has one, is suspended, so no lock is held while the client is
+     * away.
+     */
+    class PipelineCursor : public Cursor {
+    public:
+        PipelineCursor(const intrusive_ptr<Pipeline>& pipeline,
+                       const intrusive_ptr<DocumentSourceCursor>& source):
+            _pipeline(pipeline),
+            _source(source),
+            _output(pipeline->output()),
+            _unstarted(true),
+            _hasCurrent(false) {
+        }
+
+        virtual bool ok() {
+            if (_unstarted) {
+                _unstarted = false;
+                fetch(&DocumentSource::eof, true);
+            }
+            return _hasCurrent;
+        }
+
+        virtual bool advance() {
+            if (ok())
+                fetch(&DocumentSource::advance, false);
+            return _hasCurrent;
+        }
+
+        virtual BSONObj current() {
+            verify(_hasCurrent);
+            return _currentObj;
+        }
+
+        // The results aren't records in a collection, so they have no location.
+        virtual Record* _current() { return 0; }
+        virtual DiskLoc currLoc() { return DiskLoc(); }
+        virtual DiskLoc refLoc() { return DiskLoc(); }
+
+        virtual bool supportGetMore() { return true; }
+
+        // The pipeline's own source yields while it runs; this cursor is only suspended and
+        // resumed between batches, through noteLocation() and checkLocation().
+        virtual bool supportYields() { return false; }
+
+        virtual void noteLocation() {
+            if (_source)
+                _source->suspend();
+        }
+
+        virtual void checkLocation() {
+            if (_source)
+                guard(&DocumentSourceCursor::resume);
+        }
+
+        virtual string toString() { return "PipelineCursor"; }
+        virtual bool getsetdup(DiskLoc loc) { return false; }
+        virtual bool isMultiKey() const { return false; }
+        virtual bool modifiedKeys() const { return false; }
+        virtual long long nscanned() { return 0; }
+
+    private:
+        /* run step on the output source, and pick up the Document it leaves there */
+        void fetch(bool (DocumentSource::*step)(), bool stepMeansEof) {
+            try {
+                bool more = (_output->*step)();
+                _hasCurrent = stepMeansEof ? !more : more;
+                if (_hasCurrent) {
+                    BSONObjBuilder builder;
+                    _output->getCurrent()->toBson(&builder);
+                    _currentObj = builder.obj();
+                }
+                else {
+                    _currentObj = BSONObj();
+                }
+            }
+            catch (...) {
+                fail();
+                throw;
+            }
+        }
+
+        void guard(void (DocumentSourceCursor::*step)()) {
+            try {
+                (_source.get()->*step)();
+            }
+            catch (...) {
+                fail();
+                throw;
+            }
+        }
+
+        /*
+          Release the pipeline's Cursor while the caller's lock is still
+          held; the ClientCursor holding this is about to be erased.
+         */
+        void fail() {
+            _unstarted = false;
+            _hasCurrent = false;
+            _currentObj = BSONObj();
+            _output->dispose();
+        }
+
+        intrusive_ptr<Pipeline> _pipeline;
+        intrusive_ptr<DocumentSourceCursor> _source;
+        DocumentSource* _output;
+        bool _unstarted;
+        bool _hasCurrent;
+        BSONObj _currentObj;
+    };
+
     class PipelineCommand :
         public Command {
     public:
@@ -42,7 +159,10 @@ namespace mongo {
         virtual LockType locktype() const { return NONE; }
         virtual bool slaveOk() const { return true; }
         virtual void help(stringstream &help) const {
-            help << "{ pipeline : [ { <data-pipe-op>: {...}}, ... ] }";
+            help << "{ pipeline : [ { <data-pipe-op>: {...}}, ... ], allowDiskUsage : <bool>,"
+                    " cursor : { batchSize : <n> } }\n"
+                    "with cursor, results are returned as { cursor : { id, ns, firstBatch } }"
+                    " and the rest are read with getMore";
         }
 
         virtual void addRequiredPrivileges(const std::string& dbname,
@@ -58,6 +178,7 @@ namespace mongo {
 
             intrusive_ptr<ExpressionContext> pCtx =
                 ExpressionContext::create(&InterruptStatusMongod::status);
+            pCtx->setTempDir(dbpath + "/_tmp");
 
             /* try to parse the command; if this fails, then we didn't run */
             intrusive_ptr<Pipeline> pPipeline = Pipeline::parseCommand(errmsg, cmdObj, pCtx);
@@ -89,11 +210,70 @@ namespace mongo {
 #endif
 
             // This does the mongod-specific stuff like creating a cursor
-            PipelineD::prepareCursorSource(pPipeline, nsToDatabase(ns), pCtx);
+            intrusive_ptr<DocumentSourceCursor> pSource =
+                PipelineD::prepareCursorSource(pPipeline, nsToDatabase(ns), pCtx);
+
+            if (pPipeline->isCursorCommand() && !pPipeline->isExplain())
+                return runCursorCommand(ns, cmdObj, pPipeline, pSource, pCtx, result);
+
             return pPipeline->run(result, errmsg);
         }
 
     private:
+        /*
+          Return the first batch of the pipeline's results, and if there are
+          more, keep the pipeline in a ClientCursor for getMore.
+         */
+        bool runCursorCommand(const string& ns, const BSONObj& cmdObj,
+                              const intrusive_ptr<Pipeline>& pPipeline,
+                              const intrusive_ptr<DocumentSourceCursor>& pSource,
+                              const intrusive_ptr<ExpressionContext>& pCtx,
+                              BSONObjBuilder& result) {
+            pPipeline->stitch();
+            shared_ptr<PipelineCursor> cursor(new PipelineCursor(pPipeline, pSource));
+
+            // Fill the batch the way a getMore would; a document that doesn't fit is left
+            // current in the cursor for the next getMore.
+            const int batchSize = pPipeline->getBatchSize();
+            BSONArrayBuilder firstBatch;
+            int n = 0;
+            for (; cursor->ok(); cursor->advance()) {
+                if (batchSize && n >= batchSize)
+                    break;
+
+                BSONObj next = cursor->current();
+                if (n && firstBatch.len() + next.objsize() > MaxBytesToReturnToClientAtOnce)
+                    break;
+
+                firstBatch.append(next);
+                n++;
+            }
+
+            CursorId id = 0;
+            if (cursor->ok()) {
+                {
+                    Client::ReadContext ctx(ns);
+                    ClientCursor* cc = new ClientCursor(0, cursor, ns, cmdObj.getOwned());
+                    id = cc->cursorid();
+                }
+
+                // Releases the read lock the pipeline's DocumentSourceCursor holds.
+                cursor->noteLocation();
+            }
+
+            BSONObjBuilder cursorObj(result.subobjStart("cursor"));
+            cursorObj.append("id", id);
+            cursorObj.append("ns", ns);
+            cursorObj.append("firstBatch", firstBatch.arr());
+            cursorObj.done();
+
+            if (pCtx->getSpilledBytes()) {
+                result.appendNumber("spilledBytes", pCtx->getSpilledBytes());
+            }
+
+            return true;
+        }
+
         /*
           Execute the pipeline for the explain.  This is common to both the
           locked and unlocked code path.  However, the results are different.
@@ -141,6 +321,7 @@ namespace mongo {
             /* on the shard servers, create the local pipeline */
             intrusive_ptr<ExpressionContext> pShardCtx(
                 ExpressionContext::create(&InterruptStatusMongod::status));
+            pShardCtx->setTempDir(dbpath + "/_tmp");
             intrusive_ptr<Pipeline> pShardPipeline(
                 Pipeline::parseCommand(errmsg, shardBson, pShardCtx));
             if (!pShardPipeline.get()) {
@@ -0,0 +1,122 @@
+// @file plan_cache.cpp - The planCache command, for inspecting and pinning cached query plans.
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/pch.h"
+
+#include <string>
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/namespace_details.h"
+#include "mongo/db/query_optimizer_internal.h"
+#include "mongo/db/queryutil.h"
+
+namespace mongo {
+
+    /**
+     * { planCache: <collection> }
+     *     lists the collection's cached plans and the cache's counters
+     * { planCache: <collection>, pin: <query>, sort: <sort>, index: <key pattern> }
+     *     makes the index, or { $natural: 1 }, the plan for queries of the shape of <query>
+     * { planCache: <collection>, unpin: <query>, sort: <sort> }
+     * { planCache: <collection>, clear: true }
+     *     drops every cached plan, pinned or not
+     */
+    class PlanCacheCmd : public Command {
+    public:
+        PlanCacheCmd() : Command("planCache") {}
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool logTheOp() { return false; }
+        virtual LockType locktype() const { return READ; }
+
+        virtual void help(stringstream& h) const {
+            h << "list, pin or clear the query plans cached for a collection\n"
+                 "{ planCache: <collection> } lists the plans, most recently used first\n"
+                 "{ planCache: <collection>, pin: <query>, sort: <sort>, index: <key pattern> }\n"
+                 "{ planCache: <collection>, unpin: <query>, sort: <sort> }\n"
+                 "{ planCache: <collection>, clear: true }\n"
+                 "the plan cache is per server, and pins are lost when the collection's indexes "
+                 "change or the server restarts";
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::planCache);
+            out->push_back(Privilege(parseNs(dbname, cmdObj), actions));
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg,
+                 BSONObjBuilder& result, bool fromRepl) {
+            string ns = parseNs(dbname, cmdObj);
+            NamespaceDetails* d = nsdetails(ns);
+            if (!d) {
+                errmsg = "ns not found";
+                return false;
+            }
+
+            BSONElement sort = cmdObj["sort"];
+            if (!sort.eoo() && sort.type() != Object) {
+                errmsg = "sort must be an object";
+                return false;
+            }
+            BSONObj order = sort.eoo() ? BSONObj() : sort.Obj();
+
+            if (cmdObj["pin"].ok()) {
+                BSONElement query = cmdObj["pin"];
+                BSONElement index = cmdObj["index"];
+                if (query.type() != Object || index.type() != Object || index.Obj().isEmpty()) {
+                    errmsg = "pin must be a query, and index the key pattern of an index";
+                    return false;
+                }
+                FieldRangeSetPair frsp(ns.c_str(), query.Obj());
+                if (!QueryUtilIndexed::pinIndexForPatterns(d, frsp, query.Obj(), order,
+                                                           index.Obj(), errmsg)) {
+                    return false;
+                }
+            }
+            else if (cmdObj["unpin"].ok()) {
+                BSONElement query = cmdObj["unpin"];
+                if (query.type() != Object) {
+                    errmsg = "unpin must be a query";
+                    return false;
+                }
+                FieldRangeSetPair frsp(ns.c_str(), query.Obj());
+                if (!QueryUtilIndexed::unpinIndexForPatterns(frsp, order)) {
+                    errmsg = "no plan is pinned for this query";
+                    return false;
+                }
+            }
+            else if (cmdObj["clear"].trueValue()) {
+                SimpleMutex::scoped_lock lk(NamespaceDetailsTransient::_qcMutex);
+                NamespaceDetailsTransient::get_inlock(ns).clearQueryCache();
+            }
+
+            SimpleMutex::scoped_lock lk(NamespaceDetailsTransient::_qcMutex);
+            NamespaceDetailsTransient::get_inlock(ns).queryPlanCache().appendStats(result);
+            return true;
+        }
+    } planCacheCmd;
+
+} // namespace mongo
@@ -27,6 +27,7 @@
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/util/net/listen.h"
+#include "mongo/util/net/message_compression.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/ramlog.h"
 #include "mongo/util/version.h"
@@ -314,6 +315,7 @@ namespace mongo {
             BSONObj generateSection(const BSONElement& configElement) const {
                 BSONObjBuilder b;
                 networkCounter.append( b );
+                appendMessageCompressionStats( &b );
                 return b.obj();
             }
                 
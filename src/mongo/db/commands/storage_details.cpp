@@ -41,7 +41,8 @@ namespace {
      */
     enum SubCommand {
         SUBCMD_DISK_STORAGE,
-        SUBCMD_PAGES_IN_RAM
+        SUBCMD_PAGES_IN_RAM,
+        SUBCMD_FREE_SPACE
     };
 
     /**
@@ -295,7 +296,10 @@ namespace {
               << "Provides detailed and aggregate information regarding record and deleted record "
               << "layout in storage files ({analyze: 'diskStorage'}) and percentage of pages "
               << "currently in RAM ({analyze: 'pagesInRAM'}). Slow if run on large collections. "
-              << "Select the desired subcommand with {analyze: 'diskStorage' | 'pagesInRAM'}; "
+              << "{analyze: 'freeSpace'} reports the deleted records by size class, their "
+              << "fragmentation and the time taken to allocate from them. "
+              << "Select the desired subcommand with "
+              << "{analyze: 'diskStorage' | 'pagesInRAM' | 'freeSpace'}; "
               << "specify {extent: num_} and, optionally, {range: [start, end]} to restrict "
               << "processing to a single extent (start and end are offsets from the beginning of "
               << "the extent. {granularity: bytes} or {numberOfSlices: num_} enable aggregation of "
@@ -697,6 +701,8 @@ namespace {
                 return analyzeDiskStorage(nsd, ex, params, errmsg, outputBuilder);
             case SUBCMD_PAGES_IN_RAM:
                 return analyzePagesInRAM(ex, params, errmsg, outputBuilder);
+            case SUBCMD_FREE_SPACE:
+                break; // per collection, not per extent
         }
         verify(false && "unreachable");
     }
@@ -748,7 +754,8 @@ namespace {
         return true;
     }
 
-    static const char* USE_ANALYZE_STR = "use {analyze: 'diskStorage' | 'pagesInRAM'}";
+    static const char* USE_ANALYZE_STR =
+            "use {analyze: 'diskStorage' | 'pagesInRAM' | 'freeSpace'}";
 
     bool StorageDetailsCmd::run(const string& dbname, BSONObj& cmdObj, int, string& errmsg,
                                 BSONObjBuilder& result, bool fromRepl) {
@@ -768,6 +775,9 @@ namespace {
         else if (str::equals(subCommandStr, "pagesInRAM")) {
             subCommand = SUBCMD_PAGES_IN_RAM;
         }
+        else if (str::equals(subCommandStr, "freeSpace")) {
+            subCommand = SUBCMD_FREE_SPACE;
+        }
         else {
             errmsg = str::stream() << subCommandStr << " is not a valid subcommand, "
                                                     << USE_ANALYZE_STR;
@@ -784,6 +794,16 @@ namespace {
             return false;
         }
 
+        if (subCommand == SUBCMD_FREE_SPACE) {
+            if (nsd->isCapped()) {
+                errmsg = "capped collections reuse space in insertion order, use "
+                         "{analyze: 'diskStorage'}";
+                return false;
+            }
+            nsdetails(ns)->appendFreeSpaceStats(ns.c_str(), &result, true);
+            return true;
+        }
+
         const Extent* extent = NULL;
 
         // { extent: num }
@@ -28,6 +28,7 @@
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/privilege.h"
 #include "mongo/db/background.h"
+#include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/curop-inl.h"
@@ -37,6 +38,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/sort_phase_one.h"
 #include "mongo/util/concurrency/task.h"
 #include "mongo/util/timer.h"
@@ -46,6 +48,9 @@ namespace mongo {
 
     void freeExtents(DiskLoc firstExt, DiskLoc lastExt);
 
+    // from d_migrate.cpp
+    void logOpForSharding( const char * opstr , const char * ns , const BSONObj& obj , BSONObj * patt );
+
     /* this should be done in alloc record not here, but doing here for now. 
        really dumb; it's a start.
     */
@@ -107,6 +112,14 @@ namespace mongo {
                         oldObjSize += sz;
                         oldObjSizeWithPadding += recOld->netLength();
 
+                        const char* stored = objOld.objdata();
+                        std::string compressed;
+                        if ( d->isUserFlagSet( NamespaceDetails::Flag_CompressRecords ) &&
+                             compressRecordData( objOld, &compressed ) ) {
+                            stored = compressed.data();
+                            sz = compressed.size();
+                        }
+
                         unsigned lenWHdr = sz + Record::HeaderSize;
                         unsigned lenWPadding = lenWHdr;
                         {
@@ -123,7 +136,7 @@ namespace mongo {
                         datasize += recNew->netLength();
                         recNew = (Record *) getDur().writingPtr(recNew, lenWHdr);
                         addRecordToRecListInExtent(recNew, loc);
-                        memcpy(recNew->data(), objOld.objdata(), sz);
+                        memcpy(recNew->data(), stored, sz);
 
                         {
                             // extract keys for all indexes we will be rebuilding
@@ -243,6 +256,7 @@ namespace mongo {
         for( int i = 0; i < Buckets; i++ ) { 
             d->deletedList[i].writing().Null();
         }
+        NamespaceDetailsTransient::get(ns).freeSpaceMap().reset();
 
 
 
@@ -338,6 +352,265 @@ namespace mongo {
         return ok;
     }
 
+    /**
+     * The most records an online compact moves out of an extent in one hold of the write lock.
+     */
+    MONGO_EXPORT_SERVER_PARAMETER(onlineCompactBatchSize, int, 100);
+
+    /**
+     * How long an online compact waits for the cursors open on its collection to finish before
+     * it gives up with an error.
+     */
+    MONGO_EXPORT_SERVER_PARAMETER(onlineCompactCursorWaitSecs, int, 600);
+
+    namespace {
+
+    /* marks the extent an online compact is emptying, so space freed in it stays off the deleted
+       lists.  see NamespaceDetailsTransient::compactingExtent().  the mark is cleared however the
+       compact ends; must be destroyed in the write lock.
+    */
+    class CompactingExtent : boost::noncopyable {
+    public:
+        CompactingExtent(const char *ns) : _ns(ns) { }
+        ~CompactingExtent() { clear(); }
+
+        /* take ext's deleted records off the lists and mark it */
+        void set(NamespaceDetails *d, const DiskLoc& ext) {
+            d->unlinkDeletedInExtent(_ns, ext);
+            NamespaceDetailsTransient::get(_ns).setCompactingExtent(ext);
+            _ext = ext;
+        }
+
+        /* put the space of the record at dloc, deleted while the extent was marked, back on the
+           deleted lists */
+        void giveBack(NamespaceDetails *d, const DiskLoc& dloc) {
+            NamespaceDetailsTransient::get(_ns).setCompactingExtent(DiskLoc());
+            d->addDeletedRec(_ns, dloc.drec(), dloc);
+            NamespaceDetailsTransient::get(_ns).setCompactingExtent(_ext);
+        }
+
+        /* the mark is only in memory: it's gone if the collection's transient state was reset */
+        bool lost() const {
+            return NamespaceDetailsTransient::get(_ns).compactingExtent() != _ext;
+        }
+
+        void clear() {
+            if( _ext.isNull() )
+                return;
+            NamespaceDetailsTransient::get(_ns).setCompactingExtent(DiskLoc());
+            _ext.Null();
+        }
+
+        const DiskLoc& ext() const { return _ext; }
+
+    private:
+        const char *_ns;
+        DiskLoc _ext;
+    };
+
+    /* unlink the emptied extent ext from the extent chain of d and add it to the free list */
+    void freeEmptiedExtent(NamespaceDetails *d, const DiskLoc& ext) {
+        Extent *e = ext.ext();
+        verify( e->firstRecord.isNull() );
+        verify( d->firstExtent != d->lastExtent );
+        if( e->xprev.isNull() )
+            d->firstExtent.writing() = e->xnext;
+        else
+            getDur().writingDiskLoc(e->xprev.ext()->xnext) = e->xnext;
+        if( e->xnext.isNull() )
+            d->lastExtent.writing() = e->xprev;
+        else
+            getDur().writingDiskLoc(e->xnext.ext()->xprev) = e->xprev;
+        e = getDur().writing(e);
+        e->xprev.Null();
+        e->xnext.Null();
+        e->markEmpty();
+        freeExtents( ext, ext );
+    }
+
+    /* @return the length with headers insert() allocates for the document of record r when an
+       online compact moves it
+    */
+    int moveAllocSize(NamespaceDetails *d, const Record *r) {
+        const int *data = reinterpret_cast<const int*>(r->data());
+        int len = data[0];
+        if( r->isCompressed() ) {
+            // recompressing the same document gives the same compressed length
+            len = d->isUserFlagSet(NamespaceDetails::Flag_CompressRecords) ?
+                  2 * sizeof(int) + data[1] : BSONObj::make(r).objsize();
+        }
+        return d->getRecordAllocationSize(len + Record::HeaderSize);
+    }
+
+    /* online compact: empty the extents of ns one at a time, last first, moving their records
+       into free space elsewhere a batch per hold of the write lock and yielding in between.
+       a move is the delete and reinsert an update does when a document outgrows its record, so
+       indexes are kept right as it goes.  a scan could miss a moved document though, as it may
+       land behind the scan's position, so a batch is only moved while no cursor is open on ns;
+       otherwise we yield until they're done.  that covers a clone cursor of an initial sync
+       too, which is why the moves needn't be in the oplog: they don't change any document.  we
+       give up if the cursors don't finish within onlineCompactCursorWaitSecs.
+       an extent is left alone unless the deleted records outside it can hold each of its
+       records, so the moves never allocate a new extent, and the first extent is always kept.
+       as free space can be taken while we yield, each move first checks there's still a deleted
+       record to take the document, and fails the compact before deleting anything if not.
+    */
+    bool compactOnline(const string& ns, string &errmsg, BSONObjBuilder& result) {
+        massert( 16770, "bad ns", NamespaceString::normal(ns.c_str()) );
+        massert( 16771, "can't compact a system namespace", !str::contains(ns, ".system.") );
+
+        Lock::DBWrite lk(ns);
+        BackgroundOperation::assertNoBgOpInProgForNs(ns.c_str());
+        Client::Context ctx(ns);
+        NamespaceDetails *d = nsdetails(ns);
+        uassert( 16772, str::stream() << "namespace " << ns << " does not exist", d );
+        uassert( 16773, "cannot compact capped collection", !d->isCapped() );
+
+        // keeps drops and index builds off ns while we yield
+        BackgroundOperation bgop(ns.c_str());
+
+        vector<DiskLoc> extents;
+        for( DiskLoc L = d->firstExtent; !L.isNull(); L = L.ext()->xnext )
+            extents.push_back(L);
+        log() << "compact " << ns << " online begin, " << extents.size() << " extents" << endl;
+
+        long long bytesReclaimed = 0;
+        long long recordsMoved = 0;
+        int extentsFreed = 0;
+        if( extents.size() > 1 ) {
+            CurOp *op = cc().curop();
+            ProgressMeterHolder pm(op->setMessage("compact online: 0 bytes reclaimed",
+                                                  "Online Compact Extents",
+                                                  extents.size() - 1));
+            CompactingExtent compacting(ns.c_str());
+            try {
+                for( vector<DiskLoc>::reverse_iterator i = extents.rbegin();
+                     i + 1 != extents.rend(); ++i ) {
+                    const DiskLoc ext = *i;
+                    vector<int> lens;
+                    for( DiskLoc L = ext.ext()->firstRecord; !L.isNull(); L = L.rec()->nextInExtent(L) )
+                        lens.push_back(moveAllocSize(d, L.rec()));
+                    if( !d->allocsFitOutsideExtent(ns.c_str(), ext, lens) ) {
+                        log() << "compact online skipping extent " << ext.toString() << ", the "
+                              << lens.size() << " records in it don't fit in the free space "
+                              << "elsewhere" << endl;
+                        pm.hit();
+                        continue;
+                    }
+
+                    const int length = ext.ext()->length;
+                    compacting.set(d, ext);
+                    Timer waiting;
+                    while( 1 ) {
+                        if( compacting.lost() )
+                            compacting.set(d, ext);
+
+                        set<CursorId> open;
+                        ClientCursor::find(ns, open);
+                        if( !open.empty() ) {
+                            uassert( 16781, str::stream() << "compact online gave up after waiting "
+                                            << onlineCompactCursorWaitSecs << " secs for "
+                                            << open.size() << " cursors on " << ns << " to finish",
+                                     waiting.seconds() < onlineCompactCursorWaitSecs );
+                            string msg = str::stream() << "compact online: waiting for "
+                                                       << open.size() << " cursors to finish";
+                            op->setMessageText(msg.c_str());
+                            ClientCursor::staticYield(10 * 1000, ns, NULL);
+                            d = nsdetails(ns);
+                            massert( 16778, str::stream() << "namespace " << ns
+                                            << " went away during compact", d );
+                            continue;
+                        }
+
+                        for( int n = 0; n < onlineCompactBatchSize; n++ ) {
+                            DiskLoc L = ext.ext()->firstRecord;
+                            if( L.isNull() )
+                                break;
+                            Record *r = L.rec();
+                            // the record freed by the delete stays off the deleted lists, so the
+                            // insert takes the deleted record allocWillBeAt() finds now
+                            DiskLoc to = d->allocWillBeAt(ns.c_str(), moveAllocSize(d, r));
+                            uassert( 16782, str::stream() << "compact online stopped, no free "
+                                            "space left outside extent " << ext.toString()
+                                            << " for a record", !to.isNull() );
+                            BSONObj o = BSONObj::make(r).getOwned();
+                            theDataFileMgr.deleteRecord(d, ns.c_str(), r, L);
+                            try {
+                                theDataFileMgr.insert(ns.c_str(), o.objdata(), o.objsize());
+                            }
+                            catch(...) {
+                                // the delete stands, so put the document back in its own space
+                                // rather than lose it
+                                compacting.giveBack(d, L);
+                                try {
+                                    theDataFileMgr.insert(ns.c_str(), o.objdata(), o.objsize());
+                                }
+                                catch(...) {
+                                    error() << "compact online couldn't put back " << o.toString()
+                                            << endl;
+                                    throw;
+                                }
+                                throw;
+                            }
+                            // deleting the record took it off a chunk migration's clone list, so
+                            // have the migration reload the document from its new place
+                            logOpForSharding("i", ns.c_str(), o, NULL);
+                            recordsMoved++;
+                            getDur().commitIfNeeded();
+                        }
+
+                        if( ext.ext()->firstRecord.isNull() )
+                            break;
+                        waiting.reset();
+
+                        string msg = str::stream() << "compact online: " << bytesReclaimed
+                                                   << " bytes reclaimed";
+                        op->setMessageText(msg.c_str());
+                        ClientCursor::staticYield(ClientCursor::suggestYieldMicros(), ns, NULL);
+                        d = nsdetails(ns);
+                        massert( 16774, str::stream() << "namespace " << ns
+                                        << " went away during compact", d );
+                    }
+
+                    freeEmptiedExtent(d, ext);
+                    compacting.clear();
+                    bytesReclaimed += length;
+                    extentsFreed++;
+                    getDur().commitIfNeeded();
+
+                    pm.hit();
+                    string msg = str::stream() << "compact online: " << bytesReclaimed
+                                               << " bytes reclaimed";
+                    op->setMessageText(msg.c_str());
+
+                    ClientCursor::staticYield(ClientCursor::suggestYieldMicros(), ns, NULL);
+                    d = nsdetails(ns);
+                    massert( 16775, str::stream() << "namespace " << ns
+                                    << " went away during compact", d );
+                }
+            }
+            catch(...) {
+                if( !compacting.ext().isNull() ) {
+                    // the space already freed in it stays orphaned until an offline compact
+                    warning() << "compact online stopped part way through extent "
+                              << compacting.ext().toString() << endl;
+                }
+                log() << "compact " << ns << " online end (with error)" << endl;
+                throw;
+            }
+            pm.finished();
+        }
+
+        result.appendNumber("recordsMoved", recordsMoved);
+        result.append("extentsFreed", extentsFreed);
+        result.appendNumber("bytesReclaimed", bytesReclaimed);
+        log() << "compact " << ns << " online end, " << extentsFreed << " extents freed, "
+              << bytesReclaimed << " bytes reclaimed" << endl;
+        return true;
+    }
+
+    } // namespace
+
     bool isCurrentlyAReplSetPrimary();
 
     class CompactCmd : public Command {
@@ -358,8 +631,12 @@ namespace mongo {
             help << "compact collection\n"
                 "warning: this operation blocks the server and is slow. you can cancel with cancelOp()\n"
                 "{ compact : <collection_name>, [force:<bool>], [validate:<bool>],\n"
-                "  [paddingFactor:<num>], [paddingBytes:<num>] }\n"
+                "  [paddingFactor:<num>], [paddingBytes:<num>], [online:<bool>] }\n"
                 "  force - allows to run on a replica set primary\n"
+                "  online - move records out of the collection's extents a few at a time, yielding in between,\n"
+                "           and free the extents emptied. may run on a primary; the other options don't apply.\n"
+                "           records are only moved while no cursor is open on the collection, and it fails if\n"
+                "           they aren't all closed within onlineCompactCursorWaitSecs\n"
                 "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (defaults to true in this version)\n";
         }
         CompactCmd() : Command("compact") { }
@@ -371,7 +648,8 @@ namespace mongo {
                 return false;
             }
 
-            if( isCurrentlyAReplSetPrimary() && !cmdObj["force"].trueValue() ) { 
+            bool online = cmdObj["online"].trueValue();
+            if( !online && isCurrentlyAReplSetPrimary() && !cmdObj["force"].trueValue() ) { 
                 errmsg = "will not run compact on an active replica set primary as this is a slow blocking operation. use force:true to force";
                 return false;
             }
@@ -403,6 +681,9 @@ namespace mongo {
                 }
             }
 
+            if( online )
+                return compactOnline(ns, errmsg, result);
+
             double pf = 1.0;
             int pb = 0;
             if( cmdObj.hasElement("paddingFactor") ) {
@@ -227,6 +227,8 @@ namespace mongo {
                                   unsigned long long progressMeterTotal = 0,
                                   int secondsBetween = 3);
         string getMessage() const { return _message.toString(); }
+        /** change the message text, leaving any progress meter running */
+        void setMessageText(const char * msg) { _message = msg; }
         ProgressMeter& getProgressMeter() { return _progressMeter; }
         CurOp *parent() const { return _wrapped; }
         void kill(bool* pNotifyFlag = NULL); 
@@ -32,6 +32,8 @@
 #include "dur.h"
 #include "lockstat.h"
 #include "mongo/db/commands/server_status.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/top.h"
 
 // oplog locking
 // no top level read locks
@@ -51,6 +53,10 @@ namespace mongo {
 
     static const bool DB_LEVEL_LOCKING_ENABLED = ( ( MONGOD_CONCURRENCY_LEVEL ) >= MONGOD_CONCURRENCY_LEVEL_DB );
 
+    // Whether writers that ask for it lock just a collection and not its whole database.  May be
+    // changed at runtime; each lock acquisition decides for itself.
+    MONGO_EXPORT_SERVER_PARAMETER(collectionLevelLocking, bool, true);
+
     inline LockState& lockState() { 
         return cc().lockState();
     }
@@ -86,6 +92,11 @@ namespace mongo {
     typedef mapsf< StringMap<WrapperForRWLock*> > DBLocksMap;
     static DBLocksMap dblocks;
 
+    /* full ns->lock, for writers holding their database's lock in intent mode.  Like the database
+       locks these are never deleted.
+    */
+    static DBLocksMap collectionLocks;
+
     /* we don't want to touch dblocks too much as a mutex is involved.  thus party for that, 
        this is here...
     */
@@ -258,9 +269,21 @@ namespace mongo {
             msgasserted(16105, str::stream() << "expected to be write locked for " << ns);
         }
     }
+    void Lock::assertWholeDBWriteLocked(const StringData& ns) {
+        assertWriteLocked(ns);
+        LockState &ls = lockState();
+        if( ls.collectionLock() && nsToDatabaseSubstring(ns) == ls.otherName() ) {
+            ls.dump();
+            msgasserted(16755, str::stream() << "expected " << ns << "'s database to be write "
+                        "locked, but only " << ls.collectionName() << " is");
+        }
+    }
     bool Lock::dbLevelLockingEnabled() {
         return DB_LEVEL_LOCKING_ENABLED;
     }
+    bool Lock::collectionLevelLockingEnabled() {
+        return DB_LEVEL_LOCKING_ENABLED && collectionLevelLocking;
+    }
 
     RWLockRecursive &Lock::ParallelBatchWriterMode::_batchLock = *(new RWLockRecursive("special"));
     void Lock::ParallelBatchWriterMode::iAmABatchParticipant() {
@@ -301,6 +324,7 @@ namespace mongo {
         _timer.reset();
         _stat = stat;
         cc().curop()->lockStat().recordAcquireTimeMicros( _type , acquisitionTime );
+        _acquired( acquisitionTime );
         return acquisitionTime;
     }
 
@@ -557,6 +581,7 @@ namespace mongo {
         _locked_W=false;
         _locked_w=false; 
         _weLocked=0;
+        _collectionLock=0;
 
 
         massert( 16186 , "can't get a DBWrite while having a read lock" , ! ls.hasAnyReadLock() );
@@ -565,6 +590,11 @@ namespace mongo {
 
         if (DB_LEVEL_LOCKING_ENABLED) {
             StringData db = nsToDatabaseSubstring( ns );
+            // holding one collection of a database says nothing about the rest of it
+            massert( 16754 , str::stream() << "can't lock " << ns << " while only "
+                             << ls.collectionName() << " is locked" ,
+                     ls.collectionLock() == 0 || db != ls.otherName() ||
+                     ns == ls.collectionName() );
             Nestable nested = n(db);
             if( nested == admin ) { 
                 // we can't nestedly lock both admin and local as implemented. so lock_W.
@@ -572,7 +602,7 @@ namespace mongo {
                 _locked_W = true;
                 return;
             } 
-            if( !nested )
+            if( !nested && !lockCollection(ns) )
                 lockOther(db);
             lockTop(ls);
             if( nested )
@@ -596,6 +626,9 @@ namespace mongo {
             return;
         if (DB_LEVEL_LOCKING_ENABLED) {
             StringData db = nsToDatabaseSubstring(ns);
+            massert( 16758 , str::stream() << "can't read " << ns << " while only "
+                             << ls.collectionName() << " is locked" ,
+                     ls.collectionLock() == 0 || db != ls.otherName() || ls.isLocked( ns ) );
             Nestable nested = n(db);
             if( !nested )
                 lockOther(db);
@@ -610,7 +643,14 @@ namespace mongo {
     }
 
     Lock::DBWrite::DBWrite( const StringData& ns )
-        : ScopedLock( 'w' ), _what(ns.toString()), _nested(false) {
+        : ScopedLock( 'w' ), _collectionLock(0), _what(ns.toString()), _nested(false),
+          _collectionOnly(false) {
+        lockDB( _what );
+    }
+
+    Lock::DBWrite::DBWrite( const StringData& ns, bool collectionOnly )
+        : ScopedLock( 'w' ), _collectionLock(0), _what(ns.toString()), _nested(false),
+          _collectionOnly(collectionOnly) {
         lockDB( _what );
     }
 
@@ -635,7 +675,14 @@ namespace mongo {
             else
                 lockState().unlockedOther();
     
-            _weLocked->unlock();
+            if( _collectionLock ) {
+                _collectionLock->stats.recordLockTimeMicros( 'W', _collectionTimer.micros() );
+                _collectionLock->unlock();
+                _weLocked->unlock_intent();
+            }
+            else {
+                _weLocked->unlock();
+            }
         }
 
         if( _locked_w ) {
@@ -649,6 +696,7 @@ namespace mongo {
             qlk.unlock_W();
         }
         _weLocked = 0;
+        _collectionLock = 0;
         _locked_W = _locked_w = false;
     }
     void Lock::DBRead::unlockDB() {
@@ -674,6 +722,61 @@ namespace mongo {
         _locked_r = false;
     }
 
+    bool Lock::DBWrite::lockCollection(const string& ns) {
+        LockState& ls = lockState();
+        if( !_collectionOnly || !collectionLevelLocking || ls.otherCount() )
+            return false;
+        // a bare database name, and system and $ namespaces, need the whole database
+        if( ns.find( '.' ) == string::npos || NamespaceString::special( ns.c_str() ) )
+            return false;
+
+        StringData db = nsToDatabaseSubstring( ns );
+        massert(16756, str::stream() << "can't dblock:" << db << " when local or admin is already locked", ls.nestableCount() == 0);
+
+        WrapperForRWLock* dbLock;
+        {
+            DBLocksMap::ref r(dblocks);
+            WrapperForRWLock*& lock = r[db];
+            if( lock == 0 )
+                lock = new WrapperForRWLock(db);
+            dbLock = lock;
+        }
+        WrapperForRWLock* collectionLock;
+        {
+            DBLocksMap::ref r(collectionLocks);
+            WrapperForRWLock*& lock = r[ns];
+            if( lock == 0 )
+                lock = new WrapperForRWLock(ns);
+            collectionLock = lock;
+        }
+        ls.lockedOther( db , 1 , dbLock );
+        ls.lockedCollection( ns , collectionLock );
+
+        fassert(16757,_weLocked==0);
+        dbLock->lock_intent();
+        _weLocked = dbLock;
+
+        // The collection is locked before the global 'w' lock (in lockTop), so that no one holding
+        // 'w' ever waits on a collection lock.  A journal commit upgrading from 'w' (see
+        // UpgradeToExclusive) would otherwise wait on us while we waited on its collection.
+        Timer t;
+        collectionLock->lock();
+        collectionLock->stats.recordAcquireTimeMicros( 'W', t.micros() );
+        _collectionLock = collectionLock;
+        _collectionTimer.reset();
+        return true;
+    }
+
+    void Lock::DBWrite::_acquired( long long micros ) {
+        if( _what.find( '.' ) != string::npos )
+            Top::global.recordLockWait( _what, 1, micros );
+    }
+
+    void Lock::DBRead::_acquired( long long micros ) {
+        if( _what.find( '.' ) != string::npos )
+            Top::global.recordLockWait( _what, -1, micros );
+    }
+
     void Lock::DBWrite::lockTop(LockState& ls) { 
         switch( ls.threadState() ) { 
         case 'w':
@@ -851,10 +954,30 @@ namespace mongo {
             b.append(".", qlk.stats.report());
             b.append("admin", nestableLocks[Lock::admin]->stats.report());
             b.append("local", nestableLocks[Lock::local]->stats.report());
+
+            map<string, BSONObj> collections; // sorted so each database's are together
+            {
+                DBLocksMap::ref r(collectionLocks);
+                for( DBLocksMap::const_iterator i = r.r.begin(); i != r.r.end(); ++i ) {
+                    collections[i->first] = i->second->stats.report();
+                }
+            }
             {
                 DBLocksMap::ref r(dblocks);
                 for( DBLocksMap::const_iterator i = r.r.begin(); i != r.r.end(); ++i ) {
-                    b.append(i->first, i->second->stats.report());
+                    BSONObjBuilder db( b.subobjStart( i->first ) );
+                    db.appendElements( i->second->stats.report() );
+
+                    const string prefix = i->first + '.';
+                    map<string, BSONObj>::const_iterator c = collections.lower_bound( prefix );
+                    if( c != collections.end() && str::startsWith( c->first, prefix ) ) {
+                        BSONObjBuilder colls( db.subobjStart( "collections" ) );
+                        for( ; c != collections.end() && str::startsWith( c->first, prefix ); ++c ) {
+                            colls.append( c->first.substr( prefix.size() ), c->second );
+                        }
+                        colls.done();
+                    }
+                    db.done();
                 }
             }
             return b.obj();
@@ -47,8 +47,12 @@ namespace mongo {
         static bool atLeastReadLocked(const StringData& ns); // true if this db is locked
         static void assertAtLeastReadLocked(const StringData& ns);
         static void assertWriteLocked(const StringData& ns);
+        /** like assertWriteLocked(), but a collection lock on ns's database doesn't count */
+        static void assertWholeDBWriteLocked(const StringData& ns);
 
         static bool dbLevelLockingEnabled(); 
+        /** true if DBWrite may lock just a collection (see the collectionLevelLocking parameter) */
+        static bool collectionLevelLockingEnabled();
         
         static LockStat* globalLockStat();
         static LockStat* nestableLockStat( Nestable db );
@@ -105,6 +109,9 @@ namespace mongo {
         protected:
             explicit ScopedLock( char type ); 
 
+            /** called once the lock has been acquired, with the time spent waiting for it */
+            virtual void _acquired( long long micros ) {}
+
         private:
             friend struct TempRelease;
             void tempRelease(); // TempRelease class calls these
@@ -157,24 +164,39 @@ namespace mongo {
              * flow
              *   1) lockDB
              *      a) lockTop
-             *      b) lockNestable or lockOther
+             *      b) lockNestable or lockOther or lockCollection
              *   2) unlockDB
              */
 
             void lockTop(LockState&);
             void lockNestable(Nestable db);
             void lockOther(const StringData& db);
+            bool lockCollection(const string& ns);
             void lockDB(const string& ns);
             void unlockDB();
 
         protected:
             void _tempRelease();
             void _relock();
+            void _acquired( long long micros );
 
         public:
             DBWrite(const StringData& dbOrNs);
+
+            /**
+             * With collectionOnly, lock only the collection ns exclusively, and its database in
+             * intent mode, so writers to other collections of the database run concurrently.
+             * The database is locked exclusively instead when collection level locking is
+             * disabled, for local, admin and system namespaces, and when nested in another lock.
+             * The caller must not create or drop namespaces, or open the database, while only the
+             * collection is locked; see collectionLocked().
+             */
+            DBWrite(const StringData& ns, bool collectionOnly);
             virtual ~DBWrite();
 
+            /** @return true if only the collection, and not its whole database, is locked */
+            bool collectionLocked() const { return _collectionLock != 0; }
+
             class UpgradeToExclusive : private boost::noncopyable {
             public:
                 UpgradeToExclusive();
@@ -189,8 +211,11 @@ namespace mongo {
             bool _locked_w;
             bool _locked_W;
             WrapperForRWLock *_weLocked;
+            WrapperForRWLock *_collectionLock;
+            Timer _collectionTimer;
             const string _what;
             bool _nested;
+            const bool _collectionOnly;
         };
 
         // lock this database for reading. do not shared_lock globally first, that is handledin herein. 
@@ -204,6 +229,7 @@ namespace mongo {
         protected:
             void _tempRelease();
             void _relock();
+            void _acquired( long long micros );
 
         public:
             DBRead(const StringData& dbOrNs);
@@ -52,8 +52,8 @@ namespace mongo {
     Database::~Database() {
         verify( Lock::isW() );
         magic = 0;
-        size_t n = _files.size();
-        for ( size_t i = 0; i < n; i++ )
+        int n = _nFiles.load();
+        for ( int i = 0; i < n; i++ )
             delete _files[i];
         if( ccByLoc.size() ) {
             log() << "\n\n\nWARNING: ccByLoc not empty on database close! " << ccByLoc.size() << ' ' << name << endl;
@@ -61,9 +61,10 @@ namespace mongo {
     }
 
     Database::Database(const char *nm, bool& newDb, const string& _path )
-        : name(nm), path(_path), namespaceIndex( path, name ),
+        : name(nm), path(_path), _extentMutex("extentAlloc"), namespaceIndex( path, name ),
           profileName(name + ".system.profile")
     {
+        _files.resize( DiskLoc::MaxFiles, 0 );
         try {
             {
                 // check db name is valid
@@ -108,10 +109,11 @@ namespace mongo {
                 log() << e.what() << endl;
             }
             // since destructor won't be called:
-            for ( size_t i = 0; i < _files.size(); i++ ) {
+            for ( int i = 0; i < _nFiles.load(); i++ ) {
                 delete _files[i];
+                _files[i] = 0;
             }
-            _files.clear();
+            _nFiles.store( 0 );
             throw;
         }
     }
@@ -191,7 +193,7 @@ namespace mongo {
         }
 
         {
-            if( n < (int) _files.size() && _files[n] ) {
+            if( n < _nFiles.load() && _files[n] ) {
                 dlog(2) << "openExistingFile " << n << " is already open" << endl;
                 return true;
             }
@@ -211,10 +213,7 @@ namespace mongo {
                 delete df;
                 throw;
             }
-            while ( n >= (int) _files.size() ) {
-                _files.push_back(0);
-            }
-            _files[n] = df;
+            _publishFile( n, df );
         }
 
         return true;
@@ -291,17 +290,18 @@ namespace mongo {
         }
         MongoDataFile* p = 0;
         if ( !preallocateOnly ) {
-            while ( n >= (int) _files.size() ) {
+            if ( n >= _nFiles.load() ) {
                 verify(this);
                 if( !Lock::isWriteLocked(this->name) ) {
                     log() << "error: getFile() called in a read lock, yet file to return is not yet open" << endl;
-                    log() << "       getFile(" << n << ") _files.size:" <<_files.size() << ' ' << fileName(n).string() << endl;
+                    log() << "       getFile(" << n << ") numFiles:" << _nFiles.load() << ' ' << fileName(n).string() << endl;
                     log() << "       context ns: " << cc().ns() << endl;
                     verify(false);
                 }
-                _files.push_back(0);
             }
-            p = _files[n];
+            else {
+                p = _files[n];
+            }
         }
         if ( p == 0 ) {
             assertDbWriteLocked(this);
@@ -323,14 +323,21 @@ namespace mongo {
             if ( preallocateOnly )
                 delete p;
             else
-                _files[n] = p;
+                _publishFile( n, p );
         }
         return preallocateOnly ? 0 : p;
     }
 
+    void Database::_publishFile( int n, MongoDataFile* f ) {
+        _files[n] = f;
+        // readers without _extentMutex only look at slots below _nFiles, so it moves last
+        if ( n >= _nFiles.load() )
+            _nFiles.store( n + 1 );
+    }
+
     MongoDataFile* Database::addAFile( int sizeNeeded, bool preallocateNextFile ) {
         assertDbWriteLocked(this);
-        int n = (int) _files.size();
+        int n = _nFiles.load();
         MongoDataFile *ret = getFile( n, sizeNeeded );
         if ( preallocateNextFile )
             preallocateAFile();
@@ -394,6 +401,7 @@ namespace mongo {
 
 
     Extent* Database::allocExtent( const char *ns, int size, bool capped, bool enforceQuota ) {
+        SimpleMutex::scoped_lock lk( _extentMutex );
         // todo: when profiling, these may be worth logging into profile collection
         bool fromFreeList = true;
         Extent *e = DataFileMgr::allocFromFreeList( ns, size, capped );
@@ -435,13 +443,13 @@ namespace mongo {
 
     int Database::numFiles() const { 
         DEV assertDbAtLeastReadLocked(this);
-        return (int) _files.size(); 
+        return _nFiles.load();
     }
 
     void Database::flushFiles( bool sync ) {
         assertDbAtLeastReadLocked(this);
-        for( vector<MongoDataFile*>::iterator i = _files.begin(); i != _files.end(); i++ ) { 
-            MongoDataFile *f = *i;
+        for( int i = 0; i < _nFiles.load(); i++ ) {
+            MongoDataFile *f = _files[i];
             f->flush(sync);
         }
     }
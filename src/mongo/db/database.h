@@ -22,6 +22,7 @@
 #include "mongo/db/cmdline.h"
 #include "mongo/db/namespace_details.h"
 #include "mongo/db/record.h"
+#include "mongo/platform/atomic_word.h"
 
 namespace mongo {
 
@@ -133,7 +134,16 @@ namespace mongo {
         // must be in the dbLock when touching this (and write locked when writing to of course)
         // however during Database object construction we aren't, which is ok as it isn't yet visible
         //   to others and we are in the dbholder lock then.
+        // writers holding only collection locks add files in _extentMutex while others read; so that
+        //   reads stay safe the vector is sized up front and never changes size, and a file is
+        //   published by storing _nFiles only after its slot is filled in.
         vector<MongoDataFile*> _files;
+        AtomicInt32 _nFiles;
+        void _publishFile( int n, MongoDataFile* f );
+
+        // serializes allocating extents (from the free list or new files) between writers holding
+        // only collection locks on this database
+        SimpleMutex _extentMutex;
 
     public: // this should be private later
 
@@ -48,6 +48,7 @@
 #include "mongo/db/stats/counters.h"
 #include "mongo/db/stats/snapshots.h"
 #include "mongo/db/ttl.h"
+#include "mongo/s/d_logic.h"
 #include "mongo/s/d_writeback.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/background.h"
@@ -233,8 +234,37 @@ namespace mongo {
             Client * c = currentClient.get();
             if( c ) c->shutdown();
             globalScriptEngine->threadDone();
+
+            // the thread may go on to service other connections (see supportsDetach())
+            currentClient.reset(0);
+            ShardedConnectionInfo::reset();
+        }
+
+        virtual bool supportsDetach() const { return true; }
+
+        virtual void* detach( AbstractMessagingPort* p ) {
+            DetachedConnection* dc = new DetachedConnection();
+            dc->client = currentClient.release();
+            dc->shardInfo = ShardedConnectionInfo::release();
+            verify( dc->client );
+            verify( ! dc->client->lockState().threadState() );
+            return dc;
         }
 
+        virtual void attach( AbstractMessagingPort* p , void* state ) {
+            scoped_ptr<DetachedConnection> dc( static_cast<DetachedConnection*>( state ) );
+            verify( currentClient.get() == 0 );
+            currentClient.reset( dc->client );
+            ShardedConnectionInfo::attach( dc->shardInfo );
+            setThreadName( dc->client->desc().rawData() );
+        }
+
+    private:
+        /** a connection's thread local state while no thread is servicing it */
+        struct DetachedConnection {
+            Client* client;
+            ShardedConnectionInfo* shardInfo;
+        };
     };
 
     void logStartup() {
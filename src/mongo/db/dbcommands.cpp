@@ -1266,6 +1266,11 @@ namespace mongo {
                 result.append( "capped" , nsd->isCapped() );
                 result.appendNumber( "max" , nsd->maxCappedDocs() );
             }
+            else {
+                BSONObjBuilder freeSpace( result.subobjStart( "freeSpace" ) );
+                nsd->appendFreeSpaceStats( ns.c_str(), &freeSpace, verbose );
+                freeSpace.doneFast();
+            }
 
             if ( verbose )
                 result.appendArray( "extents" , extents.arr() );
@@ -1284,6 +1289,7 @@ namespace mongo {
             help << 
                 "Sets collection options.\n"
                 "Example: { collMod: 'foo', usePowerOf2Sizes:true }\n"
+                "Example: { collMod: 'foo', compressRecords:true }\n"
                 "Example: { collMod: 'foo', index: {keyPattern: {a: 1}, expireAfterSeconds: 600} }";
         }
         virtual void addRequiredPrivileges(const std::string& dbname,
@@ -1323,6 +1329,27 @@ namespace mongo {
                         result.appendBool( "usePowerOf2Sizes_new", newPowerOf2 );
                     }
                 }
+                else if ( str::equals( "compressRecords", e.fieldName() ) ) {
+                    bool oldCompress = nsd->isUserFlagSet(NamespaceDetails::Flag_CompressRecords);
+                    bool newCompress = e.trueValue();
+
+                    if ( newCompress && nsd->isCapped() ) {
+                        errmsg = "can't compress the records of a capped collection";
+                        ok = false;
+                        continue;
+                    }
+
+                    if ( oldCompress != newCompress ) {
+                        // records already written keep their form; only new writes change
+                        result.appendBool( "compressRecords_old", oldCompress );
+
+                        newCompress ? nsd->setUserFlag( NamespaceDetails::Flag_CompressRecords ) :
+                                      nsd->clearUserFlag( NamespaceDetails::Flag_CompressRecords );
+                        nsd->syncUserFlags( ns ); // must keep system.namespaces up-to-date
+
+                        result.appendBool( "compressRecords_new", newCompress );
+                    }
+                }
                 else if ( str::equals( "index", e.fieldName() ) ) {
                     BSONObj indexObj = e.Obj();
                     BSONObj keyPattern = indexObj.getObjectField( "keyPattern" );
@@ -82,6 +82,7 @@ namespace mongo {
 
             for ( int i = 0; i < Buckets; i++ )
                 d->deletedList[i].Null();
+            NamespaceDetailsTransient::get(dropns.c_str()).freeSpaceMap().reset();
 
             result.append("ns", dropns.c_str());
             return 1;
@@ -337,6 +338,7 @@ namespace mongo {
                     shared_ptr<Cursor> c = theDataFileMgr.findAll(ns);
                     int n = 0;
                     int nInvalid = 0;
+                    int nCorrupt = 0;
                     long long nQuantizedSize = 0;
                     long long nPowerOf2QuantizedSize = 0;
                     long long len = 0;
@@ -380,7 +382,22 @@ namespace mongo {
                         }
 
                         if (full){
-                            BSONObj obj = BSONObj::make(r);
+                            BSONObj obj;
+                            try {
+                                obj = BSONObj::make(r);
+                            }
+                            catch (const DBException& e) {
+                                // the record's compressed data doesn't uncompress to an object
+                                valid = false;
+                                if (nCorrupt == 0) // only log once;
+                                    errors << "corrupt compressed record detected (see logs for more info)";
+                                nCorrupt++;
+                                nInvalid++;
+                                log() << "Corrupt compressed record detected in " << ns << " at "
+                                      << cl.toString() << ": " << e.what() << endl;
+                                c->advance();
+                                continue;
+                            }
                             if (!obj.isValid() || !obj.valid()){ // both fast and deep checks
                                 valid = false;
                                 if (nInvalid == 0) // only log once;
@@ -722,7 +722,9 @@ namespace mongo {
             }
 
             size_t compressedLength = 0;
+            Timer compressTimer;
             rawCompress(uncompressed.buf(), uncompressed.len(), b.cur(), &compressedLength);
+            unsigned long long compressMicros = compressTimer.micros();
             verify( compressedLength < 0xffffffff );
             verify( compressedLength < max );
             b.skip(compressedLength);
@@ -753,6 +755,8 @@ namespace mongo {
                 verify( _curLogFile );
 
                 stats.curr->_uncompressedBytes += uncompressed.len();
+                stats.curr->_compressedBytes += compressedLength;
+                stats.curr->_compressMicros += compressMicros;
                 unsigned w = b.len();
                 _written += w;
                 verify( w <= L );
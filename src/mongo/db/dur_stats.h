@@ -37,10 +37,12 @@ namespace mongo {
                 unsigned _earlyCommits; // count of early commits from commitIfNeeded() or from getDur().commitNow()
                 unsigned long long _journaledBytes;
                 unsigned long long _uncompressedBytes;
+                unsigned long long _compressedBytes; // _uncompressedBytes after compression, before framing and padding
                 unsigned long long _writeToDataFilesBytes;
 
                 unsigned long long _prepLogBufferMicros;
                 unsigned long long _writeToJournalMicros;
+                unsigned long long _compressMicros; // part of _writeToJournalMicros
                 unsigned long long _writeToDataFilesMicros;
                 unsigned long long _remapPrivateViewMicros;
 
@@ -86,6 +86,9 @@ namespace mongo {
         bob.appendNumber( "nscannedObjectsAllPlans", clauseInfo.nscannedObjectsAllPlans() );
         bob.appendNumber( "nscannedAllPlans", clauseInfo.nscannedAllPlans() );
         bob.append( "scanAndOrder", _scanAndOrder );
+        if ( _scanAndOrder ) {
+            bob.appendNumber( "scanAndOrderBytes", clauseInfo.scanAndOrderBytes() );
+        }
         bob.append( "indexOnly", _indexOnly );
         bob.appendNumber( "nYields", clauseInfo.nYields() );
         bob.appendNumber( "nChunkSkips", clauseInfo.nChunkSkips() );
@@ -104,6 +107,7 @@ namespace mongo {
     _n(),
     _nscannedObjects(),
     _nChunkSkips(),
+    _scanAndOrderBytes(),
     _nYields() {
     }
     
@@ -213,6 +217,11 @@ namespace mongo {
         _clauses.back()->reviseN( n );
     }
 
+    void ExplainQueryInfo::noteScanAndOrderBytes( long long bytes ) {
+        verify( !_clauses.empty() );
+        _clauses.back()->noteScanAndOrderBytes( bytes );
+    }
+
     void ExplainQueryInfo::setAncillaryInfo( const AncillaryInfo &ancillaryInfo ) {
         _ancillaryInfo = ancillaryInfo;
     }
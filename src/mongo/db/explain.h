@@ -93,6 +93,8 @@ namespace mongo {
         void noteYield();
         /** Revise the total number of documents returned to match an external count. */
         void reviseN( long long n );
+        /** Note the most bytes buffered to sort the clause's results in memory. */
+        void noteScanAndOrderBytes( long long bytes ) { _scanAndOrderBytes = bytes; }
         /** Stop the clauses's timer. */
         void stopTimer();
 
@@ -106,6 +108,7 @@ namespace mongo {
         long long nscannedObjectsAllPlans() const { return _nscannedObjects; }
         long long nscannedAllPlans() const;
         long long nChunkSkips() const { return _nChunkSkips; }
+        long long scanAndOrderBytes() const { return _scanAndOrderBytes; }
         int nYields() const { return _nYields; }
         int millis() const { return _timer.duration(); }
 
@@ -120,6 +123,7 @@ namespace mongo {
         long long _n;
         long long _nscannedObjects;
         long long _nChunkSkips;
+        long long _scanAndOrderBytes;
         int _nYields;
         DurationTimer _timer;
     };
@@ -133,6 +137,8 @@ namespace mongo {
         void noteYield();
         /** Revise the number of documents returned by the current clause. */
         void reviseN( long long n );
+        /** Note the most bytes buffered to sort the current clause's results in memory. */
+        void noteScanAndOrderBytes( long long bytes );
 
         /* Additional information describing the query. */
         struct AncillaryInfo {
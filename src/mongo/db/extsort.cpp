@@ -33,44 +33,37 @@
 
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/namespace-inl.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/file.h"
 
 namespace mongo {
 
-    HLMutex BSONObjExternalSorter::_extSortMutex("s");
-    IndexInterface *BSONObjExternalSorter::extSortIdxInterface;
-    Ordering BSONObjExternalSorter::extSortOrder( Ordering::make(BSONObj()) );
-    bool BSONObjExternalSorter::extSortMayInterrupt( false );
-    unsigned long long BSONObjExternalSorter::_compares = 0;
+    MONGO_EXPORT_SERVER_PARAMETER(externalSortThreads, int, 2);
+
     unsigned long long BSONObjExternalSorter::_uniqueNumber = 0;
     static SimpleMutex _uniqueNumberMutex( "uniqueNumberMutex" );
 
     /*static*/
     int BSONObjExternalSorter::_compare(IndexInterface& i, const Data& l, const Data& r, const Ordering& order) { 
-        _compares++;
         int x = i.keyCompare(l.first, r.first, order);
         if ( x )
             return x;
         return l.second.compare( r.second );
     }
 
-    /*static*/
-    int BSONObjExternalSorter::extSortComp( const void *lv, const void *rv ) {
-        DEV RARELY {
-            _extSortMutex.dassertLocked(); // must be as we use a global var
+    bool BSONObjExternalSorter::MyCmp::operator()( const Data &l, const Data &r ) const {
+        if ( _checkForInterrupt ) {
+            RARELY killCurrentOp.checkForInterrupt(!_mayInterrupt);
         }
-#ifndef __sunos__
-        // Some solaris gnu qsort implementations do not support callback exceptions.
-        RARELY killCurrentOp.checkForInterrupt(!extSortMayInterrupt);
-#endif
-        Data * l = (Data*)lv;
-        Data * r = (Data*)rv;
-        return _compare(*extSortIdxInterface, *l, *r, extSortOrder);
-    };
+        return _compare(_i, l, r, _order) < 0;
+    }
 
     BSONObjExternalSorter::BSONObjExternalSorter( IndexInterface &i, const BSONObj & order , long maxFileSize )
         : _idxi(i), _order( order.getOwned() ) , _maxFilesize( maxFileSize ) ,
-          _arraySize(1000000), _cur(0), _curSizeSoFar(0), _sorted(0) {
+          _numThreads( std::max( externalSortThreads, 0 ) ),
+          _bufferSize( maxFileSize / ( 1 + _numThreads ) ),
+          _arraySize(1000000), _cur(0), _curSizeSoFar(0), _sorted(0),
+          _runMutex( "extSortRuns" ), _runsInFlight(0) {
 
         stringstream rootpath;
         rootpath << dbpath;
@@ -89,10 +82,13 @@ namespace mongo {
         LOG(1) << "external sort root: " << _root.string() << endl;
 
         create_directories( _root );
-        _compares = 0;
     }
 
     BSONObjExternalSorter::~BSONObjExternalSorter() {
+        // runs still in flight (we're unwinding from an error) must finish before their
+        // buffers and files go away
+        _runWriters.reset();
+
         if ( _cur ) {
             delete _cur;
             _cur = 0;
@@ -102,13 +98,7 @@ namespace mongo {
     }
 
     void BSONObjExternalSorter::_sortInMem( bool mayInterrupt ) {
-        // extSortComp needs to use glpbals
-        // qsort_r only seems available on bsd, which is what i really want to use
-        HLMutex::scoped_lock lk(_extSortMutex);
-        extSortIdxInterface = &_idxi;
-        extSortOrder = Ordering::make(_order);
-        extSortMayInterrupt = mayInterrupt;
-        _cur->sort( BSONObjExternalSorter::extSortComp );
+        std::sort( _cur->begin(), _cur->end(), MyCmp( _idxi, _order, true, mayInterrupt ) );
     }
 
     void BSONObjExternalSorter::sort( bool mayInterrupt ) {
@@ -118,39 +108,38 @@ namespace mongo {
 
         if ( _cur && _files.size() == 0 ) {
             _sortInMem( mayInterrupt );
-            LOG(1) << "\t\t not using file.  size:" << _curSizeSoFar << " _compares:" << _compares << endl;
+            LOG(1) << "\t\t not using file.  size:" << _curSizeSoFar << endl;
             return;
         }
 
-        if ( _cur ) {
-            finishMap( mayInterrupt );
+        // the last buffer is merged straight from memory, while the final runs are written
+        if ( _cur && _cur->size() ) {
+            _sortInMem( mayInterrupt );
         }
-
-        if ( _cur ) {
+        else if ( _cur ) {
             delete _cur;
             _cur = 0;
         }
 
-        if ( _files.size() == 0 )
-            return;
+        _waitForRuns( 0, mayInterrupt );
+        _runWriters.reset();
 
+        LOG(1) << "\t\t external sort used " << _files.size() << " files" << endl;
     }
 
     void BSONObjExternalSorter::add( const BSONObj& o, const DiskLoc& loc, bool mayInterrupt ) {
         uassert( 10049 ,  "sorted already" , ! _sorted );
 
         if ( ! _cur ) {
-            _cur = new InMemory( _arraySize );
+            _cur = new InMemory();
         }
 
-        Data& d = _cur->getNext();
-        d.first = o.getOwned();
-        d.second = loc;
+        _cur->push_back( Data( o.getOwned(), loc ) );
 
         long size = o.objsize();
         _curSizeSoFar += size + sizeof( DiskLoc ) + sizeof( BSONObj );
 
-        if (  _cur->hasSpace() == false ||  _curSizeSoFar > _maxFilesize ) {
+        if ( (int)_cur->size() >= _arraySize || _curSizeSoFar > _bufferSize ) {
             finishMap( mayInterrupt );
             LOG(1) << "finishing map" << endl;
         }
@@ -164,12 +153,59 @@ namespace mongo {
         if ( _cur->size() == 0 )
             return;
 
-        _sortInMem( mayInterrupt );
-
         stringstream ss;
         ss << _root.string() << "/file." << _files.size();
         string file = ss.str();
 
+        if ( _numThreads == 0 ) {
+            _sortInMem( mayInterrupt );
+            _writeRun( *_cur, file );
+            _cur->clear();
+            _files.push_back( file );
+            return;
+        }
+
+        killCurrentOp.checkForInterrupt(!mayInterrupt);
+
+        // wait for a thread to be free, so that the buffers held stay within the budget
+        _waitForRuns( _numThreads - 1, mayInterrupt );
+        if ( ! _runWriters ) {
+            _runWriters.reset( new ThreadPool( _numThreads ) );
+        }
+
+        {
+            mongo::mutex::scoped_lock lk( _runMutex );
+            _runsInFlight++;
+        }
+        _runWriters->schedule( &BSONObjExternalSorter::_writeRunInBackground, this, _cur, file );
+        _cur = 0;
+        _files.push_back( file );
+    }
+
+    void BSONObjExternalSorter::_writeRunInBackground( InMemory* run, const string& file ) {
+        string error;
+        try {
+            std::sort( run->begin(), run->end(), MyCmp( _idxi, _order ) );
+            _writeRun( *run, file );
+        }
+        catch ( DBException& e ) {
+            error = e.toString();
+        }
+        catch ( std::exception& e ) {
+            error = e.what();
+        }
+        delete run;
+
+        mongo::mutex::scoped_lock lk( _runMutex );
+        if ( ! error.empty() && _runError.empty() ) {
+            _runError = error;
+        }
+        _runsInFlight--;
+        _runDone.notify_all();
+    }
+
+    /*static*/
+    void BSONObjExternalSorter::_writeRun( InMemory& run, const string& file ) {
         // todo: it may make sense to fadvise that this not be cached so that building the index doesn't 
         //       eject other things the db is using from the file system cache.  while we will soon be reading 
         //       this back, if it fit in ram, there wouldn't have been a need for an external sort in the first 
@@ -179,36 +215,52 @@ namespace mongo {
         out.open( file.c_str() , ios_base::out | ios_base::binary );
         assertStreamGood( 10051 ,  (string)"couldn't open file: " + file , out );
 
-        int num = 0;
-        for ( InMemory::iterator i=_cur->begin(); i != _cur->end(); ++i ) {
-            Data p = *i;
-            out.write( p.first.objdata() , p.first.objsize() );
-            out.write( (char*)(&p.second) , sizeof( DiskLoc ) );
-            num++;
+        for ( InMemory::iterator i=run.begin(); i != run.end(); ++i ) {
+            out.write( i->first.objdata() , i->first.objsize() );
+            out.write( (char*)(&i->second) , sizeof( DiskLoc ) );
         }
 
-        _cur->clear();
-
-        _files.push_back( file );
         out.close();
+        assertStreamGood( 16751 , (string)"couldn't write file: " + file , out );
 
-        LOG(2) << "Added file: " << file << " with " << num << "objects for external sort" << endl;
+        LOG(2) << "Added file: " << file << " with " << run.size() << "objects for external sort" << endl;
+    }
+
+    void BSONObjExternalSorter::_waitForRuns( int maxInFlight, bool mayInterrupt ) {
+        mongo::mutex::scoped_lock lk( _runMutex );
+        while ( _runsInFlight > maxInFlight ) {
+            _runDone.timed_wait( lk.boost(), incxtimemillis( 100 ) );
+            killCurrentOp.checkForInterrupt(!mayInterrupt);
+        }
+        massert( 16752, "external sort failed to write a run: " + _runError, _runError.empty() );
     }
 
     // ---------------------------------
 
     BSONObjExternalSorter::Iterator::Iterator( BSONObjExternalSorter * sorter ) :
-        _cmp( sorter->_idxi, sorter->_order ) , _in( 0 ) {
+        _cmp( sorter->_idxi, sorter->_order ) , _merging( false ), _in( 0 ) {
 
         for ( list<string>::iterator i=sorter->_files.begin(); i!=sorter->_files.end(); i++ ) {
             _files.push_back( new FileIterator( *i ) );
-            _stash.push_back( pair<Data,bool>( Data( BSONObj() , DiskLoc() ) , false ) );
         }
 
-        if ( _files.size() == 0 && sorter->_cur ) {
+        if ( sorter->_cur ) {
             _in = sorter->_cur;
             _it = sorter->_cur->begin();
         }
+
+        if ( _files.size() == 0 )
+            return;
+
+        _merging = true;
+        int sources = _files.size() + ( _in ? 1 : 0 );
+        _heads.resize( sources );
+        _exhausted.resize( sources );
+        for ( int i = 0; i < sources; i++ ) {
+            _exhausted[i] = ! _advance( i );
+        }
+        _tree.resize( sources );
+        _tree[0] = sources == 1 ? 0 : _build( 1 );
     }
 
     BSONObjExternalSorter::Iterator::~Iterator() {
@@ -217,49 +269,72 @@ namespace mongo {
         _files.clear();
     }
 
+    bool BSONObjExternalSorter::Iterator::_advance( int i ) {
+        if ( i < (int)_files.size() ) {
+            if ( ! _files[i]->more() )
+                return false;
+            _heads[i] = _files[i]->next();
+            return true;
+        }
+
+        if ( _it == _in->end() )
+            return false;
+        _heads[i] = *_it;
+        ++_it;
+        return true;
+    }
+
+    bool BSONObjExternalSorter::Iterator::_less( int a, int b ) const {
+        if ( _exhausted[a] )
+            return false;
+        if ( _exhausted[b] )
+            return true;
+        return _cmp( _heads[a], _heads[b] );
+    }
+
+    int BSONObjExternalSorter::Iterator::_build( int node ) {
+        int sources = _tree.size();
+        if ( node >= sources )
+            return node - sources;
+
+        int left = _build( 2 * node );
+        int right = _build( 2 * node + 1 );
+        if ( _less( right, left ) ) {
+            _tree[node] = left;
+            return right;
+        }
+        _tree[node] = right;
+        return left;
+    }
+
     bool BSONObjExternalSorter::Iterator::more() {
 
-        if ( _in )
-            return _it != _in->end();
+        if ( _merging )
+            return ! _exhausted[ _tree[0] ];
 
-        for ( vector<FileIterator*>::iterator i=_files.begin(); i!=_files.end(); i++ )
-            if ( (*i)->more() )
-                return true;
-        for ( vector< pair<Data,bool> >::iterator i=_stash.begin(); i!=_stash.end(); i++ )
-            if ( i->second )
-                return true;
-        return false;
+        return _in && _it != _in->end();
     }
 
     BSONObjExternalSorter::Data BSONObjExternalSorter::Iterator::next() {
 
-        if ( _in ) {
+        if ( ! _merging ) {
             Data& d = *_it;
             ++_it;
             return d;
         }
 
-        Data best;
-        int slot = -1;
-
-        for ( unsigned i=0; i<_stash.size(); i++ ) {
-
-            if ( ! _stash[i].second ) {
-                if ( _files[i]->more() )
-                    _stash[i] = pair<Data,bool>( _files[i]->next() , true );
-                else
-                    continue;
-            }
-
-            if ( slot == -1 || _cmp( best , _stash[i].first ) == 0 ) {
-                best = _stash[i].first;
-                slot = i;
-            }
+        int winner = _tree[0];
+        verify( ! _exhausted[winner] );
+        Data best = _heads[winner];
+        _exhausted[winner] = ! _advance( winner );
 
+        // replay the winner's path to the root; each node keeps the loser of its match
+        int sources = _tree.size();
+        for ( int node = ( winner + sources ) / 2; node > 0; node /= 2 ) {
+            if ( _less( _tree[node], winner ) )
+                std::swap( _tree[node], winner );
         }
-
-        verify( slot >= 0 );
-        _stash[slot].second = false;
+        _tree[0] = winner;
 
         return best;
     }
@@ -288,6 +363,10 @@ namespace mongo {
 
         _length = (unsigned long long)boost::filesystem::file_size( file );
         _readSoFar = 0;
+
+        _buf.reset( new char[BufferSize] );
+        _bufPos = 0;
+        _bufLen = 0;
     }
     BSONObjExternalSorter::FileIterator::~FileIterator() {
         if ( _file >= 0 ) {
@@ -305,22 +384,29 @@ namespace mongo {
 
 
     bool BSONObjExternalSorter::FileIterator::_read( char* buf, long long count ) {
-        long long total = 0;
-        while ( total < count ) {
+        while ( count > 0 ) {
+            if ( _bufPos == _bufLen ) {
 #ifdef _WIN32
-            long long now = ::_read( _file, buf, count );
+                long long now = ::_read( _file, _buf.get(), BufferSize );
 #else
-            long long now = ::read( _file, buf, count );
+                long long now = ::read( _file, _buf.get(), BufferSize );
 #endif
-            if ( now < 0 ) {
-                log() << "read failed for BSONObjExternalSorter " << errnoWithDescription() << endl;
-                return false;
-            }
-            if ( now == 0 ) {
-                return false;
+                if ( now < 0 ) {
+                    log() << "read failed for BSONObjExternalSorter " << errnoWithDescription() << endl;
+                    return false;
+                }
+                if ( now == 0 ) {
+                    return false;
+                }
+                _bufPos = 0;
+                _bufLen = (unsigned)now;
             }
-            total += now;
-            buf += now;
+
+            unsigned n = (unsigned)std::min( count, (long long)( _bufLen - _bufPos ) );
+            memcpy( buf, _buf.get() + _bufPos, n );
+            _bufPos += n;
+            buf += n;
+            count -= n;
         }
         return true;
     }
@@ -24,12 +24,27 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/namespace-inl.h"
 #include "mongo/db/curop-inl.h"
-#include "mongo/util/array.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
 
 namespace mongo {
 
+    /**
+     * How many background threads each external sort uses to sort and write its runs.  0 sorts
+     * and writes every run on the caller's thread.  Settable with setParameter; a sort reads it
+     * once, when it is created.
+     */
+    extern int externalSortThreads;
+
     /**
        for external (disk) sorting by BSONObj and attaching a value
+
+       Keys are buffered in memory until maxFileSize is reached.  Each full buffer is then sorted
+       and written out as a run by a background thread, while the caller goes on filling the next
+       buffer; with externalSortThreads > 1 several runs are sorted at once.  The memory budget is
+       split between the buffer being filled and the runs in flight, so the sorter never holds
+       much more than maxFileSize of keys.  The last buffer is not written out; it is merged from
+       memory along with the runs on disk.
      */
     class BSONObjExternalSorter : boost::noncopyable {
     public:
@@ -40,27 +55,28 @@ namespace mongo {
         const IndexInterface& getIndexInterface() const { return _idxi; }
  
     private:
-        static HLMutex _extSortMutex;
         IndexInterface& _idxi;
 
         static int _compare(IndexInterface& i, const Data& l, const Data& r, const Ordering& order);
 
         class MyCmp {
         public:
-            MyCmp( IndexInterface& i, BSONObj order = BSONObj() ) : _i(i), _order( Ordering::make(order) ) {}
-            bool operator()( const Data &l, const Data &r ) const {
-                return _compare(_i, l, r, _order) < 0;
-            };
+            /**
+             * @param checkForInterrupt if true, the comparison every so often checks whether the
+             *     current op was killed, so it must only be used on the op's own thread.
+             */
+            MyCmp( IndexInterface& i, BSONObj order = BSONObj(), bool checkForInterrupt = false,
+                   bool mayInterrupt = false ) :
+                _i(i), _order( Ordering::make(order) ), _checkForInterrupt( checkForInterrupt ),
+                _mayInterrupt( mayInterrupt ) {}
+            bool operator()( const Data &l, const Data &r ) const;
         private:
             IndexInterface& _i;
             const Ordering _order;
+            bool _checkForInterrupt;
+            bool _mayInterrupt;
         };
 
-        static IndexInterface *extSortIdxInterface;
-        static Ordering extSortOrder;
-        static bool extSortMayInterrupt;
-        static int extSortComp( const void *lv, const void *rv );
-
         class FileIterator : boost::noncopyable {
         public:
             FileIterator( const std::string& file );
@@ -73,12 +89,22 @@ namespace mongo {
             int _file;
             unsigned long long _length;
             unsigned long long _readSoFar;
+
+            // reads are served from here, so a key doesn't cost a system call
+            static const unsigned BufferSize = 64 * 1024;
+            boost::scoped_array<char> _buf;
+            unsigned _bufPos;
+            unsigned _bufLen;
         };
 
     public:
 
-        typedef FastArray<Data> InMemory;
+        typedef vector<Data> InMemory;
 
+        /**
+         * Returns the sorted keys.  Runs are merged with a loser tree, so each key costs about
+         * log2(number of runs) comparisons rather than one per run.
+         */
         class Iterator : boost::noncopyable {
         public:
 
@@ -88,9 +114,25 @@ namespace mongo {
             Data next();
 
         private:
+            /** Load the next key of source i into _heads[i].  @return false if there isn't one. */
+            bool _advance( int i );
+
+            /** @return true if source a's head goes before source b's; exhausted sources last. */
+            bool _less( int a, int b ) const;
+
+            /** Play the matches of the subtree under node, recording losers.  @return winner. */
+            int _build( int node );
+
             MyCmp _cmp;
             vector<FileIterator*> _files;
-            vector< pair<Data,bool> > _stash;
+
+            // merge state, with one source per file plus the in memory buffer if there is one.
+            // _tree[0] is the source with the smallest head, _tree[1..n-1] hold the loser of the
+            // match played at that node; source i is the leaf at node n + i.
+            bool _merging;
+            vector<Data> _heads;
+            vector<char> _exhausted;
+            vector<int> _tree;
 
             InMemory * _in;
             InMemory::iterator _it;
@@ -107,6 +149,7 @@ namespace mongo {
             return auto_ptr<Iterator>( new Iterator( this ) );
         }
 
+        /** @return the number of runs written to disk, or being written. */
         int numFiles() {
             return _files.size();
         }
@@ -122,13 +165,26 @@ namespace mongo {
 
         void _sortInMem( bool mayInterrupt );
 
-        void sort( const std::string& file );
         void finishMap( bool mayInterrupt );
 
+        /** Sort a full buffer and write it to file, on a background thread.  Takes ownership. */
+        void _writeRunInBackground( InMemory* run, const string& file );
+
+        /** Write a sorted buffer to file. */
+        static void _writeRun( InMemory& run, const string& file );
+
+        /**
+         * Wait until no more than maxInFlight runs are being written, and fail if writing one
+         * failed.
+         */
+        void _waitForRuns( int maxInFlight, bool mayInterrupt );
+
         BSONObj _order;
         long _maxFilesize;
         boost::filesystem::path _root;
 
+        const int _numThreads;
+        long _bufferSize; // budget for one buffer, _maxFilesize split between the buffers
         int _arraySize;
         InMemory * _cur;
         long _curSizeSoFar;
@@ -136,7 +192,13 @@ namespace mongo {
         list<string> _files;
         bool _sorted;
 
-        static unsigned long long _compares;
+        // runs being sorted and written in the background
+        mongo::mutex _runMutex;
+        boost::condition _runDone;
+        int _runsInFlight;
+        string _runError;
+        scoped_ptr<ThreadPool> _runWriters; // last, so it is joined before the above go away
+
         static unsigned long long _uniqueNumber;
     };
 }
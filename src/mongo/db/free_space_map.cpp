@@ -0,0 +1,255 @@
+// @file free_space_map.cpp
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/free_space_map.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/bits.h"
+
+namespace mongo {
+
+    MONGO_EXPORT_SERVER_PARAMETER(freeSpaceMapMaxRecords, int, 1000000);
+
+    FreeSpaceMap::FreeSpaceMap() :
+        _owner( 0 ),
+        _unmapped( false ),
+        _bytes( 0 ),
+        _allocs( 0 ),
+        _allocMisses( 0 ),
+        _allocMicros( 0 ),
+        _coalesced( 0 ),
+        _builds( 0 ) {
+        memset( _nonEmpty, 0, sizeof( _nonEmpty ) );
+    }
+
+    int FreeSpaceMap::sizeClass( int len ) {
+        if ( len < 4 )
+            return 0;
+        int lg = 0;
+        for ( int shift = 16; shift > 0; shift >>= 1 ) {
+            if ( len >> ( lg + shift ) )
+                lg += shift;
+        }
+        // four classes per power of two, split by the two bits below the top one
+        return lg * 4 + ( ( len >> ( lg - 2 ) ) & 3 );
+    }
+
+    int FreeSpaceMap::classMinSize( int sizeClass ) {
+        if ( sizeClass < 8 )
+            return sizeClass < 4 ? 0 : 4;
+        return ( 4 + ( sizeClass & 3 ) ) << ( sizeClass / 4 - 2 );
+    }
+
+    void FreeSpaceMap::startBuild( const void* owner ) {
+        reset();
+        _owner = owner;
+        _builds++;
+    }
+
+    void FreeSpaceMap::markUnmapped( const void* owner ) {
+        reset();
+        _owner = owner;
+        _unmapped = true;
+    }
+
+    void FreeSpaceMap::reset() {
+        _owner = 0;
+        _unmapped = false;
+        _records.clear();
+        for ( int i = 0; i < NumClasses; i++ )
+            _classes[i].clear();
+        memset( _nonEmpty, 0, sizeof( _nonEmpty ) );
+        _bytes = 0;
+    }
+
+    void FreeSpaceMap::link( const DiskLoc& loc, int len, int chain, const DiskLoc& prev,
+                             const DiskLoc& next ) {
+        Entry& e = _records[loc];
+        e.len = len;
+        e.chain = chain;
+        e.prev = prev;
+        e.next = next;
+        _addToClass( len, loc );
+        _bytes += len;
+
+        if ( !prev.isNull() ) {
+            RecordMap::iterator i = _records.find( prev );
+            if ( i != _records.end() )
+                i->second.next = loc;
+        }
+        if ( !next.isNull() ) {
+            RecordMap::iterator i = _records.find( next );
+            if ( i != _records.end() )
+                i->second.prev = loc;
+        }
+    }
+
+    bool FreeSpaceMap::unlink( const DiskLoc& loc, int* chain, DiskLoc* prev, DiskLoc* next ) {
+        RecordMap::iterator i = _records.find( loc );
+        if ( i == _records.end() )
+            return false;
+        *chain = i->second.chain;
+        *prev = i->second.prev;
+        *next = i->second.next;
+
+        if ( !prev->isNull() ) {
+            RecordMap::iterator p = _records.find( *prev );
+            if ( p != _records.end() )
+                p->second.next = *next;
+        }
+        if ( !next->isNull() ) {
+            RecordMap::iterator n = _records.find( *next );
+            if ( n != _records.end() )
+                n->second.prev = *prev;
+        }
+
+        _removeFromClass( i->second.len, loc );
+        _bytes -= i->second.len;
+        _records.erase( i );
+        return true;
+    }
+
+    DiskLoc FreeSpaceMap::bestFit( int len ) const {
+        int c = sizeClass( len );
+        const SizeClass& same = _classes[c];
+        SizeClass::const_iterator i = same.lower_bound( std::make_pair( len, DiskLoc() ) );
+        if ( i != same.end() )
+            return i->second;
+        // everything in a larger class fits; its smallest record fits best
+        c = _nextNonEmptyClass( c );
+        if ( c < 0 )
+            return DiskLoc();
+        return _classes[c].begin()->second;
+    }
+
+    int FreeSpaceMap::lengthAt( const DiskLoc& loc ) const {
+        RecordMap::const_iterator i = _records.find( loc );
+        return i == _records.end() ? 0 : i->second.len;
+    }
+
+    DiskLoc FreeSpaceMap::recordEndingAt( const DiskLoc& loc ) const {
+        RecordMap::const_iterator i = _records.lower_bound( loc );
+        if ( i == _records.begin() )
+            return DiskLoc();
+        --i;
+        const DiskLoc& before = i->first;
+        if ( before.a() != loc.a() || before.getOfs() + i->second.len != loc.getOfs() )
+            return DiskLoc();
+        return before;
+    }
+
+    long long FreeSpaceMap::recordsBetween( const DiskLoc& start, const DiskLoc& end,
+                                            std::vector<DiskLoc>* locs ) const {
+        long long bytes = 0;
+        for ( RecordMap::const_iterator i = _records.lower_bound( start );
+              i != _records.end() && i->first < end; ++i ) {
+            bytes += i->second.len;
+            if ( locs )
+                locs->push_back( i->first );
+        }
+        return bytes;
+    }
+
+    void FreeSpaceMap::lengthsOutside( const DiskLoc& start, const DiskLoc& end,
+                                       std::vector<int>* lens ) const {
+        for ( RecordMap::const_iterator i = _records.begin(); i != _records.end(); ++i ) {
+            if ( i->first < start || !( i->first < end ) )
+                lens->push_back( i->second.len );
+        }
+    }
+
+    int FreeSpaceMap::largestRecord() const {
+        for ( int c = NumClasses - 1; c >= 0; c-- ) {
+            if ( !_classes[c].empty() )
+                return _classes[c].rbegin()->first;
+        }
+        return 0;
+    }
+
+    void FreeSpaceMap::noteAlloc( long long micros, bool found ) {
+        _allocs++;
+        _allocMicros += micros;
+        if ( !found )
+            _allocMisses++;
+    }
+
+    void FreeSpaceMap::appendCounters( BSONObjBuilder* b ) const {
+        b->appendNumber( "allocs", _allocs );
+        b->appendNumber( "allocMisses", _allocMisses );
+        b->appendNumber( "allocMicros", _allocMicros );
+        b->append( "avgAllocMicros", _allocs ? double( _allocMicros ) / double( _allocs ) : 0.0 );
+        b->appendNumber( "coalesced", _coalesced );
+        b->append( "builds", _builds );
+    }
+
+    void FreeSpaceMap::appendRecordStats( BSONObjBuilder* b, bool classes ) const {
+        b->appendNumber( "records", numRecords() );
+        b->appendNumber( "bytes", totalBytes() );
+        int largest = largestRecord();
+        b->append( "largest", largest );
+        b->append( "fragmentation", _bytes ? 1.0 - double( largest ) / double( _bytes ) : 0.0 );
+
+        if ( !classes )
+            return;
+        BSONArrayBuilder arr( b->subarrayStart( "classes" ) );
+        for ( int c = 0; c < NumClasses; c++ ) {
+            const SizeClass& records = _classes[c];
+            if ( records.empty() )
+                continue;
+            long long bytes = 0;
+            for ( SizeClass::const_iterator i = records.begin(); i != records.end(); ++i )
+                bytes += i->first;
+            BSONObjBuilder sc( arr.subobjStart() );
+            sc.append( "minSize", classMinSize( c ) );
+            sc.appendNumber( "records", static_cast<long long>( records.size() ) );
+            sc.appendNumber( "bytes", bytes );
+            sc.doneFast();
+        }
+        arr.doneFast();
+    }
+
+    void FreeSpaceMap::_addToClass( int len, const DiskLoc& loc ) {
+        int c = sizeClass( len );
+        _classes[c].insert( std::make_pair( len, loc ) );
+        _nonEmpty[c / 64] |= 1ULL << ( c % 64 );
+    }
+
+    void FreeSpaceMap::_removeFromClass( int len, const DiskLoc& loc ) {
+        int c = sizeClass( len );
+        _classes[c].erase( std::make_pair( len, loc ) );
+        if ( _classes[c].empty() )
+            _nonEmpty[c / 64] &= ~( 1ULL << ( c % 64 ) );
+    }
+
+    int FreeSpaceMap::_nextNonEmptyClass( int sizeClass ) const {
+        int c = sizeClass + 1;
+        for ( int word = c / 64; word < NumClasses / 64; word++ ) {
+            unsigned long long bits = _nonEmpty[word];
+            if ( word == c / 64 && c % 64 )
+                bits &= ~0ULL << ( c % 64 );
+            int bit = firstBitSet( bits );
+            if ( bit )
+                return word * 64 + bit - 1;
+        }
+        return -1;
+    }
+
+} // namespace mongo
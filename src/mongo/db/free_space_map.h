@@ -0,0 +1,178 @@
+// @file free_space_map.h - In memory index of a collection's deleted records.
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "mongo/db/diskloc.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * The most deleted records a collection's FreeSpaceMap indexes; a collection with more free
+     * records than this allocates by walking its deleted lists.  0 disables the map.  Settable
+     * with setParameter.
+     */
+    extern int freeSpaceMapMaxRecords;
+
+    /**
+     * Mirrors the deleted record chains of a non capped collection (NamespaceDetails::deletedList)
+     * in memory, so a best fit record can be found, unlinked from its on disk chain, and merged
+     * with its physical neighbors without walking the chains.
+     *
+     * Records are kept in size classes four to a power of two, with a bitmap of the classes that
+     * hold any records: a lookup scans the requested size's class for the smallest record that
+     * fits and otherwise takes the smallest record of the next non empty class.  Each record also
+     * remembers its neighbors in its on disk chain, so unlinking it doesn't need the chain's
+     * predecessor, and records are ordered by location, so the records adjacent to a location are
+     * found directly.
+     *
+     * The map holds no disk state of its own: NamespaceDetails rebuilds it from the deleted lists
+     * when it's missing or was built for different NamespaceDetails, and keeps it in step with
+     * each change it makes to the chains.  The allocation counters survive a rebuild.
+     *
+     * Not thread safe; callers hold the collection's write lock to change the map and at least
+     * its read lock to read it.
+     */
+    class FreeSpaceMap : boost::noncopyable {
+    public:
+        static const int NumClasses = 128;
+
+        FreeSpaceMap();
+
+        /** @return the size class of a record 'len' bytes long, with headers. */
+        static int sizeClass( int len );
+
+        /** @return the smallest record length in size class 'sizeClass'. */
+        static int classMinSize( int sizeClass );
+
+        /** @return true if the map mirrors the chains of 'owner'. */
+        bool builtFor( const void* owner ) const { return _owner == owner && !_unmapped; }
+
+        /** @return true if the chains of 'owner' couldn't be mapped. */
+        bool unmappedFor( const void* owner ) const { return _owner == owner && _unmapped; }
+
+        /** Start mirroring the chains of 'owner', which have no records in the map yet. */
+        void startBuild( const void* owner );
+
+        /**
+         * The chains of 'owner' have too many records to map, or a bad link; drop every record
+         * and leave 'owner' to walk its chains until the map is reset.
+         */
+        void markUnmapped( const void* owner );
+
+        /** Forget every record and the owner, so the map is built again before it's used. */
+        void reset();
+
+        /**
+         * Add the record at 'loc', 'len' bytes long, to chain number 'chain' between 'prev' and
+         * 'next'.  A null 'prev' makes the record the chain's head.  The records at 'prev' and
+         * 'next', if in the map, are relinked to it.
+         */
+        void link( const DiskLoc& loc, int len, int chain, const DiskLoc& prev,
+                   const DiskLoc& next );
+
+        /**
+         * Remove the record at 'loc', relinking its chain neighbors to each other.
+         * @param chain set to the number of the record's chain.
+         * @param prev set to the record before it in its chain, null if it was the head.
+         * @param next set to the record after it in its chain, null if it was the tail.
+         * @return false if 'loc' isn't in the map.
+         */
+        bool unlink( const DiskLoc& loc, int* chain, DiskLoc* prev, DiskLoc* next );
+
+        /**
+         * @return the smallest record at least 'len' bytes long, the lowest located of equal
+         * ones, or a null DiskLoc if none is long enough.
+         */
+        DiskLoc bestFit( int len ) const;
+
+        /** @return the length of the record at 'loc', or 0 if 'loc' isn't in the map. */
+        int lengthAt( const DiskLoc& loc ) const;
+
+        /** @return the record ending where 'loc' starts, in the same file, or a null DiskLoc. */
+        DiskLoc recordEndingAt( const DiskLoc& loc ) const;
+
+        /**
+         * @return the bytes of the records located from 'start' up to but not including 'end'.
+         * @param locs if not null, the records' locations are appended to it in order.
+         */
+        long long recordsBetween( const DiskLoc& start, const DiskLoc& end,
+                                  std::vector<DiskLoc>* locs ) const;
+
+        /**
+         * Append the lengths of the records located before 'start' or from 'end' on to 'lens',
+         * in location order.
+         */
+        void lengthsOutside( const DiskLoc& start, const DiskLoc& end,
+                             std::vector<int>* lens ) const;
+
+        long long numRecords() const { return _records.size(); }
+        long long totalBytes() const { return _bytes; }
+        int largestRecord() const;
+
+        /** An allocation from the map took 'micros', and did or didn't find a record. */
+        void noteAlloc( long long micros, bool found );
+
+        /** Freeing a record merged it with 'neighbors' adjacent deleted records. */
+        void noteCoalesced( int neighbors ) { _coalesced += neighbors; }
+
+        /**
+         * Append the map's record count and bytes, its largest record and its fragmentation: the
+         * share of the free bytes that the largest record doesn't hold.
+         * @param classes also append the records and bytes of each non empty size class.
+         */
+        void appendRecordStats( BSONObjBuilder* b, bool classes ) const;
+
+        /** Append the allocation, coalescing and build counters. */
+        void appendCounters( BSONObjBuilder* b ) const;
+
+    private:
+        struct Entry {
+            int len;
+            int chain;
+            DiskLoc prev;
+            DiskLoc next;
+        };
+        typedef std::map<DiskLoc, Entry> RecordMap;
+        typedef std::set< std::pair<int, DiskLoc> > SizeClass;
+
+        void _addToClass( int len, const DiskLoc& loc );
+        void _removeFromClass( int len, const DiskLoc& loc );
+        int _nextNonEmptyClass( int sizeClass ) const;
+
+        const void* _owner;
+        bool _unmapped;
+        RecordMap _records;
+        SizeClass _classes[NumClasses];
+        unsigned long long _nonEmpty[NumClasses / 64];
+        long long _bytes;
+
+        long long _allocs;
+        long long _allocMisses;
+        long long _allocMicros;
+        long long _coalesced;
+        int _builds;
+    };
+
+} // namespace mongo
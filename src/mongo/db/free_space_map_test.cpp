@@ -0,0 +1,193 @@
+// free_space_map_test.cpp
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Unit tests for FreeSpaceMap. */
+
+#include "mongo/db/free_space_map.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+    TEST( FreeSpaceMap, SizeClasses ) {
+        ASSERT_EQUALS( FreeSpaceMap::sizeClass( 32 ), FreeSpaceMap::sizeClass( 39 ) );
+        ASSERT_EQUALS( FreeSpaceMap::sizeClass( 32 ) + 1, FreeSpaceMap::sizeClass( 40 ) );
+        ASSERT_EQUALS( FreeSpaceMap::sizeClass( 32 ) + 4, FreeSpaceMap::sizeClass( 64 ) );
+        ASSERT_LESS_THAN( FreeSpaceMap::sizeClass( 0x7fffffff ), FreeSpaceMap::NumClasses );
+
+        // every length falls in the class whose minimum it is at least, and the next one's isn't
+        for ( int len = 8; len < 100000; len += 7 ) {
+            int c = FreeSpaceMap::sizeClass( len );
+            ASSERT_LESS_THAN_OR_EQUALS( FreeSpaceMap::classMinSize( c ), len );
+            ASSERT_GREATER_THAN( FreeSpaceMap::classMinSize( c + 1 ), len );
+        }
+    }
+
+    TEST( FreeSpaceMap, BestFit ) {
+        FreeSpaceMap fsm;
+        fsm.startBuild( &fsm );
+        fsm.link( DiskLoc( 0, 1000 ), 300, 0, DiskLoc(), DiskLoc() );
+        fsm.link( DiskLoc( 0, 2000 ), 400, 0, DiskLoc( 0, 1000 ), DiskLoc() );
+        fsm.link( DiskLoc( 1, 1000 ), 300, 0, DiskLoc( 0, 2000 ), DiskLoc() );
+        fsm.link( DiskLoc( 0, 9000 ), 100000, 1, DiskLoc(), DiskLoc() );
+
+        ASSERT_EQUALS( DiskLoc( 0, 1000 ), fsm.bestFit( 300 ) );
+        ASSERT_EQUALS( DiskLoc( 0, 1000 ), fsm.bestFit( 290 ) );
+        ASSERT_EQUALS( DiskLoc( 0, 2000 ), fsm.bestFit( 301 ) );
+        ASSERT_EQUALS( DiskLoc( 0, 9000 ), fsm.bestFit( 401 ) );
+        ASSERT( fsm.bestFit( 100001 ).isNull() );
+        ASSERT_EQUALS( 4, fsm.numRecords() );
+        ASSERT_EQUALS( 101000, fsm.totalBytes() );
+        ASSERT_EQUALS( 100000, fsm.largestRecord() );
+    }
+
+    TEST( FreeSpaceMap, UnlinkRelinksChain ) {
+        FreeSpaceMap fsm;
+        fsm.startBuild( &fsm );
+        DiskLoc a( 0, 1000 );
+        DiskLoc b( 0, 2000 );
+        DiskLoc c( 0, 3000 );
+        fsm.link( a, 100, 3, DiskLoc(), DiskLoc() );
+        fsm.link( b, 100, 3, a, DiskLoc() );
+        fsm.link( c, 100, 3, b, DiskLoc() );
+
+        int chain;
+        DiskLoc prev;
+        DiskLoc next;
+        ASSERT( fsm.unlink( b, &chain, &prev, &next ) );
+        ASSERT_EQUALS( 3, chain );
+        ASSERT_EQUALS( a, prev );
+        ASSERT_EQUALS( c, next );
+        ASSERT( !fsm.unlink( b, &chain, &prev, &next ) );
+
+        // the head's successor is now c, and c's predecessor a
+        ASSERT( fsm.unlink( c, &chain, &prev, &next ) );
+        ASSERT_EQUALS( a, prev );
+        ASSERT( next.isNull() );
+        ASSERT( fsm.unlink( a, &chain, &prev, &next ) );
+        ASSERT( prev.isNull() );
+        ASSERT( next.isNull() );
+        ASSERT_EQUALS( 0, fsm.numRecords() );
+        ASSERT( fsm.bestFit( 1 ).isNull() );
+    }
+
+    TEST( FreeSpaceMap, HeadInsert ) {
+        FreeSpaceMap fsm;
+        fsm.startBuild( &fsm );
+        DiskLoc a( 0, 1000 );
+        DiskLoc b( 0, 2000 );
+        fsm.link( a, 100, 0, DiskLoc(), DiskLoc() );
+        // b pushed on the front of a's chain
+        fsm.link( b, 100, 0, DiskLoc(), a );
+
+        int chain;
+        DiskLoc prev;
+        DiskLoc next;
+        ASSERT( fsm.unlink( a, &chain, &prev, &next ) );
+        ASSERT_EQUALS( b, prev );
+        ASSERT( next.isNull() );
+    }
+
+    TEST( FreeSpaceMap, Adjacency ) {
+        FreeSpaceMap fsm;
+        fsm.startBuild( &fsm );
+        fsm.link( DiskLoc( 0, 1000 ), 200, 0, DiskLoc(), DiskLoc() );
+        fsm.link( DiskLoc( 1, 1000 ), 200, 0, DiskLoc(), DiskLoc() );
+
+        ASSERT_EQUALS( DiskLoc( 0, 1000 ), fsm.recordEndingAt( DiskLoc( 0, 1200 ) ) );
+        ASSERT( fsm.recordEndingAt( DiskLoc( 0, 1204 ) ).isNull() );
+        ASSERT( fsm.recordEndingAt( DiskLoc( 0, 1000 ) ).isNull() );
+        ASSERT( fsm.recordEndingAt( DiskLoc( 1, 1000 ) ).isNull() );
+        ASSERT_EQUALS( 200, fsm.lengthAt( DiskLoc( 1, 1000 ) ) );
+        ASSERT_EQUALS( 0, fsm.lengthAt( DiskLoc( 1, 1200 ) ) );
+    }
+
+    TEST( FreeSpaceMap, RecordsBetween ) {
+        FreeSpaceMap fsm;
+        fsm.startBuild( &fsm );
+        fsm.link( DiskLoc( 0, 1000 ), 100, 0, DiskLoc(), DiskLoc() );
+        fsm.link( DiskLoc( 0, 2000 ), 200, 0, DiskLoc(), DiskLoc() );
+        fsm.link( DiskLoc( 0, 3000 ), 300, 0, DiskLoc(), DiskLoc() );
+        fsm.link( DiskLoc( 1, 2000 ), 400, 0, DiskLoc(), DiskLoc() );
+
+        std::vector<DiskLoc> locs;
+        ASSERT_EQUALS( 500, fsm.recordsBetween( DiskLoc( 0, 2000 ), DiskLoc( 0, 4000 ), &locs ) );
+        ASSERT_EQUALS( 2U, locs.size() );
+        ASSERT_EQUALS( DiskLoc( 0, 2000 ), locs[0] );
+        ASSERT_EQUALS( DiskLoc( 0, 3000 ), locs[1] );
+
+        // the end is excluded, and other files are never in range
+        ASSERT_EQUALS( 100, fsm.recordsBetween( DiskLoc( 0, 0 ), DiskLoc( 0, 2000 ), 0 ) );
+        ASSERT_EQUALS( 0, fsm.recordsBetween( DiskLoc( 0, 3004 ), DiskLoc( 0, 8000 ), 0 ) );
+        ASSERT_EQUALS( 1000, fsm.totalBytes() );
+
+        std::vector<int> lens;
+        fsm.lengthsOutside( DiskLoc( 0, 2000 ), DiskLoc( 0, 3000 ), &lens );
+        ASSERT_EQUALS( 3U, lens.size() );
+        ASSERT_EQUALS( 100, lens[0] );
+        ASSERT_EQUALS( 300, lens[1] );
+        ASSERT_EQUALS( 400, lens[2] );
+    }
+
+    TEST( FreeSpaceMap, Owner ) {
+        FreeSpaceMap fsm;
+        int owner;
+        int other;
+        ASSERT( !fsm.builtFor( &owner ) );
+        fsm.startBuild( &owner );
+        fsm.link( DiskLoc( 0, 1000 ), 200, 0, DiskLoc(), DiskLoc() );
+        ASSERT( fsm.builtFor( &owner ) );
+        ASSERT( !fsm.builtFor( &other ) );
+
+        fsm.markUnmapped( &owner );
+        ASSERT( !fsm.builtFor( &owner ) );
+        ASSERT( fsm.unmappedFor( &owner ) );
+        ASSERT_EQUALS( 0, fsm.numRecords() );
+
+        fsm.reset();
+        ASSERT( !fsm.unmappedFor( &owner ) );
+    }
+
+    TEST( FreeSpaceMap, Stats ) {
+        FreeSpaceMap fsm;
+        fsm.startBuild( &fsm );
+        fsm.link( DiskLoc( 0, 1000 ), 100, 0, DiskLoc(), DiskLoc() );
+        fsm.link( DiskLoc( 0, 2000 ), 300, 0, DiskLoc(), DiskLoc() );
+        fsm.noteAlloc( 10, true );
+        fsm.noteAlloc( 20, false );
+        fsm.noteCoalesced( 2 );
+
+        BSONObjBuilder b;
+        fsm.appendRecordStats( &b, true );
+        fsm.appendCounters( &b );
+        BSONObj stats = b.obj();
+        ASSERT_EQUALS( 2, stats[ "records" ].numberLong() );
+        ASSERT_EQUALS( 400, stats[ "bytes" ].numberLong() );
+        ASSERT_EQUALS( 300, stats[ "largest" ].numberInt() );
+        ASSERT_EQUALS( 0.25, stats[ "fragmentation" ].number() );
+        ASSERT_EQUALS( 2, stats[ "allocs" ].numberLong() );
+        ASSERT_EQUALS( 1, stats[ "allocMisses" ].numberLong() );
+        ASSERT_EQUALS( 15.0, stats[ "avgAllocMicros" ].number() );
+        ASSERT_EQUALS( 2, stats[ "coalesced" ].numberLong() );
+        ASSERT_EQUALS( 2, stats[ "classes" ].Obj().nFields() );
+    }
+
+} // namespace
+} // namespace mongo
@@ -115,12 +115,13 @@ namespace mongo {
                 return;
             }
 
-            typename BtreeBucket<V>::KeyNode kn = bucket->keyNode(pos);
-            key = kn.key.toBson();
-            recordLoc = kn.recordLoc;
+            char buf[ V::KeyMax ];
+            key = bucket->keyAt(pos, buf).toBson();
+            recordLoc = bucket->k(pos).recordLoc;
         }
         virtual BSONObj keyAt(DiskLoc thisLoc, int pos) {
-            return thisLoc.btree<V>()->keyAt(pos).toBson();
+            char buf[ V::KeyMax ];
+            return thisLoc.btree<V>()->keyAt(pos, buf).toBson();
         }
         virtual DiskLoc locate(const IndexDetails &idx , const DiskLoc& thisLoc, const BSONObj& key, const Ordering &order,
                 int& pos, bool& found, const DiskLoc &recordLoc, int direction=1) { 
@@ -143,10 +144,16 @@ namespace mongo {
         return l.woCompare(r, ordering, /*considerfieldname*/false);
     }
 
+    template <>
+    int IndexInterfaceImpl< V2 >::keyCompare(const BSONObj& l, const BSONObj& r, const Ordering &ordering) { 
+        return l.woCompare(r, ordering, /*considerfieldname*/false);
+    }
+
     IndexInterfaceImpl<V0> iii_v0;
     IndexInterfaceImpl<V1> iii_v1;
+    IndexInterfaceImpl<V2> iii_v2;
 
-    IndexInterface *IndexDetails::iis[] = { &iii_v0, &iii_v1 };
+    IndexInterface *IndexDetails::iis[] = { &iii_v0, &iii_v1, &iii_v2 };
 
     int removeFromSysIndexes(const char *ns, const char *idxName) {
         string system_indexes = cc().database()->name + ".system.indexes";
@@ -427,7 +434,7 @@ namespace mongo {
                 // note (one day) we may be able to fresh build less versions than we can use
                 // isASupportedIndexVersionNumber() is what we can use
                 uassert(14803, str::stream() << "this version of mongod cannot build new indexes of version number " << vv, 
-                    vv == 0 || vv == 1);
+                    vv == 0 || vv == 1 || vv == 2);
                 v = (int) vv;
             }
             // idea is to put things we use a lot earlier
@@ -0,0 +1,93 @@
+// @file index_side_table.cpp
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/index_side_table.h"
+
+#include <map>
+
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    MONGO_EXPORT_SERVER_PARAMETER(bgIndexSideTableMaxBytes, int, 256 * 1024 * 1024);
+
+    namespace {
+        typedef std::map<std::string, IndexSideTable*> Registry;
+
+        SimpleMutex registryMutex( "indexSideTables" );
+        Registry registry;
+    }
+
+    IndexSideTable::IndexSideTable( const std::string& indexNs ) :
+        _indexNs( indexNs ),
+        _bytes( 0 ),
+        _total( 0 ),
+        _overflowed( false ) {
+        SimpleMutex::scoped_lock lk( registryMutex );
+        massert( 16764, "index already has a side table: " + indexNs,
+                 registry.insert( std::make_pair( indexNs, this ) ).second );
+    }
+
+    IndexSideTable::~IndexSideTable() {
+        SimpleMutex::scoped_lock lk( registryMutex );
+        registry.erase( _indexNs );
+    }
+
+    IndexSideTable* IndexSideTable::get( const std::string& indexNs ) {
+        SimpleMutex::scoped_lock lk( registryMutex );
+        Registry::const_iterator i = registry.find( indexNs );
+        return i == registry.end() ? NULL : i->second;
+    }
+
+    void IndexSideTable::noteInsert( const BSONObj& key, const DiskLoc& loc ) {
+        _add( key, loc, true );
+    }
+
+    void IndexSideTable::noteRemove( const BSONObj& key, const DiskLoc& loc ) {
+        _add( key, loc, false );
+    }
+
+    void IndexSideTable::take( size_t max, std::vector<Entry>* out ) {
+        for ( size_t i = 0; i < max && !_entries.empty(); i++ ) {
+            const Entry& e = _entries.front();
+            _bytes -= e.key.objsize() + sizeof( Entry );
+            out->push_back( e );
+            _entries.pop_front();
+        }
+    }
+
+    void IndexSideTable::_add( const BSONObj& key, const DiskLoc& loc, bool insert ) {
+        _total++;
+        if ( _overflowed )
+            return;
+        long long bytes = key.objsize() + sizeof( Entry );
+        if ( _bytes + bytes > bgIndexSideTableMaxBytes ) {
+            // the build will be abandoned, so there's no point holding on to anything
+            _overflowed = true;
+            _entries.clear();
+            _bytes = 0;
+            return;
+        }
+        _entries.push_back( Entry( key.getOwned(), loc, insert ) );
+        _bytes += bytes;
+    }
+
+} // namespace mongo
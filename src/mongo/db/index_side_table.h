@@ -0,0 +1,95 @@
+// @file index_side_table.h - Index writes captured while an index is bulk loaded.
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "mongo/db/diskloc.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * The most key bytes an IndexSideTable holds; a table that would grow past it drops its
+     * entries and is marked overflowed, which abandons its index build.  Settable with
+     * setParameter.
+     */
+    extern int bgIndexSideTableMaxBytes;
+
+    /**
+     * Records, in order, the key insertions and removals made to an index while a background
+     * build bulk loads it, so the builder can apply them to the btree it built from its own scan
+     * of the collection.  Applying an entry the scan already saw is harmless: inserting a key the
+     * index already has for the same record is a no op, as is removing one it doesn't.
+     *
+     * A table registers itself under its index's namespace for its lifetime; writers that find
+     * a table for an index record their changes there instead of changing the btree.
+     *
+     * Entries are recorded and taken with the collection's write lock held; the registry has its
+     * own mutex.
+     */
+    class IndexSideTable : boost::noncopyable {
+    public:
+        struct Entry {
+            Entry( const BSONObj& k, const DiskLoc& l, bool ins ) :
+                key( k ), loc( l ), insert( ins ) {
+            }
+            BSONObj key;
+            DiskLoc loc;
+            bool insert; // false for a removal
+        };
+
+        /** Register a table for the index with namespace 'indexNs', which has none. */
+        explicit IndexSideTable( const std::string& indexNs );
+
+        /** Unregister the table. */
+        ~IndexSideTable();
+
+        /** @return the table registered for the index namespace 'indexNs', or NULL. */
+        static IndexSideTable* get( const std::string& indexNs );
+
+        void noteInsert( const BSONObj& key, const DiskLoc& loc );
+        void noteRemove( const BSONObj& key, const DiskLoc& loc );
+
+        /** Move up to 'max' of the oldest entries, oldest first, to the end of 'out'. */
+        void take( size_t max, std::vector<Entry>* out );
+
+        bool empty() const { return _entries.empty(); }
+        size_t numEntries() const { return _entries.size(); }
+        long long numBytes() const { return _bytes; }
+
+        /** @return the number of entries ever recorded. */
+        long long totalEntries() const { return _total; }
+
+        /** @return true if entries were dropped because the table grew too large. */
+        bool overflowed() const { return _overflowed; }
+
+    private:
+        void _add( const BSONObj& key, const DiskLoc& loc, bool insert );
+
+        const std::string _indexNs;
+        std::deque<Entry> _entries;
+        long long _bytes;
+        long long _total;
+        bool _overflowed;
+    };
+
+} // namespace mongo
@@ -0,0 +1,79 @@
+// index_side_table_test.cpp
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** Unit tests for IndexSideTable. */
+
+#include "mongo/db/index_side_table.h"
+
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+    TEST( IndexSideTable, Registry ) {
+        ASSERT( IndexSideTable::get( "test.c.$a_1" ) == NULL );
+        {
+            IndexSideTable table( "test.c.$a_1" );
+            ASSERT_EQUALS( &table, IndexSideTable::get( "test.c.$a_1" ) );
+            ASSERT( IndexSideTable::get( "test.c.$b_1" ) == NULL );
+            ASSERT_THROWS( IndexSideTable( "test.c.$a_1" ), MsgAssertionException );
+        }
+        ASSERT( IndexSideTable::get( "test.c.$a_1" ) == NULL );
+    }
+
+    TEST( IndexSideTable, TakeInOrder ) {
+        IndexSideTable table( "test.c.$a_1" );
+        table.noteInsert( BSON( "" << 1 ), DiskLoc( 0, 100 ) );
+        table.noteRemove( BSON( "" << 1 ), DiskLoc( 0, 100 ) );
+        table.noteInsert( BSON( "" << 2 ), DiskLoc( 0, 100 ) );
+        ASSERT_EQUALS( 3U, table.numEntries() );
+        ASSERT_GREATER_THAN( table.numBytes(), 0 );
+
+        std::vector<IndexSideTable::Entry> batch;
+        table.take( 2, &batch );
+        ASSERT_EQUALS( 2U, batch.size() );
+        ASSERT( batch[0].insert );
+        ASSERT( !batch[1].insert );
+        ASSERT_EQUALS( 1, batch[1].key.firstElement().numberInt() );
+        ASSERT_EQUALS( DiskLoc( 0, 100 ), batch[1].loc );
+
+        table.take( 10, &batch );
+        ASSERT_EQUALS( 3U, batch.size() );
+        ASSERT_EQUALS( 2, batch[2].key.firstElement().numberInt() );
+        ASSERT( table.empty() );
+        ASSERT_EQUALS( 0, table.numBytes() );
+        ASSERT_EQUALS( 3, table.totalEntries() );
+    }
+
+    TEST( IndexSideTable, Overflow ) {
+        int saved = bgIndexSideTableMaxBytes;
+        bgIndexSideTableMaxBytes = 100;
+        IndexSideTable table( "test.c.$a_1" );
+        table.noteInsert( BSON( "" << 1 ), DiskLoc( 0, 100 ) );
+        ASSERT( !table.overflowed() );
+        table.noteInsert( BSON( "" << std::string( 200, 'x' ) ), DiskLoc( 0, 200 ) );
+        ASSERT( table.overflowed() );
+        ASSERT( table.empty() );
+        table.noteRemove( BSON( "" << 1 ), DiskLoc( 0, 100 ) );
+        ASSERT( table.empty() );
+        ASSERT_EQUALS( 3, table.totalEntries() );
+        bgIndexSideTableMaxBytes = saved;
+    }
+
+} // namespace
+} // namespace mongo
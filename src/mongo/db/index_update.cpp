@@ -24,16 +24,25 @@
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/extsort.h"
 #include "mongo/db/index.h"
+#include "mongo/db/index_side_table.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/namespace_details.h"
 #include "mongo/db/pdfile_private.h"
 #include "mongo/db/replutil.h"
 #include "mongo/db/repl/rs.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/sort_phase_one.h"
+#include "mongo/util/elapsed_tracker.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/startup_test.h"
 
 namespace mongo {
+
+    /**
+     * When true, background builds of indexes that accept duplicate keys sort the collection's
+     * keys and build the btree bottom up instead of inserting each document's keys in turn.
+     */
+    MONGO_EXPORT_SERVER_PARAMETER(bgIndexBulkLoad, bool, true);
     
     /* unindex all keys in index for this record. */
     static void _unindexRecord(IndexDetails& id, BSONObj& obj, const DiskLoc& dl, bool logMissing = true) {
@@ -62,6 +71,38 @@ namespace mongo {
         }
     }
 
+    IndexSideTable* sideTableFor(NamespaceDetails* d, int idxNo) {
+        if ( idxNo < d->nIndexes )
+            return NULL;
+        return IndexSideTable::get(d->idx(idxNo).indexNamespace());
+    }
+
+    /* record the insertion or removal of this record's keys in an index's side table. */
+    static void noteKeysInSideTable(IndexSideTable* side, const BSONObjSet& keys,
+                                    const DiskLoc& dl, bool insert) {
+        for ( BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); i++ ) {
+            if ( insert )
+                side->noteInsert(*i, dl);
+            else
+                side->noteRemove(*i, dl);
+        }
+    }
+
+    /* unindex all keys in an index being built for this record. */
+    static void _unindexRecordInProgress(NamespaceDetails* d, int idxNo, BSONObj& obj,
+                                         const DiskLoc& dl) {
+        if ( IndexSideTable* side = sideTableFor(d, idxNo) ) {
+            // the index is being bulk loaded, and its builder removes the keys later
+            BSONObjSet keys;
+            d->idx(idxNo).getKeysFromObject(obj, keys);
+            noteKeysInSideTable(side, keys, dl, false);
+            return;
+        }
+        // Always pass nowarn here, as this one may be missing for valid reasons as we are
+        // concurrently building it
+        _unindexRecord(d->idx(idxNo), obj, dl, false);
+    }
+
 //zzz
     /* unindex all keys in all indexes for this record. */
     void unindexRecord(NamespaceDetails *d, 
@@ -74,9 +115,7 @@ namespace mongo {
             _unindexRecord(d->idx(i), obj, dl, !noWarn);
 
         for (int i = 0; i < d->indexBuildsInProgress; i++) { // background index
-            // Always pass nowarn here, as this one may be missing for valid reasons as we are
-            // concurrently building it
-            _unindexRecord(d->idx(n+i), obj, dl, false);
+            _unindexRecordInProgress(d, n+i, obj, dl);
         }
     }
 
@@ -89,6 +128,10 @@ namespace mongo {
                              const BSONObj& obj,
                              DiskLoc recordLoc,
                              const bool allowDups) {
+        if ( sideTableFor(d, idxNo) ) {
+            // a bulk loading index may have no btree yet
+            return;
+        }
         IndexDetails &idx = d->idx(idxNo);
         idx.getKeysFromObject(obj, keys);
         if( keys.empty() )
@@ -128,6 +171,15 @@ namespace mongo {
         {
             BSONObjSet keys;
             for ( int i = 0; i < n; i++ ) {
+                if ( IndexSideTable* side = sideTableFor(d, i) ) {
+                    // the index is being bulk loaded, and its builder adds the keys later
+                    d->idx(i).getKeysFromObject(obj, keys);
+                    if( keys.size() > 1 )
+                        d->setIndexIsMultikey(ns, i);
+                    noteKeysInSideTable(side, keys, loc, true);
+                    keys.clear();
+                    continue;
+                }
                 // this call throws on unique constraint violation.  we haven't done any writes yet so that is fine.
                 fetchIndexInserters(/*out*/keys, 
                                     inserter, 
@@ -169,7 +221,10 @@ namespace mongo {
                         */
                         for( int j = 0; j < n; j++ ) {
                             try {
-                                _unindexRecord(d->idx(j), obj, loc, false);
+                                if ( j < d->nIndexes )
+                                    _unindexRecord(d->idx(j), obj, loc, false);
+                                else
+                                    _unindexRecordInProgress(d, j, obj, loc);
                             }
                             catch(...) {
                                 LOG(3) << "unindex fails on rollback after unique key constraint prevented insert\n";
@@ -250,7 +305,9 @@ namespace mongo {
                                    SortPhaseOne* phase1,
                                    ProgressMeterHolder& pm,
                                    Timer& t,
-                                   bool mayInterrupt ) {
+                                   bool mayInterrupt,
+                                   bool mayYield ) {
+        verify( dupsAllowed || !mayYield );
         BtreeBuilder<V> btBuilder(dupsAllowed, idx);
         BSONObj keyLast;
         auto_ptr<BSONObjExternalSorter::Iterator> i = sorter.iterator();
@@ -259,6 +316,9 @@ namespace mongo {
                                     "Index: (2/3) BTree Bottom Up Progress",
                                     phase1->nkeys,
                                     10));
+        const string ns = idx.parentNS();
+        const string idxName = idx.indexName();
+        ElapsedTracker yieldTracker(128, 10);
         while( i->more() ) {
             RARELY killCurrentOp.checkForInterrupt( !mayInterrupt );
             BSONObjExternalSorter::Data d = i->next();
@@ -292,6 +352,16 @@ namespace mongo {
                 uassert( 10092 , "too may dups on index build with dropDups=true", dupsToDrop.size() < 1000000 );
             }
             pm.hit();
+
+            if ( mayYield && yieldTracker.intervalHasElapsed() ) {
+                // the keys are read from the sorter's files and the buckets aren't reachable
+                // until the btree is committed, so only the index's position may change
+                ClientCursor::staticYield( ClientCursor::suggestYieldMicros(), ns, NULL );
+                killCurrentOp.checkForInterrupt();
+                int idxNo = IndexBuildsInProgress::get( ns.c_str(), idxName );
+                massert( 16777, "cannot find index build anymore", idxNo != -1 );
+                btBuilder.yielded( nsdetails( ns )->idx( idxNo ) );
+            }
         }
         pm.finished();
         op->setMessage("index: (3/3) btree-middle", "Index: (3/3) BTree Middle Progress");
@@ -319,6 +389,58 @@ namespace mongo {
         }
     }
 
+    /** buildBottomUpPhases2And3 for the version of 'idx'. */
+    static void buildBottomUp( bool dupsAllowed,
+                               IndexDetails& idx,
+                               BSONObjExternalSorter& sorter,
+                               bool dropDups,
+                               set<DiskLoc>& dupsToDrop,
+                               CurOp* op,
+                               SortPhaseOne* phase1,
+                               ProgressMeterHolder& pm,
+                               Timer& t,
+                               bool mayInterrupt,
+                               bool mayYield = false ) {
+        if( idx.version() == 0 )
+            buildBottomUpPhases2And3<V0>(dupsAllowed,
+                                         idx,
+                                         sorter,
+                                         dropDups,
+                                         dupsToDrop,
+                                         op,
+                                         phase1,
+                                         pm,
+                                         t,
+                                         mayInterrupt,
+                                         mayYield);
+        else if( idx.version() == 1 ) 
+            buildBottomUpPhases2And3<V1>(dupsAllowed,
+                                         idx,
+                                         sorter,
+                                         dropDups,
+                                         dupsToDrop,
+                                         op,
+                                         phase1,
+                                         pm,
+                                         t,
+                                         mayInterrupt,
+                                         mayYield);
+        else if( idx.version() == 2 ) 
+            buildBottomUpPhases2And3<V2>(dupsAllowed,
+                                         idx,
+                                         sorter,
+                                         dropDups,
+                                         dupsToDrop,
+                                         op,
+                                         phase1,
+                                         pm,
+                                         t,
+                                         mayInterrupt,
+                                         mayYield);
+        else
+            verify(false);
+    }
+
     // throws DBException
     uint64_t fastBuildIndex(const char* ns,
                             NamespaceDetails* d,
@@ -331,7 +453,7 @@ namespace mongo {
         tlog(1) << "fastBuildIndex " << ns << ' ' << idx.info.obj().toString() << endl;
 
         bool dupsAllowed = !idx.unique() || ignoreUniqueIndex(idx);
-        bool dropDups = idx.dropDups() || inDBRepair;
+        bool dropDups = idx.dropDups() || inDBRepair || cc().isRepairIndexBuild();
         BSONObj order = idx.keyPattern();
 
         getDur().writingDiskLoc(idx.head).Null();
@@ -369,30 +491,8 @@ namespace mongo {
         set<DiskLoc> dupsToDrop;
 
         /* build index --- */
-        if( idx.version() == 0 )
-            buildBottomUpPhases2And3<V0>(dupsAllowed,
-                                         idx,
-                                         sorter,
-                                         dropDups,
-                                         dupsToDrop,
-                                         op,
-                                         phase1,
-                                         pm,
-                                         t,
-                                         mayInterrupt);
-        else if( idx.version() == 1 ) 
-            buildBottomUpPhases2And3<V1>(dupsAllowed,
-                                         idx,
-                                         sorter,
-                                         dropDups,
-                                         dupsToDrop,
-                                         op,
-                                         phase1,
-                                         pm,
-                                         t,
-                                         mayInterrupt);
-        else
-            verify(false);
+        buildBottomUp(dupsAllowed, idx, sorter, dropDups, dupsToDrop, op, phase1, pm, t,
+                      mayInterrupt);
 
         if( dropDups ) 
             log() << "\t fastBuildIndex dupsToDrop:" << dupsToDrop.size() << endl;
@@ -504,6 +604,160 @@ namespace mongo {
             return n;
         }
 
+        /** @return the position of the index being built, which may move while we yield. */
+        int findIndexBuild(const char* ns, const std::string& idxName) {
+            int idxNo = IndexBuildsInProgress::get(ns, idxName);
+            // The index must still be around, because this is the thread that would clean it up
+            massert(16765, "cannot find index build anymore", idxNo != -1);
+            return idxNo;
+        }
+
+        /**
+         * Abandon the build once its side table has overflowed; checked while the build yields so
+         * that an early overflow doesn't pay for the rest of the scan, sort and btree build.
+         */
+        void checkSideTable(const IndexSideTable& sideTable) {
+            uassert(16767, "background index build abandoned: its side table of concurrent "
+                           "changes exceeded bgIndexSideTableMaxBytes",
+                    !sideTable.overflowed());
+        }
+
+        /**
+         * Build the index the way a foreground build does, from an external sort of its keys,
+         * without holding the lock for the collection scan or the sort.  Until the index is
+         * complete, writers record their changes to it in a side table instead of its btree;
+         * once the btree is built they're applied in batches, yielding between batches, and the
+         * last batch is applied with the lock held until the index is published.
+         *
+         * Only for indexes that accept every key, so there is never a duplicate to report to a
+         * writer or to drop.
+         */
+        unsigned long long bulkLoad(const char* ns, NamespaceDetails* d, IndexDetails& idx) {
+            CurOp* op = cc().curop();
+            Timer t;
+
+            std::string idxName = idx.indexName();
+            IndexSideTable sideTable(idx.indexNamespace());
+            getDur().writingDiskLoc(idx.head).Null();
+
+            SortPhaseOne phase1;
+            phase1.sorter.reset(new BSONObjExternalSorter(idx.idxInterface(),
+                                                          idx.keyPattern().getOwned()));
+            phase1.sorter->hintNumObjects(d->stats.nrecords);
+
+            // After a yield idx may point at a different index (if indexes get flipped, see
+            // insert_makeIndex), so below idxNo is recalculated after each yield and idx isn't
+            // used.
+            int idxNo = findIndexBuild(ns, idxName);
+
+            ProgressMeterHolder pm(op->setMessage("bg index build: collection scan",
+                                                  "Background Index Build Scan Progress",
+                                                  d->stats.nrecords,
+                                                  10));
+            {
+                auto_ptr<ClientCursor> cc;
+                {
+                    shared_ptr<Cursor> c = theDataFileMgr.findAll(ns);
+                    cc.reset( new ClientCursor(QueryOption_NoCursorTimeout, c, ns) );
+                }
+                while ( cc->ok() ) {
+                    phase1.addKeys(d->idx(idxNo).getSpec(), cc->current(), cc->currLoc(), true);
+                    cc->advance();
+                    pm.hit();
+
+                    if ( !cc->yieldSometimes( ClientCursor::WillNeed ) ) {
+                        cc.release();
+                        uasserted(16766, "cursor gone during bg index bulk load");
+                    }
+                    pm->setTotalWhileRunning( d->stats.nrecords );
+                    idxNo = findIndexBuild(ns, idxName);
+                    checkSideTable(sideTable);
+                }
+            }
+            pm.finished();
+
+            op->setMessage("bg index build: external sort");
+            {
+                // the sorter holds its own copy of every key, so nothing here needs the lock
+                dbtempreleasecond unlock;
+                phase1.sorter->sort(true);
+            }
+            killCurrentOp.checkForInterrupt();
+            checkSideTable(sideTable);
+            idxNo = findIndexBuild(ns, idxName);
+            if ( phase1.multi ) {
+                d->setIndexIsMultikey(ns, idxNo);
+            }
+            LOG(t.seconds() > 5 ? 0 : 1) << "\t external sort used : "
+                                         << phase1.sorter->numFiles() << " files in "
+                                         << t.seconds() << " secs" << endl;
+
+            // yields while the leaf buckets are filled; building the levels above them, about
+            // one key per leaf bucket, doesn't
+            set<DiskLoc> dupsToDrop;
+            buildBottomUp(true, d->idx(idxNo), *phase1.sorter, false, dupsToDrop, op, &phase1,
+                          pm, t, true, true);
+
+            unsigned long long applied = applySideTable(ns, d, idxName, &sideTable);
+            log() << "\t bg index bulk loaded " << phase1.nkeys << " keys, then applied "
+                  << applied << " concurrent changes" << endl;
+            return phase1.n;
+        }
+
+        /**
+         * Apply the changes recorded in 'sideTable' to the built btree until none are left,
+         * yielding between batches and checking for a kill or an overflow after each.  Returns with the lock held and the table empty.
+         */
+        unsigned long long applySideTable(const char* ns, NamespaceDetails* d,
+                                          const std::string& idxName,
+                                          IndexSideTable* sideTable) {
+            const size_t batchSize = 1000;
+            ProgressMeter& progress = cc().curop()->setMessage("bg index build: catch up",
+                                                               "Background Index Catch Up Progress",
+                                                               sideTable->numEntries());
+            unsigned long long applied = 0;
+            vector<IndexSideTable::Entry> batch;
+            while ( true ) {
+                killCurrentOp.checkForInterrupt();
+                checkSideTable(*sideTable);
+                batch.clear();
+                sideTable->take(batchSize, &batch);
+                if ( batch.empty() ) {
+                    break;
+                }
+
+                int idxNo = findIndexBuild(ns, idxName);
+                IndexDetails& idx = d->idx(idxNo);
+                IndexInterface& ii = idx.idxInterface();
+                Ordering ordering = Ordering::make(idx.keyPattern());
+                for ( vector<IndexSideTable::Entry>::const_iterator i = batch.begin();
+                      i != batch.end(); ++i ) {
+                    try {
+                        if ( i->insert ) {
+                            ii.bt_insert(idx.head, i->loc, i->key, ordering, true, idx);
+                        }
+                        else {
+                            ii.unindex(idx.head, idx, i->key, i->loc);
+                        }
+                    }
+                    catch ( AssertionException& e ) {
+                        // the scan may already have loaded the key
+                        if ( e.getCode() != 10287 ) {
+                            throw;
+                        }
+                    }
+                }
+                applied += batch.size();
+                progress.setTotalWhileRunning( applied + sideTable->numEntries() );
+                progress.hit( batch.size() );
+                getDur().commitIfNeeded();
+
+                ClientCursor::staticYield( ClientCursor::suggestYieldMicros(), ns, NULL );
+            }
+            progress.finished();
+            return applied;
+        }
+
         /* we do set a flag in the namespace for quick checking, but this is our authoritative info -
            that way on a crash/restart, we don't think we are still building one. */
         set<NamespaceDetails*> bgJobsInProgress;
@@ -531,8 +785,13 @@ namespace mongo {
 
             prep(ns.c_str(), d);
             try {
-                idx.head.writing() = idx.idxInterface().addBucket(idx);
-                n = addExistingToIndex(ns.c_str(), d, idx);
+                if ( bgIndexBulkLoad && !idx.unique() ) {
+                    n = bulkLoad(ns.c_str(), d, idx);
+                }
+                else {
+                    idx.head.writing() = idx.idxInterface().addBucket(idx);
+                    n = addExistingToIndex(ns.c_str(), d, idx);
+                }
                 // idx may point at an invalid index entry at this point
             }
             catch(...) {
@@ -564,7 +823,7 @@ namespace mongo {
         // Build index spec here in case the collection is empty and the index details are invalid
         idx.getSpec();
 
-        if( inDBRepair || !background ) {
+        if( inDBRepair || cc().isRepairIndexBuild() || !background ) {
             n = fastBuildIndex(ns.c_str(), d, idx, mayInterrupt);
             verify( !idx.head.isNull() );
         }
@@ -22,9 +22,14 @@
 #include "mongo/platform/cstdint.h"
 
 namespace mongo {
+    class IndexSideTable;
     class NamespaceDetails;
     class Record;
 
+    // If index idxNo of d is being bulk loaded in the background, returns the side table its
+    // writes go to instead of its btree; otherwise NULL.
+    IndexSideTable* sideTableFor(NamespaceDetails* d, int idxNo);
+
     // unindex all keys in index for this record. 
     void unindexRecord(NamespaceDetails *d, Record *todelete, const DiskLoc& dl, bool noWarn = false);
 
@@ -77,7 +82,12 @@ namespace mongo {
                             ProgressMeter* progressMeter,
                             bool mayInterrupt );
 
-    /** Popuate the index @param 'idx' using the keys contained in @param 'sorter'. */
+    /**
+     * Popuate the index @param 'idx' using the keys contained in @param 'sorter'.
+     * With @param 'mayYield', which requires 'dupsAllowed', the lock is yielded now and then
+     * while the leaf buckets are filled; 'idx' must be an index build in progress, and is
+     * looked up again by name after each yield.
+     */
     template< class V >
     void buildBottomUpPhases2And3( bool dupsAllowed,
                                    IndexDetails& idx,
@@ -88,7 +98,8 @@ namespace mongo {
                                    SortPhaseOne* phase1,
                                    ProgressMeterHolder& pm,
                                    Timer& t,
-                                   bool mayInterrupt );
+                                   bool mayInterrupt,
+                                   bool mayYield = false );
 
     /** Drop duplicate documents from the set @param 'dupsToDrop'. */
     void doDropDups( const char* ns,
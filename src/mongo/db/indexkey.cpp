@@ -459,7 +459,8 @@ namespace mongo {
                 g.getKeys( obj, keys );
                 break;
             }
-            case 1: {
+            case 1:
+            case 2: { // v:2 only changes how the btree stores keys; they are still KeyV1 data
                 KeyGeneratorV1 g( *this );
                 g.getKeys( obj, keys );
                 break;
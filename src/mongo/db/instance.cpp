@@ -516,6 +516,18 @@ namespace mongo {
         delete database; // closes files
     }
 
+    Lock::DBWrite* lockForCollectionWrite( const char *ns ) {
+        auto_ptr<Lock::DBWrite> lk( new Lock::DBWrite( ns, true ) );
+        if ( lk->collectionLocked() ) {
+            Database *db = dbHolder().get( ns, dbpath );
+            if ( !db || !db->namespaceIndex.details( ns ) ) {
+                lk.reset();
+                lk.reset( new Lock::DBWrite( ns ) );
+            }
+        }
+        return lk.release();
+    }
+
     void receivedUpdate(Message& m, CurOp& op) {
         DbMessage d(m);
         const char *ns = d.getns();
@@ -542,7 +554,7 @@ namespace mongo {
         PageFaultRetryableSection s;
         while ( 1 ) {
             try {
-                Lock::DBWrite lk(ns);
+                scoped_ptr<Lock::DBWrite> lk( lockForCollectionWrite( ns ) );
                 
                 // void ReplSetImpl::relinquish() uses big write lock so 
                 // this is thus synchronized given our lock above.
@@ -584,7 +596,7 @@ namespace mongo {
         PageFaultRetryableSection s;
         while ( 1 ) {
             try {
-                Lock::DBWrite lk(ns);
+                scoped_ptr<Lock::DBWrite> lk( lockForCollectionWrite( ns ) );
                 
                 // writelock is used to synchronize stepdowns w/ writes
                 uassert( 10056 ,  "not master", isMasterNs( ns ) );
@@ -815,7 +827,7 @@ namespace mongo {
         PageFaultRetryableSection s;
         while ( true ) {
             try {
-                Lock::DBWrite lk(ns);
+                scoped_ptr<Lock::DBWrite> lk( lockForCollectionWrite( ns ) );
                 
                 // CONCURRENCY TODO: is being read locked in big log sufficient here?
                 // writelock is used to synchronize stepdowns w/ writes
@@ -73,6 +73,13 @@ namespace mongo {
 
     void getDatabaseNames( vector< string > &names , const string& usePath = dbpath );
 
+    /**
+     * Write lock ns for an insert, update or delete.  Where that only locks the collection, an
+     * unopened database or a missing collection would have to be created with just the collection
+     * locked, so then the whole database is locked instead.
+     */
+    Lock::DBWrite* lockForCollectionWrite( const char *ns );
+
     /* returns true if there is no data on this server.  useful when starting replication.
        local database does NOT count.
     */
@@ -355,6 +355,30 @@ namespace mongo {
         dassert( (*_keyData & cNOTUSED) == 0 );
     }
 
+    KeyV2::KeyV2(const BSONObj& obj) : _inBuffer(false) {
+        KeyV1Owned k(obj);
+        _copy(k.data(), k.dataSize());
+    }
+
+    KeyV2 KeyV2::copyOf(const KeyV1& key) {
+        KeyV2 k;
+        k._copy(key.data(), key.dataSize());
+        return k;
+    }
+
+    void KeyV2::_copy(const char *keyData, int len) {
+        StackBufBuilder b;
+        b.appendUChar(0); // nothing shared with a bucket prefix
+        b.appendBuf(keyData, len);
+        _owned = RCString::create(StringData(b.buf(), b.len()));
+        _keyData = (const unsigned char *) _owned->c_str() + 1;
+    }
+
+    BSONObj KeyV2::toBson() const {
+        BSONObj o = KeyV1::toBson();
+        return _owned || _inBuffer ? o.getOwned() : o;
+    }
+
     BSONObj KeyV1::toBson() const { 
         verify( _keyData != 0 );
         if( !isCompactFormat() )
@@ -19,6 +19,7 @@
 #pragma once
  
 #include "jsobj.h"
+#include "mongo/util/intrusive_counter.h"
 
 namespace mongo { 
 
@@ -27,6 +28,8 @@ namespace mongo {
         KeyBson is a legacy wrapper implementation for old BSONObj style keys for v:0 indexes.
 
         KeyV1 is the new implementation.
+
+        KeyV2 is KeyV1 as stored in the prefix compressed buckets of v:2 indexes.
     */
     class KeyBson /* "KeyV0" */ { 
     public:
@@ -115,4 +118,60 @@ namespace mongo {
         void traditional(const BSONObj& obj); // store as traditional bson not as compact format
     };
 
+    // corresponding to BtreeData_V2
+    /**
+     * The data of a KeyV2 is KeyV1 data preceded by a byte counting the leading bytes that were
+     * left out of it in favor of its bucket's prefix, which is always zero here: a key read from a
+     * bucket points at uncompressed data there, at a copy decompressed to a buffer its reader
+     * provided, or owns a decompressed copy.  Comparisons and translation to bson are KeyV1's.
+     */
+    class KeyV2 : public KeyV1 {
+        void operator=(const KeyV2&);
+    public:
+        KeyV2() : _inBuffer(false) { }
+
+        KeyV2(const KeyV2& rhs) : KeyV1(rhs), _owned(rhs._owned), _inBuffer(rhs._inBuffer) { }
+
+        /** @param storedData uncompressed key data in a bucket, a zero byte then KeyV1 data. */
+        explicit KeyV2(const char *storedData) : KeyV1(storedData + 1), _inBuffer(false) { }
+
+        /** @obj a BSON object translated to KeyV1 format as by KeyV1Owned, into a copy we own. */
+        explicit KeyV2(const BSONObj& obj);
+
+        /** @return a key owning a copy of 'key', e.g. one decompressed to a temporary buffer. */
+        static KeyV2 copyOf(const KeyV1& key);
+
+        /**
+         * @param data a zero byte then KeyV1 data, decompressed to a buffer of the caller's.
+         * @return a key valid only as long as that buffer is.
+         */
+        static KeyV2 inBuffer(const char *data) {
+            KeyV2 k(data);
+            k._inBuffer = true;
+            return k;
+        }
+
+        void assign(const KeyV2& rhs) {
+            KeyV1::assign(rhs);
+            _owned = rhs._owned;
+            _inBuffer = rhs._inBuffer;
+        }
+
+        /** get the key data we want to store in the btree bucket, uncompressed */
+        const char * data() const { return KeyV1::data() - 1; }
+
+        /** @return size of data() */
+        int dataSize() const { return KeyV1::dataSize() + 1; }
+
+        /** a key we own or read to a buffer may go before the result, so bson keys are then copied */
+        BSONObj toBson() const;
+        string toString() const { return toBson().toString(); }
+
+    private:
+        void _copy(const char *keyData, int len);
+
+        intrusive_ptr<const RCString> _owned;
+        bool _inBuffer;
+    };
+
 };
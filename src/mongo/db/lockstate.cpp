@@ -34,6 +34,7 @@ namespace mongo {
           _nestableCount(0), 
           _otherCount(0), 
           _otherLock(NULL),
+          _collectionLock(NULL),
           _scopedLk(NULL),
           _lockPending(false),
           _lockPendingParallelWriter(false)
@@ -61,8 +62,19 @@ namespace mongo {
         nsToDatabase(ns, db);
         
         DEV verify( _otherName.find( '.' ) == string::npos ); // XXX this shouldn't be here, but somewhere
-        if ( _otherCount && db == _otherName )
+        if ( _otherCount && db == _otherName ) {
+            if ( _collectionLock ) {
+                // only our own collection, its indexes (<collection>.$<index>), and the
+                // database's freelist, whose extent allocation has a mutex of its own, are
+                // covered by a collection lock
+                if ( ns == db || ns == _collectionName )
+                    return true;
+                if ( ns.startsWith( _collectionName + ".$" ) )
+                    return true;
+                return ns == string( db ) + ".$freelist";
+            }
             return true;
+        }
 
         if ( _nestableCount ) {
             if ( mongoutils::str::equals( db , "local" ) )
@@ -125,7 +137,14 @@ namespace mongo {
             if( k ) {
                 string s = "^";
                 s += k->name();
-                b.append(s, kind(_otherCount));
+                WrapperForRWLock *c = _collectionLock;
+                if( c ) {
+                    b.append(s, "w");
+                    b.append("^" + c->name(), kind(_otherCount));
+                }
+                else {
+                    b.append(s, kind(_otherCount));
+                }
             }
         }
         BSONObj o = b.obj();
@@ -153,6 +172,9 @@ namespace mongo {
             if( _otherCount ) {
                 ss << " otherdb:" << _otherName;
             }
+            if( _collectionLock ) {
+                ss << " collection:" << _collectionName;
+            }
             if( _nestableCount ) {
                 ss << " nestableCount:" << _nestableCount << " which:";
                 if( _whichNestable == Lock::local ) 
@@ -214,6 +236,14 @@ namespace mongo {
         _otherName = "";
         _otherCount = 0;
         _otherLock = 0;
+        _collectionName = "";
+        _collectionLock = 0;
+    }
+
+    void LockState::lockedCollection( const StringData& ns , WrapperForRWLock* lock ) {
+        fassert( 16753 , _otherCount > 0 && _collectionLock == 0 );
+        _collectionName = ns.toString();
+        _collectionLock = lock;
     }
 
     LockStat* LockState::getRelevantLockStat() {
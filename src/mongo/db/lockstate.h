@@ -20,6 +20,7 @@
 #pragma once
 
 #include "mongo/db/d_concurrency.h"
+#include "mongo/util/concurrency/qlock.h"
 
 namespace mongo {
 
@@ -70,6 +71,10 @@ namespace mongo {
         int otherCount() const { return _otherCount; }
         const string& otherName() const { return _otherName; }
         WrapperForRWLock* otherLock() const { return _otherLock; }
+
+        /** the collection we hold exclusively while holding otherLock() in intent mode, if any */
+        WrapperForRWLock* collectionLock() const { return _collectionLock; }
+        const string& collectionName() const { return _collectionName; }
         
         void enterScopedLock( Lock::ScopedLock* lock );
         Lock::ScopedLock* leaveScopedLock();
@@ -79,6 +84,7 @@ namespace mongo {
         void lockedOther( const StringData& db , int type , WrapperForRWLock* lock );
         void lockedOther( int type );  // "same lock as last time" case 
         void unlockedOther();
+        void lockedCollection( const StringData& ns , WrapperForRWLock* lock );
         bool _batchWriter;
 
         LockStat* getRelevantLockStat();
@@ -99,6 +105,10 @@ namespace mongo {
         string _otherName;             // which database are we locking and working with (besides local/admin) 
         WrapperForRWLock* _otherLock;  // so we don't have to check the map too often (the map has a mutex)
 
+        // collection level locking related; set only while _otherLock is held in intent mode
+        string _collectionName;
+        WrapperForRWLock* _collectionLock;
+
         // for temprelease
         // for the nonrecursive case. otherwise there would be many
         // the first lock goes here, which is ok since we can't yield recursive locks
@@ -111,16 +121,23 @@ namespace mongo {
         friend class AcquiringParallelWriter;
     };
 
+    /** a database or collection lock.  lock_intent() is the 'w' mode of a QLock: intent writers
+        are compatible with one another but not with lock() or lock_shared().  a database lock held
+        that way is paired with exclusive locks on the collections written.
+    */
     class WrapperForRWLock : boost::noncopyable { 
-        SimpleRWLock r;
+        QLock q;
+        const string _name;
     public:
-        string name() const { return r.name; }
+        string name() const { return _name; }
         LockStat stats;
-        WrapperForRWLock(const StringData& name) : r(name) { }
-        void lock()          { r.lock(); }
-        void lock_shared()   { r.lock_shared(); }
-        void unlock()        { r.unlock(); }
-        void unlock_shared() { r.unlock_shared(); }
+        WrapperForRWLock(const StringData& name) : _name(name.toString()) { }
+        void lock()          { q.lock_W(); }
+        void lock_shared()   { q.lock_R(); }
+        void lock_intent()   { q.lock_w(); }
+        void unlock()        { q.unlock_W(); }
+        void unlock_shared() { q.unlock_R(); }
+        void unlock_intent() { q.unlock_w(); }
     };
 
     class ScopedLock;
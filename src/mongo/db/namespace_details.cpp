@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <list>
+#include <set>
 
 #include <boost/filesystem/operations.hpp>
 
@@ -227,6 +228,47 @@ namespace mongo {
         }
     }
 
+    void NamespaceDetails::addDeletedRec(const char *ns, DeletedRecord *d, DiskLoc dloc) {
+        if ( !isCapped() ) {
+            const DiskLoc& compacting = NamespaceDetailsTransient::get(ns).compactingExtent();
+            if ( !compacting.isNull() && compacting == DiskLoc(dloc.a(), d->extentOfs()) ) {
+                // orphaned: the extent is freed whole when the compact has emptied it
+                return;
+            }
+        }
+
+        FreeSpaceMap* fsm = _freeSpaceMap(ns);
+        if ( !fsm ) {
+            addDeletedRec(d, dloc);
+            return;
+        }
+
+        // merge with the deleted records on either side of us in our extent
+        int merged = 0;
+        DiskLoc after = dloc;
+        after.inc(d->lengthWithHeaders());
+        if ( fsm->lengthAt(after) && after.drec()->extentOfs() == d->extentOfs() &&
+             _unlinkDeleted(*fsm, after) ) {
+            getDur().writingInt(d->lengthWithHeaders()) += after.drec()->lengthWithHeaders();
+            merged++;
+        }
+        DiskLoc before = fsm->recordEndingAt(dloc);
+        if ( !before.isNull() && before.drec()->extentOfs() == d->extentOfs() &&
+             _unlinkDeleted(*fsm, before) ) {
+            getDur().writingInt(before.drec()->lengthWithHeaders()) += d->lengthWithHeaders();
+            d = before.drec();
+            dloc = before;
+            merged++;
+        }
+        fsm->noteCoalesced(merged);
+
+        int b = bucket(d->lengthWithHeaders());
+        DiskLoc oldHead = deletedList[b];
+        addDeletedRec(d, dloc);
+        if ( fsm->builtFor(this) )
+            fsm->link(dloc, d->lengthWithHeaders(), b, DiskLoc(), oldHead);
+    }
+
     /* @return the size for an allocated record quantized to 1/16th of the BucketSize
        @param allocSize    requested size to allocate
     */
@@ -263,6 +305,8 @@ namespace mongo {
     DiskLoc NamespaceDetails::allocWillBeAt(const char *ns, int lenToAlloc) {
         if ( ! isCapped() ) {
             lenToAlloc = (lenToAlloc + 3) & 0xfffffffc;
+            if ( FreeSpaceMap* fsm = _freeSpaceMap(ns) )
+                return _mappedAlloc(*fsm, lenToAlloc, true);
             return __stdAlloc(lenToAlloc, true);
         }
         return DiskLoc();
@@ -326,7 +370,7 @@ namespace mongo {
         newDelW->lengthWithHeaders() = left;
         newDelW->nextDeleted().Null();
 
-        addDeletedRec(newDel, newDelLoc);
+        addDeletedRec(ns, newDel, newDelLoc);
 
         return loc;
     }
@@ -413,6 +457,177 @@ namespace mongo {
         return bestmatch;
     }
 
+    /* @return the free space map of non capped ns, built from our deleted lists if need be, or
+       null if we walk the deleted lists instead.
+    */
+    FreeSpaceMap* NamespaceDetails::_freeSpaceMap(const char *ns) {
+        if ( isCapped() || freeSpaceMapMaxRecords <= 0 )
+            return 0;
+        FreeSpaceMap& fsm = NamespaceDetailsTransient::get(ns).freeSpaceMap();
+        if ( fsm.builtFor(this) )
+            return &fsm;
+        if ( fsm.unmappedFor(this) )
+            return 0;
+
+        Timer t;
+        if ( !_mapDeletedLists(ns, fsm, freeSpaceMapMaxRecords) )
+            return 0;
+        int ms = t.millis();
+        if ( ms > 100 ) {
+            log() << "mapped " << fsm.numRecords() << " deleted records of " << ns << " in "
+                  << ms << "ms" << endl;
+        }
+        return &fsm;
+    }
+
+    /* add every record on our deleted lists to fsm.
+       @return false, leaving fsm marked unmapped, on a bad link or more than maxRecords records
+    */
+    bool NamespaceDetails::_mapDeletedLists(const char *ns, FreeSpaceMap& fsm,
+                                            long long maxRecords) {
+        fsm.startBuild(this);
+        for ( int b = 0; b < Buckets; b++ ) {
+            DiskLoc prev;
+            for ( DiskLoc cur = deletedList[b]; !cur.isNull(); cur = cur.drec()->nextDeleted() ) {
+                if ( cur.questionable() ) {
+                    // leave it to __stdAlloc and validate to report
+                    warning() << "bad deleted record link " << cur.toString() << " in bucket " << b
+                              << " of " << ns << ", not mapping its free space" << endl;
+                    fsm.markUnmapped(this);
+                    return false;
+                }
+                if ( fsm.numRecords() >= maxRecords ) {
+                    log() << ns << " has over " << maxRecords
+                          << " deleted records, not mapping its free space" << endl;
+                    fsm.markUnmapped(this);
+                    return false;
+                }
+                fsm.link(cur, cur.drec()->lengthWithHeaders(), b, prev, DiskLoc());
+                prev = cur;
+            }
+        }
+        return true;
+    }
+
+    /* __stdAlloc for a collection with a free space map: takes the best fitting deleted record */
+    DiskLoc NamespaceDetails::_mappedAlloc(FreeSpaceMap& fsm, int len, bool peekOnly) {
+        Timer t;
+        DiskLoc loc = fsm.bestFit(len);
+        if ( peekOnly )
+            return loc;
+        if ( !loc.isNull() && !_unlinkDeleted(fsm, loc) )
+            return __stdAlloc(len, false);
+        fsm.noteAlloc(t.micros(), !loc.isNull());
+        return loc;
+    }
+
+    /* unlink a deleted record from its chain, without walking the chain.
+       @return false, and forget the map, if the map is out of step with the chain.
+    */
+    bool NamespaceDetails::_unlinkDeleted(FreeSpaceMap& fsm, const DiskLoc& dloc) {
+        int b;
+        DiskLoc prev;
+        DiskLoc next;
+        verify( fsm.unlink(dloc, &b, &prev, &next) );
+        DeletedRecord *r = dloc.drec();
+        DiskLoc& link = prev.isNull() ? deletedList[b] : prev.drec()->nextDeleted();
+        if ( link != dloc || r->nextDeleted() != next ) {
+            warning() << "free space map out of step with deleted list at " << dloc.toString()
+                      << " in bucket " << b << ", rebuilding it" << endl;
+            fsm.reset();
+            return false;
+        }
+        getDur().writingDiskLoc(link) = next;
+        r->nextDeleted().writing().setInvalid(); // defensive.
+        verify(r->extentOfs() < dloc.getOfs());
+        return true;
+    }
+
+    void NamespaceDetails::appendFreeSpaceStats(const char *ns, BSONObjBuilder *b, bool scan) {
+        FreeSpaceMap& fsm = NamespaceDetailsTransient::get(ns).freeSpaceMap();
+        bool mapped = fsm.builtFor(this);
+        b->appendBool("mapped", mapped);
+        if ( mapped ) {
+            fsm.appendRecordStats(b, scan);
+        }
+        else if ( scan ) {
+            FreeSpaceMap scratch;
+            if ( _mapDeletedLists(ns, scratch, std::numeric_limits<long long>::max()) )
+                scratch.appendRecordStats(b, true);
+        }
+        fsm.appendCounters(b);
+    }
+
+    bool NamespaceDetails::allocsFitOutsideExtent(const char *ns, const DiskLoc& ext,
+                                                  const vector<int>& lens) {
+        vector<int> free;
+        if ( FreeSpaceMap* fsm = _freeSpaceMap(ns) ) {
+            DiskLoc end = ext;
+            end.inc(ext.ext()->length);
+            fsm->lengthsOutside(ext, end, &free);
+        }
+        else {
+            _walkDeletedLists(ext, false, &free);
+        }
+
+        multiset<int> left(free.begin(), free.end());
+        for ( vector<int>::const_iterator i = lens.begin(); i != lens.end(); ++i ) {
+            int len = (*i + 3) & 0xfffffffc;
+            multiset<int>::iterator best = left.lower_bound(len);
+            if ( best == left.end() )
+                return false;
+            int regionlen = *best;
+            left.erase(best);
+            // as in alloc(): the remainder is split off when it's big enough to be worth keeping
+            if ( regionlen - len < 24 || regionlen - len < (len >> 3) )
+                continue;
+            len = std::min(regionlen, quantizeAllocationSpace(len));
+            if ( regionlen - len >= 24 )
+                left.insert(regionlen - len);
+        }
+        return true;
+    }
+
+    void NamespaceDetails::unlinkDeletedInExtent(const char *ns, const DiskLoc& ext) {
+        if ( FreeSpaceMap* fsm = _freeSpaceMap(ns) ) {
+            DiskLoc end = ext;
+            end.inc(ext.ext()->length);
+            vector<DiskLoc> locs;
+            fsm->recordsBetween(ext, end, &locs);
+            vector<DiskLoc>::const_iterator i = locs.begin();
+            while ( i != locs.end() && _unlinkDeleted(*fsm, *i) )
+                ++i;
+            if ( i == locs.end() )
+                return;
+            // the map was out of step and has been reset; finish the job the slow way
+        }
+        _walkDeletedLists(ext, true, 0);
+        // the map no longer mirrors the lists, it's rebuilt on the next allocation
+        NamespaceDetailsTransient::get(ns).freeSpaceMap().reset();
+    }
+
+    /* walk our deleted lists.  if unlink, take the deleted records in extent ext off them.
+       @param lensOutside if not null, the lengths of the deleted records outside ext are
+              appended to it.
+    */
+    void NamespaceDetails::_walkDeletedLists(const DiskLoc& ext, bool unlink,
+                                             vector<int> *lensOutside) {
+        for ( int b = 0; b < Buckets; b++ ) {
+            DiskLoc *prev = &deletedList[b];
+            while ( !prev->isNull() ) {
+                DeletedRecord *r = prev->drec();
+                bool inExt = prev->a() == ext.a() && r->extentOfs() == ext.getOfs();
+                if ( inExt && unlink ) {
+                    getDur().writingDiskLoc(*prev) = r->nextDeleted();
+                    continue;
+                }
+                if ( !inExt && lensOutside )
+                    lensOutside->push_back(r->lengthWithHeaders());
+                prev = &r->nextDeleted();
+            }
+        }
+    }
+
     void NamespaceDetails::dumpDeleted(set<DiskLoc> *extents) {
         for ( int i = 0; i < Buckets; i++ ) {
             DiskLoc dl = deletedList[i];
@@ -469,18 +684,23 @@ namespace mongo {
 
     /* alloc with capped table handling. */
     DiskLoc NamespaceDetails::_alloc(const char *ns, int len) {
-        if ( ! isCapped() )
+        if ( ! isCapped() ) {
+            if ( FreeSpaceMap* fsm = _freeSpaceMap(ns) )
+                return _mappedAlloc(*fsm, len, false);
             return __stdAlloc(len, false);
+        }
 
         return cappedAlloc(ns,len);
     }
 
     void NamespaceIndex::kill_ns(const char *ns) {
-        Lock::assertWriteLocked(ns);
+        Lock::assertWholeDBWriteLocked(ns);
         if ( !ht )
             return;
         Namespace n(ns);
         ht->kill(n);
+        // the ns's free space map and cached plans refer to the details we just freed
+        NamespaceDetailsTransient::eraseCollection(ns);
 
         for( int i = 0; i<=1; i++ ) {
             try {
@@ -498,7 +718,7 @@ namespace mongo {
         add_ns( ns, details );
     }
     void NamespaceIndex::add_ns( const char *ns, const NamespaceDetails &details ) {
-        Lock::assertWriteLocked(ns);
+        Lock::assertWholeDBWriteLocked(ns);
         init();
         Namespace n(ns);
         uassert( 10081 , "too many namespaces/collections", ht->put(n, details));
@@ -506,7 +726,7 @@ namespace mongo {
 
     /* extra space for indexes when more than 10 */
     NamespaceDetails::Extra* NamespaceIndex::newExtra(const char *ns, int i, NamespaceDetails *d) {
-        Lock::assertWriteLocked(ns);
+        Lock::assertWholeDBWriteLocked(ns);
         verify( i >= 0 && i <= 1 );
         Namespace n(ns);
         Namespace extra(n.extraName(i).c_str()); // throws userexception if ns name too long
@@ -716,7 +936,7 @@ namespace mongo {
     // that is NOT handled here yet!  TODO
     // repair may not use nsdt though not sure.  anyway, requires work.
     NamespaceDetailsTransient::NamespaceDetailsTransient(Database *db, const string& ns) : 
-        _ns(ns), _keysComputed(false), _qcWriteCount() 
+        _ns(ns), _keysComputed(false)
     {
         dassert(db);
     }
@@ -19,12 +19,14 @@
 #include "mongo/pch.h"
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/diskloc.h"
+#include "mongo/db/free_space_map.h"
 #include "mongo/db/index.h"
 #include "mongo/db/index_set.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/mongommf.h"
 #include "mongo/db/namespace.h"
 #include "mongo/db/namespacestring.h"
+#include "mongo/db/query_plan_cache.h"
 #include "mongo/db/querypattern.h"
 #include "mongo/platform/unordered_map.h"
 #include "mongo/util/hashtab.h"
@@ -190,7 +192,8 @@ namespace mongo {
         };
 
         enum UserFlags {
-            Flag_UsePowerOf2Sizes = 1 << 0
+            Flag_UsePowerOf2Sizes = 1 << 0,
+            Flag_CompressRecords = 1 << 1 // store new and rewritten records compressed
         };
 
         IndexDetails& idx(int idxNo, bool missingExpected = false );
@@ -391,6 +394,27 @@ namespace mongo {
 
         /* add a given record to the deleted chains for this NS */
         void addDeletedRec(DeletedRecord *d, DiskLoc dloc);
+        /* add a given record to the deleted chains of ns.  if ns has a free space map the record
+           is merged with any deleted records next to it in its extent, and the map kept in step.
+           a record in the extent an online compact is emptying is left off the chains.
+        */
+        void addDeletedRec(const char *ns, DeletedRecord *d, DiskLoc dloc);
+        /* append the free space of non capped ns: its deleted records and their fragmentation
+           if they are mapped, and the times taken to allocate from them.
+           @param scan count the deleted lists if they are not mapped, and break the deleted
+                  records down by size class
+        */
+        void appendFreeSpaceStats(const char *ns, BSONObjBuilder *b, bool scan);
+        /* @return true if the deleted records of non capped ns outside extent ext can take
+           allocations of each of lens, in order, the way alloc() would best fit and split them.
+           neighbors freed meanwhile aren't merged, so a true is never optimistic.  read from the
+           free space map when there is one, else the deleted lists are walked.
+        */
+        bool allocsFitOutsideExtent(const char *ns, const DiskLoc& ext, const vector<int>& lens);
+        /* take the deleted records in extent ext of non capped ns off the deleted lists, for an
+           online compact about to empty it.
+        */
+        void unlinkDeletedInExtent(const char *ns, const DiskLoc& ext);
         void dumpDeleted(set<DiskLoc> *extents = 0);
         // Start from firstExtent by default.
         DiskLoc firstRecord( const DiskLoc &startExtent = DiskLoc() ) const;
@@ -414,6 +438,11 @@ namespace mongo {
         DiskLoc _alloc(const char *ns, int len);
         void maybeComplain( const char *ns, int len ) const;
         DiskLoc __stdAlloc(int len, bool willBeAt);
+        FreeSpaceMap* _freeSpaceMap(const char *ns);
+        bool _mapDeletedLists(const char *ns, FreeSpaceMap& fsm, long long maxRecords);
+        DiskLoc _mappedAlloc(FreeSpaceMap& fsm, int len, bool peekOnly);
+        bool _unlinkDeleted(FreeSpaceMap& fsm, const DiskLoc& dloc);
+        void _walkDeletedLists(const DiskLoc& ext, bool unlink, vector<int> *lensOutside);
         void compact(); // combine adjacent deleted records
         friend class NamespaceIndex;
         struct ExtraOld {
@@ -515,8 +544,7 @@ namespace mongo {
 
         /* query cache (for query optimizer) ------------------------------------- */
     private:
-        int _qcWriteCount;
-        map<QueryPattern,CachedQueryPlan> _qcCache;
+        QueryPlanCache _qcCache;
         static NamespaceDetailsTransient& make_inlock(const string& ns);
         static CMap& get_cmap_inlock(const string& ns);
     public:
@@ -538,22 +566,34 @@ namespace mongo {
 
         void clearQueryCache() {
             _qcCache.clear();
-            _qcWriteCount = 0;
-        }
-        /* you must notify the cache if you are doing writes, as query plan utility will change */
-        void notifyOfWriteOp() {
-            if ( _qcCache.empty() )
-                return;
-            if ( ++_qcWriteCount >= 100 )
-                clearQueryCache();
         }
         CachedQueryPlan cachedQueryPlanForPattern( const QueryPattern &pattern ) {
-            return _qcCache[ pattern ];
+            return _qcCache.find( pattern );
         }
         void registerCachedQueryPlanForPattern( const QueryPattern &pattern,
                                                const CachedQueryPlan &cachedQueryPlan ) {
-            _qcCache[ pattern ] = cachedQueryPlan;
+            _qcCache.set( pattern, cachedQueryPlan );
         }
+        /* you must be in the qcMutex when using this */
+        QueryPlanCache& queryPlanCache() { return _qcCache; }
+
+        /* free space map (for record allocation) ------------------------------- */
+        /* assumed to be in write lock for this, or read lock to read it */
+    private:
+        FreeSpaceMap _freeSpace;
+    public:
+        FreeSpaceMap& freeSpaceMap() { return _freeSpace; }
+
+        /* online compact ------------------------------------------------------ */
+        /* assumed to be in write lock for this */
+    private:
+        DiskLoc _compactingExtent;
+    public:
+        /* the extent an online compact is emptying.  space freed in it is kept off the deleted
+           lists, as the compact frees the whole extent once its last record has moved out.
+        */
+        const DiskLoc& compactingExtent() const { return _compactingExtent; }
+        void setCompactingExtent(const DiskLoc& ext) { _compactingExtent = ext; }
 
     }; /* NamespaceDetailsTransient */
 
@@ -426,6 +426,10 @@ namespace mongo {
         _bufferedMatches = ret;
         return ret;
     }
+
+    long long ReorderBuildStrategy::scanAndOrderBytes() const {
+        return _scanAndOrder->peakApproxSize();
+    }
     
     ScanAndOrder *
     ReorderBuildStrategy::newScanAndOrder( const QueryPlanSummary &queryPlan ) const {
@@ -443,7 +447,8 @@ namespace mongo {
         return new ScanAndOrder( _parsedQuery.getSkip(),
                                 _parsedQuery.getNumToReturn(),
                                 _parsedQuery.getOrder(),
-                                *fieldRangeSet );
+                                *fieldRangeSet,
+                                _parsedQuery.getFields() );
     }
 
     HybridBuildStrategy* HybridBuildStrategy::make( const ParsedQuery& parsedQuery,
@@ -507,6 +512,10 @@ namespace mongo {
         return _reorderBuild->rewriteMatches();
     }
 
+    long long HybridBuildStrategy::scanAndOrderBytes() const {
+        return _reorderedMatches ? _reorderBuild->scanAndOrderBytes() : 0;
+    }
+
     int HybridBuildStrategy::bufferedMatches() const {
         return _reorderedMatches ?
                 _reorderBuild->bufferedMatches() :
@@ -584,6 +593,7 @@ namespace mongo {
             shared_ptr<ExplainQueryInfo> explainInfo = _explain->doneQueryInfo();
             if ( rewriteCount != -1 ) {
                 explainInfo->reviseN( rewriteCount );
+                explainInfo->noteScanAndOrderBytes( _builder->scanAndOrderBytes() );
             }
             _builder->resetBuf();
             fillQueryResultFromObj( _buf, 0, explainInfo->bson() );
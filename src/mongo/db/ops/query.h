@@ -165,6 +165,8 @@ namespace mongo {
         virtual int rewriteMatches() { return -1; }
         /** @return the number of matches that have been written to the buffer. */
         virtual int bufferedMatches() const = 0;
+        /** @return the most bytes held for an in memory sort, or 0 if results were in order. */
+        virtual long long scanAndOrderBytes() const { return 0; }
         /**
          * Callback when enough results have been read for the first batch, with potential handoff
          * to getMore.
@@ -211,6 +213,7 @@ namespace mongo {
         void _handleMatchNoDedup( ResultDetails* resultDetails );
         virtual int rewriteMatches();
         virtual int bufferedMatches() const { return _bufferedMatches; }
+        virtual long long scanAndOrderBytes() const;
     private:
         ReorderBuildStrategy( const ParsedQuery& parsedQuery,
                               const shared_ptr<Cursor>& cursor,
@@ -250,6 +253,7 @@ namespace mongo {
         virtual bool handleMatch( ResultDetails* resultDetails );
         virtual int rewriteMatches();
         virtual int bufferedMatches() const;
+        virtual long long scanAndOrderBytes() const;
         virtual void finishedFirstBatch();
         bool handleReorderMatch( ResultDetails* resultDetails );
         DiskLocDupSet _scanAndOrderDups;
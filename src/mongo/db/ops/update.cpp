@@ -91,7 +91,8 @@ namespace mongo {
             const BSONObj& onDisk = loc.obj();
             auto_ptr<ModSetState> mss = mods->prepare( onDisk, false /* not an insertion */ );
 
-            if( mss->canApplyInPlace() ) {
+            // a compressed record's object is a copy, so it can't be modified in place
+            if( mss->canApplyInPlace() && !r->isCompressed() ) {
                 mss->applyModsInPlace(true);
                 debug.fastmod = true;
                 DEBUGUPDATE( "\t\t\t updateById doing in place update" );
@@ -332,7 +333,10 @@ namespace mongo {
                     auto_ptr<ModSetState> mss = useMods->prepare( onDisk,
                                                                   false /* not an insertion */ );
 
-                    bool willAdvanceCursor = multi && c->ok() && ( modsIsIndexed || ! mss->canApplyInPlace() );
+                    // a compressed record's object is a copy, so it can't be modified in place
+                    bool inPlace = mss->canApplyInPlace() && !r->isCompressed();
+
+                    bool willAdvanceCursor = multi && c->ok() && ( modsIsIndexed || ! inPlace );
 
                     if ( willAdvanceCursor ) {
                         if ( cc.get() ) {
@@ -347,7 +351,7 @@ namespace mongo {
                     // order to ensure that they are validated inside DataFileMgr::updateRecord(.).
                     bool isSystemUsersMod = (NamespaceString(ns).coll == "system.users");
 
-                    if ( !mss->isUpdateIndexed() && mss->canApplyInPlace() && !isSystemUsersMod ) {
+                    if ( !mss->isUpdateIndexed() && inPlace && !isSystemUsersMod ) {
                         mss->applyModsInPlace( true );// const_cast<BSONObj&>(onDisk) );
 
                         DEBUGUPDATE( "\t\t\t doing in place update" );
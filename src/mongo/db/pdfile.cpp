@@ -44,6 +44,7 @@ _ disallow system* manipulations from the database.
 #include "mongo/db/db.h"
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/extsort.h"
+#include "mongo/db/index_side_table.h"
 #include "mongo/db/index_update.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/kill_current_op.h"
@@ -55,6 +56,7 @@ _ disallow system* manipulations from the database.
 #include "mongo/db/replutil.h"
 #include "mongo/db/sort_phase_one.h"
 #include "mongo/db/repl/oplog.h"
+#include "mongo/util/compress.h"
 #include "mongo/util/file.h"
 #include "mongo/util/file_allocator.h"
 #include "mongo/util/hashtab.h"
@@ -524,7 +526,7 @@ namespace mongo {
             NamespaceDetails *dw = details->writingWithoutExtra();
             dw->lastExtentSize = e->length;
         }
-        details->addDeletedRec(emptyLoc.drec(), emptyLoc);
+        details->addDeletedRec(ns, emptyLoc.drec(), emptyLoc);
     }
 
     Extent* MongoDataFile::createExtent(const char *ns, int approxSize, bool newCapped, int loops) {
@@ -1094,7 +1096,7 @@ namespace mongo {
                     *getDur().writing(p) = 0;
                     //DEV memset(todelete->data, 0, todelete->netLength()); // attempt to notice invalid reuse.
                 }
-                d->addDeletedRec((DeletedRecord*)todelete, dl);
+                d->addDeletedRec(ns, (DeletedRecord*)todelete, dl);
             }
         }
     }
@@ -1126,7 +1128,6 @@ namespace mongo {
         unindexRecord(d, todelete, dl, noWarn);
 
         _deleteRecord(d, ns, todelete, dl);
-        NamespaceDetailsTransient::get( ns ).notifyOfWriteOp();
 
         if ( ! toDelete.isEmpty() ) {
             logOp( "d" , ns , toDelete );
@@ -1179,7 +1180,17 @@ namespace mongo {
         uassert( 13596 , str::stream() << "cannot change _id of a document old:" << objOld << " new:" << objNew , ! changedId );
         dupCheck(changes, *d, dl);
 
-        if ( toupdate->netLength() < objNew.objsize() ) {
+        const char* stored = objNew.objdata();
+        int storedSize = objNew.objsize();
+        std::string compressed;
+        if ( !d->isCapped() &&
+             d->isUserFlagSet( NamespaceDetails::Flag_CompressRecords ) &&
+             compressRecordData( objNew, &compressed ) ) {
+            stored = compressed.data();
+            storedSize = compressed.size();
+        }
+
+        if ( toupdate->netLength() < storedSize ) {
             // doesn't fit.  reallocate -----------------------------------------------------
             moveCounter.increment();
             uassert( 10003 , "failing update: objects in a capped ns cannot grow", !(d && d->isCapped()));
@@ -1195,7 +1206,6 @@ namespace mongo {
             return res;
         }
 
-        nsdt->notifyOfWriteOp();
         d->paddingFits();
 
         /* have any index keys changed? */
@@ -1203,6 +1213,15 @@ namespace mongo {
             int keyUpdates = 0;
             int z = d->getTotalIndexCount();
             for ( int x = 0; x < z; x++ ) {
+                if ( IndexSideTable* side = sideTableFor(d, x) ) {
+                    // the index is being bulk loaded, and its builder applies the changes later
+                    for ( unsigned i = 0; i < changes[x].removed.size(); i++ )
+                        side->noteRemove(*changes[x].removed[i], dl);
+                    for ( unsigned i = 0; i < changes[x].added.size(); i++ )
+                        side->noteInsert(*changes[x].added[i], dl);
+                    keyUpdates += changes[x].added.size();
+                    continue;
+                }
                 IndexDetails& idx = d->idx(x);
                 IndexInterface& ii = idx.idxInterface();
                 for ( unsigned i = 0; i < changes[x].removed.size(); i++ ) {
@@ -1240,8 +1259,7 @@ namespace mongo {
         }
 
         //  update in place
-        int sz = objNew.objsize();
-        memcpy(getDur().writingPtr(toupdate->data(), sz), objNew.objdata(), sz);
+        memcpy(getDur().writingPtr(toupdate->data(), storedSize), stored, storedSize);
         return dl;
     }
 
@@ -1292,6 +1310,42 @@ namespace mongo {
         }
     }
 #endif
+    bool compressRecordData( const BSONObj& obj, std::string* out ) {
+        const int headerSize = 2 * sizeof( int );
+        int size = obj.objsize();
+        std::string compressed;
+        compressed.resize( headerSize + maxCompressedLength( size ) );
+        size_t compressedLen;
+        rawCompress( obj.objdata(), size, &compressed[ headerSize ], &compressedLen );
+        int storedSize = headerSize + compressedLen;
+        if ( storedSize > size - size / 8 )
+            return false;
+        reinterpret_cast<int*>( &compressed[0] )[0] = Record::CompressedDataMarker;
+        reinterpret_cast<int*>( &compressed[0] )[1] = compressedLen;
+        compressed.resize( storedSize );
+        out->swap( compressed );
+        return true;
+    }
+
+    BSONObj uncompressRecordData( const char* data ) {
+        const int headerSize = 2 * sizeof( int );
+        dassert( reinterpret_cast<const int*>( data )[0] == Record::CompressedDataMarker );
+        int compressedLen = reinterpret_cast<const int*>( data )[1];
+        size_t size;
+        massert( 16768, "corrupt compressed record",
+                 compressedLen > 0 &&
+                 getUncompressedLength( data + headerSize, compressedLen, &size ) &&
+                 size >= 5 && size <= static_cast<size_t>( BSONObjMaxInternalSize ) );
+        BSONObj::Holder* h = static_cast<BSONObj::Holder*>( malloc( size + sizeof( unsigned ) ) );
+        h->zero();
+        if ( !rawUncompress( data + headerSize, compressedLen, h->data ) ||
+             *reinterpret_cast<int*>( h->data ) != static_cast<int>( size ) ) {
+            free( h );
+            msgasserted( 16769, "corrupt compressed record" );
+        }
+        return BSONObj( h );
+    }
+
 #pragma pack(1)
     struct IDToInsert {
         char type;
@@ -1674,6 +1728,23 @@ namespace mongo {
             BSONElementManipulator::lookForTimestamps( io );
         }
 
+        // a compressed collection stores the whole object, any added _id included, compressed
+        std::string compressed;
+        if ( obuf && !god && !d->isCapped() &&
+             d->isUserFlagSet( NamespaceDetails::Flag_CompressRecords ) ) {
+            BSONObj obj( reinterpret_cast<const char*>( obuf ) );
+            BufBuilder withId;
+            if ( idToInsert.needed() ) {
+                withId.appendNum( obj.objsize() + idToInsert.size() );
+                withId.appendBuf( idToInsert.rawdata(), idToInsert.size() );
+                withId.appendBuf( obj.objdata() + 4, obj.objsize() - 4 );
+                obj = BSONObj( withId.buf() );
+            }
+            if ( compressRecordData( obj, &compressed ) ) {
+                len = compressed.size();
+            }
+        }
+
         int lenWHdr = d->getRecordAllocationSize( len + Record::HeaderSize );
         fassert( 16440, lenWHdr >= ( len + Record::HeaderSize ) );
         
@@ -1730,7 +1801,10 @@ namespace mongo {
         {
             verify( r->lengthWithHeaders() >= lenWHdr );
             r = (Record*) getDur().writingPtr(r, lenWHdr);
-            if( idToInsert.needed() ) {
+            if( !compressed.empty() ) {
+                memcpy(r->data(), compressed.data(), len);
+            }
+            else if( idToInsert.needed() ) {
                 /* a little effort was made here to avoid a double copy when we add an ID */
                 int originalSize = *((int*) obuf);
                 ((int&)*r->data()) = originalSize + idToInsert.size();
@@ -1752,10 +1826,6 @@ namespace mongo {
             s->nrecords++;
         }
 
-        // we don't bother resetting query optimizer stats for the god tables - also god is true when adding a btree bucket
-        if ( !god )
-            NamespaceDetailsTransient::get( ns ).notifyOfWriteOp();
-
         if ( tableToIndex ) {
             insert_makeIndex(tableToIndex, tabletoidxns, loc, mayInterrupt);
         }
@@ -1763,7 +1833,7 @@ namespace mongo {
         /* add this record to our indexes */
         if ( !earlyIndex && d->nIndexes ) {
             try {
-                BSONObj obj(r->data());
+                BSONObj obj = BSONObj::make(r);
                 // not sure which of these is better -- either can be used.  oldIndexRecord may be faster, 
                 // but twosteps handles dup key errors more efficiently.
                 //oldIndexRecord(d, obj, loc);
@@ -262,6 +262,15 @@ namespace mongo {
 
         int netLength() const { _accessing(); return _netLength(); }
 
+        /**
+         * The first int of the data of a record holding a compressed document; see
+         * compressRecordData().  A BSONObj's first int, its size, is never negative.
+         */
+        static const int CompressedDataMarker = -1;
+
+        /** @return true if the record holds a compressed document. */
+        bool isCompressed() const { return *reinterpret_cast<const int*>( data() ) == CompressedDataMarker; }
+
         /* use this when a record is deleted. basically a union with next/prev fields */
         DeletedRecord& asDeleted() { return *((DeletedRecord*) this); }
 
@@ -660,7 +669,20 @@ namespace mongo {
         return reinterpret_cast<DeletedRecord*>(getRecord(dl));
     }
 
+    /**
+     * Store 'obj' for a collection with NamespaceDetails::Flag_CompressRecords set: the snappy
+     * compressed object behind Record::CompressedDataMarker and the compressed length.
+     * @return false, leaving 'out' alone, if that isn't at least an eighth smaller than 'obj', in
+     * which case the object is stored as it is.
+     */
+    bool compressRecordData( const BSONObj& obj, std::string* out );
+
+    /** @return an owned copy of the object in compressed record data 'data'. */
+    BSONObj uncompressRecordData( const char* data );
+
     inline BSONObj BSONObj::make(const Record* r ) {
+        if ( r->isCompressed() )
+            return uncompressRecordData( r->data() );
         return BSONObj( r->data() );
     }
 
@@ -43,6 +43,13 @@ namespace mongo {
          */
         virtual Value getValue() const = 0;
 
+        /*
+          Get the approximate amount of memory used by the accumulated
+          state, in bytes.  This should be cheap, as it is checked for every
+          value accumulated when $group may spill to disk.
+         */
+        virtual size_t getMemUsage() const { return sizeof(*this); }
+
     protected:
         Accumulator();
 
@@ -68,6 +75,9 @@ namespace mongo {
         virtual Value getValue() const;
         virtual const char *getOpName() const;
 
+        // virtuals from Accumulator
+        virtual size_t getMemUsage() const { return sizeof(*this) + memUsageBytes; }
+
         /*
           Create an appending accumulator.
 
@@ -82,6 +92,7 @@ namespace mongo {
         typedef boost::unordered_set<Value, Value::Hash > SetType;
         mutable SetType set;
         mutable SetType::iterator itr; 
+        mutable size_t memUsageBytes; // of the Values in set
         intrusive_ptr<ExpressionContext> pCtx;
     };
 
@@ -98,6 +109,11 @@ namespace mongo {
         // virtuals from Expression
         virtual Value getValue() const;
 
+        // virtuals from Accumulator
+        virtual size_t getMemUsage() const {
+            return sizeof(*this) + pValue.getApproximateSize();
+        }
+
     protected:
         AccumulatorSingleValue();
 
@@ -206,6 +222,9 @@ namespace mongo {
         virtual Value getValue() const;
         virtual const char *getOpName() const;
 
+        // virtuals from Accumulator
+        virtual size_t getMemUsage() const { return sizeof(*this) + memUsageBytes; }
+
         /*
           Create an appending accumulator.
 
@@ -219,6 +238,7 @@ namespace mongo {
         AccumulatorPush(const intrusive_ptr<ExpressionContext> &pTheCtx);
 
         mutable vector<Value> vpValue;
+        mutable size_t memUsageBytes; // of the Values in vpValue
         intrusive_ptr<ExpressionContext> pCtx;
     };
 
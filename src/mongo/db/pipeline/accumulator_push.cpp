@@ -28,6 +28,7 @@ namespace mongo {
         if (!pCtx->getDoingMerge()) {
             if (!prhs.missing()) {
                 vpValue.push_back(prhs);
+                memUsageBytes += prhs.getApproximateSize();
             }
         }
         else {
@@ -41,6 +42,8 @@ namespace mongo {
             
             const vector<Value>& vec = prhs.getArray();
             vpValue.insert(vpValue.end(), vec.begin(), vec.end());
+            for (size_t i = 0; i < vec.size(); i++)
+                memUsageBytes += vec[i].getApproximateSize();
         }
 
         return Value();
@@ -54,6 +57,7 @@ namespace mongo {
         const intrusive_ptr<ExpressionContext> &pTheCtx):
         Accumulator(),
         vpValue(),
+        memUsageBytes(0),
         pCtx(pTheCtx) {
     }
 
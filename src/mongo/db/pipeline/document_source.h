@@ -23,6 +23,7 @@
 #include "db/clientcursor.h"
 #include "db/jsobj.h"
 #include "db/pipeline/document.h"
+#include "db/pipeline/document_spiller.h"
 #include "db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "db/pipeline/value.h"
@@ -39,7 +40,9 @@ namespace mongo {
     class ExpressionFieldPath;
     class ExpressionObject;
     class DocumentSourceLimit;
+    class DBClientCursor;
     class Matcher;
+    class ScopedDbConnection;
 
     class DocumentSource :
         public IntrusiveCounterUnsigned,
@@ -319,12 +322,21 @@ namespace mongo {
         virtual Document getCurrent();
         virtual void setSource(DocumentSource *pSource);
 
+        /**
+          Kill the shard cursor being read, if there is one.
+         */
+        virtual void dispose();
+
         /* convenient shorthand for a commonly used type */
         typedef map<Shard, BSONObj> ShardOutput;
 
         /**
           Create a DocumentSource that wraps the output of many shards
 
+          A shard's output is either its whole result array, or the first
+          batch of a cursor; the rest of a cursor's results are fetched with
+          getMore as they are needed, one shard at a time.
+
           @param shardOutput output from the individual shards
           @param pExpCtx the expression context for the pipeline
           @returns the newly created DocumentSource
@@ -344,19 +356,36 @@ namespace mongo {
         /**
           Advance to the next document, setting pCurrent appropriately.
 
-          Adjusts pCurrent, pBsonSource, and iterator, as needed.  On exit,
-          pCurrent is the Document to return, or NULL.  If NULL, this
-          indicates there is nothing more to return.
+          Adjusts pCurrent, the batch and cursor being read, and iterator,
+          as needed.  On exit, pCurrent is the Document to return, or NULL.
+          If NULL, this indicates there is nothing more to return.
          */
         void getNextDocument();
 
+        /**
+          Start reading the next shard's output.
+         */
+        void startShard();
+
+        /* close the shard cursor, and return its connection to the pool */
+        void releaseShardCursor();
+
+        /* kill the cursors of the shards not read yet */
+        void killUnreadCursors();
+
         bool unstarted;
         bool hasCurrent;
-        bool newSource; // set to true for the first item of a new source
-        intrusive_ptr<DocumentSourceBsonArray> pBsonSource;
         Document pCurrent;
+        const ShardOutput shardOutput;
         ShardOutput::const_iterator iterator;
         ShardOutput::const_iterator listEnd;
+
+        /* the batch being read; points into shardOutput */
+        scoped_ptr<BSONObjIterator> pBatchIterator;
+
+        /* the rest of the current shard's results, if it returned a cursor */
+        scoped_ptr<ScopedDbConnection> pConnection;
+        scoped_ptr<DBClientCursor> pShardCursor;
     };
 
 
@@ -372,12 +401,16 @@ namespace mongo {
          * type may only be used by one thread.
          */
         struct CursorWithContext {
-            /** Takes a read lock that will be held for the lifetime of the object. */
+            /**
+             * Takes a read lock that will be held for the lifetime of the object, unless the
+             * owning DocumentSourceCursor is suspended.
+             */
             CursorWithContext( const string& ns );
 
             // Must be the first struct member for proper construction and destruction, as other
-            // members may depend on the read lock it acquires.
-            Client::ReadContext _readContext;
+            // members may depend on the read lock it acquires.  Empty while the source is
+            // suspended, or resumed under a lock held by the caller.
+            scoped_ptr<Client::ReadContext> _readContext;
             shared_ptr<ShardChunkManager> _chunkMgr;
             ClientCursor::Holder _cursor;
         };
@@ -396,6 +429,20 @@ namespace mongo {
          */
         virtual void dispose();
 
+        /**
+         * Prepare the Cursor to be idle between client requests, and release the read lock the
+         * CursorWithContext holds.  Used when the pipeline's results are returned through a
+         * ClientCursor and getMore.  A no-op once the source is exhausted or disposed.
+         */
+        void suspend();
+
+        /**
+         * Continue after suspend().  The caller must hold a read lock on the namespace, and the
+         * source won't yield it.  If the collection went away while the source was suspended,
+         * the source is disposed and this throws.
+         */
+        void resume();
+
         /**
           Create a document source based on a cursor.
 
@@ -458,6 +505,11 @@ namespace mongo {
         bool hasCurrent;
         Document pCurrent;
 
+        /* valid while suspended */
+        CursorId suspendedId;
+        bool suspendedForYield;
+        ClientCursor::YieldData suspendedYieldData;
+
         string ns; // namespace
 
         /*
@@ -693,6 +745,33 @@ namespace mongo {
             vector<intrusive_ptr<Accumulator> >, Value::Hash> GroupsType;
         GroupsType groups;
 
+        /*
+          If the groups outgrow aggregationSpillThresholdBytes and the
+          pipeline may use the disk, spill() writes their partial results
+          out as a run sorted by _id, the same partial results a shard
+          would send to mongos.  Once the input is exhausted, the runs are
+          merged, and readSpilledGroup() combines the partial results for
+          the next _id into the single entry left in groups.
+
+          The accumulators are created with pSpillCtx, so that spill() can
+          briefly switch them to producing partial results.
+         */
+        void spill();
+        void readSpilledGroup();
+
+        class SpillComparator :
+            public DocumentSpiller::Comparator {
+        public:
+            virtual Value extractKey(const Document& doc) const { return doc["_id"]; }
+            virtual int compareKeys(const Value& lhs, const Value& rhs) const {
+                return Value::compare(lhs, rhs);
+            }
+        };
+
+        intrusive_ptr<ExpressionContext> pSpillCtx;
+        SpillComparator spillComparator;
+        scoped_ptr<DocumentSpiller> spiller;
+
         /*
           The field names for the result documents and the accumulator
           factories for the result documents.  The Expressions are the
@@ -942,6 +1021,9 @@ namespace mongo {
         void populateOne();  // limit == 1
         void populateTopK(); // limit > 1
 
+        /// sort what's buffered in documents and write it out as a run
+        void spill();
+
         /* these two parallel each other */
         typedef vector<intrusive_ptr<ExpressionFieldPath> > SortPaths;
         SortPaths vSortKey;
@@ -949,6 +1031,7 @@ namespace mongo {
 
         struct KeyAndDoc {
             explicit KeyAndDoc(const Document& d, const SortPaths& sp); // extracts sort key
+            explicit KeyAndDoc(const Document& d) :doc(d) {} // no key, for output only
             Value key; // array of keys if vSortKey.size() > 1
             Document doc;
         };
@@ -957,6 +1040,9 @@ namespace mongo {
         /// Compare two KeyAndDocs according to the specified sort key.
         int compare(const KeyAndDoc& lhs, const KeyAndDoc& rhs) const;
 
+        /// Compare two keys extracted by KeyAndDoc.
+        int compareKeys(const Value& lhs, const Value& rhs) const;
+
         /*
           This is a utility class just for the STL sort that is done
           inside.
@@ -971,8 +1057,30 @@ namespace mongo {
             const DocumentSourceSort& _source;
         };
 
+        /* orders the runs written out by spill() */
+        class SpillComparator :
+            public DocumentSpiller::Comparator {
+        public:
+            explicit SpillComparator(const DocumentSourceSort& source): _source(source) {}
+            virtual Value extractKey(const Document& doc) const {
+                return KeyAndDoc(doc, _source.vSortKey).key;
+            }
+            virtual int compareKeys(const Value& lhs, const Value& rhs) const {
+                return _source.compareKeys(lhs, rhs);
+            }
+        private:
+            const DocumentSourceSort& _source;
+        };
+
+        /*
+          If the sort has spilled to disk, documents only holds the current
+          document, and the rest are read from the spiller as we advance.
+         */
         deque<KeyAndDoc> documents;
 
+        SpillComparator spillComparator;
+        scoped_ptr<DocumentSpiller> spiller;
+
         intrusive_ptr<DocumentSourceLimit> limitSrc;
     };
     inline void swap(DocumentSourceSort::KeyAndDoc& l, DocumentSourceSort::KeyAndDoc& r) {
@@ -17,11 +17,15 @@
 #include "pch.h"
 
 #include "mongo/db/pipeline/document_source.h"
+
+#include "mongo/client/connpool.h"
+#include "mongo/client/dbclientcursor.h"
 #include "mongo/s/shard.h"
 
 namespace mongo {
 
     DocumentSourceCommandShards::~DocumentSourceCommandShards() {
+        DESTRUCTOR_GUARD( dispose(); )
     }
 
     bool DocumentSourceCommandShards::eof() {
@@ -54,6 +58,50 @@ namespace mongo {
         verify(false);
     }
 
+    void DocumentSourceCommandShards::dispose() {
+        pBatchIterator.reset();
+        releaseShardCursor();
+        killUnreadCursors();
+    }
+
+    void DocumentSourceCommandShards::releaseShardCursor() {
+        // destroying the cursor kills it on the shard, if it isn't exhausted
+        pShardCursor.reset();
+
+        if (pConnection) {
+            pConnection->done();
+            pConnection.reset();
+        }
+    }
+
+    void DocumentSourceCommandShards::killUnreadCursors() {
+        for(; iterator != listEnd; ++iterator) {
+            BSONElement cursorElement = iterator->second["cursor"];
+            if (cursorElement.type() != Object)
+                continue;
+
+            BSONObj cursorObj = cursorElement.embeddedObject();
+            long long cursorId = cursorObj["id"].numberLong();
+            if (!cursorId)
+                continue;
+
+            try {
+                ScopedDbConnection connection(iterator->first.getConnString());
+                {
+                    // destroying a cursor that isn't exhausted kills it on the shard
+                    DBClientCursor cursor(connection.get(), cursorObj["ns"].String(),
+                                          cursorId, 0, 0);
+                }
+                connection.done();
+            }
+            catch (const DBException& e) {
+                // the shard will time the cursor out
+                warning() << "couldn't kill aggregation cursor " << cursorId << " on shard "
+                          << iterator->first.getName() << causedBy(e) << endl;
+            }
+        }
+    }
+
     void DocumentSourceCommandShards::sourceToBson(
         BSONObjBuilder *pBuilder, bool explain) const {
         /* this has no BSON equivalent */
@@ -61,14 +109,13 @@ namespace mongo {
     }
 
     DocumentSourceCommandShards::DocumentSourceCommandShards(
-        const ShardOutput& shardOutput,
+        const ShardOutput& theShardOutput,
         const intrusive_ptr<ExpressionContext> &pExpCtx):
         DocumentSource(pExpCtx),
         unstarted(true),
         hasCurrent(false),
-        newSource(false),
-        pBsonSource(),
         pCurrent(),
+        shardOutput(theShardOutput),
         iterator(shardOutput.begin()),
         listEnd(shardOutput.end())
     {}
@@ -89,51 +136,78 @@ namespace mongo {
         }
 
         while(true) {
-            if (!pBsonSource.get()) {
-                /* if there aren't any more futures, we're done */
-                if (iterator == listEnd) {
-                    pCurrent = Document();
-                    hasCurrent = false;
+            /* the rest of the batch we have in hand */
+            if (pBatchIterator) {
+                if (pBatchIterator->more()) {
+                    pCurrent = Document(pBatchIterator->next().Obj());
                     return;
                 }
+                pBatchIterator.reset();
+            }
 
-                /* grab the next command result */
-                BSONObj resultObj = iterator->second;
-
-                uassert(16390, str::stream() << "sharded pipeline failed on shard " <<
-                                            iterator->first.getName() << ": " <<
-                                            resultObj.toString(),
-                        resultObj["ok"].trueValue());
-
-                /* grab the result array out of the shard server's response */
-                BSONElement resultArray = resultObj["result"];
-                massert(16391, str::stream() << "no result array? shard:" <<
-                                            iterator->first.getName() << ": " <<
-                                            resultObj.toString(),
-                        resultArray.type() == Array);
-
-                // done with error checking, don't need the shard name anymore
-                ++iterator;
-
-                if (resultArray.embeddedObject().isEmpty()){
-                    // this shard had no results, on to the next one
-                    continue;
+            /* then the rest of the shard's cursor, if it gave us one */
+            if (pShardCursor) {
+                if (pShardCursor->more()) {
+                    pCurrent = Document(pShardCursor->nextSafe());
+                    return;
                 }
-
-                pBsonSource = DocumentSourceBsonArray::create(&resultArray, pExpCtx);
-                newSource = true;
+                releaseShardCursor();
             }
 
-            /* if we're done with this shard's results, try the next */
-            if (pBsonSource->eof() ||
-                (!newSource && !pBsonSource->advance())) {
-                pBsonSource.reset();
-                continue;
+            /* if there aren't any more shards, we're done */
+            if (iterator == listEnd) {
+                pCurrent = Document();
+                hasCurrent = false;
+                return;
             }
 
-            pCurrent = pBsonSource->getCurrent();
-            newSource = false;
-            return;
+            startShard();
+        }
+    }
+
+    void DocumentSourceCommandShards::startShard() {
+        /* grab the next command result */
+        const Shard& shard = iterator->first;
+        BSONObj resultObj = iterator->second;
+
+        uassert(16390, str::stream() << "sharded pipeline failed on shard " <<
+                                    shard.getName() << ": " <<
+                                    resultObj.toString(),
+                resultObj["ok"].trueValue());
+
+        BSONElement cursorElement = resultObj["cursor"];
+        if (cursorElement.type() == Object) {
+            /* the shard returned a cursor; its first batch came with the reply */
+            BSONObj cursorObj = cursorElement.embeddedObject();
+            BSONElement firstBatch = cursorObj["firstBatch"];
+            massert(16749, str::stream() << "no firstBatch in cursor? shard:" <<
+                                        shard.getName() << ": " <<
+                                        resultObj.toString(),
+                    firstBatch.type() == Array);
+
+            pBatchIterator.reset(new BSONObjIterator(firstBatch.embeddedObject()));
+
+            long long cursorId = cursorObj["id"].numberLong();
+            if (cursorId) {
+                // like getMores on unsharded collections, these don't need shard versioning
+                pConnection.reset(new ScopedDbConnection(shard.getConnString()));
+                pShardCursor.reset(new DBClientCursor(pConnection->get(),
+                                                      cursorObj["ns"].String(),
+                                                      cursorId, 0, 0));
+            }
         }
+        else {
+            /* grab the result array out of the shard server's response */
+            BSONElement resultArray = resultObj["result"];
+            massert(16391, str::stream() << "no result array? shard:" <<
+                                        shard.getName() << ": " <<
+                                        resultObj.toString(),
+                    resultArray.type() == Array);
+
+            pBatchIterator.reset(new BSONObjIterator(resultArray.embeddedObject()));
+        }
+
+        // done with error checking, don't need the shard name anymore
+        ++iterator;
     }
 }
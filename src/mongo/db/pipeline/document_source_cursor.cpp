@@ -27,7 +27,7 @@
 namespace mongo {
 
     DocumentSourceCursor::CursorWithContext::CursorWithContext( const string& ns )
-        : _readContext( ns ) // Take a read lock.
+        : _readContext( new Client::ReadContext( ns ) ) // Take a read lock.
         , _chunkMgr(shardingState.needShardChunkManager( ns )
                     ? shardingState.getShardChunkManager( ns )
                     : ShardChunkManagerPtr())
@@ -64,6 +64,40 @@ namespace mongo {
         _cursorWithContext.reset();
     }
 
+    void DocumentSourceCursor::suspend() {
+        if ( !_cursorWithContext )
+            return;
+
+        suspendedId = cursor()->cursorid();
+        suspendedForYield = cursor()->prepareToYield( suspendedYieldData );
+        if ( !suspendedForYield )
+            cursor()->c()->noteLocation();
+
+        _cursorWithContext->_readContext.reset();
+    }
+
+    void DocumentSourceCursor::resume() {
+        if ( !_cursorWithContext )
+            return;
+
+        verify( !_cursorWithContext->_readContext );
+        Lock::assertAtLeastReadLocked( ns );
+
+        // The ClientCursor is deleted if its collection was dropped while we were suspended.
+        bool ok = suspendedForYield
+                ? ClientCursor::recoverFromYield( suspendedYieldData )
+                : ClientCursor::find( suspendedId, false ) != NULL;
+        if ( !ok ) {
+            _cursorWithContext->_cursor.release();
+            dispose();
+            uasserted( 16748, "collection or database disappeared while aggregation cursor "
+                              "was suspended" );
+        }
+
+        if ( !suspendedForYield )
+            cursor()->c()->checkLocation();
+    }
+
     ClientCursor::Holder& DocumentSourceCursor::cursor() {
         verify( _cursorWithContext );
         verify( _cursorWithContext->_cursor );
@@ -78,6 +112,10 @@ namespace mongo {
     }
 
     void DocumentSourceCursor::yieldSometimes() {
+        // When resumed, the read lock belongs to the caller and isn't ours to give up.
+        if ( !_cursorWithContext->_readContext )
+            return;
+
         try { // SERVER-5752 may make this try unnecessary
             // if we are index only we don't need the recored
             bool cursorOk = cursor()->yieldSometimes(canUseCoveredIndex()
@@ -224,6 +262,8 @@ namespace mongo {
         DocumentSource(pCtx),
         unstarted(true),
         hasCurrent(false),
+        suspendedId(0),
+        suspendedForYield(false),
         _cursorWithContext( cursorWithContext )
     {}
 
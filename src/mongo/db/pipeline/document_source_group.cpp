@@ -28,6 +28,17 @@
 namespace mongo {
     const char DocumentSourceGroup::groupName[] = "$group";
 
+    namespace {
+        /* orders groups by _id for writing out a run */
+        class SpilledGroupLess {
+        public:
+            template <typename GroupsIterator>
+            bool operator()(const GroupsIterator& lhs, const GroupsIterator& rhs) const {
+                return Value::compare(lhs->first, rhs->first) < 0;
+            }
+        };
+    }
+
     DocumentSourceGroup::~DocumentSourceGroup() {
     }
 
@@ -52,6 +63,11 @@ namespace mongo {
 
         ++groupsIterator;
         if (groupsIterator == groups.end()) {
+            if (spiller && spiller->more()) {
+                readSpilledGroup();
+                return true;
+            }
+
             dispose();
             return false;
         }
@@ -69,6 +85,7 @@ namespace mongo {
     void DocumentSourceGroup::dispose() {
         GroupsType().swap(groups);
         groupsIterator = groups.end();
+        spiller.reset();
 
         pSource->dispose();
     }
@@ -290,6 +307,14 @@ namespace mongo {
         const size_t numAccumulators = vpAccumulatorFactory.size();
         dassert(numAccumulators == vpExpression.size());
 
+        /*
+          Only keep track of memory use if we can do something about it;
+          getting the accumulators' usage isn't free.
+        */
+        const bool canSpill = pExpCtx->canSpillToDisk();
+        pSpillCtx = canSpill ? pExpCtx->clone() : pExpCtx.get();
+        size_t memUsage = 0;
+
         for (bool hasNext = !pSource->eof(); hasNext; hasNext = pSource->advance()) {
             Document input  = pSource->getCurrent();
 
@@ -304,16 +329,18 @@ namespace mongo {
               Look for the _id value in the map; if it's not there, add a
               new entry with a blank accumulator.
             */
+            const size_t oldSize = groups.size();
             vector<intrusive_ptr<Accumulator> >& group = groups[id];
+            const bool inserted = groups.size() != oldSize;
 
-            if (numAccumulators == 0)
-                continue; // we are basically building a set
+            if (inserted && canSpill)
+                memUsage += id.getApproximateSize() + sizeof(group);
 
-            if (group.empty()) {
+            if (inserted && numAccumulators) {
                 /* add the accumulators */
                 group.reserve(numAccumulators);
                 for (size_t i = 0; i < numAccumulators; i++) {
-                    intrusive_ptr<Accumulator> accum = (*vpAccumulatorFactory[i])(pExpCtx);
+                    intrusive_ptr<Accumulator> accum = (*vpAccumulatorFactory[i])(pSpillCtx);
                     accum->addOperand(vpExpression[i]);
                     group.push_back(accum);
                 }
@@ -321,8 +348,34 @@ namespace mongo {
 
             /* tickle all the accumulators for the group we found */
             dassert(numAccumulators == group.size());
-            for (size_t i = 0; i < numAccumulators; i++)
+            for (size_t i = 0; i < numAccumulators; i++) {
+                if (!canSpill) {
+                    group[i]->evaluate(input);
+                    continue;
+                }
+
+                const size_t before = inserted ? 0 : group[i]->getMemUsage();
                 group[i]->evaluate(input);
+                memUsage += group[i]->getMemUsage() - before;
+            }
+
+            if (canSpill && memUsage > static_cast<size_t>(aggregationSpillThresholdBytes)) {
+                spill();
+                memUsage = 0;
+            }
+        }
+
+        if (spiller) {
+            /* write out the remainder, and start merging the runs */
+            spill();
+            spiller->startMerge();
+            populated = true;
+
+            if (spiller->more())
+                readSpilledGroup();
+            else
+                groupsIterator = groups.end();
+            return;
         }
 
         /* start the group iterator */
@@ -330,6 +383,73 @@ namespace mongo {
         populated = true;
     }
 
+    void DocumentSourceGroup::spill() {
+        if (!spiller)
+            spiller.reset(new DocumentSpiller(pExpCtx, &spillComparator));
+
+        vector<GroupsType::iterator> sorted;
+        sorted.reserve(groups.size());
+        for (GroupsType::iterator it(groups.begin()); it != groups.end(); ++it)
+            sorted.push_back(it);
+        std::sort(sorted.begin(), sorted.end(), SpilledGroupLess());
+
+        /* have the accumulators produce what a shard would send to mongos */
+        pSpillCtx->setInShard(true);
+
+        const size_t n = vFieldName.size();
+        for (size_t iGroup = 0; iGroup < sorted.size(); ++iGroup) {
+            const vector<intrusive_ptr<Accumulator> >& group = sorted[iGroup]->second;
+            MutableDocument partial(1 + n);
+            partial.addField("_id", sorted[iGroup]->first);
+            for (size_t i = 0; i < n; ++i) {
+                Value value(group[i]->getValue());
+                if (!value.missing())
+                    partial.addField(vFieldName[i], value);
+            }
+
+            spiller->add(partial.freeze());
+        }
+
+        pSpillCtx->setInShard(pExpCtx->getInShard());
+
+        spiller->finishRun();
+        GroupsType().swap(groups);
+    }
+
+    void DocumentSourceGroup::readSpilledGroup() {
+        /*
+          Merge all the partial results for the next _id the same way
+          getRouterSource()'s merger would.
+        */
+        intrusive_ptr<ExpressionContext> pMergerExpCtx = pExpCtx->clone();
+        pMergerExpCtx->setDoingMerge(true);
+
+        const size_t n = vFieldName.size();
+        vector<intrusive_ptr<Accumulator> > merged;
+        merged.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            intrusive_ptr<Accumulator> accum = (*vpAccumulatorFactory[i])(pMergerExpCtx);
+            accum->addOperand(ExpressionFieldPath::create(vFieldName[i]));
+            merged.push_back(accum);
+        }
+
+        Document partial = spiller->next();
+        const Value id = partial["_id"];
+        while (true) {
+            for (size_t i = 0; i < n; ++i)
+                merged[i]->evaluate(partial);
+
+            if (!spiller->more() || Value::compare(spiller->peek()["_id"], id) != 0)
+                break;
+
+            partial = spiller->next();
+        }
+
+        GroupsType().swap(groups);
+        groups[id].swap(merged);
+        groupsIterator = groups.begin();
+    }
+
     Document DocumentSourceGroup::makeDocument(
         const GroupsType::iterator &rIter) {
         vector<intrusive_ptr<Accumulator> > *pGroup = &rIter->second;
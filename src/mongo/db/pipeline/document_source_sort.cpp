@@ -51,6 +51,9 @@ namespace mongo {
         if (!documents.empty())
             documents.pop_front(); // this way we release memory as we go
 
+        if (documents.empty() && spiller && spiller->more())
+            documents.push_back(KeyAndDoc(spiller->next()));
+
         return !documents.empty();
     }
 
@@ -90,12 +93,14 @@ namespace mongo {
 
     void DocumentSourceSort::dispose() {
         documents.clear();
+        spiller.reset();
         pSource->dispose();
     }
 
     DocumentSourceSort::DocumentSourceSort(const intrusive_ptr<ExpressionContext> &pExpCtx)
         : SplittableDocumentSource(pExpCtx)
         , populated(false)
+        , spillComparator(*this)
     {}
 
     long long DocumentSourceSort::getLimit() const {
@@ -210,10 +215,37 @@ namespace mongo {
         /* track and warn about how much physical memory has been used */
         DocMemMonitor dmm(this);
 
+        /*
+          If we may spill, the memory limit is ours to enforce: write out
+          a sorted run whenever the buffered documents outgrow it.
+        */
+        const bool canSpill = pExpCtx->canSpillToDisk();
+        size_t bufferedBytes = 0;
+
         /* pull everything from the underlying source */
         for (bool hasNext = !pSource->eof(); hasNext; hasNext = pSource->advance()) {
             documents.push_back(KeyAndDoc(pSource->getCurrent(), vSortKey));
-            dmm.addToTotal(documents.back().doc.getApproximateSize());
+            size_t size = documents.back().doc.getApproximateSize();
+
+            if (!canSpill) {
+                dmm.addToTotal(size);
+                continue;
+            }
+
+            bufferedBytes += size;
+            if (bufferedBytes > static_cast<size_t>(aggregationSpillThresholdBytes)) {
+                spill();
+                bufferedBytes = 0;
+            }
+        }
+
+        if (spiller) {
+            /* write out the remainder, and start reading back the merged runs */
+            spill();
+            spiller->startMerge();
+            if (spiller->more())
+                documents.push_back(KeyAndDoc(spiller->next()));
+            return;
         }
 
         /* sort the list */
@@ -221,6 +253,20 @@ namespace mongo {
         sort(documents.begin(), documents.end(), comparator);
     }
 
+    void DocumentSourceSort::spill() {
+        if (!spiller)
+            spiller.reset(new DocumentSpiller(pExpCtx, &spillComparator));
+
+        Comparator comparator(*this);
+        sort(documents.begin(), documents.end(), comparator);
+
+        for (deque<KeyAndDoc>::const_iterator it(documents.begin()); it != documents.end(); ++it)
+            spiller->add(it->doc);
+
+        spiller->finishRun();
+        documents.clear();
+    }
+
     void DocumentSourceSort::populateOne() {
         if (pSource->eof())
             return;
@@ -290,6 +336,10 @@ namespace mongo {
     }
 
     int DocumentSourceSort::compare(const KeyAndDoc & lhs, const KeyAndDoc & rhs) const {
+        return compareKeys(lhs.key, rhs.key);
+    }
+
+    int DocumentSourceSort::compareKeys(const Value& lhs, const Value& rhs) const {
 
         /*
           populate() already checked that there is a non-empty sort key,
@@ -301,14 +351,14 @@ namespace mongo {
         const size_t n = vSortKey.size();
         if (n == 1) { // simple fast case
             if (vAscending[0])
-                return  Value::compare(lhs.key, rhs.key);
+                return  Value::compare(lhs, rhs);
             else
-                return -Value::compare(lhs.key, rhs.key);
+                return -Value::compare(lhs, rhs);
         }
 
         // compound sort
         for (size_t i = 0; i < n; i++) {
-            int cmp = Value::compare(lhs.key[i], rhs.key[i]);
+            int cmp = Value::compare(lhs[i], rhs[i]);
             if (cmp) {
                 /* if necessary, adjust the return value by the key ordering */
                 if (!vAscending[i])
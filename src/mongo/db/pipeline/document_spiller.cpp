@@ -0,0 +1,193 @@
+/**
+ * Copyright (c) 2013 10gen Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pch.h"
+
+#include "db/pipeline/document_spiller.h"
+
+#include <boost/filesystem/operations.hpp>
+
+#include "db/jsobj.h"
+#include "db/pipeline/expression_context.h"
+#include "db/server_parameters.h"
+
+namespace mongo {
+
+    MONGO_EXPORT_SERVER_PARAMETER(aggregationSpillThresholdBytes, int, 100 * 1024 * 1024);
+
+    static SimpleMutex uniqueNumberMutex("documentSpiller");
+    static unsigned long long uniqueNumber = 0;
+
+    /* reads back the BSON documents of one run, in the order they were written */
+    class DocumentSpiller::RunReader :
+        boost::noncopyable {
+    public:
+        RunReader(const string& file):
+            file(file),
+            in(file.c_str(), ios_base::in | ios_base::binary) {
+            assertStreamGood(16741, "couldn't open aggregation spill file: " + file, in);
+        }
+
+        bool next(Document *pDoc) {
+            int size;
+            if (!in.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+                massert(16742, "truncated aggregation spill file: " + file,
+                        in.gcount() == 0);
+                return false;
+            }
+            massert(16743, "corrupt aggregation spill file: " + file,
+                    size >= BSONObj().objsize());
+
+            buffer.resize(size);
+            memcpy(&buffer[0], &size, sizeof(size));
+            in.read(&buffer[sizeof(size)], size - sizeof(size));
+            massert(16744, "truncated aggregation spill file: " + file, in.good());
+
+            *pDoc = Document(BSONObj(&buffer[0]));
+            return true;
+        }
+
+    private:
+        const string file;
+        ifstream in;
+        vector<char> buffer;
+    };
+
+    DocumentSpiller::DocumentSpiller(const intrusive_ptr<ExpressionContext> &pTheExpCtx,
+                                     const Comparator *pTheComparator):
+        pExpCtx(pTheExpCtx),
+        pComparator(pTheComparator),
+        totalBytes(0) {
+        verify(pExpCtx->canSpillToDisk());
+
+        unsigned long long thisUniqueNumber;
+        {
+            SimpleMutex::scoped_lock lk(uniqueNumberMutex);
+            thisUniqueNumber = uniqueNumber++;
+        }
+
+        stringstream ss;
+        ss << pExpCtx->getTempDir() << "/aggregate." << time(0) << "." << thisUniqueNumber;
+        directory = ss.str();
+
+        LOG(1) << "aggregation spill directory: " << directory << endl;
+        boost::filesystem::create_directories(directory);
+    }
+
+    DocumentSpiller::~DocumentSpiller() {
+        for (size_t i = 0; i < readers.size(); ++i)
+            delete readers[i];
+
+        if (out.is_open())
+            out.close();
+
+        try {
+            boost::filesystem::remove_all(directory);
+        }
+        catch (const boost::filesystem::filesystem_error& e) {
+            warning() << "couldn't remove aggregation spill directory " << directory
+                      << ": " << e.what() << endl;
+        }
+    }
+
+    void DocumentSpiller::add(const Document& doc) {
+        verify(readers.empty()); // can't spill once merging has started
+
+        if (!out.is_open()) {
+            stringstream ss;
+            ss << directory << "/run." << runs.size();
+            runs.push_back(ss.str());
+
+            out.open(runs.back().c_str(), ios_base::out | ios_base::binary);
+            assertStreamGood(16745, "couldn't open aggregation spill file: " + runs.back(), out);
+        }
+
+        BSONObjBuilder builder;
+        doc.toBson(&builder);
+        BSONObj obj(builder.done());
+
+        out.write(obj.objdata(), obj.objsize());
+        assertStreamGood(16746, "couldn't write aggregation spill file: " + runs.back(), out);
+
+        totalBytes += obj.objsize();
+        pExpCtx->addSpilledBytes(obj.objsize());
+    }
+
+    void DocumentSpiller::finishRun() {
+        if (!out.is_open())
+            return;
+
+        out.close();
+        assertStreamGood(16747, "couldn't write aggregation spill file: " + runs.back(), out);
+        LOG(1) << "aggregation spilled run " << runs.back() << ", " << totalBytes
+               << " bytes spilled so far" << endl;
+    }
+
+    void DocumentSpiller::startMerge() {
+        finishRun();
+
+        readers.reserve(runs.size());
+        for (size_t i = 0; i < runs.size(); ++i) {
+            readers.push_back(new RunReader(runs[i]));
+            pushFrom(i);
+        }
+    }
+
+    bool DocumentSpiller::more() const {
+        return !heap.empty();
+    }
+
+    Document DocumentSpiller::next() {
+        verify(!heap.empty());
+
+        HeapGreater greater(pComparator);
+        std::pop_heap(heap.begin(), heap.end(), greater);
+
+        Document doc = heap.back().doc;
+        size_t run = heap.back().run;
+        heap.pop_back();
+
+        pushFrom(run);
+        return doc;
+    }
+
+    const Document& DocumentSpiller::peek() const {
+        verify(!heap.empty());
+        return heap.front().doc;
+    }
+
+    void DocumentSpiller::pushFrom(size_t i) {
+        HeapEntry entry;
+        if (!readers[i]->next(&entry.doc))
+            return;
+
+        entry.key = pComparator->extractKey(entry.doc);
+        entry.run = i;
+        heap.push_back(entry);
+        std::push_heap(heap.begin(), heap.end(), HeapGreater(pComparator));
+    }
+
+    bool DocumentSpiller::HeapGreater::operator()(const HeapEntry& lhs,
+                                                  const HeapEntry& rhs) const {
+        int cmp = pComparator->compareKeys(lhs.key, rhs.key);
+        if (cmp)
+            return cmp > 0;
+
+        /* equal keys come out in the order they were spilled */
+        return lhs.run > rhs.run;
+    }
+
+}
@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2013 10gen Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mongo/pch.h"
+
+#include <fstream>
+
+#include "db/pipeline/document.h"
+#include "db/pipeline/value.h"
+
+namespace mongo {
+
+    class ExpressionContext;
+
+    /*
+      How many bytes a $sort or $group that may spill to disk buffers in
+      memory before it writes out a run.  Settable with setParameter.
+     */
+    extern int aggregationSpillThresholdBytes;
+
+    /*
+      Lets a blocking pipeline stage ($sort, $group) move its working set
+      out of memory.
+
+      The stage hands over its buffered Documents one sorted run at a time
+      with add() and finishRun().  Once its input is exhausted it calls
+      startMerge(), and then reads the union of all runs back in order with
+      more()/next().
+      Every run is a file of serialized BSON documents in a directory under
+      the ExpressionContext's tempDir; the directory is removed when the
+      spiller is destroyed.
+
+      Documents that compare equal are returned in the order of the runs
+      they were spilled in, so a stage that spills in input order can rely
+      on that when merging (eg $first and $last in $group).
+     */
+    class DocumentSpiller :
+        boost::noncopyable {
+    public:
+        /*
+          Supplied by the stage to order Documents.  The key is extracted
+          once per Document read back, and only keys are compared.
+         */
+        class Comparator {
+        public:
+            virtual ~Comparator() {}
+            virtual Value extractKey(const Document& doc) const = 0;
+            virtual int compareKeys(const Value& lhs, const Value& rhs) const = 0;
+        };
+
+        /*
+          @param pExpCtx supplies the temporary directory, and is credited
+              with the bytes spilled
+          @param pComparator must outlive the spiller
+         */
+        DocumentSpiller(const intrusive_ptr<ExpressionContext> &pExpCtx,
+                        const Comparator *pComparator);
+        ~DocumentSpiller();
+
+        /*
+          Append a Document to the run being written.  Documents must be
+          added in the Comparator's order.
+         */
+        void add(const Document& doc);
+
+        /// End the run being written, if there is one.
+        void finishRun();
+
+        /// The number of runs written so far.
+        size_t numRuns() const { return runs.size(); }
+
+        /// The number of bytes written to temporary files so far.
+        long long spilledBytes() const { return totalBytes; }
+
+        /*
+          Done spilling; prepare to read the runs back.
+         */
+        void startMerge();
+
+        /// true if there is another Document to be read
+        bool more() const;
+
+        /// The next Document in order across all runs.
+        Document next();
+
+        /// The Document next() will return, without consuming it.
+        const Document& peek() const;
+
+    private:
+        class RunReader;
+
+        struct HeapEntry {
+            Value key;
+            Document doc;
+            size_t run;
+        };
+
+        /// orders the heap so that the smallest key is at the front
+        class HeapGreater {
+        public:
+            HeapGreater(const Comparator *pC): pComparator(pC) {}
+            bool operator()(const HeapEntry& lhs, const HeapEntry& rhs) const;
+        private:
+            const Comparator *pComparator;
+        };
+
+        /// read the next Document from run i into the heap, if there is one
+        void pushFrom(size_t i);
+
+        intrusive_ptr<ExpressionContext> pExpCtx;
+        const Comparator *pComparator;
+        string directory;
+        vector<string> runs;
+        ofstream out;
+        long long totalBytes;
+
+        vector<RunReader*> readers;
+        vector<HeapEntry> heap;
+    };
+
+}
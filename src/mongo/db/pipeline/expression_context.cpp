@@ -28,6 +28,8 @@ namespace mongo {
         doingMerge(false),
         inShard(false),
         inRouter(false),
+        allowDiskUsage(false),
+        spilledBytes(0),
         intCheckCounter(1),
         pStatus(pS) {
     }
@@ -47,6 +49,8 @@ namespace mongo {
         newContext->setDoingMerge(getDoingMerge());
         newContext->setInShard(getInShard());
         newContext->setInRouter(getInRouter());
+        newContext->setAllowDiskUsage(getAllowDiskUsage());
+        newContext->setTempDir(getTempDir());
         return newContext;
     }
 
@@ -33,9 +33,27 @@ namespace mongo {
         void setInShard(bool b);
         void setInRouter(bool b);
 
+        /**
+           Allow $group and $sort to spill to temporary files under tempDir
+           once they outgrow their memory budget.  Only mongod sets a
+           tempDir, so in mongos this is passed through to the shards but
+           has no local effect.
+         */
+        void setAllowDiskUsage(bool b);
+        void setTempDir(const string& dir);
+
         bool getDoingMerge() const;
         bool getInShard() const;
         bool getInRouter() const;
+        bool getAllowDiskUsage() const;
+        const string& getTempDir() const;
+
+        /// true if stages may spill, ie disk use was requested and is possible here
+        bool canSpillToDisk() const;
+
+        /// Total bytes written to temporary files by this context's stages.
+        void addSpilledBytes(long long bytes);
+        long long getSpilledBytes() const;
 
         /**
            Used by a pipeline to check for interrupts so that killOp() works.
@@ -54,6 +72,9 @@ namespace mongo {
         bool doingMerge;
         bool inShard;
         bool inRouter;
+        bool allowDiskUsage;
+        string tempDir;
+        long long spilledBytes;
         unsigned intCheckCounter; // interrupt check counter
         InterruptStatus *const pStatus;
     };
@@ -76,6 +97,14 @@ namespace mongo {
         inRouter = b;
     }
 
+    inline void ExpressionContext::setAllowDiskUsage(bool b) {
+        allowDiskUsage = b;
+    }
+
+    inline void ExpressionContext::setTempDir(const string& dir) {
+        tempDir = dir;
+    }
+
     inline bool ExpressionContext::getDoingMerge() const {
         return doingMerge;
     }
@@ -88,4 +117,24 @@ namespace mongo {
         return inRouter;
     }
 
+    inline bool ExpressionContext::getAllowDiskUsage() const {
+        return allowDiskUsage;
+    }
+
+    inline const string& ExpressionContext::getTempDir() const {
+        return tempDir;
+    }
+
+    inline bool ExpressionContext::canSpillToDisk() const {
+        return allowDiskUsage && !tempDir.empty();
+    }
+
+    inline void ExpressionContext::addSpilledBytes(long long bytes) {
+        spilledBytes += bytes;
+    }
+
+    inline long long ExpressionContext::getSpilledBytes() const {
+        return spilledBytes;
+    }
+
 };
@@ -31,6 +31,9 @@ namespace mongo {
     const char Pipeline::pipelineName[] = "pipeline";
     const char Pipeline::explainName[] = "explain";
     const char Pipeline::fromRouterName[] = "fromRouter";
+    const char Pipeline::allowDiskUsageName[] = "allowDiskUsage";
+    const char Pipeline::cursorName[] = "cursor";
+    const char Pipeline::batchSizeName[] = "batchSize";
     const char Pipeline::splitMongodPipelineName[] = "splitMongodPipeline";
     const char Pipeline::serverPipelineName[] = "serverPipeline";
     const char Pipeline::mongosPipelineName[] = "mongosPipeline";
@@ -41,6 +44,8 @@ namespace mongo {
     Pipeline::Pipeline(const intrusive_ptr<ExpressionContext> &pTheCtx):
         collectionName(),
         explain(false),
+        cursorCommand(false),
+        batchSize(0),
         splitMongodPipeline(false),
         pCtx(pTheCtx) {
     }
@@ -128,6 +133,31 @@ namespace mongo {
                 continue;
             }
 
+            /* check for permission to spill $group and $sort to disk */
+            if (!strcmp(pFieldName, allowDiskUsageName)) {
+                pCtx->setAllowDiskUsage(cmdElement.trueValue());
+                continue;
+            }
+
+            /* check for a request to return the results through a cursor */
+            if (!strcmp(pFieldName, cursorName)) {
+                if (cmdElement.type() != Object) {
+                    errmsg = "cursor option must be an object";
+                    return intrusive_ptr<Pipeline>();
+                }
+
+                pPipeline->cursorCommand = true;
+                BSONElement batchSizeElem = cmdElement.Obj()[batchSizeName];
+                if (!batchSizeElem.eoo()) {
+                    if (!batchSizeElem.isNumber() || batchSizeElem.numberLong() < 0) {
+                        errmsg = "cursor.batchSize must be a non-negative number";
+                        return intrusive_ptr<Pipeline>();
+                    }
+                    pPipeline->batchSize = batchSizeElem.numberInt();
+                }
+                continue;
+            }
+
             /* check for debug options */
             if (!strcmp(pFieldName, splitMongodPipelineName)) {
                 pPipeline->splitMongodPipeline = true;
@@ -377,9 +407,20 @@ namespace mongo {
         if ((btemp = pCtx->getInRouter())) {
             pBuilder->append(fromRouterName, btemp);
         }
+
+        if ((btemp = pCtx->getAllowDiskUsage())) {
+            pBuilder->append(allowDiskUsageName, btemp);
+        }
+
+        if (cursorCommand) {
+            BSONObjBuilder cursorBuilder(pBuilder->subobjStart(cursorName));
+            if (batchSize)
+                cursorBuilder.append(batchSizeName, batchSize);
+            cursorBuilder.doneFast();
+        }
     }
 
-    bool Pipeline::run(BSONObjBuilder &result, string &errmsg) {
+    void Pipeline::stitch() {
         massert(16600, "should not have an empty pipeline",
                 !sources.empty());
 
@@ -393,6 +434,15 @@ namespace mongo {
             pTemp->setSource(prevSource);
             prevSource = pTemp.get();
         }
+    }
+
+    DocumentSource* Pipeline::output() const {
+        verify(!sources.empty());
+        return sources.back().get();
+    }
+
+    bool Pipeline::run(BSONObjBuilder &result, string &errmsg) {
+        stitch();
 
         /*
           Iterate through the resulting documents, and add them to the result.
@@ -411,7 +461,7 @@ namespace mongo {
             // the array in which the aggregation results reside
             // cant use subArrayStart() due to error handling
             BSONArrayBuilder resultArray;
-            DocumentSource* finalSource = sources.back().get();
+            DocumentSource* finalSource = output();
             for(bool hasDoc = !finalSource->eof(); hasDoc; hasDoc = finalSource->advance()) {
                 Document pDocument(finalSource->getCurrent());
 
@@ -430,6 +480,10 @@ namespace mongo {
             result.appendArray("result", resultArray.arr());
         }
 
+        if (pCtx->getSpilledBytes()) {
+            result.appendNumber("spilledBytes", pCtx->getSpilledBytes());
+        }
+
     return true;
     }
 
@@ -101,6 +101,19 @@ namespace mongo {
         */
         bool run(BSONObjBuilder &result, string &errmsg);
 
+        /**
+          Chain the sources together, so that output() produces the
+          pipeline's results.  run() does this itself; it's only needed by
+          callers that iterate the results themselves.
+         */
+        void stitch();
+
+        /**
+          The source that produces the pipeline's results.  Only valid once
+          the sources have been stitch()ed together.
+         */
+        DocumentSource* output() const;
+
         /**
           Debugging:  should the processing pipeline be split within
           mongod, simulating the real mongos/mongod split?  This is determined
@@ -121,6 +134,20 @@ namespace mongo {
          */
         bool isExplain() const;
 
+        /**
+           Ask if the results are to be returned through a cursor, rather
+           than as a single array in the command's response.
+
+           @returns true if the command had a cursor option
+         */
+        bool isCursorCommand() const;
+
+        /**
+           The number of documents asked for in the first batch of a
+           cursor command, or 0 to fill it up to the usual reply size.
+         */
+        int getBatchSize() const;
+
         /// The initial source is special since it varies between mongos and mongod.
         void addInitialSource(intrusive_ptr<DocumentSource> source);
 
@@ -129,6 +156,11 @@ namespace mongo {
          */
         static const char commandName[];
 
+        /**
+          The option asking for the results to be returned through a cursor.
+         */
+        static const char cursorName[];
+
         /*
           PipelineD is a "sister" class that has additional functionality
           for the Pipeline.  It exists because of linkage requirements.
@@ -144,6 +176,8 @@ namespace mongo {
         static const char pipelineName[];
         static const char explainName[];
         static const char fromRouterName[];
+        static const char allowDiskUsageName[];
+        static const char batchSizeName[];
         static const char splitMongodPipelineName[];
         static const char serverPipelineName[];
         static const char mongosPipelineName[];
@@ -189,6 +223,8 @@ namespace mongo {
         typedef deque<intrusive_ptr<DocumentSource> > SourceContainer;
         SourceContainer sources;
         bool explain;
+        bool cursorCommand;
+        int batchSize;
 
         bool splitMongodPipeline;
         intrusive_ptr<ExpressionContext> pCtx;
@@ -216,6 +252,14 @@ namespace mongo {
         return explain;
     }
 
+    inline bool Pipeline::isCursorCommand() const {
+        return cursorCommand;
+    }
+
+    inline int Pipeline::getBatchSize() const {
+        return batchSize;
+    }
+
 } // namespace mongo
 
 
@@ -29,7 +29,7 @@
 
 namespace mongo {
 
-    void PipelineD::prepareCursorSource(
+    intrusive_ptr<DocumentSourceCursor> PipelineD::prepareCursorSource(
         const intrusive_ptr<Pipeline> &pPipeline,
         const string &dbName,
         const intrusive_ptr<ExpressionContext> &pExpCtx) {
@@ -44,7 +44,8 @@ namespace mongo {
                 geoNear->client.reset(new DBDirectClient);
                 geoNear->db = dbName;
                 geoNear->collection = pPipeline->collectionName;
-                return; // we don't need a DocumentSourceCursor in this case
+                // we don't need a DocumentSourceCursor in this case
+                return intrusive_ptr<DocumentSourceCursor>();
             }
         }
 
@@ -225,6 +226,7 @@ namespace mongo {
             pSource->dispose();
 
         pPipeline->addInitialSource(pSource);
+        return pSource;
     }
 
 } // namespace mongo
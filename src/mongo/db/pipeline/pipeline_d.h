@@ -50,8 +50,10 @@ namespace mongo {
            @param pPipeline the logical "this" for this operation
            @param dbName the name of the database
            @param pExpCtx the expression context for this pipeline
+           @returns the DocumentSourceCursor added, or NULL if the pipeline
+             reads its input some other way (eg $geoNear)
          */
-        static void prepareCursorSource(
+        static intrusive_ptr<DocumentSourceCursor> prepareCursorSource(
             const intrusive_ptr<Pipeline> &pPipeline,
             const string &dbName,
             const intrusive_ptr<ExpressionContext> &pExpCtx);
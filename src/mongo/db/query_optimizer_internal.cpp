@@ -22,6 +22,7 @@
 #include "mongo/db/db.h"
 #include "mongo/db/pagefault.h"
 #include "mongo/db/parsed_query.h"
+#include "mongo/db/query_plan_cache.h"
 #include "mongo/db/query_plan_selection_policy.h"
 #include "mongo/db/queryutil.h"
 
@@ -731,6 +732,7 @@ namespace mongo {
         _frsp( frsp ),
         _mayRecordPlan(),
         _usingCachedPlan(),
+        _cachedPlanPinned(),
         _order( order.getOwned() ),
         _oldNScanned( 0 ),
         _yieldSometimesTracker( 256, 20 ),
@@ -748,6 +750,7 @@ namespace mongo {
         DEBUGQO( "QueryPlanSet::init " << ns << "\t" << _originalQuery );
         _plans.clear();
         _usingCachedPlan = false;
+        _cachedPlanPinned = false;
 
         _generator.addInitialPlans();
     }
@@ -762,6 +765,7 @@ namespace mongo {
                                       const CachedQueryPlan& cachedPlan ) {
         verify( nPlans() == 0 );
         _usingCachedPlan = true;
+        _cachedPlanPinned = cachedPlan.pinned();
         _oldNScanned = cachedPlan.nScanned();
         _cachedPlanCharacter = cachedPlan.planCharacter();
         pushPlan( plan );
@@ -790,6 +794,7 @@ namespace mongo {
     bool QueryPlanSet::hasPossiblyExcludedPlans() const {
         return
             _usingCachedPlan &&
+            !_cachedPlanPinned &&
             ( nPlans() == 1 ) &&
             ( firstPlan()->utility() != QueryPlan::Optimal );
     }
@@ -1016,6 +1021,9 @@ namespace mongo {
                 runner.queryPlan().registerSelf( runner.nscanned(),
                                                  _plans.characterizeCandidatePlans() );
             }
+            else if ( _plans.usingCachedPlan() ) {
+                runner.queryPlan().noteCachedPlanRun( runner.nscanned() );
+            }
             _done = true;
             return holder._runner;
         }
@@ -1023,8 +1031,9 @@ namespace mongo {
             return holder._runner;
         }
         if ( _plans.hasPossiblyExcludedPlans() &&
-            runner.nscanned() > _plans.oldNScanned() * 10 ) {
+            runner.nscanned() > _plans.oldNScanned() * queryPlanCacheReplanFactor ) {
             verify( _plans.nPlans() == 1 && _plans.firstPlan()->special().empty() );
+            _plans.firstPlan()->noteCachedPlanReplan();
             holder._offset = -runner.nscanned();
             _plans.addFallbackPlans();
             QueryPlanSet::PlanVector::const_iterator i = _plans.plans().begin();
@@ -1563,33 +1572,80 @@ namespace mongo {
                                                     const BSONObj& order ) {
         SimpleMutex::scoped_lock lk(NamespaceDetailsTransient::_qcMutex);
         NamespaceDetailsTransient& nsdt = NamespaceDetailsTransient::get_inlock( frsp.ns() );
-        CachedQueryPlan noCachedPlan;
-        nsdt.registerCachedQueryPlanForPattern( frsp._singleKey.pattern( order ), noCachedPlan );
-        nsdt.registerCachedQueryPlanForPattern( frsp._multiKey.pattern( order ), noCachedPlan );
+        nsdt.queryPlanCache().invalidate( frsp._singleKey.pattern( order ) );
+        nsdt.queryPlanCache().invalidate( frsp._multiKey.pattern( order ) );
     }
     
     CachedQueryPlan QueryUtilIndexed::bestIndexForPatterns( const FieldRangeSetPair& frsp,
                                                             const BSONObj& order ) {
         SimpleMutex::scoped_lock lk( NamespaceDetailsTransient::_qcMutex );
         NamespaceDetailsTransient& nsdt = NamespaceDetailsTransient::get_inlock( frsp.ns() );
+        QueryPlanCache& cache = nsdt.queryPlanCache();
         // TODO Maybe it would make sense to return the index with the lowest
         // nscanned if there are two possibilities.
+        QueryPattern singleKeyPattern = frsp._singleKey.pattern( order );
         {
-            QueryPattern pattern = frsp._singleKey.pattern( order );
-            CachedQueryPlan cachedQueryPlan = nsdt.cachedQueryPlanForPattern( pattern );
+            CachedQueryPlan cachedQueryPlan = cache.find( singleKeyPattern );
             if ( !cachedQueryPlan.indexKey().isEmpty() ) {
+                cache.noteHit( singleKeyPattern );
                 return cachedQueryPlan;
             }
         }
+        QueryPattern multiKeyPattern = frsp._multiKey.pattern( order );
         {
-            QueryPattern pattern = frsp._multiKey.pattern( order );
-            CachedQueryPlan cachedQueryPlan = nsdt.cachedQueryPlanForPattern( pattern );
+            CachedQueryPlan cachedQueryPlan = cache.find( multiKeyPattern );
             if ( !cachedQueryPlan.indexKey().isEmpty() ) {
+                cache.noteHit( multiKeyPattern );
                 return cachedQueryPlan;
             }
         }
+        cache.noteMiss( singleKeyPattern, multiKeyPattern );
         return CachedQueryPlan();
     }
+
+    bool QueryUtilIndexed::pinIndexForPatterns( NamespaceDetails* d,
+                                                const FieldRangeSetPair& frsp,
+                                                const BSONObj& query,
+                                                const BSONObj& order,
+                                                const BSONObj& indexKey,
+                                                string& errmsg ) {
+        int idxNo = -1;
+        if ( !str::equals( indexKey.firstElementFieldName(), "$natural" ) ) {
+            idxNo = d->findIndexByKeyPattern( indexKey );
+            if ( idxNo < 0 ) {
+                errmsg = str::stream() << "no index with key pattern " << indexKey;
+                return false;
+            }
+        }
+
+        scoped_ptr<QueryPlan> plan( QueryPlan::make( d, idxNo, frsp, 0, query, order ) );
+        // the plans addCachedPlan() would pass over
+        if ( plan->utility() == QueryPlan::Unhelpful ||
+             plan->utility() == QueryPlan::Disallowed ||
+             !plan->special().empty() ) {
+            errmsg = str::stream() << "index " << indexKey << " can't be pinned for this query";
+            return false;
+        }
+
+        bool scanAndOrder = plan->scanAndOrderRequired();
+        CachedQueryPlan pinned( plan->indexKey(), 0,
+                                CandidatePlanCharacter( !scanAndOrder, scanAndOrder ), true );
+
+        SimpleMutex::scoped_lock lk( NamespaceDetailsTransient::_qcMutex );
+        NamespaceDetailsTransient& nsdt = NamespaceDetailsTransient::get_inlock( frsp.ns() );
+        nsdt.queryPlanCache().pin( frsp._singleKey.pattern( order ), pinned );
+        nsdt.queryPlanCache().pin( frsp._multiKey.pattern( order ), pinned );
+        return true;
+    }
+
+    bool QueryUtilIndexed::unpinIndexForPatterns( const FieldRangeSetPair& frsp,
+                                                  const BSONObj& order ) {
+        SimpleMutex::scoped_lock lk( NamespaceDetailsTransient::_qcMutex );
+        NamespaceDetailsTransient& nsdt = NamespaceDetailsTransient::get_inlock( frsp.ns() );
+        bool singleKey = nsdt.queryPlanCache().unpin( frsp._singleKey.pattern( order ) );
+        bool multiKey = nsdt.queryPlanCache().unpin( frsp._multiKey.pattern( order ) );
+        return singleKey || multiKey;
+    }
     
     bool QueryUtilIndexed::uselessOr( const OrRangeGenerator& org,
                                       NamespaceDetails* d,
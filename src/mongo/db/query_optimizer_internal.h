@@ -456,6 +456,7 @@ namespace mongo {
         PlanVector _plans;
         bool _mayRecordPlan;
         bool _usingCachedPlan;
+        bool _cachedPlanPinned;
         CandidatePlanCharacter _cachedPlanCharacter;
         BSONObj _order;
         long long _oldNScanned;
@@ -804,6 +805,21 @@ namespace mongo {
         static CachedQueryPlan bestIndexForPatterns( const FieldRangeSetPair& frsp,
                                                      const BSONObj& order );
 
+        /**
+         * Pin the index with key pattern 'indexKey', or $natural, as the plan for both the single
+         * and multi key pattern.
+         * @return false, setting 'errmsg', if the index doesn't exist or can't be used.
+         */
+        static bool pinIndexForPatterns( NamespaceDetails* d,
+                                         const FieldRangeSetPair& frsp,
+                                         const BSONObj& query,
+                                         const BSONObj& order,
+                                         const BSONObj& indexKey,
+                                         string& errmsg );
+
+        /** Unpin the plans of the single and multi key pattern.  @return false if neither was. */
+        static bool unpinIndexForPatterns( const FieldRangeSetPair& frsp, const BSONObj& order );
+
         static bool uselessOr( const OrRangeGenerator& org, NamespaceDetails* d, int hintIdx );
     };
     
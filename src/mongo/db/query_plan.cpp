@@ -346,6 +346,18 @@ doneCheckOrder:
         NamespaceDetailsTransient &nsdt = NamespaceDetailsTransient::get_inlock( ns() );
         nsdt.registerCachedQueryPlanForPattern( queryPattern, queryPlanToCache );
     }
+
+    void QueryPlan::noteCachedPlanRun( long long nScanned ) const {
+        SimpleMutex::scoped_lock lk( NamespaceDetailsTransient::_qcMutex );
+        NamespaceDetailsTransient &nsdt = NamespaceDetailsTransient::get_inlock( ns() );
+        nsdt.queryPlanCache().noteRun( _frs.pattern( _order ), nScanned );
+    }
+
+    void QueryPlan::noteCachedPlanReplan() const {
+        SimpleMutex::scoped_lock lk( NamespaceDetailsTransient::_qcMutex );
+        NamespaceDetailsTransient &nsdt = NamespaceDetailsTransient::get_inlock( ns() );
+        nsdt.queryPlanCache().noteReplan( _frs.pattern( _order ) );
+    }
     
     void QueryPlan::checkTableScanAllowed() const {
         if ( likely( !cmdLine.noTableScan ) )
@@ -102,6 +102,12 @@ namespace mongo {
         /** Register this plan as a winner for its QueryPattern, with specified 'nscanned'. */
         void registerSelf( long long nScanned, CandidatePlanCharacter candidatePlans ) const;
 
+        /** Note a run of this plan, taken from the plan cache, that scanned 'nScanned'. */
+        void noteCachedPlanRun( long long nScanned ) const;
+
+        /** Note that this plan, taken from the plan cache, regressed and is being raced again. */
+        void noteCachedPlanReplan() const;
+
         int direction() const { return _direction; }
 
         BSONObj indexKey() const;
@@ -0,0 +1,208 @@
+// @file query_plan_cache.cpp
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/query_plan_cache.h"
+
+#include "mongo/db/server_parameters.h"
+
+namespace mongo {
+
+    MONGO_EXPORT_SERVER_PARAMETER(queryPlanCacheSize, int, 200);
+    MONGO_EXPORT_SERVER_PARAMETER(queryPlanCacheReplanFactor, int, 10);
+
+    QueryPlanCache::Entry::Entry( const QueryPattern& pattern, const CachedQueryPlan& plan ) :
+        pattern( pattern ),
+        hits(),
+        misses(),
+        replans() {
+        reset( plan );
+    }
+
+    void QueryPlanCache::Entry::reset( const CachedQueryPlan& newPlan ) {
+        plan = newPlan;
+        // the run that recorded the plan is its first
+        runs = plan.indexKey().isEmpty() ? 0 : 1;
+        totalNScanned = runs ? plan.nScanned() : 0;
+    }
+
+    QueryPlanCache::QueryPlanCache() :
+        _hits(),
+        _misses(),
+        _evictions() {
+    }
+
+    QueryPlanCache::Entry* QueryPlanCache::_find( const QueryPattern& pattern ) const {
+        EntryIndex::const_iterator i = _index.find( pattern );
+        if ( i == _index.end() ) {
+            return 0;
+        }
+        return &*i->second;
+    }
+
+    void QueryPlanCache::_touch( const QueryPattern& pattern ) {
+        EntryList::iterator i = _index[ pattern ];
+        _entries.splice( _entries.begin(), _entries, i );
+    }
+
+    void QueryPlanCache::_evict() {
+        size_t maxSize = std::max( queryPlanCacheSize, 1 );
+        EntryList::iterator i = _entries.end();
+        while( _index.size() > maxSize && i != _entries.begin() ) {
+            --i;
+            if ( i->plan.pinned() ) {
+                continue;
+            }
+            _index.erase( i->pattern );
+            i = _entries.erase( i );
+            ++_evictions;
+        }
+    }
+
+    CachedQueryPlan QueryPlanCache::find( const QueryPattern& pattern ) const {
+        Entry* entry = _find( pattern );
+        if ( !entry || entry->plan.indexKey().isEmpty() ) {
+            return CachedQueryPlan();
+        }
+        return CachedQueryPlan( entry->plan.indexKey(),
+                                entry->avgNScanned(),
+                                entry->plan.planCharacter(),
+                                entry->plan.pinned() );
+    }
+
+    void QueryPlanCache::set( const QueryPattern& pattern, const CachedQueryPlan& plan ) {
+        Entry* entry = _find( pattern );
+        if ( entry ) {
+            if ( !entry->plan.pinned() ) {
+                entry->reset( plan );
+            }
+            _touch( pattern );
+            return;
+        }
+        _entries.push_front( Entry( pattern, plan ) );
+        _index[ pattern ] = _entries.begin();
+        _evict();
+    }
+
+    void QueryPlanCache::invalidate( const QueryPattern& pattern ) {
+        Entry* entry = _find( pattern );
+        if ( !entry || entry->plan.pinned() || entry->plan.indexKey().isEmpty() ) {
+            return;
+        }
+        entry->reset( CachedQueryPlan() );
+        ++entry->replans;
+    }
+
+    void QueryPlanCache::clear() {
+        _entries.clear();
+        _index.clear();
+    }
+
+    void QueryPlanCache::noteHit( const QueryPattern& pattern ) {
+        Entry* entry = _find( pattern );
+        if ( !entry ) {
+            return;
+        }
+        ++entry->hits;
+        ++_hits;
+        _touch( pattern );
+    }
+
+    void QueryPlanCache::noteMiss( const QueryPattern& singleKeyPattern,
+                                   const QueryPattern& multiKeyPattern ) {
+        ++_misses;
+        Entry* singleKeyEntry = _find( singleKeyPattern );
+        if ( singleKeyEntry ) {
+            ++singleKeyEntry->misses;
+        }
+        Entry* multiKeyEntry = _find( multiKeyPattern );
+        if ( multiKeyEntry && multiKeyEntry != singleKeyEntry ) {
+            ++multiKeyEntry->misses;
+        }
+    }
+
+    void QueryPlanCache::noteRun( const QueryPattern& pattern, long long nScanned ) {
+        Entry* entry = _find( pattern );
+        if ( !entry || entry->plan.indexKey().isEmpty() ) {
+            return;
+        }
+        ++entry->runs;
+        entry->totalNScanned += nScanned;
+    }
+
+    void QueryPlanCache::noteReplan( const QueryPattern& pattern ) {
+        Entry* entry = _find( pattern );
+        if ( entry ) {
+            ++entry->replans;
+        }
+    }
+
+    void QueryPlanCache::pin( const QueryPattern& pattern, const CachedQueryPlan& plan ) {
+        verify( plan.pinned() );
+        Entry* entry = _find( pattern );
+        if ( entry ) {
+            entry->reset( plan );
+            _touch( pattern );
+            return;
+        }
+        _entries.push_front( Entry( pattern, plan ) );
+        _index[ pattern ] = _entries.begin();
+        _evict();
+    }
+
+    bool QueryPlanCache::unpin( const QueryPattern& pattern ) {
+        EntryIndex::iterator i = _index.find( pattern );
+        if ( i == _index.end() || !i->second->plan.pinned() ) {
+            return false;
+        }
+        // forget the pinned plan altogether, so the next query races the candidates
+        _entries.erase( i->second );
+        _index.erase( i );
+        return true;
+    }
+
+    void QueryPlanCache::appendStats( BSONObjBuilder& b ) const {
+        b.append( "size", size() );
+        b.append( "maxSize", queryPlanCacheSize );
+        b.append( "hits", _hits );
+        b.append( "misses", _misses );
+        b.append( "evictions", _evictions );
+
+        BSONArrayBuilder entries( b.subarrayStart( "entries" ) );
+        for( EntryList::const_iterator i = _entries.begin(); i != _entries.end(); ++i ) {
+            BSONObjBuilder e( entries.subobjStart() );
+            e.appendElements( i->pattern.toBSON() );
+            if ( i->plan.indexKey().isEmpty() ) {
+                e.appendNull( "indexKey" );
+            }
+            else {
+                e.append( "indexKey", i->plan.indexKey() );
+            }
+            e.append( "pinned", i->plan.pinned() );
+            e.append( "hits", i->hits );
+            e.append( "misses", i->misses );
+            e.append( "replans", i->replans );
+            e.append( "runs", i->runs );
+            e.append( "avgNScanned", i->avgNScanned() );
+            e.done();
+        }
+        entries.done();
+    }
+
+} // namespace mongo
@@ -0,0 +1,124 @@
+// @file query_plan_cache.h - Per collection cache of the query plans chosen for query patterns.
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <list>
+
+#include "mongo/db/querypattern.h"
+
+namespace mongo {
+
+    /** The most query patterns a collection's plan cache holds.  Settable with setParameter. */
+    extern int queryPlanCacheSize;
+
+    /**
+     * A run of a cached plan that scans more than this many times the plan's average nscanned
+     * races the plan against the other candidates again.  Settable with setParameter.
+     */
+    extern int queryPlanCacheReplanFactor;
+
+    /**
+     * The plans recorded for a collection's QueryPatterns, kept in least recently used order and
+     * bounded by queryPlanCacheSize.
+     *
+     * Each entry counts the lookups that found its plan (hits) or found it cleared (misses), the
+     * times its plan regressed and was raced again (replans), and the nscanned of the runs of the
+     * plan; find() reports the average nscanned of those runs, which is what later runs are
+     * measured against.  Writes to the collection don't invalidate plans, regression does.
+     *
+     * A plan pinned with pin() is not evicted, replaced or raced again until it is unpinned or
+     * the collection's indexes change.
+     *
+     * Not thread safe; the owning NamespaceDetailsTransient's callers hold
+     * NamespaceDetailsTransient::_qcMutex.
+     */
+    class QueryPlanCache : boost::noncopyable {
+    public:
+        QueryPlanCache();
+
+        /** @return the plan recorded for 'pattern', or an empty plan if there is none. */
+        CachedQueryPlan find( const QueryPattern& pattern ) const;
+
+        /** Record the plan chosen for 'pattern', unless a plan is pinned for it. */
+        void set( const QueryPattern& pattern, const CachedQueryPlan& plan );
+
+        /** Forget the plan recorded for 'pattern', unless it's pinned.  Counts as a replan. */
+        void invalidate( const QueryPattern& pattern );
+
+        /** Remove every entry, pinned or not. */
+        void clear();
+
+        /** The plan found for 'pattern' is being used. */
+        void noteHit( const QueryPattern& pattern );
+
+        /** No plan was found for either the single key or the multi key pattern of a query. */
+        void noteMiss( const QueryPattern& singleKeyPattern, const QueryPattern& multiKeyPattern );
+
+        /** A run of the plan cached for 'pattern' chose its results after scanning 'nScanned'. */
+        void noteRun( const QueryPattern& pattern, long long nScanned );
+
+        /** The plan cached for 'pattern' regressed and is being raced against other plans. */
+        void noteReplan( const QueryPattern& pattern );
+
+        /** Pin 'plan' for 'pattern', replacing any plan recorded for it. */
+        void pin( const QueryPattern& pattern, const CachedQueryPlan& plan );
+
+        /** @return false if no plan was pinned for 'pattern'. */
+        bool unpin( const QueryPattern& pattern );
+
+        int size() const { return _index.size(); }
+
+        /** Append the cache's counters and its entries, most recently used first. */
+        void appendStats( BSONObjBuilder& b ) const;
+
+    private:
+        struct Entry {
+            Entry( const QueryPattern& pattern, const CachedQueryPlan& plan );
+            void reset( const CachedQueryPlan& plan );
+            long long avgNScanned() const { return runs ? totalNScanned / runs : 0; }
+
+            QueryPattern pattern;
+            CachedQueryPlan plan;
+            long long hits;
+            long long misses;
+            long long replans;
+            long long runs;
+            long long totalNScanned;
+        };
+        typedef std::list<Entry> EntryList;
+        typedef map<QueryPattern,EntryList::iterator> EntryIndex;
+
+        /** @return the entry for 'pattern', or 0. */
+        Entry* _find( const QueryPattern& pattern ) const;
+
+        /** Make 'pattern's entry, which must exist, the most recently used. */
+        void _touch( const QueryPattern& pattern );
+
+        /** Evict least recently used entries that aren't pinned, down to queryPlanCacheSize. */
+        void _evict();
+
+        EntryList _entries; // most recently used first
+        EntryIndex _index;
+
+        long long _hits;
+        long long _misses;
+        long long _evictions;
+    };
+
+} // namespace mongo
@@ -49,6 +49,8 @@ namespace mongo {
         bool operator!=( const QueryPattern &other ) const;
         /** for development / debugging */
         string toString() const;
+        /** @return { query: { <field>: <type>, ... }, sort: <normalized sort> } */
+        BSONObj toBSON() const;
     private:
         void setSort( const BSONObj sort );
         static BSONObj normalizeSort( const BSONObj &spec );
@@ -80,17 +82,21 @@ namespace mongo {
     class CachedQueryPlan {
     public:
         CachedQueryPlan() :
-        _nScanned() {
+        _nScanned(),
+        _pinned() {
         }
         CachedQueryPlan( const BSONObj &indexKey, long long nScanned,
-                        CandidatePlanCharacter planCharacter );
+                        CandidatePlanCharacter planCharacter, bool pinned = false );
         BSONObj indexKey() const { return _indexKey; }
         long long nScanned() const { return _nScanned; }
         CandidatePlanCharacter planCharacter() const { return _planCharacter; }
+        /** @return true if the plan was pinned by the planCache command, and is never replanned. */
+        bool pinned() const { return _pinned; }
     private:
         BSONObj _indexKey;
         long long _nScanned;
         CandidatePlanCharacter _planCharacter;
+        bool _pinned;
     };
 
     inline bool QueryPattern::operator<( const QueryPattern &other ) const {
@@ -22,6 +22,7 @@
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/rs_sync.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/base/counter.h"
 #include "mongo/db/stats/timer_stats.h"
@@ -33,11 +34,23 @@ namespace replset {
     BackgroundSync* BackgroundSync::s_instance = 0;
     boost::mutex BackgroundSync::s_mutex;
 
+    // The size (bytes) the buffer may grow to before fetching waits for it to be applied
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(replBufferMaxSizeBytes, int, 256*1024*1024);
+
+    // Send the getMore for the next batch of the sync source's oplog before queueing the batch
+    // just received, so that the round trip overlaps the queueing
+    MONGO_EXPORT_SERVER_PARAMETER(replFetchPipelining, bool, true);
+
     //The number and time spent reading batches off the network
     static TimerStats getmoreReplStats;
     static ServerStatusMetricField<TimerStats> displayBatchesRecieved(
                                                     "repl.network.getmores",
                                                     &getmoreReplStats );
+    //The getmores sent before the previous batch was queued
+    static Counter64 pipelinedGetmoreStats;
+    static ServerStatusMetricField<Counter64> displayPipelinedGetmores(
+                                                    "repl.network.pipelinedGetmores",
+                                                    &pipelinedGetmoreStats );
     //The oplog entries read via the oplog reader
     static Counter64 opsReadStats;
     static ServerStatusMetricField<Counter64> displayOpsRead( "repl.network.ops",
@@ -56,9 +69,12 @@ namespace replset {
     static ServerStatusMetricField<Counter64> displayBufferSize( "repl.buffer.sizeBytes",
                                                                 &bufferSizeGauge );
     //The max size (bytes) of the buffer
-    static int bufferMaxSizeGauge = 256*1024*1024;
     static ServerStatusMetricField<int> displayBufferMaxSize( "repl.buffer.maxSizeBytes",
-                                                                &bufferMaxSizeGauge );
+                                                                &replBufferMaxSizeBytes );
+    //The number and time spent waiting for room in the buffer
+    static TimerStats bufferPushWaitStats;
+    static ServerStatusMetricField<TimerStats> displayBufferPushWait( "repl.buffer.pushWait",
+                                                                &bufferPushWaitStats );
 
 
     BackgroundSyncInterface::~BackgroundSyncInterface() {}
@@ -67,7 +83,7 @@ namespace replset {
         return o.objsize();
     }
 
-    BackgroundSync::BackgroundSync() : _buffer(bufferMaxSizeGauge, &getSize),
+    BackgroundSync::BackgroundSync() : _buffer(replBufferMaxSizeBytes, &getSize),
                                        _lastOpTimeFetched(0, 0),
                                        _lastH(0),
                                        _pause(true),
@@ -348,32 +364,17 @@ namespace replset {
                     //increment
                     networkByteStats.increment(r.currentBatchMessageSize());
 
+                    // Only while ops are coming: a getMore sent when we're caught up waits on
+                    // the sync source for new ops, and we'd have to wait for it before leaving.
+                    if (replFetchPipelining && r.moreInCurrentBatch() && r.prefetchMore()) {
+                        pipelinedGetmoreStats.increment();
+                    }
                 }
 
                 if (!r.more())
                     break;
 
-                BSONObj o = r.nextSafe().getOwned();
-                opsReadStats.increment();
-
-                {
-                    boost::unique_lock<boost::mutex> lock(_mutex);
-                    _appliedBuffer = false;
-                }
-
-                OCCASIONALLY {
-                    LOG(2) << "bgsync buffer has " << _buffer.size() << " bytes" << rsLog;
-                }
-                // the blocking queue will wait (forever) until there's room for us to push
-                _buffer.push(o);
-                bufferCountGauge.increment();
-                bufferSizeGauge.increment(getSize(o));
-
-                {
-                    boost::unique_lock<boost::mutex> lock(_mutex);
-                    _lastH = o["h"].numberLong();
-                    _lastOpTimeFetched = o["ts"]._opTime();
-                }
+                enqueueBatch(r);
             } // end while
 
             {
@@ -394,6 +395,45 @@ namespace replset {
         }
     }
 
+    void BackgroundSync::enqueueBatch(OplogReader& r) {
+        vector<BSONObj> ops;
+        size_t bytes = 0;
+        while (r.moreInCurrentBatch()) {
+            ops.push_back(r.nextSafe().getOwned());
+            bytes += getSize(ops.back());
+        }
+        if (ops.empty()) {
+            return;
+        }
+        opsReadStats.increment(ops.size());
+
+        {
+            boost::unique_lock<boost::mutex> lock(_mutex);
+            _appliedBuffer = false;
+        }
+
+        OCCASIONALLY {
+            LOG(2) << "bgsync buffer has " << _buffer.size() << " bytes" << rsLog;
+        }
+        // the blocking queue will wait (forever) until there's room for the batch
+        {
+            TimerHolder pushTimer(&bufferPushWaitStats);
+            _buffer.pushAll(ops.begin(), ops.end());
+        }
+        bufferCountGauge.increment(ops.size());
+        bufferSizeGauge.increment(bytes);
+
+        for (vector<BSONObj>::const_iterator i = ops.begin(); i != ops.end(); ++i) {
+            SyncTail::prefetchAhead(*i);
+        }
+
+        {
+            boost::unique_lock<boost::mutex> lock(_mutex);
+            _lastH = ops.back()["h"].numberLong();
+            _lastOpTimeFetched = ops.back()["ts"]._opTime();
+        }
+    }
+
     bool BackgroundSync::shouldChangeSyncTarget() {
         boost::unique_lock<boost::mutex> lock(_mutex);
 
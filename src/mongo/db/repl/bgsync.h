@@ -97,6 +97,8 @@ namespace replset {
         void _producerThread();
         // Adds elements to the list, up to maxSize.
         void produce();
+        // Moves the rest of r's current batch into the buffer
+        void enqueueBatch(OplogReader& r);
         // Check if rollback is necessary
         bool isRollbackRequired(OplogReader& r);
         void getOplogReader(OplogReader& r);
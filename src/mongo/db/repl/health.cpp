@@ -466,6 +466,8 @@ namespace mongo {
             b.append("syncingTo", syncTarget->fullName());
         }
         b.append("members", v);
+        appendInitialSyncProgress(&b);
+        appendRollbackProgress(&b);
         if( replSetBlind )
             b.append("blind",true); // to avoid confusion if set...normally never set except for testing.
     }
@@ -106,6 +106,15 @@ namespace mongo {
             return cursor->moreInCurrentBatch();
         }
 
+        /**
+         * Sends the getMore for the next batch while the current one is still being read.  The
+         * connection must not be used for anything else until the current batch runs out.
+         */
+        bool prefetchMore() {
+            uassert( 16761, "Doesn't have cursor for reading oplog", cursor.get() );
+            return cursor->prefetchMoreOnConnection();
+        }
+
         int currentBatchMessageSize() {
             if( NULL == cursor->getMessage() )
                 return 0;
@@ -26,6 +26,7 @@
 #include "mongo/db/repl/master_slave.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/replutil.h"
+#include "mongo/util/net/message_compression.h"
 
 namespace mongo {
 
@@ -133,6 +134,8 @@ namespace mongo {
             
             BSONObjBuilder result;
             appendReplicationInfo(result, level);
+            if ( theReplSet )
+                replset::appendWriterUtilization(&result);
             return result.obj();
         }
     } replicationInfoServerStatus;
@@ -157,6 +160,7 @@ namespace mongo {
                authenticated.
             */
             appendReplicationInfo(result, 0);
+            negotiateCompression(cmdObj, ClientBasic::getCurrent()->port(), &result);
 
             result.appendNumber("maxBsonObjectSize", BSONObjMaxUserSize);
             result.appendNumber("maxMessageSizeBytes", MaxMessageSizeBytes);
@@ -440,6 +440,7 @@ namespace mongo {
         ghost(0),
         _writerPool(replWriterThreadCount),
         _prefetcherPool(replPrefetcherThreadCount),
+        _lookaheadPool(replPrefetcherThreadCount),
         oplogVersion(0),
         _indexPrefetchConfig(PREFETCH_ALL) {
     }
@@ -511,6 +511,8 @@ namespace mongo {
     private:
         bool _syncDoInitialSync_clone(Cloner &cloner, const char *master,
                                       const list<string>& dbs, bool dataPass);
+        bool _syncDoInitialSync_cloneParallel(OplogReader& r, const char *master,
+                                              const list<string>& dbs, int numThreads);
         bool _syncDoInitialSync_applyToHead( replset::SyncTail& syncer, OplogReader* r ,
                                              const Member* source, const BSONObj& lastOp,
                                              BSONObj& minValidOut);
@@ -527,6 +529,8 @@ namespace mongo {
         threadpool::ThreadPool _writerPool;
         // persistent pool of worker threads for prefetching
         threadpool::ThreadPool _prefetcherPool;
+        // persistent pool of worker threads for prefetching ops ahead of their batch
+        threadpool::ThreadPool _lookaheadPool;
 
     public:
         // Allow index prefetching to be turned on/off
@@ -544,6 +548,7 @@ namespace mongo {
         static const int replWriterThreadCount;
         static const int replPrefetcherThreadCount;
         threadpool::ThreadPool& getPrefetchPool() { return _prefetcherPool; }
+        threadpool::ThreadPool& getLookaheadPool() { return _lookaheadPool; }
         threadpool::ThreadPool& getWriterPool() { return _writerPool; }
 
         static const int maxSyncSourceLagSecs;
@@ -610,6 +615,7 @@ namespace mongo {
         void summarizeStatus(BSONObjBuilder& b) const  { _summarizeStatus(b); }
         void fillIsMaster(BSONObjBuilder& b) { _fillIsMaster(b); }
         threadpool::ThreadPool& getPrefetchPool() { return ReplSetImpl::getPrefetchPool(); }
+        threadpool::ThreadPool& getLookaheadPool() { return ReplSetImpl::getLookaheadPool(); }
         threadpool::ThreadPool& getWriterPool() { return ReplSetImpl::getWriterPool(); }
 
         /**
@@ -681,6 +687,12 @@ namespace mongo {
      */
     void replLocalAuth();
 
+    /** adds the progress of the last parallel initial sync, if any, to replSetGetStatus */
+    void appendInitialSyncProgress(BSONObjBuilder* b);
+
+    /** adds the progress of the current or last rollback, if any, to replSetGetStatus */
+    void appendRollbackProgress(BSONObjBuilder* b);
+
     /** inlines ----------------- */
 
     inline Member::Member(HostAndPort h, unsigned ord, const ReplSetConfig::MemberCfg *c, bool self) :
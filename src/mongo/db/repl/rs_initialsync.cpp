@@ -18,15 +18,20 @@
 
 #include "mongo/db/repl/rs.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "mongo/db/client.h"
 #include "mongo/db/cloner.h"
 #include "mongo/db/dbhelpers.h"
+#include "mongo/db/namespace_details.h"
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/oplogreader.h"
 #include "mongo/db/repl/optime.h"
 #include "mongo/db/repl/replication_server_status.h"  // replSettings
 #include "mongo/db/repl/rs_sync.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
@@ -36,6 +41,10 @@ namespace mongo {
 
     void dropAllDatabasesExceptLocal();
 
+    // Collections cloned at once by initial sync, each over its own connection.  1 clones them
+    // one after the other and builds their indexes after the oplog is applied, as before.
+    MONGO_EXPORT_SERVER_PARAMETER(initialSyncCloneThreads, int, 4);
+
     // add try/catch with sleep
 
     void isyncassert(const string& msg, bool expr) {
@@ -107,6 +116,299 @@ namespace mongo {
         return true;
     }
 
+    namespace {
+
+        /** where each collection of the last parallel initial sync got to, for replSetGetStatus */
+        class InitialSyncProgress {
+        public:
+            enum State { PENDING, CLONING, CLONED, INDEXING, DONE, FAILED };
+
+            struct Collection {
+                Collection(const string& db, const string& ns)
+                    : db(db), ns(ns), state(PENDING), started(0), cloned(0), indexed(0) {}
+                const string db;
+                const string ns;
+                State state;
+                AtomicInt64 docs;
+                unsigned long long started;
+                unsigned long long cloned;
+                unsigned long long indexed;
+            };
+            typedef boost::shared_ptr<Collection> CollectionPtr;
+
+            InitialSyncProgress() : _mutex("InitialSyncProgress"), _threads(0) {}
+
+            void reset(int threads) {
+                scoped_lock lk(_mutex);
+                _threads = threads;
+                _collections.clear();
+            }
+
+            CollectionPtr add(const string& db, const string& ns) {
+                CollectionPtr c(new Collection(db, ns));
+                scoped_lock lk(_mutex);
+                _collections.push_back(c);
+                return c;
+            }
+
+            void setState(const CollectionPtr& c, State state) {
+                scoped_lock lk(_mutex);
+                c->state = state;
+                unsigned long long now = curTimeMillis64();
+                if (state == CLONING)
+                    c->started = now;
+                else if (state == CLONED)
+                    c->cloned = now;
+                else if (state == DONE)
+                    c->indexed = now;
+            }
+
+            void append(BSONObjBuilder* b) {
+                scoped_lock lk(_mutex);
+                if (_collections.empty())
+                    return;
+
+                unsigned long long now = curTimeMillis64();
+                int done = 0;
+                BSONArrayBuilder arr;
+                for (vector<CollectionPtr>::const_iterator i = _collections.begin();
+                     i != _collections.end(); ++i) {
+                    const Collection& c = **i;
+                    if (c.state == DONE)
+                        done++;
+                    BSONObjBuilder cb(arr.subobjStart());
+                    cb.append("ns", c.ns);
+                    cb.append("state", stateName(c.state));
+                    cb.append("docs", c.docs.load());
+                    if (c.started)
+                        cb.append("cloneMillis",
+                                  (long long)((c.cloned ? c.cloned : now) - c.started));
+                    if (c.cloned)
+                        cb.append("indexMillis",
+                                  (long long)((c.indexed ? c.indexed : now) - c.cloned));
+                    cb.done();
+                }
+
+                BSONObjBuilder sb(b->subobjStart("initialSyncStatus"));
+                sb.append("threads", _threads);
+                sb.append("collections", (int)_collections.size());
+                sb.append("done", done);
+                sb.append("progress", arr.arr());
+                sb.done();
+            }
+
+        private:
+            static const char* stateName(State state) {
+                switch (state) {
+                case PENDING: return "pending";
+                case CLONING: return "cloning";
+                case CLONED: return "cloned";
+                case INDEXING: return "indexing";
+                case DONE: return "done";
+                case FAILED: return "failed";
+                }
+                return "unknown";
+            }
+
+            mongo::mutex _mutex;
+            int _threads;
+            vector<CollectionPtr> _collections;
+        } initialSyncProgress;
+
+        /**
+         * Clones the collections of an initial sync with several threads, each with its own
+         * connection to the sync target.  A collection's indexes are built by one more thread as
+         * soon as its data is in, while the clone threads go on to the next collections.
+         */
+        class ParallelCollectionCloner {
+        public:
+            ParallelCollectionCloner(const string& master) :
+                _master(master), _mutex("ParallelCollectionCloner"), _cloning(0),
+                _failed(false) {}
+
+            void add(const InitialSyncProgress::CollectionPtr& c) { _toClone.push_back(c); }
+
+            /** @return false, with errmsg set, if a collection couldn't be cloned or indexed */
+            bool run(int numThreads, string& errmsg) {
+                _cloning = numThreads;
+                boost::thread_group threads;
+                for (int i = 0; i < numThreads; i++)
+                    threads.create_thread(boost::bind(&ParallelCollectionCloner::cloneThread,
+                                                      this, i));
+                threads.create_thread(boost::bind(&ParallelCollectionCloner::indexThread, this));
+                threads.join_all();
+
+                if (_failed)
+                    errmsg = _errmsg;
+                return !_failed;
+            }
+
+        private:
+            void cloneThread(int threadNumber) {
+                string threadName = str::stream() << "rsInitialSyncClone" << threadNumber;
+                Client::initThread(threadName.c_str());
+                replLocalAuth();
+
+                Cloner cloner;
+                InitialSyncProgress::CollectionPtr c;
+                while (_nextToClone(&c)) {
+                    initialSyncProgress.setState(c, InitialSyncProgress::CLONING);
+                    if (!_go(cloner, c, true))
+                        break;
+                    initialSyncProgress.setState(c, InitialSyncProgress::CLONED);
+
+                    scoped_lock lk(_mutex);
+                    _toIndex.push_back(c);
+                    _queueChanged.notify_all();
+                }
+
+                {
+                    scoped_lock lk(_mutex);
+                    _cloning--;
+                    _queueChanged.notify_all();
+                }
+                cc().shutdown();
+            }
+
+            /**
+             * The only thread building indexes.  Its builds are repair-style, as with a
+             * sequential initial sync: that makes the _id index drop duplicates of documents
+             * cloned before the oplog is applied, and applying the oplog refetches them.  Other
+             * unique indexes don't drop anything: in STARTUP2 ignoreUniqueIndex() lets them hold
+             * duplicates until the oplog has been applied.
+             */
+            void indexThread() {
+                Client::initThread("rsInitialSyncIndex");
+                replLocalAuth();
+
+                {
+                    Client::RepairIndexBuildScope repairBuilds;
+                    Cloner cloner;
+                    InitialSyncProgress::CollectionPtr c;
+                    while (_nextToIndex(&c)) {
+                        initialSyncProgress.setState(c, InitialSyncProgress::INDEXING);
+                        if (!_go(cloner, c, false))
+                            break;
+                        initialSyncProgress.setState(c, InitialSyncProgress::DONE);
+                    }
+                }
+                cc().shutdown();
+            }
+
+            bool _nextToClone(InitialSyncProgress::CollectionPtr* c) {
+                scoped_lock lk(_mutex);
+                if (_failed || _toClone.empty())
+                    return false;
+                *c = _toClone.front();
+                _toClone.pop_front();
+                return true;
+            }
+
+            bool _nextToIndex(InitialSyncProgress::CollectionPtr* c) {
+                scoped_lock lk(_mutex);
+                while (_toIndex.empty() && _cloning > 0 && !_failed)
+                    _queueChanged.wait(lk.boost());
+                if (_failed || _toIndex.empty())
+                    return false;
+                *c = _toIndex.front();
+                _toIndex.pop_front();
+                return true;
+            }
+
+            /** clones the data of c if dataPass, else its indexes (including _id) */
+            bool _go(Cloner& cloner, const InitialSyncProgress::CollectionPtr& c, bool dataPass) {
+                string err;
+                try {
+                    Client::WriteContext ctx(c->db);
+
+                    CloneOptions options;
+                    options.fromDB = c->db;
+                    options.logForRepl = false;
+                    options.slaveOk = true;
+                    options.useReplAuth = true;
+                    options.snapshot = false;
+                    options.mayYield = true;
+                    options.mayBeInterrupted = false;
+                    options.syncData = dataPass;
+                    options.syncIndexes = ! dataPass;
+                    options.collsToClone.insert(c->ns);
+                    options.deferIdIndex = true;
+                    options.docsCloned = &c->docs;
+
+                    int errCode;
+                    if (cloner.go(_master.c_str(), options, err, &errCode))
+                        return true;
+                }
+                catch (DBException& e) {
+                    err = e.toString();
+                }
+
+                initialSyncProgress.setState(c, InitialSyncProgress::FAILED);
+                scoped_lock lk(_mutex);
+                if (!_failed) {
+                    _failed = true;
+                    _errmsg = str::stream() << "error while "
+                                            << (dataPass ? "cloning " : "indexing ") << c->ns
+                                            << ".  " << err;
+                }
+                _queueChanged.notify_all();
+                return false;
+            }
+
+            const string _master;
+
+            mongo::mutex _mutex; // guards the rest
+            boost::condition _queueChanged;
+            deque<InitialSyncProgress::CollectionPtr> _toClone;
+            deque<InitialSyncProgress::CollectionPtr> _toIndex;
+            int _cloning; // clone threads still running
+            bool _failed;
+            string _errmsg;
+        };
+
+    } // namespace
+
+    void appendInitialSyncProgress(BSONObjBuilder* b) {
+        initialSyncProgress.append(b);
+    }
+
+    bool ReplSetImpl::_syncDoInitialSync_cloneParallel(OplogReader& r, const char *master,
+                                                       const list<string>& dbs, int numThreads) {
+        initialSyncProgress.reset(numThreads);
+        ParallelCollectionCloner cloner(master);
+
+        for( list<string>::const_iterator i = dbs.begin(); i != dbs.end(); i++ ) {
+            const string& db = *i;
+            if( db == "local" )
+                continue;
+
+            // the collections the Cloner would copy: system ones but system.users and the like,
+            // and $ ones, are left out
+            auto_ptr<DBClientCursor> cursor = r.conn()->query(db + ".system.namespaces", Query(),
+                                                              0, 0, 0, QueryOption_SlaveOk);
+            isyncassert( str::stream() << "couldn't list the collections of " << db,
+                         cursor.get() != 0 );
+            while( cursor->more() ) {
+                BSONObj collection = cursor->nextSafe();
+                string ns = collection["name"].str();
+                if( ns.find(".system.") != string::npos && !legalClientSystemNS(ns, true) )
+                    continue;
+                if( !NamespaceString::normal(ns.c_str()) )
+                    continue;
+                cloner.add(initialSyncProgress.add(db, ns));
+            }
+        }
+
+        sethbmsg( str::stream() << "initial sync cloning collections with " << numThreads
+                                << " threads" , 0);
+        string errmsg;
+        if( !cloner.run(numThreads, errmsg) ) {
+            sethbmsg( str::stream() << "initial sync: " << errmsg << "  sleeping 5 minutes", 0);
+            return false;
+        }
+        return true;
+    }
+
     void _logOpObjRS(const BSONObj& op);
 
     static void emptyOplog() {
@@ -340,6 +642,9 @@ namespace mongo {
      * three times: step 4, 6, and 8.  4 may involve refetching, 6 should not.  By the end of 6,
      * this member should have consistent data.  8 is "cosmetic," it is only to get this member
      * closer to the latest op time before it can transition to secondary state.
+     *
+     * With initialSyncCloneThreads > 1, step 2 clones several collections at once and builds each
+     * one's indexes as soon as it is cloned, and step 7 is skipped.
      */
     void ReplSetImpl::_syncDoInitialSync() {
         replset::InitialSync init(replset::BackgroundSync::get());
@@ -396,8 +701,15 @@ namespace mongo {
 
             list<string> dbs = r.conn()->getDatabaseNames();
 
+            // with more than one thread, indexes are built as each collection is cloned, rather
+            // than after the oplog is applied
+            const int numThreads = std::max(1, (int)initialSyncCloneThreads);
+            const bool parallel = numThreads > 1;
+
             Cloner cloner;
-            if (!_syncDoInitialSync_clone(cloner, sourceHostname.c_str(), dbs, true)) {
+            if (parallel ?
+                !_syncDoInitialSync_cloneParallel(r, sourceHostname.c_str(), dbs, numThreads) :
+                !_syncDoInitialSync_clone(cloner, sourceHostname.c_str(), dbs, true)) {
                 veto(source->fullName(), 600);
                 sleepsecs(300);
                 return;
@@ -423,11 +735,13 @@ namespace mongo {
 
             lastOp = minValid;
 
-            sethbmsg("initial sync building indexes",0);
-            if (!_syncDoInitialSync_clone(cloner, sourceHostname.c_str(), dbs, false)) {
-                veto(source->fullName(), 600);
-                sleepsecs(300);
-                return;
+            if (!parallel) {
+                sethbmsg("initial sync building indexes",0);
+                if (!_syncDoInitialSync_clone(cloner, sourceHostname.c_str(), dbs, false)) {
+                    veto(source->fullName(), 600);
+                    sleepsecs(300);
+                    return;
+                }
             }
         }
 
@@ -17,12 +17,18 @@
 
 #include "pch.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "mongo/db/client.h"
 #include "mongo/db/cloner.h"
+#include "mongo/db/commands/fsync.h"
+#include "mongo/db/instance.h"
 #include "mongo/db/ops/update.h"
 #include "mongo/db/ops/delete.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/rs.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
 
 /* Scenarios
 
@@ -66,6 +72,11 @@ namespace mongo {
 
     void incRBID();
 
+    // Connections the documents to roll back are refetched over, each fetching up to
+    // rollbackRefetchBatchSize documents of a collection per query
+    MONGO_EXPORT_SERVER_PARAMETER(rollbackRefetchThreads, int, 4);
+    MONGO_EXPORT_SERVER_PARAMETER(rollbackRefetchBatchSize, int, 500);
+
     class rsfatal : public std::exception {
     public:
         virtual const char* what() const throw() { return "replica set fatal exception"; }
@@ -192,6 +203,376 @@ namespace mongo {
 
     int getRBID(DBClientConnection*);
 
+    namespace {
+
+        /** where the current or last rollback got to, for replSetGetStatus */
+        class RollbackProgress {
+        public:
+            RollbackProgress() : _mutex("RollbackProgress"), _phase(NULL), _started(0),
+                                 _finished(0), _toRefetch(0), _toFix(0) {}
+
+            void start(size_t toRefetch) {
+                scoped_lock lk(_mutex);
+                _phase = "refetch";
+                _started = curTimeMillis64();
+                _finished = 0;
+                _toRefetch = toRefetch;
+                _toFix = 0;
+                refetched.store(0);
+                refetchBatches.store(0);
+                fixed.store(0);
+            }
+
+            void setPhase(const char* phase) {
+                scoped_lock lk(_mutex);
+                _phase = phase;
+            }
+
+            void setToFix(size_t toFix) {
+                scoped_lock lk(_mutex);
+                _phase = "fixup";
+                _toFix = toFix;
+            }
+
+            void finish(const char* phase) {
+                scoped_lock lk(_mutex);
+                _phase = phase;
+                _finished = curTimeMillis64();
+            }
+
+            void append(BSONObjBuilder* b) {
+                scoped_lock lk(_mutex);
+                if (!_phase)
+                    return;
+
+                BSONObjBuilder sb(b->subobjStart("rollbackStatus"));
+                sb.append("phase", _phase);
+                sb.appendDate("started", _started);
+                sb.append("millis", (long long)((_finished ? _finished : curTimeMillis64()) -
+                                                _started));
+                sb.append("docsToRefetch", (long long)_toRefetch);
+                sb.append("docsRefetched", (long long)refetched.load());
+                sb.append("refetchBatches", (long long)refetchBatches.load());
+                sb.append("docsToFix", (long long)_toFix);
+                sb.append("docsFixed", (long long)fixed.load());
+                sb.done();
+            }
+
+            AtomicUInt64 refetched;
+            AtomicUInt64 refetchBatches;
+            AtomicUInt64 fixed;
+
+        private:
+            mongo::mutex _mutex;
+            const char* _phase; // NULL until a rollback gets as far as refetching
+            unsigned long long _started;
+            unsigned long long _finished;
+            size_t _toRefetch;
+            size_t _toFix;
+        } rollbackProgress;
+
+        /** the documents of a collection to roll back, with their versions on the sync source */
+        struct CollectionFixUp {
+            CollectionFixUp() : deletes(0), updates(0), warn(false), emptied(false) {}
+
+            string ns;
+            // { _id : ... } of each document, with its version on the source, which is empty if
+            // the source doesn't have the document
+            vector< pair<bo,bo> > docs;
+
+            unsigned deletes;
+            unsigned updates;
+            bool warn;
+            bool emptied; // no records left after the deletes
+        };
+
+        typedef map< string, shared_ptr<CollectionFixUp> > FixUps;
+
+        struct DocIDLess {
+            bool operator()(const DocID& d, const BSONElement& id) const {
+                return d._id.woCompare(id, false) < 0;
+            }
+        };
+
+        /**
+         * Refetches the documents to roll back from the sync source, with an $in query per batch
+         * of _ids of a collection, over several connections.  The fetching threads take no locks,
+         * so they can run while the caller holds the write lock.
+         */
+        class RollbackRefetcher {
+        public:
+            RollbackRefetcher() : _mutex("RollbackRefetcher"), _failed(false) {}
+
+            /** @return false with errmsg set if the documents couldn't all be fetched */
+            bool run(const string& host, const set<DocID>& toRefetch, FixUps& fixUps,
+                     string& errmsg) {
+                _makeBatches(toRefetch);
+                if (_batches.empty())
+                    return true;
+
+                // connected here as authenticating may read local.system.users, which the
+                // fetching threads can't lock
+                const int numThreads = std::max(1, std::min((int)rollbackRefetchThreads,
+                                                            (int)_batches.size()));
+                vector< shared_ptr<OplogReader> > readers;
+                for (int i = 0; i < numThreads; i++) {
+                    shared_ptr<OplogReader> r(new OplogReader(false /* doHandshake */));
+                    if (!r->connect(host)) {
+                        errmsg = str::stream() << "couldn't connect to " << host;
+                        return false;
+                    }
+                    readers.push_back(r);
+                }
+
+                boost::thread_group threads;
+                for (int i = 0; i < numThreads; i++)
+                    threads.create_thread(boost::bind(&RollbackRefetcher::fetchThread, this,
+                                                      i, readers[i].get()));
+                threads.join_all();
+
+                if (_failed) {
+                    errmsg = _errmsg;
+                    return false;
+                }
+
+                for (size_t i = 0; i < _batches.size(); i++) {
+                    const Batch& b = _batches[i];
+                    shared_ptr<CollectionFixUp>& f = fixUps[b.ns];
+                    if (!f) {
+                        f.reset(new CollectionFixUp());
+                        f->ns = b.ns;
+                    }
+                    for (size_t j = 0; j < b.ids.size(); j++)
+                        f->docs.push_back(make_pair(b.ids[j]._id.wrap(), b.good[j]));
+                }
+                return true;
+            }
+
+        private:
+            struct Batch {
+                string ns;
+                vector<DocID> ids; // in _id order
+                vector<bo> good;
+            };
+
+            void _makeBatches(const set<DocID>& toRefetch) {
+                const size_t maxDocs = std::max(1, (int)rollbackRefetchBatchSize);
+                // keep the query well under the largest message
+                const int maxIdBytes = 1024 * 1024;
+
+                int idBytes = 0;
+                for (set<DocID>::const_iterator i = toRefetch.begin(); i != toRefetch.end(); ++i) {
+                    verify( !i->_id.eoo() );
+                    if (_batches.empty() || _batches.back().ns != i->ns ||
+                        _batches.back().ids.size() >= maxDocs || idBytes >= maxIdBytes) {
+                        _batches.push_back(Batch());
+                        _batches.back().ns = i->ns;
+                        idBytes = 0;
+                    }
+                    _batches.back().ids.push_back(*i);
+                    idBytes += i->_id.size();
+                }
+            }
+
+            void fetchThread(int threadNumber, OplogReader* r) {
+                string threadName = str::stream() << "rsRollbackRefetch" << threadNumber;
+                Client::initThread(threadName.c_str());
+                replLocalAuth();
+
+                try {
+                    while (!_getFailed()) {
+                        unsigned i = _next.fetchAndAdd(1);
+                        if (i >= _batches.size())
+                            break;
+                        _fetch(r->conn(), _batches[i]);
+                    }
+                }
+                catch (DBException& e) {
+                    _fail(e.toString());
+                }
+                catch (std::exception& e) {
+                    _fail(e.what());
+                }
+                cc().shutdown();
+            }
+
+            void _fetch(DBClientConnection* conn, Batch& b) {
+                BSONObjBuilder q;
+                {
+                    BSONObjBuilder id(q.subobjStart("_id"));
+                    BSONArrayBuilder in(id.subarrayStart("$in"));
+                    for (size_t i = 0; i < b.ids.size(); i++)
+                        in.append(b.ids[i]._id);
+                    in.done();
+                    id.done();
+                }
+
+                auto_ptr<DBClientCursor> c = conn->query(b.ns, q.obj(), 0, 0, NULL,
+                                                         QueryOption_SlaveOk);
+                uassert(16762, str::stream() << "rollback refetch query failed on " << b.ns,
+                        c.get());
+
+                // the documents not returned stay empty, as the source doesn't have them
+                b.good.resize(b.ids.size());
+                while (c->more()) {
+                    bo good = c->nextSafe();
+                    BSONElement id = good["_id"];
+                    vector<DocID>::const_iterator i = std::lower_bound(b.ids.begin(),
+                                                                       b.ids.end(),
+                                                                       id, DocIDLess());
+                    if (i == b.ids.end() || i->_id.woCompare(id, false) != 0)
+                        continue;
+                    b.good[i - b.ids.begin()] = good.getOwned();
+                    unsigned long long size = _totSize.addAndFetch(good.objsize());
+                    uassert(13410, "replSet too much data to roll back",
+                            size < 300 * 1024 * 1024);
+                }
+
+                rollbackProgress.refetched.fetchAndAdd(b.ids.size());
+                rollbackProgress.refetchBatches.fetchAndAdd(1);
+            }
+
+            bool _getFailed() {
+                scoped_lock lk(_mutex);
+                return _failed;
+            }
+
+            void _fail(const string& errmsg) {
+                scoped_lock lk(_mutex);
+                if (!_failed) {
+                    _failed = true;
+                    _errmsg = errmsg;
+                }
+            }
+
+            vector<Batch> _batches;
+            AtomicUInt32 _next; // the next batch to fetch
+            AtomicUInt64 _totSize;
+
+            mongo::mutex _mutex;
+            bool _failed;
+            string _errmsg;
+        };
+
+        /**
+         * Locks ns for its fixups.  A capped collection can only lose documents by being
+         * truncated, which may empty it and drop its indexes, and that needs the whole database.
+         */
+        Lock::DBWrite* lockForFixUp(const char* ns) {
+            auto_ptr<Lock::DBWrite> lk(lockForCollectionWrite(ns));
+            if (lk->collectionLocked()) {
+                Database* db = dbHolder().get(ns, dbpath);
+                NamespaceDetails* d = db ? db->namespaceIndex.details(ns) : 0;
+                if (!d || d->isCapped()) {
+                    lk.reset();
+                    lk.reset(new Lock::DBWrite(ns));
+                }
+            }
+            return lk.release();
+        }
+
+        void _fixUpCollection(CollectionFixUp* f) {
+            const char* ns = f->ns.c_str();
+            scoped_ptr<Lock::DBWrite> lk(lockForFixUp(ns));
+            Client::Context c(ns);
+
+            /* keep an archive of items rolled back */
+            RemoveSaver rs("rollback", "", f->ns);
+
+            for (vector< pair<bo,bo> >::const_iterator i = f->docs.begin();
+                 i != f->docs.end(); ++i) {
+                const bo& pattern = i->first;
+                try {
+                    getDur().commitIfNeeded();
+
+                    if( i->second.isEmpty() ) {
+                        // wasn't on the primary; delete.
+                        /* TODO1.6 : can't delete from a capped collection.  need to handle that here. */
+                        f->deletes++;
+
+                        NamespaceDetails *nsd = nsdetails(ns);
+                        if( nsd ) {
+                            if( nsd->isCapped() ) {
+                                /* can't delete from a capped collection - so we truncate instead. if this item must go,
+                                so must all successors!!! */
+                                try {
+                                    /** todo: IIRC cappedTruncateAfter does not handle completely empty.  todo. */
+                                    // this will crazy slow if no _id index.
+                                    long long start = Listener::getElapsedTimeMillis();
+                                    DiskLoc loc = Helpers::findOne(ns, pattern, false);
+                                    if( Listener::getElapsedTimeMillis() - start > 200 )
+                                        log() << "replSet warning roll back slow no _id index for " << ns << " perhaps?" << rsLog;
+                                    //would be faster but requires index: DiskLoc loc = Helpers::findById(nsd, pattern);
+                                    if( !loc.isNull() ) {
+                                        try {
+                                            nsd->cappedTruncateAfter(ns, loc, true);
+                                        }
+                                        catch(DBException& e) {
+                                            if( e.getCode() == 13415 ) {
+                                                // hack: need to just make cappedTruncate do this...
+                                                nsd->emptyCappedCollection(ns);
+                                            }
+                                            else {
+                                                throw;
+                                            }
+                                        }
+                                    }
+                                }
+                                catch(DBException& e) {
+                                    log() << "replSet error rolling back capped collection rec " << ns << ' ' << e.toString() << rsLog;
+                                }
+                            }
+                            else {
+                                try {
+                                    f->deletes++;
+                                    deleteObjects(ns, pattern, /*justone*/true, /*logop*/false, /*god*/true, &rs );
+                                }
+                                catch(...) {
+                                    log() << "replSet error rollback delete failed ns:" << ns << rsLog;
+                                }
+                            }
+                        }
+                    }
+                    else {
+                        // todo faster...
+                        OpDebug debug;
+                        f->updates++;
+                        _updateObjects(/*god*/true, ns, i->second, pattern, /*upsert=*/true, /*multi=*/false , /*logtheop=*/false , debug, &rs );
+                    }
+                }
+                catch(DBException& e) {
+                    log() << "replSet exception in rollback ns:" << ns << ' ' << pattern.toString() << ' ' << e.toString() << " ndeletes:" << f->deletes << rsLog;
+                    f->warn = true;
+                }
+                rollbackProgress.fixed.fetchAndAdd(1);
+            }
+
+            // did we empty the collection?  if so the caller checks if it even exists on the source.
+            NamespaceDetails *nsd = nsdetails(ns);
+            f->emptied = f->deletes && nsd && nsd->stats.nrecords == 0;
+        }
+
+        /**
+         * Puts the documents of a collection back as the sync source has them.  Run by the writer
+         * pool, one collection per task, while the batch writer lock keeps everyone else out.
+         */
+        void fixUpCollection(CollectionFixUp* f) {
+            replset::initializeWriterThread();
+            try {
+                _fixUpCollection(f);
+            }
+            catch(DBException& e) {
+                log() << "replSet exception in rollback ns:" << f->ns << ' ' << e.toString() << rsLog;
+                f->warn = true;
+            }
+        }
+
+    } // namespace
+
+    void appendRollbackProgress(BSONObjBuilder* b) {
+        rollbackProgress.append(b);
+    }
+
     static void syncRollbackFindCommonPoint(DBClientConnection *them, HowToFixUp& h) {
         static time_t last;
         if( time(0)-last < 60 ) {
@@ -310,42 +691,31 @@ namespace mongo {
 
         // fetch all first so we needn't handle interruption in a fancy way
 
-        unsigned long long totSize = 0;
-
-        list< pair<DocID,bo> > goodVersions;
+        /* the goodVersions of each document from current primary, by collection */
+        FixUps fixUps;
 
         bo newMinValid;
 
-        /* fetch all the goodVersions of each document from current primary */
-        DocID d;
-        unsigned long long n = 0;
+        rollbackProgress.start(h.toRefetch.size());
         try {
-            for( set<DocID>::iterator i = h.toRefetch.begin(); i != h.toRefetch.end(); i++ ) {
-                d = *i;
-
-                verify( !d._id.eoo() );
-
-                {
-                    /* TODO : slow.  lots of round trips. */
-                    n++;
-                    bo good= them->findOne(d.ns, d._id.wrap(), NULL, QueryOption_SlaveOk).getOwned();
-                    totSize += good.objsize();
-                    uassert( 13410, "replSet too much data to roll back", totSize < 300 * 1024 * 1024 );
-
-                    // note good might be eoo, indicating we should delete it
-                    goodVersions.push_back(pair<DocID,bo>(d,good));
-                }
+            string errmsg;
+            RollbackRefetcher refetcher;
+            if( !refetcher.run(them->getServerAddress(), h.toRefetch, fixUps, errmsg) ) {
+                log() << "rollback couldn't re-get objects " << rollbackProgress.refetched.load()
+                      << '/' << h.toRefetch.size() << rsLog;
+                uasserted(16763, str::stream() << "rollback couldn't re-get objects: " << errmsg);
             }
             newMinValid = r.getLastOp(rsoplog);
             if( newMinValid.isEmpty() ) {
+                rollbackProgress.finish("failed");
                 sethbmsg("rollback error newMinValid empty?");
                 return;
             }
         }
         catch(DBException& e) {
+            rollbackProgress.finish("failed");
             sethbmsg(str::stream() << "rollback re-get objects: " << e.toString(),0);
-            log() << "rollback couldn't re-get ns:" << d.ns << " _id:" << d._id << ' ' << n << '/' << h.toRefetch.size() << rsLog;
-            throw e;
+            throw;
         }
 
         MemoryMappedFile::flushAll(true);
@@ -354,11 +724,13 @@ namespace mongo {
         if( h.rbid != getRBID(r.conn()) ) {
             // our source rolled back itself.  so the data we received isn't necessarily consistent.
             sethbmsg("rollback rbid on source changed during rollback, cancelling this attempt");
+            rollbackProgress.finish("failed");
             return;
         }
 
         // update them
-        sethbmsg(str::stream() << "rollback 4 n:" << goodVersions.size());
+        sethbmsg(str::stream() << "rollback 4 n:" << h.toRefetch.size());
+        rollbackProgress.setPhase("resync");
 
         bool warn = false;
 
@@ -444,116 +816,69 @@ namespace mongo {
         NamespaceDetails *oplogDetails = nsdetails(rsoplog);
         uassert(13423, str::stream() << "replSet error in rollback can't find " << rsoplog, oplogDetails);
 
-        map<string,shared_ptr<RemoveSaver> > removeSavers;
+        size_t toFix = 0;
+        for( FixUps::iterator i = fixUps.begin(); i != fixUps.end(); ) {
+            if( h.collectionsToResync.count(i->first) ) {
+                /* we just synced this entire collection */
+                fixUps.erase(i++);
+                continue;
+            }
+            toFix += i->second->docs.size();
+            ++i;
+        }
+        rollbackProgress.setToFix(toFix);
+
+        /* the collections are fixed up in parallel by the writer pool.  the global lock is let go
+           meanwhile, the batch writer lock keeps everyone but the writers out instead. */
+        {
+            dbtemprelease release;
+            SimpleMutex::scoped_lock fsynclk(filesLockedFsync);
+            Lock::ParallelBatchWriterMode pbwm;
+
+            threadpool::ThreadPool& writerPool = getWriterPool();
+            for( FixUps::iterator i = fixUps.begin(); i != fixUps.end(); ++i ) {
+                writerPool.schedule(fixUpCollection, i->second.get());
+            }
+            writerPool.join();
+        }
 
         unsigned deletes = 0, updates = 0;
-        for( list<pair<DocID,bo> >::iterator i = goodVersions.begin(); i != goodVersions.end(); i++ ) {
-            const DocID& d = i->first;
-            bo pattern = d._id.wrap(); // { _id : ... }
+        for( FixUps::iterator i = fixUps.begin(); i != fixUps.end(); ++i ) {
+            const CollectionFixUp& f = *i->second;
+            deletes += f.deletes;
+            updates += f.updates;
+            if( f.warn )
+                warn = true;
+            if( !f.emptied )
+                continue;
+
+            // we emptied the collection, let's check if it even exists on the source.
+            Client::Context ctx(f.ns);
             try {
-                verify( d.ns && *d.ns );
-                if( h.collectionsToResync.count(d.ns) ) {
-                    /* we just synced this entire collection */
-                    continue;
-                }
-
-                getDur().commitIfNeeded();
-
-                /* keep an archive of items rolled back */
-                shared_ptr<RemoveSaver>& rs = removeSavers[d.ns];
-                if ( ! rs )
-                    rs.reset( new RemoveSaver( "rollback" , "" , d.ns ) );
-
-                // todo: lots of overhead in context, this can be faster
-                Client::Context c(d.ns);
-                if( i->second.isEmpty() ) {
-                    // wasn't on the primary; delete.
-                    /* TODO1.6 : can't delete from a capped collection.  need to handle that here. */
-                    deletes++;
-
-                    NamespaceDetails *nsd = nsdetails(d.ns);
-                    if( nsd ) {
-                        if( nsd->isCapped() ) {
-                            /* can't delete from a capped collection - so we truncate instead. if this item must go,
-                            so must all successors!!! */
-                            try {
-                                /** todo: IIRC cappedTruncateAfter does not handle completely empty.  todo. */
-                                // this will crazy slow if no _id index.
-                                long long start = Listener::getElapsedTimeMillis();
-                                DiskLoc loc = Helpers::findOne(d.ns, pattern, false);
-                                if( Listener::getElapsedTimeMillis() - start > 200 )
-                                    log() << "replSet warning roll back slow no _id index for " << d.ns << " perhaps?" << rsLog;
-                                //would be faster but requires index: DiskLoc loc = Helpers::findById(nsd, pattern);
-                                if( !loc.isNull() ) {
-                                    try {
-                                        nsd->cappedTruncateAfter(d.ns, loc, true);
-                                    }
-                                    catch(DBException& e) {
-                                        if( e.getCode() == 13415 ) {
-                                            // hack: need to just make cappedTruncate do this...
-                                            nsd->emptyCappedCollection(d.ns);
-                                        }
-                                        else {
-                                            throw;
-                                        }
-                                    }
-                                }
-                            }
-                            catch(DBException& e) {
-                                log() << "replSet error rolling back capped collection rec " << d.ns << ' ' << e.toString() << rsLog;
-                            }
-                        }
-                        else {
-                            try {
-                                deletes++;
-                                deleteObjects(d.ns, pattern, /*justone*/true, /*logop*/false, /*god*/true, rs.get() );
-                            }
-                            catch(...) {
-                                log() << "replSet error rollback delete failed ns:" << d.ns << rsLog;
-                            }
-                        }
-                        // did we just empty the collection?  if so let's check if it even exists on the source.
-                        if( nsd->stats.nrecords == 0 ) {
-                            try {
-                                string sys = cc().database()->name + ".system.namespaces";
-                                bo o = them->findOne(sys, QUERY("name"<<d.ns));
-                                if( o.isEmpty() ) {
-                                    // we should drop
-                                    try {
-                                        bob res;
-                                        string errmsg;
-                                        dropCollection(d.ns, errmsg, res);
-                                    }
-                                    catch(...) {
-                                        log() << "replset error rolling back collection " << d.ns << rsLog;
-                                    }
-                                }
-                            }
-                            catch(DBException& ) {
-                                /* this isn't *that* big a deal, but is bad. */
-                                log() << "replSet warning rollback error querying for existence of " << d.ns << " at the primary, ignoring" << rsLog;
-                            }
-                        }
+                string sys = cc().database()->name + ".system.namespaces";
+                bo o = them->findOne(sys, QUERY("name"<<f.ns));
+                if( o.isEmpty() ) {
+                    // we should drop
+                    try {
+                        bob res;
+                        string errmsg;
+                        dropCollection(f.ns, errmsg, res);
+                    }
+                    catch(...) {
+                        log() << "replset error rolling back collection " << f.ns << rsLog;
                     }
-                }
-                else {
-                    // todo faster...
-                    OpDebug debug;
-                    updates++;
-                    _updateObjects(/*god*/true, d.ns, i->second, pattern, /*upsert=*/true, /*multi=*/false , /*logtheop=*/false , debug, rs.get() );
                 }
             }
-            catch(DBException& e) {
-                log() << "replSet exception in rollback ns:" << d.ns << ' ' << pattern.toString() << ' ' << e.toString() << " ndeletes:" << deletes << rsLog;
-                warn = true;
+            catch(DBException& ) {
+                /* this isn't *that* big a deal, but is bad. */
+                log() << "replSet warning rollback error querying for existence of " << f.ns << " at the primary, ignoring" << rsLog;
             }
         }
 
-        removeSavers.clear(); // this effectively closes all of them
-
         sethbmsg(str::stream() << "rollback 5 d:" << deletes << " u:" << updates);
         MemoryMappedFile::flushAll(true);
         sethbmsg("rollback 6");
+        rollbackProgress.setPhase("truncate");
 
         // clean up oplog
         LOG(2) << "replSet rollback truncate oplog after " << h.commonPoint.toStringPretty() << rsLog;
@@ -567,6 +892,7 @@ namespace mongo {
         MemoryMappedFile::flushAll(true);
 
         // done
+        rollbackProgress.finish("done");
         if( warn )
             sethbmsg("issues during syncRollback, see log");
         else
@@ -651,11 +977,13 @@ namespace mongo {
                 syncFixUp(how, r);
             }
             catch( rsfatal& ) {
+                rollbackProgress.finish("failed");
                 sethbmsg("rollback fixup error");
                 _fatal();
                 return 2;
             }
             catch(...) {
+                rollbackProgress.finish("failed");
                 incRBID(); throw;
             }
             incRBID();
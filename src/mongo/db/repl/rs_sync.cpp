@@ -25,12 +25,17 @@
 #include "mongo/db/client.h"
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/d_concurrency.h"
+#include "mongo/db/databaseholder.h"
+#include "mongo/db/hasher.h"
+#include "mongo/db/namespace_details.h"
 #include "mongo/db/namespacestring.h"
+#include "mongo/db/pdfile.h"
 #include "mongo/db/prefetch.h"
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/repl/rs_sync.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/stats/timer_stats.h"
@@ -59,6 +64,156 @@ namespace replset {
     static ServerStatusMetricField<Counter64> displayOpsApplied( "repl.apply.ops",
                                                                 &opsAppliedStats );
 
+    /**
+     * Accumulates how much of each batch's apply time every writer spent applying its share
+     * of the batch.  A writer here is a slot in the batch partitioning rather than a
+     * particular pool thread.
+     */
+    class WriterUtilization {
+    public:
+        WriterUtilization() : _mutex("WriterUtilization"), _batchMicros(0) {}
+
+        void batchApplied( long long micros ) {
+            scoped_lock lk( _mutex );
+            _batchMicros += micros;
+        }
+
+        void writerDone( size_t writer, size_t ops, long long micros ) {
+            scoped_lock lk( _mutex );
+            if ( writer >= _writers.size() )
+                _writers.resize( writer + 1 );
+            _writers[writer].batches++;
+            _writers[writer].ops += ops;
+            _writers[writer].busyMicros += micros;
+        }
+
+        void append( BSONObjBuilder* b ) {
+            scoped_lock lk( _mutex );
+            BSONObjBuilder sub( b->subobjStart( "writers" ) );
+            sub.appendNumber( "applyMicros", _batchMicros );
+            BSONArrayBuilder arr( sub.subarrayStart( "utilization" ) );
+            for ( size_t i = 0; i < _writers.size(); ++i ) {
+                const Writer& w = _writers[i];
+                BSONObjBuilder wb( arr.subobjStart() );
+                wb.appendNumber( "batches", w.batches );
+                wb.appendNumber( "ops", w.ops );
+                wb.appendNumber( "busyMicros", w.busyMicros );
+                wb.append( "ratio", _batchMicros ? double( w.busyMicros ) / _batchMicros : 0.0 );
+                wb.done();
+            }
+            arr.done();
+            sub.done();
+        }
+
+    private:
+        struct Writer {
+            Writer() : batches(0), ops(0), busyMicros(0) {}
+            long long batches;
+            long long ops;
+            long long busyMicros;
+        };
+
+        mongo::mutex _mutex;
+        long long _batchMicros;
+        std::vector<Writer> _writers;
+    };
+
+    static WriterUtilization writerUtilization;
+
+    void appendWriterUtilization( BSONObjBuilder* b ) {
+        writerUtilization.append( b );
+    }
+
+    // Prefetch each op as soon as it is fetched from the sync source, while the batches before
+    // it are applied, instead of holding up its own batch to prefetch it
+    MONGO_EXPORT_SERVER_PARAMETER(replPrefetchLookahead, bool, false);
+
+    // The ops prefetched ahead of their batch
+    static Counter64 lookaheadOpsStats;
+    static ServerStatusMetricField<Counter64> displayLookaheadOps( "repl.preload.lookahead.ops",
+                                                                   &lookaheadOpsStats );
+    // The ops of applied batches which had already been prefetched ahead, and those which the
+    // batch still had to prefetch
+    static Counter64 lookaheadHitStats;
+    static ServerStatusMetricField<Counter64> displayLookaheadHits( "repl.preload.lookahead.hits",
+                                                                    &lookaheadHitStats );
+    static Counter64 lookaheadMissStats;
+    static ServerStatusMetricField<Counter64> displayLookaheadMisses(
+                                                    "repl.preload.lookahead.misses",
+                                                    &lookaheadMissStats );
+    // Per batch, the time its hits took to prefetch, which the batch no longer waits for
+    static TimerStats lookaheadSavedStats;
+    static ServerStatusMetricField<TimerStats> displayLookaheadSaved(
+                                                    "repl.preload.lookahead.saved",
+                                                    &lookaheadSavedStats );
+
+    /**
+     * The ops being prefetched ahead of their batch, by optime, with the time each prefetch took
+     * once it's done.  An op stays here until the batch applying it claims it, or until a later
+     * batch is applied, so the number here is how far the lookahead is ahead of the applier.
+     */
+    class PrefetchedOps {
+    public:
+        PrefetchedOps() : _mutex("PrefetchedOps") {}
+
+        /**
+         * Notes that the op at ts is about to be prefetched ahead.
+         * @return false, noting nothing, if there are already 'limit' ops here
+         */
+        bool start( const OpTime& ts, size_t limit ) {
+            scoped_lock lk( _mutex );
+            if ( _ops.size() >= limit )
+                return false;
+            _ops[ts] = Pending;
+            return true;
+        }
+
+        /** Records the time the prefetch of the op at ts took, unless it was claimed already. */
+        void done( const OpTime& ts, long long micros ) {
+            scoped_lock lk( _mutex );
+            std::map<OpTime, long long>::iterator i = _ops.find( ts );
+            if ( i != _ops.end() )
+                i->second = micros;
+        }
+
+        /**
+         * @return true if the op at ts was prefetched, adding the time its prefetch took to
+         * *micros.  An op whose prefetch hasn't finished is forgotten, and its batch prefetches
+         * it again.
+         */
+        bool claim( const OpTime& ts, long long* micros ) {
+            scoped_lock lk( _mutex );
+            std::map<OpTime, long long>::iterator i = _ops.find( ts );
+            if ( i == _ops.end() )
+                return false;
+            bool prefetched = i->second != Pending;
+            if ( prefetched )
+                *micros += i->second;
+            _ops.erase( i );
+            return prefetched;
+        }
+
+        /** Forgets the ops before ts, which were applied before their prefetch finished. */
+        void clearBefore( const OpTime& ts ) {
+            scoped_lock lk( _mutex );
+            _ops.erase( _ops.begin(), _ops.lower_bound( ts ) );
+        }
+
+        /** Forgets every op, once per batch while lookahead is off. */
+        void clear() {
+            scoped_lock lk( _mutex );
+            _ops.clear();
+        }
+
+    private:
+        static const long long Pending = -1;
+
+        mongo::mutex _mutex;
+        std::map<OpTime, long long> _ops;
+    };
+
+    static PrefetchedOps prefetchedOps;
+
 
     SyncTail::SyncTail(BackgroundSyncInterface *q) :
         Sync(""), oplogVersion(0), _networkQueue(q)
@@ -117,6 +272,15 @@ namespace replset {
         }
     }
 
+    void initializeLookaheadThread() {
+        if (!ClientBasic::getCurrent()) {
+            Client::initThread("repl lookahead prefetch worker");
+            // the batches before the ops prefetched are applied meanwhile
+            Lock::ParallelBatchWriterMode::iAmABatchParticipant();
+            replLocalAuth();
+        }
+    }
+
     static AtomicUInt32 replWriterWorkerId;
     void initializeWriterThread() {
         // Only do this once per thread
@@ -202,30 +366,90 @@ namespace replset {
         }
     }
 
-    // Doles out all the work to the reader pool threads and waits for them to complete
+    // The lookahead pool threads call this to prefetch an op before its batch is applied
+    void SyncTail::prefetchOpAhead(const BSONObj& op) {
+        initializeLookaheadThread();
+        Timer t;
+        prefetchOp(op);
+        prefetchedOps.done(op["ts"]._opTime(), t.micros());
+    }
+
+    void SyncTail::prefetchAhead(const BSONObj& op) {
+        // with lookahead off, prefetchOps() forgets any ops left from before, once per batch
+        if (!replPrefetchLookahead) {
+            return;
+        }
+
+        // don't get more than a batch ahead of the applier, counting the ops prefetched or
+        // being prefetched that no applied batch has claimed; the rest is prefetched with its
+        // batch, so its pages aren't touched long before they're used
+        if (!prefetchedOps.start(op["ts"]._opTime(), replBatchLimitOperations)) {
+            return;
+        }
+        theReplSet->getLookaheadPool().schedule(&prefetchOpAhead, op);
+        lookaheadOpsStats.increment();
+    }
+
+    // Doles out all the work to the reader pool threads and waits for them to complete.  The
+    // ops already prefetched ahead of the batch are skipped.
     void SyncTail::prefetchOps(const std::deque<BSONObj>& ops) {
+        if (ops.empty()) {
+            return;
+        }
+
+        const bool lookahead = replPrefetchLookahead;
+        if (lookahead) {
+            prefetchedOps.clearBefore(ops.front()["ts"]._opTime());
+        }
+        else {
+            prefetchedOps.clear();
+        }
+
         threadpool::ThreadPool& prefetcherPool = theReplSet->getPrefetchPool();
+        long long savedMicros = 0;
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
+            if (lookahead) {
+                if (prefetchedOps.claim((*it)["ts"]._opTime(), &savedMicros)) {
+                    lookaheadHitStats.increment();
+                    continue;
+                }
+                lookaheadMissStats.increment();
+            }
             prefetcherPool.schedule(&prefetchOp, *it);
         }
         prefetcherPool.join();
+
+        if (lookahead) {
+            lookaheadSavedStats.recordMillis(savedMicros / 1000);
+        }
     }
     
+    // Runs on a writer pool thread: applies one writer's share of the batch and accounts for it
+    void SyncTail::applyWriterVector(MultiSyncApplyFunc applyFunc,
+                                     const std::vector<BSONObj>* ops,
+                                     SyncTail* st,
+                                     size_t writer) {
+        Timer t;
+        applyFunc(*ops, st);
+        writerUtilization.writerDone(writer, ops->size(), t.micros());
+    }
+
     // Doles out all the work to the writer pool threads and waits for them to complete
     void SyncTail::applyOps(const std::vector< std::vector<BSONObj> >& writerVectors, 
                                      MultiSyncApplyFunc applyFunc) {
         ThreadPool& writerPool = theReplSet->getWriterPool();
         TimerHolder timer(&applyBatchStats);
-        for (std::vector< std::vector<BSONObj> >::const_iterator it = writerVectors.begin();
-             it != writerVectors.end();
-             ++it) {
-            if (!it->empty()) {
-                writerPool.schedule(applyFunc, boost::cref(*it), this);
+        Timer batchTimer;
+        for (size_t i = 0; i < writerVectors.size(); ++i) {
+            if (!writerVectors[i].empty()) {
+                writerPool.schedule(&SyncTail::applyWriterVector, applyFunc, &writerVectors[i],
+                                    this, i);
             }
         }
         writerPool.join();
+        writerUtilization.batchApplied(batchTimer.micros());
     }
 
     // Doles out all the work to the writer pool threads and waits for them to complete
@@ -249,8 +473,90 @@ namespace replset {
     }
 
 
+    /**
+     * @return true if the documents of ns may be written in a different order than the oplog
+     * has them, as long as the ops on any one document stay in order.  That is not the case
+     * for capped collections, whose documents are kept in insertion order, or for collections
+     * with a unique secondary index, where ops on two documents can conflict on a key.
+     */
+    static bool canPartitionByDocument(const char* ns) {
+        NamespaceString nss(ns);
+        if (nss.isSystem() || nss.db == "local") {
+            return false;
+        }
+
+        // look the collection up without opening its database: that, or creating it, is left
+        // to the op that needs it
+        Lock::DBRead lk(ns);
+        Database* db = dbHolder().get(ns, dbpath);
+        NamespaceDetails* d = db ? db->namespaceIndex.details(ns) : 0;
+        if (!d) {
+            // the collection is created by this batch; we can't tell what it will look like
+            return false;
+        }
+        if (d->isCapped()) {
+            return false;
+        }
+        NamespaceDetails::IndexIterator ii = d->ii(true);
+        while (ii.more()) {
+            IndexDetails& idx = ii.next();
+            if (idx.unique() && !idx.isIdIndex()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @return the _id of the document op modifies, or EOO if the op doesn't name one, e.g. an
+     * update or remove by another field applied from an old oplog.
+     */
+    static BSONElement documentId(const BSONObj& op) {
+        const char* opType = op.getStringField("op");
+        if (*opType == 'i' || *opType == 'd') {
+            return op.getObjectField("o")["_id"];
+        }
+        if (*opType == 'u') {
+            return op.getObjectField("o2")["_id"];
+        }
+        return BSONElement();
+    }
+
+    /** Mixes the _id of a document, id, into hash. */
+    static void hashDocumentId(const BSONElement& id, uint32_t* hash) {
+        // _id values that compare equal must hash equally.  BSONElementHasher hashes canonical
+        // types and squashes numbers to one form, so NumberInt(1) and 1.0, or 0 and -0.0, (and
+        // the same within embedded objects and arrays) reach the same writer.
+        long long idHash = BSONElementHasher::hash64(id, BSONElementHasher::DEFAULT_HASH_SEED);
+        MurmurHash3_x86_32(&idHash, sizeof(idHash), *hash, hash);
+    }
+
     void SyncTail::fillWriterVectors(const std::deque<BSONObj>& ops, 
                                               std::vector< std::vector<BSONObj> >* writerVectors) {
+        // Ops on the same namespace go to the same writer unless the namespace allows its
+        // documents to be written concurrently, in which case the ops are spread by _id so
+        // a single busy collection can use every writer.  An op without an _id could touch any
+        // document, so a namespace with one in the batch keeps all its ops on one writer for
+        // the batch.  Commands and index builds are always in batches of their own (see
+        // tryPopAndWaitForMore()).
+        std::map<std::string, bool> partitionable;
+        for (std::deque<BSONObj>::const_iterator it = ops.begin();
+             it != ops.end();
+             ++it) {
+            const char* ns = it->getStringField("ns");
+            if (*ns == '\0' || *it->getStringField("op") == 'c') {
+                continue;
+            }
+            std::map<std::string, bool>::iterator p = partitionable.find(ns);
+            if (p == partitionable.end()) {
+                p = partitionable.insert(make_pair(string(ns),
+                                                   canPartitionByDocument(ns))).first;
+            }
+            if (p->second && documentId(*it).eoo()) {
+                p->second = false;
+            }
+        }
+
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
@@ -261,6 +567,12 @@ namespace replset {
             uint32_t hash = 0;
             MurmurHash3_x86_32( ns, len, 0, &hash);
 
+            std::map<std::string, bool>::const_iterator p = partitionable.find(ns);
+            if (p != partitionable.end() && p->second &&
+                    *it->getStringField("op") != 'c') {
+                hashDocumentId(documentId(*it), &hash);
+            }
+
             (*writerVectors)[hash % writerVectors->size()].push_back(*it);
         }
     }
@@ -87,6 +87,14 @@ namespace replset {
         // returns true if we should continue waiting for BSONObjs, false if we should
         // stop waiting and apply the queue we have.  Only returns false if !ops.empty().
         bool tryPopAndWaitForMore(OpQueue* ops);
+
+        /**
+         * With replPrefetchLookahead set, prefetches the pages op needs in the background, ahead
+         * of the batch that applies it, as long as fewer than replBatchLimitOperations ops are
+         * prefetched ahead of the batch being applied.  Called as ops are fetched from the sync
+         * source.
+         */
+        static void prefetchAhead(const BSONObj& op);
         
         // After ops have been written to db, call this
         // to update local oplog.rs, as well as notify the primary
@@ -115,10 +123,17 @@ namespace replset {
         void prefetchOps(const std::deque<BSONObj>& ops);
         // Used by the thread pool readers to prefetch an op
         static void prefetchOp(const BSONObj& op);
+        // Used by the lookahead pool threads to prefetch an op before its batch
+        static void prefetchOpAhead(const BSONObj& op);
 
         // Doles out all the work to the writer pool threads and waits for them to complete
         void applyOps(const std::vector< std::vector<BSONObj> >& writerVectors, 
                       MultiSyncApplyFunc applyFunc);
+        // Used by the thread pool writers to apply one writer's ops
+        static void applyWriterVector(MultiSyncApplyFunc applyFunc,
+                                      const std::vector<BSONObj>* ops,
+                                      SyncTail* st,
+                                      size_t writer);
 
         void fillWriterVectors(const std::deque<BSONObj>& ops, 
                                std::vector< std::vector<BSONObj> >* writerVectors);
@@ -148,5 +163,11 @@ namespace replset {
     void multiSyncApply(const std::vector<BSONObj>& ops, SyncTail* st);
     void multiInitialSyncApply(const std::vector<BSONObj>& ops, SyncTail* st);
 
+    // Sets up a writer pool thread to write while the batch writer lock is held
+    void initializeWriterThread();
+
+    // Reports how busy each writer has been applying batches, for serverStatus
+    void appendWriterUtilization(BSONObjBuilder* b);
+
 } // namespace replset
 } // namespace mongo
@@ -28,6 +28,23 @@ namespace mongo {
 
     const unsigned ScanAndOrder::MaxScanAndOrderBytes = 32 * 1024 * 1024;
 
+    ScanAndOrder::ScanAndOrder(int startFrom, int limit, const BSONObj &order,
+                               const FieldRangeSet &frs, const Projection *projection) :
+        _heapified(false),
+        _nextSeq(0),
+        _startFrom(startFrom),
+        _order(order, frs),
+        _less(order),
+        // A positional projection needs the matcher to run against the whole document, so
+        // it is applied when the results are filled.
+        _projection(projection &&
+                    projection->getArrayOpType() != Projection::ARRAY_OP_POSITIONAL ?
+                    projection : 0),
+        _approxSize(0),
+        _peakApproxSize(0) {
+        _limit = limit > 0 ? limit + _startFrom : 0x7fffffff;
+    }
+
     void ScanAndOrder::add(const BSONObj& o, const DiskLoc* loc) {
         verify( o.isValid() );
         BSONObj k;
@@ -47,21 +64,44 @@ namespace mongo {
             return;   
         }
         if ( (int) _best.size() < _limit ) {
-            _add(k, o, loc);
+            BSONObj doc = _docToBuffer(o, loc);
+            _validateAndUpdateApproxSize( k.objsize() + doc.objsize() );
+            Entry entry;
+            entry.key = k.getOwned();
+            entry.doc = doc.getOwned();
+            entry.seq = _nextSeq++;
+            _best.push_back(entry);
             return;
         }
-        BestMap::iterator i;
-        verify( _best.end() != _best.begin() );
-        i = _best.end();
-        i--;
-        _addIfBetter(k, o, i, loc);
+
+        verify( !_best.empty() );
+        if ( !_heapified ) {
+            std::make_heap(_best.begin(), _best.end(), _less);
+            _heapified = true;
+        }
+        // Only a key strictly better than the worst one kept displaces it, so equal keys keep
+        // their insertion order.
+        if ( _best.front().key.woCompare(k, _order._spec.keyPattern) <= 0 ) {
+            return;
+        }
+        BSONObj doc = _docToBuffer(o, loc);
+        const Entry& worst = _best.front();
+        _validateAndUpdateApproxSize( k.objsize() + doc.objsize() -
+                                      worst.key.objsize() - worst.doc.objsize() );
+        std::pop_heap(_best.begin(), _best.end(), _less);
+        Entry& entry = _best.back();
+        entry.key = k.getOwned();
+        entry.doc = doc.getOwned();
+        entry.seq = _nextSeq++;
+        std::push_heap(_best.begin(), _best.end(), _less);
     }
 
 
     void ScanAndOrder::fill( BufBuilder& b, const ParsedQuery *parsedQuery, int& nout ) const {
         int n = 0;
         int nFilled = 0;
-        Projection *projection = parsedQuery ? parsedQuery->getFields() : NULL;
+        // Documents were projected as they were added if _projection is set.
+        Projection *projection = parsedQuery && !_projection ? parsedQuery->getFields() : NULL;
         scoped_ptr<Matcher> arrayMatcher;
         scoped_ptr<MatchDetails> details;
         if ( projection && projection->getArrayOpType() == Projection::ARRAY_OP_POSITIONAL ) {
@@ -71,11 +111,17 @@ namespace mongo {
             details.reset( new MatchDetails );
             details->requestElemMatchKey();
         }
-        for ( BestMap::const_iterator i = _best.begin(); i != _best.end(); i++ ) {
+        vector<const Entry*> sorted;
+        sorted.reserve( _best.size() );
+        for ( vector<Entry>::const_iterator i = _best.begin(); i != _best.end(); ++i ) {
+            sorted.push_back( &*i );
+        }
+        std::sort( sorted.begin(), sorted.end(), _less );
+        for ( vector<const Entry*>::const_iterator i = sorted.begin(); i != sorted.end(); ++i ) {
             n++;
             if ( n <= _startFrom )
                 continue;
-            const BSONObj& o = i->second;
+            const BSONObj& o = (*i)->doc;
             massert( 16355, "positional operator specified, but no array match",
                      ! arrayMatcher || arrayMatcher->matches( o, details.get() ) );
             fillQueryResultFromObj( b, projection, o, details.get() );
@@ -86,28 +132,29 @@ namespace mongo {
         nout = nFilled;
     }
 
-    void ScanAndOrder::_add(const BSONObj& k, const BSONObj& o, const DiskLoc* loc) {
-        BSONObj docToReturn = o;
-        if ( loc ) {
-            BSONObjBuilder b;
+    BSONObj ScanAndOrder::_docToBuffer(const BSONObj& o, const DiskLoc* loc) const {
+        if ( !_projection && !loc ) {
+            return o;
+        }
+        BSONObjBuilder b;
+        if ( _projection ) {
+            _projection->transform(o, b);
+        }
+        else {
             b.appendElements(o);
+        }
+        if ( loc ) {
             b.append("$diskLoc", loc->toBSONObj());
-            docToReturn = b.obj();
         }
-        _validateAndUpdateApproxSize( k.objsize() + docToReturn.objsize() );
-        _best.insert(make_pair(k.getOwned(),docToReturn.getOwned()));
+        return b.obj();
     }
-    
-    void ScanAndOrder::_addIfBetter(const BSONObj& k, const BSONObj& o, const BestMap::iterator& i,
-                                    const DiskLoc* loc) {
-        const BSONObj& worstBestKey = i->first;
-        int cmp = worstBestKey.woCompare(k, _order._spec.keyPattern);
-        if ( cmp > 0 ) {
-            // k is better, 'upgrade'
-            _validateAndUpdateApproxSize( -i->first.objsize() + -i->second.objsize() );
-            _best.erase(i);
-            _add(k, o, loc);
+
+    bool ScanAndOrder::EntryLess::operator()(const Entry &lhs, const Entry &rhs) const {
+        int cmp = lhs.key.woCompare(rhs.key, _keyPattern);
+        if ( cmp != 0 ) {
+            return cmp < 0;
         }
+        return lhs.seq < rhs.seq;
     }
 
     void ScanAndOrder::_validateAndUpdateApproxSize( const int approxSizeDelta ) {
@@ -118,6 +165,7 @@ namespace mongo {
                 "too much data for sort() with no index.  add an index or specify a smaller limit",
                 (unsigned)newApproxSize < MaxScanAndOrderBytes );
         _approxSize = newApproxSize;
+        _peakApproxSize = std::max( _peakApproxSize, _approxSize );
     }
 
 } // namespace mongo
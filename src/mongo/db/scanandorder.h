@@ -76,17 +76,23 @@ namespace mongo {
         }
     }
 
-    typedef multimap<BSONObj,BSONObj,BSONObjCmp> BestMap;
+    /**
+     * Buffers the documents of a query that must be sorted in memory, keeping only the
+     * startFrom + limit best of them when a limit is set.  Once that many documents are buffered
+     * they are kept in a heap with the worst one at the front, so each further document costs a
+     * comparison with it and, if better, a log(limit) replacement.
+     */
     class ScanAndOrder {
     public:
         static const unsigned MaxScanAndOrderBytes;
 
-        ScanAndOrder(int startFrom, int limit, const BSONObj &order, const FieldRangeSet &frs) :
-            _best( BSONObjCmp( order ) ),
-            _startFrom(startFrom), _order(order, frs) {
-            _limit = limit > 0 ? limit + _startFrom : 0x7fffffff;
-            _approxSize = 0;
-        }
+        /**
+         * @param projection if supplied, and not a positional projection, is applied to each
+         * document as it is added, so that only the requested fields are buffered.  Must outlive
+         * the ScanAndOrder.
+         */
+        ScanAndOrder(int startFrom, int limit, const BSONObj &order, const FieldRangeSet &frs,
+                     const Projection *projection = 0);
 
         int size() const { return _best.size(); }
 
@@ -99,6 +105,9 @@ namespace mongo {
         /* scanning complete. stick the query result in b for n objects. */
         void fill(BufBuilder& b, const ParsedQuery *query, int& nout) const;
 
+        /** @return the most bytes buffered at any one time. */
+        unsigned peakApproxSize() const { return _peakApproxSize; }
+
     /** Functions for testing. */
     protected:
 
@@ -106,10 +115,26 @@ namespace mongo {
 
     private:
 
-        void _add(const BSONObj& k, const BSONObj& o, const DiskLoc* loc);
-
-        void _addIfBetter(const BSONObj& k, const BSONObj& o, const BestMap::iterator& i,
-                          const DiskLoc* loc);
+        struct Entry {
+            BSONObj key;
+            BSONObj doc;
+            long long seq; // insertion order, which breaks ties between equal keys
+        };
+
+        /** Orders entries by key, with the best entry first. */
+        class EntryLess {
+        public:
+            EntryLess(const BSONObj &keyPattern) : _keyPattern(keyPattern) {}
+            bool operator()(const Entry &lhs, const Entry &rhs) const;
+            bool operator()(const Entry *lhs, const Entry *rhs) const {
+                return (*this)(*lhs, *rhs);
+            }
+        private:
+            BSONObj _keyPattern;
+        };
+
+        /** @return the document to buffer for o, projected and with $diskLoc if requested. */
+        BSONObj _docToBuffer(const BSONObj& o, const DiskLoc* loc) const;
 
         /**
          * @throw ScanAndOrderMemoryLimitExceededAssertionCode if approxSize would grow too high,
@@ -117,11 +142,16 @@ namespace mongo {
          */
         void _validateAndUpdateApproxSize( const int approxSizeDelta );
 
-        BestMap _best; // key -> full object
+        vector<Entry> _best; // a heap with the worst entry at the front once _limit is reached
+        bool _heapified;
+        long long _nextSeq;
         int _startFrom;
         int _limit;   // max to send back.
         KeyType _order;
+        EntryLess _less;
+        const Projection *_projection;
         unsigned _approxSize;
+        unsigned _peakApproxSize;
 
     };
 
@@ -38,6 +38,8 @@ namespace mongo {
         : total( older.total , newer.total ) ,
           readLock( older.readLock , newer.readLock ) ,
           writeLock( older.writeLock , newer.writeLock ) ,
+          readLockWait( older.readLockWait , newer.readLockWait ) ,
+          writeLockWait( older.writeLockWait , newer.writeLockWait ) ,
           queries( older.queries , newer.queries ) ,
           getmore( older.getmore , newer.getmore ) ,
           insert( older.insert , newer.insert ) ,
@@ -64,6 +66,19 @@ namespace mongo {
         _record( _global , op , lockType , micros , command );
     }
 
+    void Top::recordLockWait( const StringData& ns , int lockType , long long micros ) {
+        if ( ns[0] == '?' )
+            return;
+
+        SimpleMutex::scoped_lock lk(_lock);
+
+        CollectionData& coll = _usage[ns];
+        UsageData& collWait = lockType > 0 ? coll.writeLockWait : coll.readLockWait;
+        collWait.inc( micros );
+        UsageData& globalWait = lockType > 0 ? _global.writeLockWait : _global.readLockWait;
+        globalWait.inc( micros );
+    }
+
     void Top::_record( CollectionData& c , int op , int lockType , long long micros , bool command ) {
         c.total.inc( micros );
 
@@ -142,6 +157,8 @@ namespace mongo {
 
             _appendStatsEntry( b , "readLock" , coll.readLock );
             _appendStatsEntry( b , "writeLock" , coll.writeLock );
+            _appendStatsEntry( b , "readLockWait" , coll.readLockWait );
+            _appendStatsEntry( b , "writeLockWait" , coll.writeLockWait );
 
             _appendStatsEntry( b , "queries" , coll.queries );
             _appendStatsEntry( b , "getmore" , coll.getmore );
@@ -55,6 +55,10 @@ namespace mongo {
             UsageData readLock;
             UsageData writeLock;
 
+            // time spent waiting to acquire the locks
+            UsageData readLockWait;
+            UsageData writeLockWait;
+
             UsageData queries;
             UsageData getmore;
             UsageData insert;
@@ -67,6 +71,7 @@ namespace mongo {
 
     public:
         void record( const StringData& ns , int op , int lockType , long long micros , bool command );
+        void recordLockWait( const StringData& ns , int lockType , long long micros );
         void append( BSONObjBuilder& b );
         void cloneMap(UsageMap& out) const;
         CollectionData getGlobalData() const { return _global; }
@@ -527,6 +527,27 @@ namespace BasicTests {
         }
     };
 
+    class QueuePushAllTest {
+    public:
+        void run() {
+            BlockingQueue<int> q( 10 );
+            vector<int> v;
+            for ( int i = 0; i < 4; i++ )
+                v.push_back( i );
+
+            q.pushAll( v.begin() , v.end() );
+            ASSERT_EQUALS( 4 , q.count() );
+            ASSERT_EQUALS( 4u , q.size() );
+
+            // more than the queue holds goes in once it is empty
+            for ( int i = 0; i < 4; i++ )
+                ASSERT_EQUALS( i , q.blockingPop() );
+            vector<int> big( 20 , 7 );
+            q.pushAll( big.begin() , big.end() );
+            ASSERT_EQUALS( 20 , q.count() );
+        }
+    };
+
     class StrTests {
     public:
 
@@ -675,6 +696,7 @@ namespace BasicTests {
             add< IsValidUTF8Test >();
 
             add< QueueTest >();
+            add< QueuePushAllTest >();
 
             add< StrTests >();
 
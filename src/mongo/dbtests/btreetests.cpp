@@ -59,3 +59,205 @@ namespace BtreeTests1 {
 namespace BtreeTests2 {
 #include "btreetests.inl"
 }
+
+#undef BtreeBucket
+#undef btree
+#undef btreemod
+#undef Continuation
+#undef testName
+#undef BTVERSION
+#undef TESTTWOSTEP
+
+/**
+ * The v:2 format packs keys differently than v0 and v1, so the size sensitive cases in
+ * btreetests.inl don't apply to it; these check that it stores and finds keys and that it uses
+ * fewer buckets than v1 for keys with long common prefixes.
+ */
+namespace BtreeTestsV2 {
+
+    const char* ns() {
+        return "unittests.btreetestsv2";
+    }
+
+    const DiskLoc recordLoc() {
+        return DiskLoc( 0, 2 );
+    }
+
+    class Base {
+    public:
+        Base() : _context( ns() ) {}
+        virtual ~Base() {
+            _c.dropCollection( ns() );
+        }
+    protected:
+        /** Create an index on 'field' of version 'v', returning its index number. */
+        int ensure( const string& field, int v ) {
+            _c.ensureIndex( ns(), BSON( field << 1 ), false, field, false, false, v );
+            NamespaceDetails* nsd = nsdetails( ns() );
+            verify( nsd );
+            return nsd->findIndexByName( field.c_str() );
+        }
+        IndexDetails& id( int idxNo ) {
+            return nsdetails( ns() )->idx( idxNo );
+        }
+        template< class V >
+        void insert( int idxNo, const BSONObj& key ) {
+            IndexDetails& idx = id( idxNo );
+            idx.head.btree<V>()->bt_insert( idx.head, recordLoc(), key,
+                                            Ordering::make( idx.keyPattern() ), true, idx,
+                                            true );
+            getDur().commitIfNeeded();
+        }
+        template< class V >
+        bool unindex( int idxNo, const BSONObj& key ) {
+            getDur().commitIfNeeded();
+            IndexDetails& idx = id( idxNo );
+            return idx.head.btree<V>()->unindex( idx.head, idx, key, recordLoc() );
+        }
+        template< class V >
+        bool present( int idxNo, const BSONObj& key, int direction ) {
+            IndexDetails& idx = id( idxNo );
+            int pos;
+            bool found;
+            idx.head.btree<V>()->locate( idx, idx.head, key,
+                                         Ordering::make( idx.keyPattern() ), pos, found,
+                                         recordLoc(), direction );
+            return found;
+        }
+        template< class V >
+        long long fullValidate( int idxNo ) {
+            IndexDetails& idx = id( idxNo );
+            idx.head.btree<V>()->assertValid( idx.keyPattern(), true );
+            return idx.head.btree<V>()->fullValidate( idx.head, idx.keyPattern(), 0, true );
+        }
+        template< class V >
+        static int countBuckets( const DiskLoc& loc ) {
+            const BtreeBucket<V>* b = loc.btree<V>();
+            int n = 1;
+            for ( int i = 0; i < b->nKeys(); ++i ) {
+                DiskLoc child = b->keyNode( i ).prevChildBucket;
+                if ( !child.isNull() )
+                    n += countBuckets<V>( child );
+            }
+            if ( !b->getNextChild().isNull() )
+                n += countBuckets<V>( b->getNextChild() );
+            return n;
+        }
+        /** A key whose value shares a long prefix with every other prefixedKey(). */
+        static BSONObj prefixedKey( int i ) {
+            char suffix[ 16 ];
+            sprintf( suffix, "%08d", i );
+            return BSON( "" << string( 100, 'p' ) + suffix );
+        }
+    private:
+        Lock::GlobalWrite _lk;
+        Client::Context _context;
+        DBDirectClient _c;
+    };
+
+    /** Keys sharing a prefix are inserted, found and removed through splits and merges. */
+    class InsertFindRemove : public Base {
+    public:
+        void run() {
+            int idxNo = ensure( "a", 2 );
+            ASSERT_EQUALS( 2, id( idxNo ).version() );
+            const int n = 2000;
+            for ( int i = 0; i < n; ++i ) {
+                insert<V2>( idxNo, prefixedKey( ( i * 7 ) % n ) );
+            }
+            // a key unlike the others forces buckets with no common prefix
+            insert<V2>( idxNo, BSON( "" << "a" ) );
+            ASSERT_EQUALS( n + 1, fullValidate<V2>( idxNo ) );
+            ASSERT( countBuckets<V2>( id( idxNo ).head ) > 1 );
+
+            for ( int i = 0; i < n; ++i ) {
+                ASSERT( present<V2>( idxNo, prefixedKey( i ), 1 ) );
+                ASSERT( present<V2>( idxNo, prefixedKey( i ), -1 ) );
+            }
+            ASSERT( !present<V2>( idxNo, prefixedKey( n ), 1 ) );
+            ASSERT( !present<V2>( idxNo, BSON( "" << string( 100, 'p' ) ), 1 ) );
+
+            for ( int i = 0; i < n; i += 2 ) {
+                ASSERT( unindex<V2>( idxNo, prefixedKey( i ) ) );
+            }
+            ASSERT_EQUALS( n / 2 + 1, fullValidate<V2>( idxNo ) );
+            for ( int i = 0; i < n; ++i ) {
+                ASSERT_EQUALS( i % 2 == 1, present<V2>( idxNo, prefixedKey( i ), 1 ) );
+            }
+        }
+    };
+
+    /** The same prefixed keys take fewer buckets in a v:2 index than in a v:1 one. */
+    class PrefixSize : public Base {
+    public:
+        void run() {
+            int v1 = ensure( "a", 1 );
+            int v2 = ensure( "b", 2 );
+            const int n = 5000;
+            for ( int i = 0; i < n; ++i ) {
+                insert<V1>( v1, prefixedKey( i ) );
+                insert<V2>( v2, prefixedKey( i ) );
+            }
+            ASSERT_EQUALS( n, fullValidate<V1>( v1 ) );
+            ASSERT_EQUALS( n, fullValidate<V2>( v2 ) );
+
+            int v1Buckets = countBuckets<V1>( id( v1 ).head );
+            int v2Buckets = countBuckets<V2>( id( v2 ).head );
+            log() << "btree prefix size: v1 buckets " << v1Buckets << " v2 buckets "
+                  << v2Buckets << endl;
+            ASSERT( v2Buckets < v1Buckets );
+
+            Timer t;
+            for ( int i = 0; i < n; ++i ) {
+                ASSERT( present<V1>( v1, prefixedKey( i ), 1 ) );
+            }
+            long long v1Micros = t.micros();
+            t.reset();
+            for ( int i = 0; i < n; ++i ) {
+                ASSERT( present<V2>( v2, prefixedKey( i ), 1 ) );
+            }
+            log() << "btree prefix lookups: v1 " << v1Micros << "us v2 " << t.micros()
+                  << "us for " << n << " keys" << endl;
+        }
+    };
+
+    /** A key read to a caller's buffer equals the one read to a copy of its own. */
+    class KeyAtBuffer : public Base {
+    public:
+        void run() {
+            int idxNo = ensure( "a", 2 );
+            const int n = 1000;
+            for ( int i = 0; i < n; ++i ) {
+                insert<V2>( idxNo, prefixedKey( i ) );
+            }
+            check( id( idxNo ).head );
+        }
+    private:
+        static void check( const DiskLoc& loc ) {
+            const BtreeBucket<V2>* b = loc.btree<V2>();
+            char buf[ V2::KeyMax ];
+            for ( int i = 0; i < b->nKeys(); ++i ) {
+                BSONObj fromBuffer = b->keyAt( i, buf ).toBson();
+                ASSERT_EQUALS( b->keyAt( i ).toBson(), fromBuffer );
+                DiskLoc child = b->keyNode( i ).prevChildBucket;
+                if ( !child.isNull() )
+                    check( child );
+            }
+            if ( !b->getNextChild().isNull() )
+                check( b->getNextChild() );
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite( "btree2" ) {
+        }
+
+        void setupTests() {
+            add< InsertFindRemove >();
+            add< PrefixSize >();
+            add< KeyAtBuffer >();
+        }
+    } myall;
+
+} // namespace BtreeTestsV2
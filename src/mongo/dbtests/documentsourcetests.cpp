@@ -285,6 +285,57 @@ namespace DocumentSourceTests {
             WriterClientScope _writerScope;
         };
 
+        /** Suspend a DocumentSourceCursor between batches, and resume it under another lock. */
+        class SuspendResume : public Base {
+        public:
+            void run() {
+                client.insert( ns, BSON( "a" << 1 ) );
+                client.insert( ns, BSON( "a" << 2 ) );
+                createSource();
+                ASSERT( !source()->eof() );
+                ASSERT_EQUALS( 1, source()->getCurrent()->getValue( "a" ).coerceToInt() );
+                source()->suspend();
+                // Suspending releases the read lock.
+                ASSERT( !Lock::isReadLocked() );
+                {
+                    Client::ReadContext ctx( ns );
+                    source()->resume();
+                    // The next result is as expected.
+                    ASSERT( source()->advance() );
+                    ASSERT_EQUALS( 2, source()->getCurrent()->getValue( "a" ).coerceToInt() );
+                    source()->suspend();
+                }
+                ASSERT( !Lock::isReadLocked() );
+                {
+                    Client::ReadContext ctx( ns );
+                    source()->resume();
+                    // There are no more results.
+                    ASSERT( !source()->advance() );
+                }
+                ASSERT( !Lock::isReadLocked() );
+            }
+        };
+
+        /** A DocumentSourceCursor whose collection is dropped while suspended can't resume. */
+        class SuspendDrop : public Base {
+        public:
+            void run() {
+                client.insert( ns, BSON( "a" << 1 ) );
+                client.insert( ns, BSON( "a" << 2 ) );
+                createSource();
+                ASSERT( !source()->eof() );
+                source()->suspend();
+                client.dropCollection( ns );
+                {
+                    Client::ReadContext ctx( ns );
+                    ASSERT_THROWS( source()->resume(), UserException );
+                }
+                // The source was disposed of.
+                ASSERT( !source()->advance() );
+                ASSERT( !Lock::isReadLocked() );
+            }
+        };
+
     } // namespace DocumentSourceCursor
 
     namespace DocumentSourceLimit {
@@ -1763,6 +1814,8 @@ namespace DocumentSourceTests {
             add<DocumentSourceCursor::Dispose>();
             add<DocumentSourceCursor::IterateDispose>();
             add<DocumentSourceCursor::Yield>();
+            add<DocumentSourceCursor::SuspendResume>();
+            add<DocumentSourceCursor::SuspendDrop>();
 
             add<DocumentSourceLimit::DisposeSource>();
             add<DocumentSourceLimit::DisposeSourceCascade>();
@@ -20,19 +20,12 @@
 
 #include "mongo/db/pdfile.h"
 #include "mongo/platform/cstdint.h"
+#include "mongo/util/timer.h"
 
 #include "mongo/dbtests/dbtests.h"
 
 namespace ExtSortTests {
 
-    bool isSolaris() {
-#ifdef __sunos__
-        return true;
-#else
-        return false;
-#endif
-    }
-
     static const char* const _ns = "unittests.extsort";
     DBDirectClient _client;
     IndexInterface& _arbitraryIndexInterface = *IndexDetails::iis[ time( 0 ) % 2 ];
@@ -303,7 +296,7 @@ namespace ExtSortTests {
                                           10 * 1024 );
             // Register a request to kill the current operation.
             cc().curop()->kill();
-            if ( _mayInterrupt && !isSolaris() ) { // This interrupt is unsupported on solaris.
+            if ( _mayInterrupt ) {
                 // When enough keys are added to fill the first file, an interruption will be
                 // triggered as the records are sorted for the file.
                 ASSERT_THROWS( addKeysUntilFileFlushed( &sorter, _mayInterrupt ), UserException );
@@ -350,7 +343,7 @@ namespace ExtSortTests {
             ASSERT( sorter.getCurSizeSoFar() > 0 );
             // Register a request to kill the current operation.
             cc().curop()->kill();
-            if ( _mayInterrupt && !isSolaris() ) { // This interrupt is unsupported on solaris.
+            if ( _mayInterrupt ) {
                 // The sort is aborted due to the kill request.
                 ASSERT_THROWS( sorter.sort( _mayInterrupt ), UserException );
                 // TODO Check that an iterator cannot be retrieved because the keys are unsorted (Not
@@ -375,6 +368,61 @@ namespace ExtSortTests {
         bool _mayInterrupt;
     };
 
+    /** Sets externalSortThreads for the life of a test. */
+    class SortThreadsSetting {
+    public:
+        SortThreadsSetting( int threads ) : _old( externalSortThreads ) {
+            externalSortThreads = threads;
+        }
+        ~SortThreadsSetting() {
+            externalSortThreads = _old;
+        }
+    private:
+        int _old;
+    };
+
+    /** Merge many runs, of different lengths, in descending key order with duplicate keys. */
+    class MergeManyRuns {
+    public:
+        MergeManyRuns( int threads ) :
+            _threads( threads ) {
+        }
+        void run() {
+            SortThreadsSetting setting( _threads );
+            const int total = 20000;
+            BSONObjExternalSorter sorter( IndexInterface::defaultVersion(), BSON( "a" << -1 ),
+                                          16 * 1024 );
+            for ( int i = 0; i < total; i++ ) {
+                // string keys of varying length make the runs differ in length
+                string key( 1 + ( i * 7 ) % 13, 'a' + ( i * 31 ) % 26 );
+                sorter.add( BSON( "" << key ), DiskLoc( 0, i ), false );
+            }
+            sorter.sort( false );
+            ASSERT( sorter.numFiles() > 10 );
+
+            auto_ptr<BSONObjExternalSorter::Iterator> i = sorter.iterator();
+            vector<bool> seen( total );
+            BSONObjExternalSorter::Data prev;
+            int num = 0;
+            while ( i->more() ) {
+                BSONObjExternalSorter::Data d = i->next();
+                if ( num > 0 ) {
+                    int cmp = prev.first.firstElement().woCompare( d.first.firstElement() );
+                    ASSERT( cmp >= 0 );
+                    if ( cmp == 0 )
+                        ASSERT( prev.second < d.second );
+                }
+                ASSERT( ! seen[d.second.getOfs()] );
+                seen[d.second.getOfs()] = true;
+                prev = d;
+                num++;
+            }
+            ASSERT_EQUALS( total, num );
+        }
+    private:
+        int _threads;
+    };
+
     class ExtSortTests : public Suite {
     public:
         ExtSortTests() :
@@ -395,6 +443,9 @@ namespace ExtSortTests {
             add<InterruptAdd>( true );
             add<InterruptSort>( false );
             add<InterruptSort>( true );
+            add<MergeManyRuns>( 0 );
+            add<MergeManyRuns>( 1 );
+            add<MergeManyRuns>( 4 );
         }
     } extSortTests;
 
@@ -476,6 +476,47 @@ namespace IndexUpdateTests {
         }
     };
 
+    /**
+     * A v:2 index generates keys for the documents present when it is built and for those
+     * inserted and removed afterwards.
+     */
+    class InsertBuildV2Index : public IndexBuildBase {
+    public:
+        void run() {
+            int32_t nDocs = 1000;
+            for( int32_t i = 0; i < nDocs; ++i ) {
+                _client.insert( _ns, BSON( "a" << i ) );
+            }
+            BSONObj indexInfo = BSON( "v" << 2 <<
+                                      "key" << BSON( "a" << 1 ) <<
+                                      "ns" << _ns <<
+                                      "name" << "a_1" );
+            theDataFileMgr.insertWithObjMod( "unittests.system.indexes", indexInfo, false );
+            NamespaceDetails* nsd = nsdetails( _ns );
+            int idxNo = nsd->findIndexByName( "a_1" );
+            ASSERT( idxNo >= 0 );
+            IndexDetails& id = nsd->idx( idxNo );
+            ASSERT_EQUALS( 2, id.version() );
+            // Keys are generated the same way as for a v:1 index.
+            BSONObjSet keys;
+            id.getKeysFromObject( BSON( "a" << 5 ), keys );
+            ASSERT_EQUALS( 1U, keys.size() );
+            ASSERT_EQUALS( BSON( "" << 5 ), *keys.begin() );
+            // Documents inserted and removed after the build are indexed.
+            for( int32_t i = nDocs; i < 2 * nDocs; ++i ) {
+                _client.insert( _ns, BSON( "a" << i ) );
+            }
+            _client.remove( _ns, BSON( "a" << BSON( "$lt" << 10 ) ) );
+            ASSERT_EQUALS( 2 * nDocs - 10, hintedCount( BSONObj() ) );
+            ASSERT_EQUALS( 1, hintedCount( BSON( "a" << nDocs + 5 ) ) );
+            ASSERT_EQUALS( 0, hintedCount( BSON( "a" << 5 ) ) );
+        }
+    private:
+        int hintedCount( const BSONObj& query ) {
+            return _client.query( _ns, Query( query ).hint( BSON( "a" << 1 ) ) )->itcount();
+        }
+    };
+
     /** DBDirectClient::ensureIndex() is not interrupted. */
     class DirectClientEnsureIndexInterruptDisallowed : public IndexBuildBase {
     public:
@@ -596,6 +637,7 @@ namespace IndexUpdateTests {
             add<InsertBuildIndexInterruptDisallowed>();
             add<InsertBuildIdIndexInterrupt>();
             add<InsertBuildIdIndexInterruptDisallowed>();
+            add<InsertBuildV2Index>();
             add<DirectClientEnsureIndexInterruptDisallowed>();
             add<HelpersEnsureIndexInterruptDisallowed>();
             add<IndexBuildInProgressTest>();
@@ -1578,6 +1578,18 @@ namespace NamespaceTests {
                 return DiskLoc();
             }
 
+            /** Return the number of DeletedRecords in deletedList. */
+            int nDeletedRecords() {
+                int count = 0;
+                for( int i = 0; i < Buckets; ++i ) {
+                    for( DiskLoc dl = nsd()->deletedList[ i ]; !dl.isNull();
+                         dl = dl.drec()->nextDeleted() ) {
+                        ++count;
+                    }
+                }
+                return count;
+            }
+
             /**
              * 'cook' the deletedList by shrinking the smallest deleted record to size
              * 'newDeletedRecordSize'.
@@ -1604,6 +1616,9 @@ namespace NamespaceTests {
                 // new size.
                 nsd()->deletedList[ NamespaceDetails::bucket( newDeletedRecordSize ) ].writing() =
                         deleted;
+
+                // The free space map no longer mirrors the deletedList.
+                nsdt().freeSpaceMap().reset();
             }
         };
 
@@ -2060,6 +2075,72 @@ namespace NamespaceTests {
             virtual string spec() const { return ""; }
         };
         
+        /** A freed record is merged with the deleted records on either side of it. */
+        class FreedRecordsCoalesce : public Base {
+        public:
+            void run() {
+                create();
+                ASSERT_EQUALS( 1, nDeletedRecords() );
+                DiskLoc deleted = smallestDeletedRecord();
+                int deletedLength = deleted.drec()->lengthWithHeaders();
+
+                DiskLoc l[ 3 ];
+                for ( int i = 0; i < 3; ++i ) {
+                    BSONObj b = bigObj( true );
+                    l[ i ] = theDataFileMgr.insert( ns(), b.objdata(), b.objsize() );
+                    ASSERT( !l[ i ].isNull() );
+                }
+                ASSERT_EQUALS( deleted, l[ 0 ] );
+
+                // The last record merges with the free space after it, the first has no deleted
+                // neighbor.
+                theDataFileMgr.deleteRecord( ns(), l[ 2 ].rec(), l[ 2 ] );
+                theDataFileMgr.deleteRecord( ns(), l[ 0 ].rec(), l[ 0 ] );
+                ASSERT_EQUALS( 2, nDeletedRecords() );
+
+                // The middle record joins them into the original deleted record.
+                theDataFileMgr.deleteRecord( ns(), l[ 1 ].rec(), l[ 1 ] );
+                ASSERT_EQUALS( 1, nDeletedRecords() );
+                ASSERT_EQUALS( deleted, smallestDeletedRecord() );
+                ASSERT_EQUALS( deletedLength, deleted.drec()->lengthWithHeaders() );
+
+                BSONObjBuilder b;
+                nsd()->appendFreeSpaceStats( ns(), &b, false );
+                BSONObj stats = b.obj();
+                ASSERT( stats[ "mapped" ].trueValue() );
+                ASSERT_EQUALS( 1, stats[ "records" ].numberLong() );
+                ASSERT_EQUALS( 3, stats[ "coalesced" ].numberLong() );
+                ASSERT_EQUALS( 0, stats[ "fragmentation" ].number() );
+            }
+            virtual string spec() const { return ""; }
+        };
+
+        /** alloc() takes the smallest deleted record that fits, wherever it is chained. */
+        class AllocBestFit : public Base {
+        public:
+            void run() {
+                create();
+                DiskLoc l[ 5 ];
+                for ( int i = 0; i < 5; ++i ) {
+                    BSONObj b = bigObj( true );
+                    l[ i ] = theDataFileMgr.insert( ns(), b.objdata(), b.objsize() );
+                }
+                int recordLength = l[ 1 ].rec()->lengthWithHeaders();
+
+                // Free two records apart from each other, the later one freed first so it isn't
+                // the head of its chain.
+                theDataFileMgr.deleteRecord( ns(), l[ 3 ].rec(), l[ 3 ] );
+                theDataFileMgr.deleteRecord( ns(), l[ 1 ].rec(), l[ 1 ] );
+
+                // The lowest located of the equal records is taken, not the large remainder of
+                // the extent.
+                ASSERT_EQUALS( l[ 1 ], nsd()->allocWillBeAt( ns(), recordLength ) );
+                ASSERT_EQUALS( l[ 1 ], nsd()->alloc( ns(), recordLength ) );
+                ASSERT_EQUALS( l[ 3 ], nsd()->alloc( ns(), recordLength ) );
+            }
+            virtual string spec() const { return ""; }
+        };
+
         /* test  NamespaceDetails::cappedTruncateAfter(const char *ns, DiskLoc loc)
         */
         class TruncateCapped : public Base {
@@ -2284,6 +2365,92 @@ namespace NamespaceTests {
             }
         };                                                                                         
         
+
+        class QueryPlanCacheBase : public NamespaceDetailsTests::Base {
+        public:
+            QueryPlanCacheBase() :
+                _oldSize( queryPlanCacheSize ) {
+                create();
+            }
+            ~QueryPlanCacheBase() {
+                queryPlanCacheSize = _oldSize;
+            }
+        protected:
+            static QueryPattern pattern( const char* field ) {
+                FieldRangeSet frs( "unittests.NamespaceDetailsTests", BSON( field << 1 ), true,
+                                   true );
+                return QueryPattern( frs, BSONObj() );
+            }
+            static CachedQueryPlan plan( const BSONObj& indexKey, long long nScanned,
+                                         bool pinned = false ) {
+                return CachedQueryPlan( indexKey, nScanned, CandidatePlanCharacter( true, false ),
+                                        pinned );
+            }
+            QueryPlanCache& cache() const { return nsdt().queryPlanCache(); }
+        private:
+            int _oldSize;
+        };
+
+        /** The least recently used plans are evicted, but not pinned ones. */
+        class QueryPlanCacheEviction : public QueryPlanCacheBase {
+        public:
+            void run() {
+                queryPlanCacheSize = 2;
+                cache().set( pattern( "a" ), plan( BSON( "a" << 1 ), 1 ) );
+                cache().set( pattern( "b" ), plan( BSON( "b" << 1 ), 1 ) );
+                // a lookup of 'a' makes 'b' the least recently used
+                cache().noteHit( pattern( "a" ) );
+                cache().set( pattern( "c" ), plan( BSON( "c" << 1 ), 1 ) );
+                ASSERT_EQUALS( 2, cache().size() );
+                ASSERT_EQUALS( BSONObj(), cache().find( pattern( "b" ) ).indexKey() );
+                ASSERT_EQUALS( BSON( "a" << 1 ), cache().find( pattern( "a" ) ).indexKey() );
+
+                cache().pin( pattern( "b" ), plan( BSON( "b" << 1 ), 0, true ) );
+                cache().set( pattern( "d" ), plan( BSON( "d" << 1 ), 1 ) );
+                cache().set( pattern( "e" ), plan( BSON( "e" << 1 ), 1 ) );
+                ASSERT_EQUALS( 2, cache().size() );
+                ASSERT( cache().find( pattern( "b" ) ).pinned() );
+                ASSERT_EQUALS( BSON( "e" << 1 ), cache().find( pattern( "e" ) ).indexKey() );
+
+                BSONObjBuilder b;
+                cache().appendStats( b );
+                BSONObj stats = b.obj();
+                ASSERT_EQUALS( 4, stats[ "evictions" ].numberLong() );
+                ASSERT_EQUALS( 1, stats[ "hits" ].numberLong() );
+            }
+        };
+
+        /** Runs are averaged, regressions and misses counted, and pins aren't overwritten. */
+        class QueryPlanCacheEntryStats : public QueryPlanCacheBase {
+        public:
+            void run() {
+                cache().set( pattern( "a" ), plan( BSON( "a" << 1 ), 10 ) );
+                cache().noteRun( pattern( "a" ), 30 );
+                ASSERT_EQUALS( 20, cache().find( pattern( "a" ) ).nScanned() );
+
+                cache().invalidate( pattern( "a" ) );
+                ASSERT_EQUALS( BSONObj(), cache().find( pattern( "a" ) ).indexKey() );
+                cache().noteMiss( pattern( "a" ), pattern( "a" ) );
+
+                cache().pin( pattern( "a" ), plan( BSON( "$natural" << 1 ), 0, true ) );
+                cache().set( pattern( "a" ), plan( BSON( "a" << 1 ), 10 ) );
+                cache().invalidate( pattern( "a" ) );
+                ASSERT_EQUALS( BSON( "$natural" << 1 ),
+                               cache().find( pattern( "a" ) ).indexKey() );
+
+                BSONObjBuilder b;
+                cache().appendStats( b );
+                BSONObj entry = b.obj()[ "entries" ].Array()[ 0 ].Obj();
+                ASSERT( entry[ "pinned" ].trueValue() );
+                ASSERT_EQUALS( 1, entry[ "replans" ].numberLong() );
+                ASSERT_EQUALS( 1, entry[ "misses" ].numberLong() );
+
+                ASSERT( cache().unpin( pattern( "a" ) ) );
+                ASSERT_EQUALS( 0, cache().size() );
+                ASSERT( !cache().unpin( pattern( "a" ) ) );
+            }
+        };
+        
     } // namespace NamespaceDetailsTransientTests
                                                                                  
     class All : public Suite {
@@ -2396,6 +2563,8 @@ namespace NamespaceTests {
             add< NamespaceDetailsTests::AllocQuantizedWithoutExtra >();
             add< NamespaceDetailsTests::AllocNotQuantizedNearDeletedSize >();
             add< NamespaceDetailsTests::AllocFailsWithTooSmallDeletedRecord >();
+            add< NamespaceDetailsTests::FreedRecordsCoalesce >();
+            add< NamespaceDetailsTests::AllocBestFit >();
             add< NamespaceDetailsTests::TwoExtent >();
             add< NamespaceDetailsTests::TruncateCapped >();
             add< NamespaceDetailsTests::Migrate >();
@@ -2404,6 +2573,8 @@ namespace NamespaceTests {
             add< NamespaceDetailsTests::Size >();
             add< NamespaceDetailsTests::SetIndexIsMultikey >();
             add< NamespaceDetailsTransientTests::ClearQueryCache >();
+            add< NamespaceDetailsTransientTests::QueryPlanCacheEviction >();
+            add< NamespaceDetailsTransientTests::QueryPlanCacheEntryStats >();
         }
     } myall;
 } // namespace NamespaceTests
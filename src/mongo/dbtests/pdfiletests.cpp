@@ -313,6 +313,35 @@ namespace PdfileTests {
                 ASSERT( 0 != o.getField( "a" ).date() );
             }
         };
+
+        class CompressedRecords : public Base {
+        public:
+            void run() {
+                BSONObj first = BSON( "_id" << 0 );
+                theDataFileMgr.insertWithObjMod( ns(), first );
+                nsd()->setUserFlag( NamespaceDetails::Flag_CompressRecords );
+
+                // a document that compresses is stored compressed and read back whole
+                BSONObj big = BSON( "_id" << 1 << "s" << string( 1000, 'x' ) );
+                DiskLoc loc = theDataFileMgr.insertWithObjMod( ns(), big );
+                ASSERT( loc.rec()->isCompressed() );
+                ASSERT( loc.rec()->netLength() < big.objsize() );
+                ASSERT_EQUALS( big, loc.obj() );
+
+                // one that doesn't is stored as it is
+                BSONObj small = BSON( "_id" << 2 );
+                loc = theDataFileMgr.insertWithObjMod( ns(), small );
+                ASSERT( !loc.rec()->isCompressed() );
+                ASSERT_EQUALS( small, loc.obj() );
+
+                // an added _id is compressed along with the rest
+                BSONObj noId = BSON( "s" << string( 1000, 'y' ) );
+                loc = theDataFileMgr.insertWithObjMod( ns(), noId );
+                ASSERT( loc.rec()->isCompressed() );
+                ASSERT_EQUALS( jstOID, loc.obj()[ "_id" ].type() );
+                ASSERT_EQUALS( string( 1000, 'y' ), loc.obj()[ "s" ].String() );
+            }
+        };
     } // namespace Insert
 
     class ExtentSizing {
@@ -409,6 +438,7 @@ namespace PdfileTests {
             add< ScanCapped::LastInExtent >();
             add< Insert::InsertAddId >();
             add< Insert::UpdateDate >();
+            add< Insert::CompressedRecords >();
             add< ExtentSizing >();
             add< ExtentAllocOrder >();
         }
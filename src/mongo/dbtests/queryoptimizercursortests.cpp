@@ -2895,7 +2895,18 @@ namespace QueryOptimizerCursorTests {
                     client.remove( ns(), BSON( "i" << i + 1 ) );
                 }
             }
-            // Best plan cleared by ~1000 writes.
+            // Writes alone don't clear the best plan.
+            nPlans( 1 );
+
+            {
+                DBDirectClient client;
+                client.insert( ns(), BSON( "a" << 4 << "b" << 1 ) );
+                // A replan because the cached plan performed badly, e.g. its in memory sort
+                // exceeded the memory limit, clears the best plan.
+                shared_ptr<QueryOptimizerCursor> c = getCursor( BSON( "a" << 4 ), BSON( "b" << 1 ) );
+                ASSERT( c->hasPossiblyExcludedPlans() );
+                c->clearIndexesForPatterns();
+            }
             nPlans( 3 );
 
             shared_ptr<ParsedQuery> parsedQuery
@@ -1595,8 +1595,9 @@ namespace QueryTests {
         
         class TestableScanAndOrder : public ScanAndOrder {
         public:
-            TestableScanAndOrder(int startFrom, int limit, BSONObj order, const FieldRangeSet &frs)
-            : ScanAndOrder( startFrom, limit, order, frs ) {
+            TestableScanAndOrder(int startFrom, int limit, BSONObj order, const FieldRangeSet &frs,
+                                 const Projection *projection = 0)
+            : ScanAndOrder( startFrom, limit, order, frs, projection ) {
             }
             unsigned approxSize() const { return ScanAndOrder::approxSize(); }
         };
@@ -1655,6 +1656,60 @@ namespace QueryTests {
                 assertNumFilled( 1, t );
             }
         };
+
+        /** Only the best skip + limit documents are kept, and they are returned in order. */
+        class TopK : public Base {
+        public:
+            void run() {
+                FieldRangeSet frs( "n/a", BSONObj(), true, true );
+                Testable t( 2, 3, BSON( "a" << -1 ), frs );
+                for( int i = 0; i < 100; ++i ) {
+                    // Each key is added twice, and equal keys are returned in insertion order.
+                    t.add( BSON( "a" << ( i * 37 ) % 50 << "b" << i ), 0 );
+                }
+                ASSERT_EQUALS( 5, t.size() );
+                unsigned peak = t.peakApproxSize();
+                ASSERT( peak >= t.approxSize() );
+
+                BufBuilder bb;
+                int nout;
+                t.fill( bb, 0, nout );
+                ASSERT_EQUALS( 3, nout );
+                const char *data = bb.buf();
+                BSONObj expected[] = { BSON( "a" << 48 << "b" << 4 ),
+                                       BSON( "a" << 48 << "b" << 54 ),
+                                       BSON( "a" << 47 << "b" << 31 ) };
+                for( int i = 0; i < 3; ++i ) {
+                    BSONObj o( data );
+                    ASSERT_EQUALS( expected[ i ], o );
+                    data += o.objsize();
+                }
+            }
+        };
+
+        /** A projection is applied before documents are buffered. */
+        class Projected : public Base {
+        public:
+            void run() {
+                FieldRangeSet frs( "n/a", BSONObj(), true, true );
+                Projection projection;
+                projection.init( BSON( "a" << 1 << "_id" << 0 ) );
+                Testable projected( 0, 0, BSON( "a" << 1 ), frs, &projection );
+                Testable full( 0, 0, BSON( "a" << 1 ), frs );
+                BSONObj o = BSON( "a" << 1 << "big" << string( 1000, 'x' ) );
+                projected.add( o, 0 );
+                full.add( o, 0 );
+                ASSERT( projected.approxSize() < 100 );
+                ASSERT( full.approxSize() > 1000 );
+                ASSERT_EQUALS( projected.approxSize(), projected.peakApproxSize() );
+
+                BufBuilder bb;
+                int nout;
+                projected.fill( bb, 0, nout );
+                ASSERT_EQUALS( 1, nout );
+                ASSERT_EQUALS( BSON( "a" << 1 ), BSONObj( bb.buf() ) );
+            }
+        };
         
     } // namespace ScanAndOrderTests
 
@@ -1729,6 +1784,8 @@ namespace QueryTests {
             
             add< ScanAndOrderTests::Unlimited >();
             add< ScanAndOrderTests::LimitOne >();
+            add< ScanAndOrderTests::TopK >();
+            add< ScanAndOrderTests::Projected >();
         }
     } myall;
 
@@ -253,13 +253,38 @@ namespace ShardingTests {
 
             client().update(ChunkType::ConfigNS, BSONObj(), BSON( "$set" << b.obj()));
 
+            // Route through the old manager, so it has a routing table to share
+            boost::shared_ptr<const ChunkRoutingTable> oldRouting =
+                    manager->getChunkRanges().routingTable();
+
             // Make new manager load chunk diff
             ChunkManager newManager( manager );
             newManager.loadExistingRanges( shard().getConnString() );
 
+            // Only versions changed, which leaves every range as it was
+            ASSERT( newManager.getChunkRanges().routingTable() == oldRouting );
+
             ASSERT( newManager.getVersion().toLong() == laterVersion.toLong() );
             ASSERT( newManager.getVersion().epoch() == laterVersion.epoch() );
             ASSERT( static_cast<int>( newManager.getChunkMap().size() ) == numChunks );
+
+            // The old manager still has the old chunk, the new one the changed chunk
+            BSONObj firstMax = firstChunk[ChunkType::max()].Obj();
+            ChunkMap oldChunks = manager->getChunkMap();
+            ChunkMap newChunks = newManager.getChunkMap();
+            ASSERT( oldChunks.find( firstMax )->second->getLastmod().toLong() == version.toLong() );
+            ASSERT( newChunks.find( firstMax )->second->getLastmod().toLong() ==
+                    laterVersion.toLong() );
+
+#if !defined(_DEBUG)
+            // Only the changed chunk and the old max version chunk are reloaded, the others are
+            // shared (debug builds sometimes reload everything)
+            int numShared = 0;
+            for ( ChunkMap::const_iterator it = newChunks.begin(); it != newChunks.end(); ++it ) {
+                if ( oldChunks.find( it->first )->second == it->second ) numShared++;
+            }
+            ASSERT( numShared >= numChunks - 2 );
+#endif
         }
 
     };
@@ -890,6 +890,59 @@ namespace ThreadedTests {
         }
     };
 
+    // Writers to different collections of one database hold their collection locks at the same
+    // time, while writers to the same collection, and whole database writers, wait.
+    class CollectionLockTest : public ThreadedTest<3> {
+    public:
+        CollectionLockTest() : bHeld(false), dbWaited(false) { }
+    private:
+        AtomicUInt32 inA;
+        volatile bool bHeld;
+        volatile bool dbWaited;
+        virtual void validate() {
+            ASSERT( bHeld );
+            ASSERT( dbWaited );
+        }
+        virtual void subthread(int x) {
+            Client::initThread("colllocktest");
+            if( !Lock::collectionLevelLockingEnabled() ) {
+                bHeld = dbWaited = true;
+                cc().shutdown();
+                return;
+            }
+            if( x == 1 ) {
+                Lock::DBWrite lk("unittests.colllock_a", true);
+                ASSERT( lk.collectionLocked() );
+                ASSERT( Lock::isWriteLocked("unittests.colllock_a") );
+                ASSERT( !Lock::isWriteLocked("unittests.colllock_b") );
+                inA.addAndFetch(1);
+                sleepmillis(400);
+                inA.subtractAndFetch(1);
+            }
+            if( x == 2 ) {
+                sleepmillis(100);
+                Lock::DBWrite lk("unittests.colllock_b", true);
+                ASSERT( lk.collectionLocked() );
+                // thread 1 still holds colllock_a
+                ASSERT_EQUALS( 1U, inA.load() );
+                bHeld = true;
+            }
+            if( x == 3 ) {
+                sleepmillis(200);
+                Timer t;
+                Lock::DBWrite lk("unittests");
+                ASSERT( !lk.collectionLocked() );
+                ASSERT_EQUALS( 0U, inA.load() );
+                dbWaited = t.millis() > 50;
+
+                // system namespaces always lock the whole database
+                Lock::DBWrite nested("unittests.system.indexes", true);
+                ASSERT( !nested.collectionLocked() );
+            }
+            cc().shutdown();
+        }
+    };
+
     // Tests waiting on the TicketHolder by running many more threads than can fit into the "hotel", but only
     // max _nRooms threads should ever get in at once
     class TicketHolderWaits : public ThreadedTest<10> {
@@ -999,6 +1052,7 @@ namespace ThreadedTests {
             add< RWLockTest4 >();
 
             add< MongoMutexTest >();
+            add< CollectionLockTest >();
             add< TicketHolderWaits >();
         }
     } myall;
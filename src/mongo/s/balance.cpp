@@ -18,6 +18,8 @@
 
 #include "mongo/s/balance.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/client/distlock.h"
 #include "mongo/db/cmdline.h"
@@ -45,69 +47,104 @@ namespace mongo {
 
     int Balancer::_moveChunks(const vector<CandidateChunkPtr>* candidateChunks,
                               bool secondaryThrottle,
-                              bool waitForDelete)
+                              bool waitForDelete,
+                              bool concurrently)
     {
+        if ( concurrently && candidateChunks->size() > 1 ) {
+            AtomicUInt32 movedCount;
+            boost::thread_group movers;
+            for ( vector<CandidateChunkPtr>::const_iterator it = candidateChunks->begin(); it != candidateChunks->end(); ++it ) {
+                movers.create_thread( boost::bind( &Balancer::_moveChunkThread , this , it->get() ,
+                                                   secondaryThrottle , waitForDelete , &movedCount ) );
+            }
+            movers.join_all();
+            return movedCount.load();
+        }
+
         int movedCount = 0;
 
         for ( vector<CandidateChunkPtr>::const_iterator it = candidateChunks->begin(); it != candidateChunks->end(); ++it ) {
-            const CandidateChunk& chunkInfo = *it->get();
+            if ( _moveChunk( *it->get() , secondaryThrottle , waitForDelete ) )
+                movedCount++;
+        }
 
-            DBConfigPtr cfg = grid.getDBConfig( chunkInfo.ns );
-            verify( cfg );
+        return movedCount;
+    }
 
-            ChunkManagerPtr cm = cfg->getChunkManager( chunkInfo.ns );
+    void Balancer::_moveChunkThread(const CandidateChunk* chunkInfo,
+                                    bool secondaryThrottle,
+                                    bool waitForDelete,
+                                    AtomicUInt32* movedCount)
+    {
+        setThreadName( "BalancerMove" );
+        try {
+            if ( _moveChunk( *chunkInfo , secondaryThrottle , waitForDelete ) )
+                movedCount->addAndFetch( 1 );
+        }
+        catch ( std::exception& e ) {
+            log() << "caught exception while moving chunk " << chunkInfo->chunk << " of "
+                  << chunkInfo->ns << ": " << e.what() << endl;
+        }
+    }
+
+    bool Balancer::_moveChunk(const CandidateChunk& chunkInfo,
+                              bool secondaryThrottle,
+                              bool waitForDelete)
+    {
+        DBConfigPtr cfg = grid.getDBConfig( chunkInfo.ns );
+        verify( cfg );
+
+        ChunkManagerPtr cm = cfg->getChunkManager( chunkInfo.ns );
+        verify( cm );
+
+        ChunkPtr c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+        if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
+            // likely a split happened somewhere
+            cm = cfg->getChunkManager( chunkInfo.ns , true /* reload */);
             verify( cm );
 
-            ChunkPtr c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+            c = cm->findIntersectingChunk( chunkInfo.chunk.min );
             if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
-                // likely a split happened somewhere
-                cm = cfg->getChunkManager( chunkInfo.ns , true /* reload */);
-                verify( cm );
-
-                c = cm->findIntersectingChunk( chunkInfo.chunk.min );
-                if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
-                    log() << "chunk mismatch after reload, ignoring will retry issue " << chunkInfo.chunk.toString() << endl;
-                    continue;
-                }
+                log() << "chunk mismatch after reload, ignoring will retry issue " << chunkInfo.chunk.toString() << endl;
+                return false;
             }
+        }
 
-            BSONObj res;
-            if (c->moveAndCommit(Shard::make(chunkInfo.to),
-                                 Chunk::MaxChunkSize,
-                                 secondaryThrottle,
-                                 waitForDelete,
-                                 res)) {
-                movedCount++;
-                continue;
-            }
+        BSONObj res;
+        if (c->moveAndCommit(Shard::make(chunkInfo.to),
+                             Chunk::MaxChunkSize,
+                             secondaryThrottle,
+                             waitForDelete,
+                             res)) {
+            return true;
+        }
 
-            // the move requires acquiring the collection metadata's lock, which can fail
-            log() << "balancer move failed: " << res << " from: " << chunkInfo.from << " to: " << chunkInfo.to
-                  << " chunk: " << chunkInfo.chunk << endl;
+        // the move requires acquiring the collection metadata's lock, which can fail
+        log() << "balancer move failed: " << res << " from: " << chunkInfo.from << " to: " << chunkInfo.to
+              << " chunk: " << chunkInfo.chunk << endl;
 
-            if ( res["chunkTooBig"].trueValue() ) {
-                // reload just to be safe
-                cm = cfg->getChunkManager( chunkInfo.ns );
-                verify( cm );
-                c = cm->findIntersectingChunk( chunkInfo.chunk.min );
-                
-                log() << "forcing a split because migrate failed for size reasons" << endl;
-                
-                res = BSONObj();
-                c->singleSplit( true , res );
-                log() << "forced split results: " << res << endl;
-                
-                if ( ! res["ok"].trueValue() ) {
-                    log() << "marking chunk as jumbo: " << c->toString() << endl;
-                    c->markAsJumbo();
-                    // we increment moveCount so we do another round right away
-                    movedCount++;
-                }
+        if ( res["chunkTooBig"].trueValue() ) {
+            // reload just to be safe
+            cm = cfg->getChunkManager( chunkInfo.ns );
+            verify( cm );
+            c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+
+            log() << "forcing a split because migrate failed for size reasons" << endl;
 
+            res = BSONObj();
+            c->singleSplit( true , res );
+            log() << "forced split results: " << res << endl;
+
+            if ( ! res["ok"].trueValue() ) {
+                log() << "marking chunk as jumbo: " << c->toString() << endl;
+                c->markAsJumbo();
+                // we increment moveCount so we do another round right away
+                return true;
             }
+
         }
 
-        return movedCount;
+        return false;
     }
 
     void Balancer::_ping( DBClientBase& conn, bool waiting ) {
@@ -176,7 +213,9 @@ namespace mongo {
         }        
     }
 
-    void Balancer::_doBalanceRound( DBClientBase& conn, vector<CandidateChunkPtr>* candidateChunks ) {
+    void Balancer::_doBalanceRound( DBClientBase& conn,
+                                    int maxConcurrentMigrations,
+                                    vector<CandidateChunkPtr>* candidateChunks ) {
         verify( candidateChunks );
 
         //
@@ -239,8 +278,12 @@ namespace mongo {
 
         //
         // 3. For each collection, check if the balancing policy recommends moving anything around.
+        // When the moves are to run concurrently, each must involve shards none of the others do,
+        // as a shard takes part in one migration at a time.
         //
 
+        set<string> busyShards;
+
         for (vector<string>::const_iterator it = collections.begin(); it != collections.end(); ++it ) {
             const string& ns = *it;
 
@@ -334,7 +377,21 @@ namespace mongo {
                 continue;
             }
 
-            CandidateChunk* p = _policy->balance( ns, status, _balancedLastTime );
+            CandidateChunk* p;
+            if ( maxConcurrentMigrations > 1 ) {
+                if ( candidateChunks->size() >= (size_t)maxConcurrentMigrations )
+                    continue;
+
+                p = _policy->balance( ns, shardInfo, shardToChunksMap, ranges, busyShards,
+                                      _balancedLastTime );
+                if ( p ) {
+                    busyShards.insert( p->from );
+                    busyShards.insert( p->to );
+                }
+            }
+            else {
+                p = _policy->balance( ns, status, _balancedLastTime );
+            }
             if ( p ) candidateChunks->push_back( CandidateChunkPtr( p ) );
         }
     }
@@ -451,11 +508,20 @@ namespace mongo {
                         secondaryThrottle = balancerConfig[SettingsType::secondaryThrottle()].trueValue();
                     }
 
+                    int maxConcurrentMigrations =
+                        SettingsType::maxConcurrentMigrations.getDefault();
+                    BSONElement maxConcurrentElem =
+                        balancerConfig[SettingsType::maxConcurrentMigrations()];
+                    if ( maxConcurrentElem.isNumber() && maxConcurrentElem.numberInt() > 0 ) {
+                        maxConcurrentMigrations = maxConcurrentElem.numberInt();
+                    }
+
                     LOG(1) << "waitForDelete: " << waitForDelete << endl;
                     LOG(1) << "secondaryThrottle: " << secondaryThrottle << endl;
+                    LOG(1) << "maxConcurrentMigrations: " << maxConcurrentMigrations << endl;
 
                     vector<CandidateChunkPtr> candidateChunks;
-                    _doBalanceRound( conn.conn() , &candidateChunks );
+                    _doBalanceRound( conn.conn() , maxConcurrentMigrations , &candidateChunks );
                     if ( candidateChunks.size() == 0 ) {
                         LOG(1) << "no need to move any chunk" << endl;
                         _balancedLastTime = 0;
@@ -463,7 +529,8 @@ namespace mongo {
                     else {
                         _balancedLastTime = _moveChunks(&candidateChunks,
                                                         secondaryThrottle,
-                                                        waitForDelete );
+                                                        waitForDelete,
+                                                        maxConcurrentMigrations > 1 );
                     }
 
                     LOG(1) << "*** end of balancing round" << endl;
@@ -21,6 +21,7 @@
 #include "mongo/pch.h"
 
 #include "mongo/client/dbclientinterface.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/s/balancer_policy.h"
 #include "mongo/util/background.h"
 
@@ -33,7 +34,8 @@ namespace mongo {
      *
      * The balancer does act continuously but in "rounds". At a given round, it would decide if there is an imbalance by
      * checking the difference in chunks between the most and least loaded shards. It would issue a request for a chunk
-     * migration per round, if it found so.
+     * migration per collection per round, if it found so. Those migrations run one after the other, or, if the balancer
+     * settings allow more than one concurrent migration, at the same time on disjoint pairs of shards.
      */
     class Balancer : public BackgroundJob {
     public:
@@ -76,22 +78,44 @@ namespace mongo {
          * be moved.
          *
          * @param conn is the connection with the config server(s)
+         * @param maxConcurrentMigrations if more than 1, pick at most that many candidates, no two of which
+         *        have a shard in common
          * @param candidateChunks (IN/OUT) filled with candidate chunks, one per collection, that could possibly be moved
          */
-        void _doBalanceRound( DBClientBase& conn, vector<CandidateChunkPtr>* candidateChunks );
+        void _doBalanceRound( DBClientBase& conn,
+                              int maxConcurrentMigrations,
+                              vector<CandidateChunkPtr>* candidateChunks );
 
         /**
-         * Issues chunk migration request, one at a time.
+         * Issues chunk migration requests, one at a time or all at once.
          *
          * @param candidateChunks possible chunks to move
          * @param secondaryThrottle wait for secondaries to catch up before pushing more deletes
          * @param waitForDelete wait for deletes to complete after each chunk move
+         * @param concurrently move all the chunks at the same time, each from its own thread; the
+         *        candidates must not have a shard in common
          * @return number of chunks effectively moved
          */
         int _moveChunks(const vector<CandidateChunkPtr>* candidateChunks,
+                        bool secondaryThrottle,
+                        bool waitForDelete,
+                        bool concurrently);
+
+        /**
+         * Moves one chunk, splitting it or marking it as jumbo if it is too big to move.
+         *
+         * @return true if the chunk moved, or if it was marked as jumbo
+         */
+        bool _moveChunk(const CandidateChunk& chunkInfo,
                         bool secondaryThrottle,
                         bool waitForDelete);
 
+        /** body of the threads of a concurrent _moveChunks; counts successes in movedCount */
+        void _moveChunkThread(const CandidateChunk* chunkInfo,
+                              bool secondaryThrottle,
+                              bool waitForDelete,
+                              AtomicUInt32* movedCount);
+
         /**
          * Marks this balancer as being live on the config server(s).
          *
@@ -391,6 +391,39 @@ namespace mongo {
         return NULL;
     }
 
+    MigrateInfo* BalancerPolicy::balance( const string& ns,
+                                          const ShardInfoMap& shardInfo,
+                                          const ShardToChunksMap& shardToChunksMap,
+                                          const vector<TagRange>& tagRanges,
+                                          const set<string>& busyShards,
+                                          int balancedLastTime ) {
+        ShardInfoMap freeShardInfo;
+        ShardToChunksMap freeShardToChunksMap;
+        for ( ShardInfoMap::const_iterator i = shardInfo.begin(); i != shardInfo.end(); ++i ) {
+            if ( busyShards.count( i->first ) )
+                continue;
+
+            freeShardInfo[i->first] = i->second;
+
+            ShardToChunksMap::const_iterator chunks = shardToChunksMap.find( i->first );
+            if ( chunks != shardToChunksMap.end() )
+                freeShardToChunksMap[i->first] = chunks->second;
+            else
+                freeShardToChunksMap[i->first];
+        }
+
+        if ( freeShardInfo.size() < 2 ) {
+            LOG(1) << "not enough free shards to balance " << ns << endl;
+            return NULL;
+        }
+
+        DistributionStatus status( freeShardInfo, freeShardToChunksMap );
+        for ( unsigned i = 0; i < tagRanges.size(); i++ )
+            verify( status.addTagRange( tagRanges[i] ) );
+
+        return balance( ns, status, balancedLastTime );
+    }
+
 
     ShardInfo::ShardInfo( long long maxSize, long long currSize,
                           bool draining, bool opsQueued,
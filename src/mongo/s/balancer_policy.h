@@ -197,6 +197,23 @@ namespace mongo {
                                      const DistributionStatus& distribution,
                                      int balancedLastTime );
 
+        /**
+         * Like balance(), but never suggests a move to or from one of busyShards, so the move can
+         * run at the same time as migrations that involve them.
+         *
+         * @param shardInfo and shardToChunksMap describe the collection as for DistributionStatus
+         * @param tagRanges the collection's tag ranges, already known to be valid
+         * @param busyShards shards that can neither give nor take a chunk right now
+         * @returns NULL or MigrateInfo of the best move among the other shards.
+         *          caller owns the MigrateInfo instance
+         */
+        static MigrateInfo* balance( const string& ns,
+                                     const ShardInfoMap& shardInfo,
+                                     const ShardToChunksMap& shardToChunksMap,
+                                     const vector<TagRange>& tagRanges,
+                                     const set<string>& busyShards,
+                                     int balancedLastTime );
+
     private:
         static bool _isJumbo( const BSONObj& chunk );
     };
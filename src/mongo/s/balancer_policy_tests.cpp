@@ -231,6 +231,47 @@ namespace mongo {
         }
 
 
+        TEST( BalancerPolicyTests, BusyShards ) {
+            ShardToChunksMap chunks;
+            addShard( chunks, 10 , false );
+            addShard( chunks, 10 , true );
+            addShard( chunks, 0 , false );
+            addShard( chunks, 0 , false );
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo( 0, 10, false, false );
+            shards["shard1"] = ShardInfo( 0, 10, false, false );
+            shards["shard2"] = ShardInfo( 0, 0, false, false );
+            shards["shard3"] = ShardInfo( 0, 0, false, false );
+
+            vector<TagRange> ranges;
+            set<string> busy;
+
+            // pick moves until no pair of free shards is out of balance
+            set<string> from;
+            for ( int i = 0; i < 2; i++ ) {
+                MigrateInfo* m = BalancerPolicy::balance( "ns", shards, chunks, ranges, busy, 0 );
+                ASSERT( m );
+                ASSERT( busy.count( m->from ) == 0 );
+                ASSERT( busy.count( m->to ) == 0 );
+                ASSERT( m->to == "shard2" || m->to == "shard3" );
+                from.insert( m->from );
+                busy.insert( m->from );
+                busy.insert( m->to );
+                delete m;
+            }
+            ASSERT_EQUALS( 2U , from.size() );
+
+            // every shard is taken
+            ASSERT( ! BalancerPolicy::balance( "ns", shards, chunks, ranges, busy, 0 ) );
+
+            // nothing to move between the two empty shards
+            busy.clear();
+            busy.insert( "shard0" );
+            busy.insert( "shard1" );
+            ASSERT( ! BalancerPolicy::balance( "ns", shards, chunks, ranges, busy, 0 ) );
+        }
+
         TEST( BalancerPolicyTests, TagsDraining ) {
 
             ShardToChunksMap chunks;
@@ -57,7 +57,7 @@ namespace mongo {
     bool Chunk::ShouldAutoSplit = true;
 
     Chunk::Chunk(const ChunkManager * manager, BSONObj from)
-        : _manager(manager), _lastmod(0, OID()), _dataWritten(mkDataWritten())
+        : _lineage(manager->_lineage), _lastmod(0, OID()), _dataWritten(mkDataWritten())
     {
         string ns = from.getStringField(ChunkType::ns().c_str());
         _shard.reset(from.getStringField(ChunkType::shard().c_str()));
@@ -71,7 +71,7 @@ namespace mongo {
         _jumbo = from[ChunkType::jumbo()].trueValue();
 
         uassert( 10170 ,  "Chunk needs a ns" , ! ns.empty() );
-        uassert( 13327 ,  "Chunk ns must match server ns" , ns == _manager->getns() );
+        uassert( 13327 ,  "Chunk ns must match server ns" , ns == _lineage->getns() );
 
         uassert( 10171 ,  "Chunk needs a server" , _shard.ok() );
 
@@ -80,17 +80,17 @@ namespace mongo {
     }
 
     Chunk::Chunk(const ChunkManager * info , const BSONObj& min, const BSONObj& max, const Shard& shard, ChunkVersion lastmod)
-        : _manager(info), _min(min), _max(max), _shard(shard), _lastmod(lastmod), _jumbo(false), _dataWritten(mkDataWritten())
+        : _lineage(info->_lineage), _min(min), _max(max), _shard(shard), _lastmod(lastmod), _jumbo(false), _dataWritten(mkDataWritten())
     {}
 
     int Chunk::mkDataWritten() {
         PseudoRandom r(static_cast<int64_t>(time(0)));
-        return r.nextInt32( MaxChunkSize / ChunkManager::SplitHeuristics::splitTestFactor );
+        return r.nextInt32( MaxChunkSize / ChunkManagerLineage::SplitHeuristics::splitTestFactor );
     }
 
     string Chunk::getns() const {
-        verify( _manager );
-        return _manager->getns();
+        verify( _lineage );
+        return _lineage->getns();
     }
 
     bool Chunk::containsPoint( const BSONObj& point ) const {
@@ -103,23 +103,23 @@ namespace mongo {
     }
 
     bool Chunk::minIsInf() const {
-        return _manager->getShardKey().globalMin().woCompare( getMin() ) == 0;
+        return _lineage->getShardKey().globalMin().woCompare( getMin() ) == 0;
     }
 
     bool Chunk::maxIsInf() const {
-        return _manager->getShardKey().globalMax().woCompare( getMax() ) == 0;
+        return _lineage->getShardKey().globalMax().woCompare( getMax() ) == 0;
     }
 
     BSONObj Chunk::_getExtremeKey( int sort ) const {
         Query q;
         if ( sort == 1 ) {
-            q.sort( _manager->getShardKey().key() );
+            q.sort( _lineage->getShardKey().key() );
         }
         else {
             // need to invert shard key pattern to sort backwards
             // TODO: make a helper in ShardKeyPattern?
 
-            BSONObj k = _manager->getShardKey().key();
+            BSONObj k = _lineage->getShardKey().key();
             BSONObjBuilder r;
 
             BSONObjIterator i(k);
@@ -133,11 +133,11 @@ namespace mongo {
         }
         // find the extreme key
         ScopedDbConnection conn(getShard().getConnString());
-        BSONObj end = conn->findOne(_manager->getns(), q);
+        BSONObj end = conn->findOne(_lineage->getns(), q);
         conn.done();
         if ( end.isEmpty() )
             return BSONObj();
-        return _manager->getShardKey().extractKey( end );
+        return _lineage->getShardKey().extractKey( end );
     }
 
     void Chunk::pickMedianKey( BSONObj& medianKey ) const {
@@ -145,8 +145,8 @@ namespace mongo {
         ScopedDbConnection conn(getShard().getConnString());
         BSONObj result;
         BSONObjBuilder cmd;
-        cmd.append( "splitVector" , _manager->getns() );
-        cmd.append( "keyPattern" , _manager->getShardKey().key() );
+        cmd.append( "splitVector" , _lineage->getns() );
+        cmd.append( "keyPattern" , _lineage->getShardKey().key() );
         cmd.append( "min" , getMin() );
         cmd.append( "max" , getMax() );
         cmd.appendBool( "force" , true );
@@ -172,8 +172,8 @@ namespace mongo {
         ScopedDbConnection conn(getShard().getConnString());
         BSONObj result;
         BSONObjBuilder cmd;
-        cmd.append( "splitVector" , _manager->getns() );
-        cmd.append( "keyPattern" , _manager->getShardKey().key() );
+        cmd.append( "splitVector" , _lineage->getns() );
+        cmd.append( "keyPattern" , _lineage->getShardKey().key() );
         cmd.append( "min" , getMin() );
         cmd.append( "max" , getMax() );
         cmd.append( "maxChunkSizeBytes" , chunkSize );
@@ -204,7 +204,7 @@ namespace mongo {
         if ( ! force ) {
             vector<BSONObj> candidates;
             const int maxPoints = 2;
-            pickSplitVector( candidates , getManager()->getCurrentDesiredChunkSize() , maxPoints , MaxObjectPerChunk );
+            pickSplitVector( candidates , _lineage->getCurrentDesiredChunkSize() , maxPoints , MaxObjectPerChunk );
             if ( candidates.size() <= 1 ) {
                 // no split points means there isn't enough data to split on
                 // 1 split point means we have between half the chunk size to full chunk size
@@ -265,7 +265,7 @@ namespace mongo {
     bool Chunk::multiSplit( const vector<BSONObj>& m , BSONObj& res ) const {
         const size_t maxSplitPoints = 8192;
 
-        uassert( 10165 , "can't split as shard doesn't have a manager" , _manager );
+        uassert( 10165 , "can't split as shard doesn't have a manager" , _lineage );
         uassert( 13332 , "need a split key to split chunk" , !m.empty() );
         uassert( 13333 , "can't split a chunk in that many parts", m.size() < maxSplitPoints );
         uassert( 13003 , "can't split a chunk with only one distinct value" , _min.woCompare(_max) );
@@ -273,8 +273,8 @@ namespace mongo {
         ScopedDbConnection conn(getShard().getConnString());
 
         BSONObjBuilder cmd;
-        cmd.append( "splitChunk" , _manager->getns() );
-        cmd.append( "keyPattern" , _manager->getShardKey().key() );
+        cmd.append( "splitChunk" , _lineage->getns() );
+        cmd.append( "keyPattern" , _lineage->getShardKey().key() );
         cmd.append( "min" , getMin() );
         cmd.append( "max" , getMax() );
         cmd.append( "from" , getShard().getName() );
@@ -288,7 +288,7 @@ namespace mongo {
             conn.done();
 
             // Mark the minor version for *eventual* reload
-            _manager->markMinorForReload( this->_lastmod );
+            _lineage->markMinorForReload( this->_lastmod );
 
             return false;
         }
@@ -296,7 +296,7 @@ namespace mongo {
         conn.done();
         
         // force reload of config
-        _manager->reload();
+        _lineage->reload();
 
         return true;
     }
@@ -309,14 +309,14 @@ namespace mongo {
     {
         uassert( 10167 ,  "can't move shard to its current location!" , getShard() != to );
 
-        log() << "moving chunk ns: " << _manager->getns() << " moving ( " << toString() << ") " << _shard.toString() << " -> " << to.toString() << endl;
+        log() << "moving chunk ns: " << _lineage->getns() << " moving ( " << toString() << ") " << _shard.toString() << " -> " << to.toString() << endl;
 
         Shard from = _shard;
 
         ScopedDbConnection fromconn(from.getConnString());
 
         bool worked = fromconn->runCommand( "admin" ,
-                                            BSON( "moveChunk" << _manager->getns() <<
+                                            BSON( "moveChunk" << _lineage->getns() <<
                                                   "from" << from.getAddress().toString() <<
                                                   "to" << to.getAddress().toString() <<
                                                   // NEEDED FOR 2.0 COMPATIBILITY
@@ -339,7 +339,7 @@ namespace mongo {
         // if succeeded, needs to reload to pick up the new location
         // if failed, mongos may be stale
         // reload is excessive here as the failure could be simply because collection metadata is taken
-        _manager->reload();
+        _lineage->reload();
 
         return worked;
     }
@@ -349,19 +349,19 @@ namespace mongo {
 
         try {
             _dataWritten += dataWritten;
-            int splitThreshold = getManager()->getCurrentDesiredChunkSize();
+            int splitThreshold = _lineage->getCurrentDesiredChunkSize();
             if ( minIsInf() || maxIsInf() ) {
                 splitThreshold = (int) ((double)splitThreshold * .9);
             }
 
-            if ( _dataWritten < splitThreshold / ChunkManager::SplitHeuristics::splitTestFactor )
+            if ( _dataWritten < splitThreshold / ChunkManagerLineage::SplitHeuristics::splitTestFactor )
                 return false;
             
-            if ( ! getManager()->_splitHeuristics._splitTickets.tryAcquire() ) {
-                LOG(1) << "won't auto split because not enough tickets: " << getManager()->getns() << endl;
+            if ( ! _lineage->_splitHeuristics._splitTickets.tryAcquire() ) {
+                LOG(1) << "won't auto split because not enough tickets: " << _lineage->getns() << endl;
                 return false;
             }
-            TicketHolderReleaser releaser( &(getManager()->_splitHeuristics._splitTickets) );
+            TicketHolderReleaser releaser( &(_lineage->_splitHeuristics._splitTickets) );
 
             // this is a bit ugly
             // we need it so that mongos blocks for the writes to actually be committed
@@ -387,9 +387,9 @@ namespace mongo {
                 _dataWritten = 0; // we're splitting, so should wait a bit
             }
 
-            bool shouldBalance = grid.shouldBalance( _manager->getns() );
+            bool shouldBalance = grid.shouldBalance( _lineage->getns() );
 
-            log() << "autosplitted " << _manager->getns() << " shard: " << toString()
+            log() << "autosplitted " << _lineage->getns() << " shard: " << toString()
                   << " on: " << splitPoint << " (splitThreshold " << splitThreshold << ")"
 #ifdef _DEBUG
                   << " size: " << getPhysicalSize() // slow - but can be useful when debugging
@@ -413,7 +413,7 @@ namespace mongo {
                     return true; // we did split even if we didn't migrate
                 }
 
-                ChunkManagerPtr cm = _manager->reload(false/*just reloaded in mulitsplit*/);
+                ChunkManagerPtr cm = _lineage->reload(false/*just reloaded in mulitsplit*/);
                 ChunkPtr toMove = cm->findIntersectingChunk(min);
 
                 if ( ! (toMove->getMin() == min && toMove->getMax() == max) ){
@@ -433,7 +433,7 @@ namespace mongo {
                                                 res ) );
                 
                 // update our config
-                _manager->reload();
+                _lineage->reload();
             }
 
             return true;
@@ -446,7 +446,7 @@ namespace mongo {
             _dataWritten = mkDataWritten();
 
             // if the collection lock is taken (e.g. we're migrating), it is fine for the split to fail.
-            warning() << "could not autosplit collection " << _manager->getns() << causedBy( e ) << endl;
+            warning() << "could not autosplit collection " << _lineage->getns() << causedBy( e ) << endl;
             return false;
         }
     }
@@ -456,8 +456,8 @@ namespace mongo {
 
         BSONObj result;
         uassert( 10169 ,  "datasize failed!" , conn->runCommand( "admin" ,
-                 BSON( "datasize" << _manager->getns()
-                       << "keyPattern" << _manager->getShardKey().key()
+                 BSON( "datasize" << _lineage->getns()
+                       << "keyPattern" << _lineage->getShardKey().key()
                        << "min" << getMin()
                        << "max" << getMax()
                        << "maxSize" << ( MaxChunkSize + 1 )
@@ -481,7 +481,7 @@ namespace mongo {
 
     void Chunk::serialize(BSONObjBuilder& to,ChunkVersion myLastMod) {
 
-        to.append( "_id" , genID( _manager->getns() , _min ) );
+        to.append( "_id" , genID( _lineage->getns() , _min ) );
 
         if ( myLastMod.isSet() ) {
             myLastMod.addToBSON(to, ChunkType::DEPRECATED_lastmod());
@@ -493,7 +493,7 @@ namespace mongo {
             verify(0);
         }
 
-        to << ChunkType::ns(_manager->getns());
+        to << ChunkType::ns(_lineage->getns());
         to << ChunkType::min(_min);
         to << ChunkType::max(_max);
         to << ChunkType::shard(_shard.getName());
@@ -514,7 +514,7 @@ namespace mongo {
 
     string Chunk::toString() const {
         stringstream ss;
-        ss << ChunkType::ns() << ":" << _manager->getns() <<
+        ss << ChunkType::ns() << ":" << _lineage->getns() <<
               ChunkType::shard()   << ": " << _shard.toString() <<
               ChunkType::DEPRECATED_lastmod() << ": " << _lastmod.toString() <<
               ChunkType::min()     << ": " << _min <<
@@ -523,7 +523,7 @@ namespace mongo {
     }
 
     ShardKeyPattern Chunk::skey() const {
-        return _manager->getShardKey();
+        return _lineage->getShardKey();
     }
 
     void Chunk::markAsJumbo() const {
@@ -590,6 +590,7 @@ namespace mongo {
         _ns( ns ),
         _key( pattern ),
         _unique( unique ),
+        _lineage( new ChunkManagerLineage( _ns, _key ) ),
         _chunkRanges(),
         _mutex("ChunkManager"),
         _sequenceNumber(++NextSequenceNumber)
@@ -609,6 +610,7 @@ namespace mongo {
                                                         collDoc[CollectionType::keyPattern()].Obj().getOwned() :
                                                         BSONObj()),
         _unique(collDoc[CollectionType::unique()].trueValue()),
+        _lineage( new ChunkManagerLineage( _ns, _key ) ),
         _chunkRanges(),
         _mutex("ChunkManager"),
         // The shard versioning mechanism hinges on keeping track of the number of times we reloaded ChunkManager's.
@@ -631,6 +633,7 @@ namespace mongo {
         _ns( oldManager->getns() ),
         _key( oldManager->getShardKey() ),
         _unique( oldManager->isUnique() ),
+        _lineage( oldManager->_lineage ),
         _chunkRanges(),
         _mutex("ChunkManager"),
         _sequenceNumber(++NextSequenceNumber)
@@ -649,9 +652,10 @@ namespace mongo {
             ChunkMap chunkMap;
             set<Shard> shards;
             ShardVersionMap shardVersions;
+            BoundList changed;
             Timer t;
 
-            bool success = _load( config, chunkMap, shards, shardVersions, _oldManager );
+            bool success = _load( config, chunkMap, shards, shardVersions, _oldManager, &changed );
 
             if( success ){
                 {
@@ -672,7 +676,17 @@ namespace mongo {
                     const_cast<ChunkMap&>(_chunkMap).swap(chunkMap);
                     const_cast<set<Shard>&>(_shards).swap(shards);
                     const_cast<ShardVersionMap&>(_shardVersions).swap(shardVersions);
-                    const_cast<ChunkRangeManager&>(_chunkRanges).reloadAll(_chunkMap);
+
+                    // Rebuild only the ranges which changed if we loaded from an older manager
+                    if ( _oldManager && _oldManager->getVersion().isSet() && ! _chunkMap.empty() ) {
+                        const_cast<ChunkRangeManager&>(_chunkRanges).reloadChanged(
+                                _oldManager->_chunkRanges, _chunkMap, changed );
+                    }
+                    else {
+                        const_cast<ChunkRangeManager&>(_chunkRanges).reloadAll(_chunkMap);
+                    }
+
+                    _lineage->setNumChunks( _chunkMap.size() );
 
                     // Once we load data, clear reference to old manager
                     _oldManager.reset();
@@ -702,9 +716,10 @@ namespace mongo {
      *
      * The mongos adapter here tracks all shards, and stores ranges by (max, Chunk) in the map.
      */
-    class CMConfigDiffTracker : public ConfigDiffTracker<ChunkPtr,Shard> {
+    class CMConfigDiffTracker : public ConfigDiffTracker<ChunkPtr,Shard,ChunkMap> {
     public:
-        CMConfigDiffTracker( ChunkManager* manager ) : _manager( manager ) {}
+        CMConfigDiffTracker( ChunkManager* manager, BoundList* changed ) :
+            _manager( manager ), _changed( changed ) {}
 
         virtual bool isTracked( const BSONObj& chunkDoc ) const {
             // Mongos tracks all shards
@@ -719,6 +734,7 @@ namespace mongo {
 
         virtual pair<BSONObj,ChunkPtr> rangeFor( const BSONObj& chunkDoc, const BSONObj& min, const BSONObj& max ) const {
             ChunkPtr c( new Chunk( _manager, chunkDoc ) );
+            _changed->push_back( make_pair( min, max ) );
             return make_pair( max, c );
         }
 
@@ -731,6 +747,7 @@ namespace mongo {
         }
 
         ChunkManager* _manager;
+        BoundList* _changed;
 
     };
 
@@ -738,7 +755,8 @@ namespace mongo {
                               ChunkMap& chunkMap,
                               set<Shard>& shards,
                               ShardVersionMap& shardVersions,
-                              ChunkManagerPtr oldManager)
+                              ChunkManagerPtr oldManager,
+                              BoundList* changed)
     {
 
         // Reset the max version, but not the epoch, when we aren't loading from the oldManager
@@ -754,35 +772,21 @@ namespace mongo {
             // Load a copy of the old versions
             shardVersions = oldManager->_shardVersions;
 
-            // Load a copy of the chunk map, replacing the chunk manager with our own
-            const ChunkMap& oldChunkMap = oldManager->getChunkMap();
-
-            // Could be v.expensive
-            // TODO: If chunks were immutable and didn't reference the manager, we could do more
-            // interesting things here
-            for( ChunkMap::const_iterator it = oldChunkMap.begin(); it != oldChunkMap.end(); it++ ){
-
-                ChunkPtr oldC = it->second;
-                ChunkPtr c( new Chunk( this, oldC->getMin(),
-                                             oldC->getMax(),
-                                             oldC->getShard(),
-                                             oldC->getLastmod() ) );
-
-                c->setBytesWritten( oldC->getBytesWritten() );
-
-                chunkMap.insert( make_pair( oldC->getMax(), c ) );
-            }
+            // Start from the old chunk map.  The chunks belong to our lineage rather than to the
+            // old manager, and the map is persistent, so this copies nothing but its root; the
+            // diff below then replaces only the chunks which changed.
+            chunkMap = oldManager->_chunkMap;
 
             // Also get any minor versions stored for reload
-            oldManager->getMarkedMinorVersions( minorVersions );
+            _lineage->getMarkedMinorVersions( minorVersions );
 
             LOG(2) << "loading chunk manager for collection " << _ns
                    << " using old chunk manager w/ version " << _version.toString()
-                   << " and " << oldChunkMap.size() << " chunks" << endl;
+                   << " and " << chunkMap.size() << " chunks" << endl;
         }
 
         // Attach a diff tracker for the versioned chunk data
-        CMConfigDiffTracker differ( this );
+        CMConfigDiffTracker differ( this, changed );
         differ.attach( _ns, chunkMap, _version, shardVersions );
 
         // Diff tracker should *always* find at least one chunk if collection exists
@@ -792,6 +796,9 @@ namespace mongo {
             LOG(2) << "loaded " << diffsApplied << " chunks into new chunk manager for " << _ns
                    << " with version " << _version << endl;
 
+            // The minor versions marked for reload are loaded now
+            _lineage->clearMarkedMinorVersions( minorVersions );
+
             // Add all the shards we find to the shards set
             for( ShardVersionMap::iterator it = shardVersions.begin(); it != shardVersions.end(); it++ ){
                 shards.insert( it->first );
@@ -840,18 +847,52 @@ namespace mongo {
     }
 
     ChunkManagerPtr ChunkManager::reload(bool force) const {
+        return _lineage->reload( force );
+    }
+
+    // -------  ChunkManagerLineage --------
+
+    ChunkManagerPtr ChunkManagerLineage::reload(bool force) const {
         return grid.getDBConfig(getns())->getChunkManager(getns(), force);
     }
 
-    void ChunkManager::markMinorForReload( ChunkVersion majorVersion ) const {
+    void ChunkManagerLineage::markMinorForReload( ChunkVersion majorVersion ) const {
         _splitHeuristics.markMinorForReload( getns(), majorVersion );
     }
 
-    void ChunkManager::getMarkedMinorVersions( set<ChunkVersion>& minorVersions ) const {
+    void ChunkManagerLineage::getMarkedMinorVersions( set<ChunkVersion>& minorVersions ) const {
         _splitHeuristics.getMarkedMinorVersions( minorVersions );
     }
 
-    void ChunkManager::SplitHeuristics::markMinorForReload( const string& ns, ChunkVersion majorVersion ) {
+    void ChunkManagerLineage::clearMarkedMinorVersions( const set<ChunkVersion>& minorVersions ) const {
+        _splitHeuristics.clearMarkedMinorVersions( minorVersions );
+    }
+
+    int ChunkManagerLineage::getCurrentDesiredChunkSize() const {
+        // split faster in early chunks helps spread out an initial load better
+        const int minChunkSize = 1 << 20;  // 1 MBytes
+
+        int splitThreshold = Chunk::MaxChunkSize;
+
+        int nc = _numChunks.get();
+
+        if ( nc <= 1 ) {
+            return 1024;
+        }
+        else if ( nc < 3 ) {
+            return minChunkSize / 2;
+        }
+        else if ( nc < 10 ) {
+            splitThreshold = max( splitThreshold / 4 , minChunkSize );
+        }
+        else if ( nc < 20 ) {
+            splitThreshold = max( splitThreshold / 2 , minChunkSize );
+        }
+
+        return splitThreshold;
+    }
+
+    void ChunkManagerLineage::SplitHeuristics::markMinorForReload( const string& ns, ChunkVersion majorVersion ) {
 
         // When we get a stale minor version, it means that some *other* mongos has just split a
         // chunk into a number of smaller parts, so we shouldn't need reload the data needed to
@@ -889,13 +930,22 @@ namespace mongo {
             grid.getDBConfig( ns )->getChunkManagerIfExists( ns, true, true );
     }
 
-    void ChunkManager::SplitHeuristics::getMarkedMinorVersions( set<ChunkVersion>& minorVersions ) {
+    void ChunkManagerLineage::SplitHeuristics::getMarkedMinorVersions( set<ChunkVersion>& minorVersions ) {
         scoped_lock lk( _staleMinorSetMutex );
         for( set<ChunkVersion>::iterator it = _staleMinorSet.begin(); it != _staleMinorSet.end(); it++ ){
             minorVersions.insert( *it );
         }
     }
 
+    void ChunkManagerLineage::SplitHeuristics::clearMarkedMinorVersions( const set<ChunkVersion>& minorVersions ) {
+        scoped_lock lk( _staleMinorSetMutex );
+        for( set<ChunkVersion>::const_iterator it = minorVersions.begin(); it != minorVersions.end(); it++ ){
+            _staleMinorSet.erase( *it );
+        }
+    }
+
+    // -------  ChunkManager --------
+
     bool ChunkManager::_isValid(const ChunkMap& chunkMap) {
 #define ENSURE(x) do { if(!(x)) { log() << "ChunkManager::_isValid failed: " #x << endl; return false; } } while(0)
 
@@ -1119,13 +1169,21 @@ namespace mongo {
             
             if ( frsp->matchPossibleForSingleKeyFRS( _key.key() ) ) {
                 BoundList ranges = _key.keyBounds( frsp->getSingleKeyFRS() );
-                for ( BoundList::const_iterator it=ranges.begin(); it != ranges.end(); ++it ){
-
-                    getShardsForRange( shards, it->first /*min*/, it->second /*max*/ );
 
-                    // once we know we need to visit all shards no need to keep looping
-                    if( shards.size() == _shards.size() ) return;
+                // an equality or $in on every shard key field bounds the query to single points
+                vector<BSONObj> points;
+                for ( BoundList::const_iterator i = ranges.begin(); i != ranges.end(); ++i ) {
+                    if ( i->first.woCompare( i->second ) != 0 )
+                        break;
+                    points.push_back( i->first );
                 }
+                if ( points.size() == ranges.size() )
+                    getShardsForPoints( shards, points );
+                else
+                    getShardsForRanges( shards, ranges );
+
+                // once we know we need to visit all shards no need to keep looping
+                if( shards.size() == _shards.size() ) return;
             }
 
             if (!org.orRangesExhausted())
@@ -1146,20 +1204,25 @@ namespace mongo {
     void ChunkManager::getShardsForRange( set<Shard>& shards,
                                           const BSONObj& min,
                                           const BSONObj& max ) const {
+        getShardsForRanges( shards, BoundList( 1, make_pair( min, max ) ) );
+    }
 
-        ChunkRangeMap::const_iterator it = _chunkRanges.upper_bound(min);
-        ChunkRangeMap::const_iterator end = _chunkRanges.upper_bound(max);
-
-        massert( 13507 , str::stream() << "no chunks found between bounds " << min << " and " << max , it != _chunkRanges.ranges().end() );
+    void ChunkManager::getShardsForRanges( set<Shard>& shards, const BoundList& ranges ) const {
+        set<int> shardIds;
+        boost::shared_ptr<const ChunkRoutingTable> routing = _chunkRanges.routingTable();
+        routing->index.findShardsForRanges( ranges, &shardIds, _shards.size() );
 
-        if( end != _chunkRanges.ranges().end() ) ++end;
+        for ( set<int>::const_iterator i = shardIds.begin(); i != shardIds.end(); ++i )
+            shards.insert( routing->shards[*i] );
+    }
 
-        for( ; it != end; ++it ){
-            shards.insert(it->second->getShard());
+    void ChunkManager::getShardsForPoints( set<Shard>& shards, const vector<BSONObj>& points ) const {
+        set<int> shardIds;
+        boost::shared_ptr<const ChunkRoutingTable> routing = _chunkRanges.routingTable();
+        routing->index.findShardsForPoints( points, &shardIds, _shards.size() );
 
-            // once we know we need to visit all shards no need to keep looping
-            if (shards.size() == _shards.size()) break;
-        }
+        for ( set<int>::const_iterator i = shardIds.begin(); i != shardIds.end(); ++i )
+            shards.insert( routing->shards[*i] );
     }
 
     void ChunkManager::getAllShards( set<Shard>& all ) const {
@@ -1303,7 +1366,7 @@ namespace mongo {
         return ss.str();
     }
 
-    void ChunkRangeManager::assertValid() const {
+    void ChunkRangeManager::assertValid(const ChunkMap& chunks) const {
         if (_ranges.empty())
             return;
 
@@ -1317,10 +1380,11 @@ namespace mongo {
             verify(allOfType(MinKey, _ranges.begin()->second->getMin()));
             verify(allOfType(MaxKey, boost::prior(_ranges.end())->second->getMax()));
 
-            // Make sure there are no gaps or overlaps
+            // Make sure there are no gaps or overlaps, and that neighbours are on different shards
             for (ChunkRangeMap::const_iterator it=boost::next(_ranges.begin()), end=_ranges.end(); it != end; ++it) {
                 ChunkRangeMap::const_iterator last = boost::prior(it);
                 verify(it->second->getMin() == last->second->getMax());
+                verify(it->second->getShard() != last->second->getShard());
             }
 
             // Check Map keys
@@ -1328,8 +1392,18 @@ namespace mongo {
                 verify(it->first == it->second->getMax());
             }
 
+            // The routing index has the same ranges
+            {
+                boost::shared_ptr<const ChunkRoutingTable> routing = routingTable();
+                verify(routing->index.numRanges() == _ranges.size());
+                size_t i = 0;
+                for (ChunkRangeMap::const_iterator it=_ranges.begin(), end=_ranges.end(); it != end; ++it, ++i) {
+                    verify(routing->index.maxAt(i) == it->first);
+                    verify(routing->shards[routing->index.shardAt(i)] == it->second->getShard());
+                }
+            }
+
             // Make sure we match the original chunks
-            const ChunkMap chunks = _ranges.begin()->second->getManager()->_chunkMap;
             for ( ChunkMap::const_iterator i=chunks.begin(); i!=chunks.end(); ++i ) {
                 const ChunkPtr chunk = i->second;
 
@@ -1358,8 +1432,118 @@ namespace mongo {
     void ChunkRangeManager::reloadAll(const ChunkMap& chunks) {
         _ranges.clear();
         _insertRange(chunks.begin(), chunks.end());
+        _setRoutingTable(boost::shared_ptr<const ChunkRoutingTable>());
+
+        DEV assertValid(chunks);
+    }
+
+    static bool boundMinLess(const pair<BSONObj,BSONObj>& a, const pair<BSONObj,BSONObj>& b) {
+        return a.first.woCompare(b.first) < 0;
+    }
+
+    void ChunkRangeManager::reloadChanged(const ChunkRangeManager& old,
+                                          const ChunkMap& chunks,
+                                          const BoundList& changed) {
+        if (old._ranges.empty()) {
+            reloadAll(chunks);
+            return;
+        }
+
+        // Widen each changed bound to the ranges of old it touches, plus the range on either side,
+        // so that the ranges rebuilt can merge with their neighbours.  Widened bounds which
+        // overlap are joined, after which none starts or ends inside a changed chunk.
+        BoundList regions;
+        for (BoundList::const_iterator it = changed.begin(); it != changed.end(); ++it) {
+            ChunkRangeMap::const_iterator first = old._ranges.upper_bound(it->first);
+            ChunkRangeMap::const_iterator last = old._ranges.lower_bound(it->second);
+            verify(first != old._ranges.end());
+            verify(last != old._ranges.end());
+
+            if (first != old._ranges.begin())
+                --first;
+            ChunkRangeMap::const_iterator next = boost::next(last);
+            if (next != old._ranges.end())
+                last = next;
+
+            regions.push_back(make_pair(first->second->getMin(), last->second->getMax()));
+        }
+        sort(regions.begin(), regions.end(), boundMinLess);
+
+        BoundList joined;
+        for (BoundList::const_iterator it = regions.begin(); it != regions.end(); ++it) {
+            if (!joined.empty() && it->first.woCompare(joined.back().second) <= 0) {
+                if (it->second.woCompare(joined.back().second) > 0)
+                    joined.back().second = it->second;
+                continue;
+            }
+            joined.push_back(*it);
+        }
+
+        // Starts as a copy of the old ranges, sharing all but those replaced below.  Splits and
+        // moves which leave every range where it was (all splits do) keep old's routing table.
+        _ranges = old._ranges;
+        bool sameRanges = true;
+        for (BoundList::const_iterator it = joined.begin(); it != joined.end(); ++it) {
+            ChunkRangeMap::const_iterator first = _ranges.upper_bound(it->first);
+            ChunkRangeMap::const_iterator last = _ranges.upper_bound(it->second);
+            vector< pair<BSONObj,Shard> > before;
+            for (ChunkRangeMap::const_iterator r = first; r != last; ++r)
+                before.push_back(make_pair(r->first, r->second->getShard()));
+
+            _ranges.erase(first, last);
+            _insertRange(chunks.upper_bound(it->first), chunks.upper_bound(it->second));
+
+            size_t i = 0;
+            for (ChunkRangeMap::const_iterator r = _ranges.upper_bound(it->first),
+                     end = _ranges.upper_bound(it->second);
+                 sameRanges && r != end; ++r, ++i) {
+                sameRanges = i < before.size() && before[i].first == r->first &&
+                             before[i].second == r->second->getShard();
+            }
+            sameRanges = sameRanges && i == before.size();
+        }
+
+        {
+            scoped_lock lk(old._routingMutex);
+            _setRoutingTable(sameRanges ? old._routing
+                                        : boost::shared_ptr<const ChunkRoutingTable>());
+        }
+
+        LOG(2) << "rebuilt " << joined.size() << " chunk ranges around " << changed.size()
+               << " changed chunks, of " << _ranges.size() << " ranges"
+               << (sameRanges ? ", routing unchanged" : "") << endl;
+
+        DEV assertValid(chunks);
+    }
+
+    boost::shared_ptr<const ChunkRoutingTable> ChunkRangeManager::routingTable() const {
+        scoped_lock lk(_routingMutex);
+        if (_routing)
+            return _routing;
+
+        boost::shared_ptr<ChunkRoutingTable> table(new ChunkRoutingTable());
+        map<Shard,int> shardIds;
+
+        vector< pair<BSONObj,int> > bounds;
+        bounds.reserve( _ranges.size() );
+        for (ChunkRangeMap::const_iterator it=_ranges.begin(), end=_ranges.end(); it != end; ++it) {
+            const Shard& shard = it->second->getShard();
+            map<Shard,int>::const_iterator id = shardIds.find( shard );
+            if ( id == shardIds.end() ) {
+                id = shardIds.insert( make_pair( shard, (int)table->shards.size() ) ).first;
+                table->shards.push_back( shard );
+            }
+            bounds.push_back( make_pair( it->first, id->second ) );
+        }
+        table->index.reload( bounds );
 
-        DEV assertValid();
+        _routing = table;
+        return _routing;
+    }
+
+    void ChunkRangeManager::_setRoutingTable(const boost::shared_ptr<const ChunkRoutingTable>& table) {
+        scoped_lock lk(_routingMutex);
+        _routing = table;
     }
 
     void ChunkRangeManager::_insertRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end) {
@@ -1370,37 +1554,14 @@ namespace mongo {
                 ++begin;
 
             shared_ptr<ChunkRange> cr (new ChunkRange(first, begin));
-            _ranges[cr->getMax()] = cr;
-        }
-    }
-
-    int ChunkManager::getCurrentDesiredChunkSize() const {
-        // split faster in early chunks helps spread out an initial load better
-        const int minChunkSize = 1 << 20;  // 1 MBytes
-
-        int splitThreshold = Chunk::MaxChunkSize;
-
-        int nc = numChunks();
-
-        if ( nc <= 1 ) {
-            return 1024;
-        }
-        else if ( nc < 3 ) {
-            return minChunkSize / 2;
-        }
-        else if ( nc < 10 ) {
-            splitThreshold = max( splitThreshold / 4 , minChunkSize );
-        }
-        else if ( nc < 20 ) {
-            splitThreshold = max( splitThreshold / 2 , minChunkSize );
+            _ranges.insert(make_pair(cr->getMax(), cr));
         }
-
-        return splitThreshold;
     }
     
     /** This is for testing only, just setting up minimal basic defaults. */
     ChunkManager::ChunkManager() :
     _unique(),
+    _lineage( new ChunkManagerLineage( _ns, _key ) ),
     _chunkRanges(),
     _mutex( "ChunkManager" ),
     _sequenceNumber()
@@ -20,10 +20,12 @@
 
 #include "mongo/bson/util/atomic_int.h"
 #include "mongo/client/distlock.h"
+#include "mongo/s/chunk_routing_index.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/shard.h"
 #include "mongo/s/shardkey.h"
 #include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/persistent_map.h"
 
 namespace mongo {
 
@@ -36,11 +38,96 @@ namespace mongo {
     typedef shared_ptr<const Chunk> ChunkPtr;
 
     // key is max for each Chunk or ChunkRange
-    typedef map<BSONObj,ChunkPtr,BSONObjCmp> ChunkMap;
-    typedef map<BSONObj,shared_ptr<ChunkRange>,BSONObjCmp> ChunkRangeMap;
+    // Both are persistent, so a reloaded ChunkManager shares whatever didn't change with the
+    // manager it was loaded from.
+    typedef PersistentMap<BSONObj,ChunkPtr,BSONObjCmp> ChunkMap;
+    typedef PersistentMap<BSONObj,shared_ptr<ChunkRange>,BSONObjCmp> ChunkRangeMap;
 
     typedef shared_ptr<const ChunkManager> ChunkManagerPtr;
 
+    /**
+     * What the successive ChunkManagers of a sharded collection have in common.
+     *
+     * A reloaded manager takes over the unchanged chunks of the manager it was loaded from, so a
+     * chunk refers to this rather than to any one manager, which may be gone while the chunk is
+     * still in use.
+     */
+    class ChunkManagerLineage : boost::noncopyable {
+    public:
+        ChunkManagerLineage( const string& ns, const ShardKeyPattern& key ) :
+            _ns( ns ), _key( key ) {}
+
+        const string& getns() const { return _ns; }
+        const ShardKeyPattern& getShardKey() const { return _key; }
+
+        /** records the number of chunks of the newest manager loaded */
+        void setNumChunks( int numChunks ) const { _numChunks.set( numChunks ); }
+
+        int getCurrentDesiredChunkSize() const;
+
+        ChunkManagerPtr reload( bool force = true ) const; // doesn't modify self!
+
+        void markMinorForReload( ChunkVersion majorVersion ) const;
+        void getMarkedMinorVersions( set<ChunkVersion>& minorVersions ) const;
+
+        /** forgets minorVersions once a reload has loaded them */
+        void clearMarkedMinorVersions( const set<ChunkVersion>& minorVersions ) const;
+
+        //
+        // Split Heuristic info
+        //
+
+
+        class SplitHeuristics {
+        public:
+
+            SplitHeuristics() :
+                _splitTickets( maxParallelSplits ),
+                _staleMinorSetMutex( "SplitHeuristics::staleMinorSet" ),
+                _staleMinorCount( 0 ) {}
+
+            void markMinorForReload( const string& ns, ChunkVersion majorVersion );
+            void getMarkedMinorVersions( set<ChunkVersion>& minorVersions );
+            void clearMarkedMinorVersions( const set<ChunkVersion>& minorVersions );
+
+            TicketHolder _splitTickets;
+
+            mutex _staleMinorSetMutex;
+
+            // mutex protects below
+            int _staleMinorCount;
+            set<ChunkVersion> _staleMinorSet;
+
+            // Test whether we should split once data * splitTestFactor > chunkSize (approximately)
+            static const int splitTestFactor = 5;
+            // Maximum number of parallel threads requesting a split
+            static const int maxParallelSplits = 5;
+
+            // The idea here is that we're over-aggressive on split testing by a factor of
+            // splitTestFactor, so we can safely wait until we get to splitTestFactor invalid splits
+            // before changing.  Unfortunately, we also potentially over-request the splits by a
+            // factor of maxParallelSplits, but since the factors are identical it works out
+            // (for now) for parallel or sequential oversplitting.
+            // TODO: Make splitting a separate thread with notifications?
+            static const int staleMinorReloadThreshold = maxParallelSplits;
+
+        };
+
+        mutable SplitHeuristics _splitHeuristics;
+
+        //
+        // End split heuristics
+        //
+
+    private:
+        const string _ns;
+        const ShardKeyPattern _key;
+
+        mutable AtomicUInt _numChunks;
+    };
+
+    typedef shared_ptr<const ChunkManagerLineage> ChunkManagerLineagePtr;
+
     /**
        config.chunks
        { ns : "alleyinsider.fs.chunks" , min : {} , max : {} , server : "localhost:30001" }
@@ -211,14 +298,14 @@ namespace mongo {
 
         string getns() const;
         Shard getShard() const { return _shard; }
-        const ChunkManager* getManager() const { return _manager; }
+        const ChunkManagerLineage* getLineage() const { return _lineage.get(); }
         
 
     private:
 
         // main shard info
         
-        const ChunkManager * _manager;
+        const ChunkManagerLineagePtr _lineage;
 
         BSONObj _min;
         BSONObj _max;
@@ -251,7 +338,6 @@ namespace mongo {
 
     class ChunkRange {
     public:
-        const ChunkManager* getManager() const { return _manager; }
         Shard getShard() const { return _shard; }
 
         const BSONObj& getMin() const { return _min; }
@@ -266,14 +352,14 @@ namespace mongo {
         bool containsPoint( const BSONObj& point ) const;
 
         ChunkRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end)
-            : _manager(begin->second->getManager())
+            : _lineage(begin->second->getLineage())
             , _shard(begin->second->getShard())
             , _min(begin->second->getMin())
             , _max(boost::prior(end)->second->getMax()) {
             verify( begin != end );
 
             DEV while (begin != end) {
-                verify(begin->second->getManager() == _manager);
+                verify(begin->second->getLineage() == _lineage);
                 verify(begin->second->getShard() == _shard);
                 ++begin;
             }
@@ -281,12 +367,12 @@ namespace mongo {
 
         // Merge min and max (must be adjacent ranges)
         ChunkRange(const ChunkRange& min, const ChunkRange& max)
-            : _manager(min.getManager())
+            : _lineage(min._lineage)
             , _shard(min.getShard())
             , _min(min.getMin())
             , _max(max.getMax()) {
             verify(min.getShard() == max.getShard());
-            verify(min.getManager() == max.getManager());
+            verify(min._lineage == max._lineage);
             verify(min.getMax() == max.getMin());
         }
 
@@ -295,23 +381,48 @@ namespace mongo {
         }
 
     private:
-        const ChunkManager* _manager;
+        const ChunkManagerLineage* _lineage; // only to check all the chunks are of one collection
         const Shard _shard;
         const BSONObj _min;
         const BSONObj _max;
     };
 
 
+    /** a ChunkRangeManager's ranges flattened for routing, with the shards its ids stand for */
+    struct ChunkRoutingTable {
+        ChunkRoutingIndex index;
+        vector<Shard> shards;
+    };
+
     class ChunkRangeManager {
     public:
+        ChunkRangeManager() : _routingMutex( "ChunkRangeManager::routing" ) { }
+
         const ChunkRangeMap& ranges() const { return _ranges; }
 
-        void clear() { _ranges.clear(); }
+        /**
+         * The ranges again, flattened for routing.  Built on first use rather than on each
+         * reload, and shared with the managers reloaded from this one while the ranges stay the
+         * same, as they do when chunks are only split.
+         */
+        boost::shared_ptr<const ChunkRoutingTable> routingTable() const;
+
+        void clear() { _ranges.clear(); _setRoutingTable( boost::shared_ptr<const ChunkRoutingTable>() ); }
 
         void reloadAll(const ChunkMap& chunks);
 
+        /**
+         * Loads the ranges of chunks, starting from those of old, which were loaded from an older
+         * version of chunks.  Only the ranges around changed are rebuilt.
+         *
+         * @param changed the [min, max) bounds of the chunks added to chunks since old was loaded
+         */
+        void reloadChanged(const ChunkRangeManager& old,
+                           const ChunkMap& chunks,
+                           const BoundList& changed);
+
         // Slow operation -- wrap with DEV
-        void assertValid() const;
+        void assertValid(const ChunkMap& chunks) const;
 
         ChunkRangeMap::const_iterator upper_bound(const BSONObj& o) const { return _ranges.upper_bound(o); }
         ChunkRangeMap::const_iterator lower_bound(const BSONObj& o) const { return _ranges.lower_bound(o); }
@@ -320,7 +431,12 @@ namespace mongo {
         // assumes nothing in this range exists in _ranges
         void _insertRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end);
 
+        void _setRoutingTable( const boost::shared_ptr<const ChunkRoutingTable>& table );
+
         ChunkRangeMap _ranges;
+
+        mutable mutex _routingMutex; // protects _routing
+        mutable boost::shared_ptr<const ChunkRoutingTable> _routing; // null until first used
     };
 
     /* config.sharding
@@ -409,7 +525,21 @@ namespace mongo {
         /** @param shards set to the shards covered by the interval [min, max], see SERVER-4791 */
         void getShardsForRange( set<Shard>& shards, const BSONObj& min, const BSONObj& max ) const;
 
+        /**
+         * @param shards set to the shards covered by any of the intervals [min, max] in ranges,
+         *     which are fastest to look up in ascending order
+         */
+        void getShardsForRanges( set<Shard>& shards, const BoundList& ranges ) const;
+
+        /**
+         * @param points shard key values, as from ShardKeyPattern::extractKey(), fastest to look
+         *     up in ascending order
+         * @param shards set to the shards owning any of points
+         */
+        void getShardsForPoints( set<Shard>& shards, const vector<BSONObj>& points ) const;
+
         ChunkMap getChunkMap() const { return _chunkMap; }
+        const ChunkRangeManager& getChunkRanges() const { return _chunkRanges; }
 
         /**
          * Returns true if, for this shard, the chunks are identical in both chunk managers
@@ -434,20 +564,17 @@ namespace mongo {
 
         void _printChunks() const;
 
-        int getCurrentDesiredChunkSize() const;
-
         ChunkManagerPtr reload(bool force=true) const; // doesn't modify self!
 
-        void markMinorForReload( ChunkVersion majorVersion ) const;
-        void getMarkedMinorVersions( set<ChunkVersion>& minorVersions ) const;
-
     private:
 
         // helpers for loading
 
         // returns true if load was consistent
+        // changed is set to the bounds of the chunks added to those of oldManager
         bool _load( const string& config, ChunkMap& chunks, set<Shard>& shards,
-                                    ShardVersionMap& shardVersions, ChunkManagerPtr oldManager);
+                                    ShardVersionMap& shardVersions, ChunkManagerPtr oldManager,
+                                    BoundList* changed );
         static bool _isValid(const ChunkMap& chunks);
 
         // end helpers
@@ -457,6 +584,9 @@ namespace mongo {
         const ShardKeyPattern _key;
         const bool _unique;
 
+        // shared with the managers this was loaded from, and with all their chunks
+        const ChunkManagerLineagePtr _lineage;
+
         const ChunkMap _chunkMap;
         const ChunkRangeManager _chunkRanges;
 
@@ -475,53 +605,7 @@ namespace mongo {
 
         const unsigned long long _sequenceNumber;
 
-        //
-        // Split Heuristic info
-        //
-
-
-        class SplitHeuristics {
-        public:
-
-            SplitHeuristics() :
-                _splitTickets( maxParallelSplits ),
-                _staleMinorSetMutex( "SplitHeuristics::staleMinorSet" ),
-                _staleMinorCount( 0 ) {}
-
-            void markMinorForReload( const string& ns, ChunkVersion majorVersion );
-            void getMarkedMinorVersions( set<ChunkVersion>& minorVersions );
-
-            TicketHolder _splitTickets;
-
-            mutex _staleMinorSetMutex;
-
-            // mutex protects below
-            int _staleMinorCount;
-            set<ChunkVersion> _staleMinorSet;
-
-            // Test whether we should split once data * splitTestFactor > chunkSize (approximately)
-            static const int splitTestFactor = 5;
-            // Maximum number of parallel threads requesting a split
-            static const int maxParallelSplits = 5;
-
-            // The idea here is that we're over-aggressive on split testing by a factor of
-            // splitTestFactor, so we can safely wait until we get to splitTestFactor invalid splits
-            // before changing.  Unfortunately, we also potentially over-request the splits by a
-            // factor of maxParallelSplits, but since the factors are identical it works out
-            // (for now) for parallel or sequential oversplitting.
-            // TODO: Make splitting a separate thread with notifications?
-            static const int staleMinorReloadThreshold = maxParallelSplits;
-
-        };
-
-        mutable SplitHeuristics _splitHeuristics;
-
-        //
-        // End split heuristics
-        //
-
         friend class Chunk;
-        friend class ChunkRangeManager; // only needed for CRM::assertValid()
         static AtomicUInt NextSequenceNumber;
         
         /** Just for testing */
@@ -561,7 +645,7 @@ namespace mongo {
         Chunk _c;
     };
     */
-    inline string Chunk::genID() const { return genID(_manager->getns(), _min); }
+    inline string Chunk::genID() const { return genID(_lineage->getns(), _min); }
 
     bool setShardVersion( DBClientBase & conn,
                           const string& ns,
@@ -37,8 +37,13 @@ namespace mongo {
      * implementation, because the logic is identical, or the chunk data, because that would be
      * slow for big clusters, so this is the alternative for now.
      * TODO: Standardize between mongos and mongod and convert template parameters to types.
+     *
+     * RangeMapType may be any map with the lookups and erase() of a std::map, such as the
+     * PersistentMap mongos keeps its chunks in.
      */
-    template < class ValType, class ShardType >
+    template < class ValType,
+               class ShardType,
+               class RangeMapType = std::map<BSONObj, ValType, BSONObjCmp> >
     class ConfigDiffTracker {
     public:
 
@@ -47,7 +52,7 @@ namespace mongo {
         //
 
         // RangeMap stores ranges indexed by max or  min key
-        typedef typename std::map<BSONObj, ValType, BSONObjCmp> RangeMap;
+        typedef RangeMapType RangeMap;
 
         // RangeOverlap is a pair of iterators defining a subset of ranges
         typedef typename std::pair< typename RangeMap::iterator, typename RangeMap::iterator> RangeOverlap;
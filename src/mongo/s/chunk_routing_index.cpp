@@ -0,0 +1,145 @@
+// @file chunk_routing_index.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/s/chunk_routing_index.h"
+
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    namespace str = mongoutils::str;
+
+    void ChunkRoutingIndex::reload( const std::vector< std::pair<BSONObj,int> >& ranges ) {
+        clear();
+
+        size_t totalSize = 0;
+        for ( size_t i = 0; i < ranges.size(); i++ )
+            totalSize += ranges[i].first.objsize();
+        _keyData.reserve( totalSize );
+        _keyOffsets.reserve( ranges.size() );
+        _shards.reserve( ranges.size() );
+
+        for ( size_t i = 0; i < ranges.size(); i++ ) {
+            const BSONObj& max = ranges[i].first;
+            const int shard = ranges[i].second;
+
+            if ( ! _shards.empty() && _shards.back() == shard ) {
+                // extend the previous range over this one
+                _keyData.resize( _keyOffsets.back() );
+            }
+            else {
+                _keyOffsets.push_back( _keyData.size() );
+                _shards.push_back( shard );
+            }
+            _keyData.insert( _keyData.end(), max.objdata(), max.objdata() + max.objsize() );
+        }
+    }
+
+    void ChunkRoutingIndex::clear() {
+        _keyData.clear();
+        _keyOffsets.clear();
+        _shards.clear();
+    }
+
+    size_t ChunkRoutingIndex::_upperBound( const BSONObj& point, size_t from ) const {
+        const size_t n = _shards.size();
+
+        // gallop forward from 'from' until a max greater than the point brackets the answer,
+        // so nearby points cost about the log of the distance between them
+        size_t lo = from;
+        size_t hi = from;
+        size_t step = 1;
+        while ( hi < n && maxAt( hi ).woCompare( point ) <= 0 ) {
+            lo = hi + 1;
+            hi = lo + step;
+            step *= 2;
+        }
+        if ( hi > n )
+            hi = n;
+
+        // the answer is in [lo, hi]
+        while ( lo < hi ) {
+            size_t mid = lo + ( hi - lo ) / 2;
+            if ( maxAt( mid ).woCompare( point ) <= 0 )
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    int ChunkRoutingIndex::findShard( const BSONObj& point ) const {
+        size_t i = _upperBound( point, 0 );
+        if ( i == _shards.size() )
+            return -1;
+        return _shards[i];
+    }
+
+    void ChunkRoutingIndex::findShardsForPoints( const std::vector<BSONObj>& points,
+                                                 std::set<int>* shards,
+                                                 size_t maxShards ) const {
+        size_t from = 0;
+        for ( size_t i = 0; i < points.size(); i++ ) {
+            if ( i > 0 && points[i].woCompare( points[i - 1] ) < 0 )
+                from = 0; // out of order, start over
+
+            size_t range = _upperBound( points[i], from );
+            if ( range == _shards.size() ) {
+                from = 0;
+                continue;
+            }
+
+            shards->insert( _shards[range] );
+            if ( shards->size() >= maxShards )
+                return;
+            from = range;
+        }
+    }
+
+    void ChunkRoutingIndex::findShardsForRanges( const BoundList& bounds,
+                                                 std::set<int>* shards,
+                                                 size_t maxShards ) const {
+        size_t from = 0;
+        for ( size_t i = 0; i < bounds.size(); i++ ) {
+            const BSONObj& min = bounds[i].first;
+            const BSONObj& max = bounds[i].second;
+
+            if ( i > 0 && min.woCompare( bounds[i - 1].first ) < 0 )
+                from = 0; // out of order, start over
+
+            size_t first = _upperBound( min, from );
+            massert( 13507 ,
+                     str::stream() << "no chunks found between bounds " << min << " and " << max ,
+                     first != _shards.size() );
+
+            // the range containing max is included, as the interval is closed
+            size_t last = _upperBound( max, first );
+            if ( last == _shards.size() )
+                --last;
+
+            for ( size_t range = first; range <= last; ++range ) {
+                shards->insert( _shards[range] );
+                if ( shards->size() >= maxShards )
+                    return;
+            }
+            from = first;
+        }
+    }
+
+}
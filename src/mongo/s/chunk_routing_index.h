@@ -0,0 +1,102 @@
+// @file chunk_routing_index.h
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * A read-only map from shard key values to the shards that own them, for routing queries.
+     *
+     * The key space is split into contiguous ranges, each owned by one shard.  Shards are
+     * identified by small integers which the caller maps back to a Shard.  The upper bounds of the
+     * ranges are stored back to back in one buffer, next to a parallel array of shard ids, so a
+     * lookup is a binary search over flat memory instead of a walk down a tree of separately
+     * allocated nodes.  Adjacent ranges owned by the same shard are merged when loading.
+     *
+     * Bounds compare like the keys of a ChunkMap: a point belongs to the first range whose max is
+     * greater than the point.
+     *
+     * Lookups of many points or ranges at once are faster when they come in ascending order, as
+     * each search then starts where the previous one ended.
+     */
+    class ChunkRoutingIndex {
+    public:
+        typedef std::vector< std::pair<BSONObj,BSONObj> > BoundList;
+
+        ChunkRoutingIndex() {}
+
+        /**
+         * Replaces the contents of the index.
+         *
+         * @param ranges (max, shard id) of contiguous ranges in ascending order, the last max
+         *     being the global max of the key space
+         */
+        void reload( const std::vector< std::pair<BSONObj,int> >& ranges );
+
+        void clear();
+
+        bool empty() const { return _shards.empty(); }
+
+        /** @return the number of ranges, after merging adjacent ranges of the same shard */
+        size_t numRanges() const { return _shards.size(); }
+
+        int shardAt( size_t i ) const { return _shards[i]; }
+        BSONObj maxAt( size_t i ) const { return BSONObj( &_keyData[_keyOffsets[i]] ); }
+
+        /** @return the id of the shard whose range contains point, or -1 if there is none */
+        int findShard( const BSONObj& point ) const;
+
+        /**
+         * Adds to shards the ids of the shards owning any of points.
+         *
+         * @param maxShards stop looking once this many shards have been found
+         */
+        void findShardsForPoints( const std::vector<BSONObj>& points,
+                                  std::set<int>* shards,
+                                  size_t maxShards ) const;
+
+        /**
+         * Adds to shards the ids of the shards owning any part of the closed intervals
+         * [min, max] of bounds.
+         *
+         * @param maxShards stop looking once this many shards have been found
+         */
+        void findShardsForRanges( const BoundList& bounds,
+                                  std::set<int>* shards,
+                                  size_t maxShards ) const;
+
+    private:
+        /**
+         * @return the first range at or after from whose max is greater than point, or
+         *     numRanges() if there is none.  The ranges before from must not contain point.
+         */
+        size_t _upperBound( const BSONObj& point, size_t from ) const;
+
+        std::vector<char> _keyData; // the max bound of each range, as consecutive BSON objects
+        std::vector<size_t> _keyOffsets; // where each range's max starts in _keyData
+        std::vector<int> _shards; // the shard id of each range
+    };
+
+}
@@ -0,0 +1,178 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/random.h"
+#include "mongo/s/chunk_routing_index.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using mongo::BSONObj;
+    using mongo::BSONObjCmp;
+    using mongo::ChunkRoutingIndex;
+    using mongo::MAXKEY;
+    using mongo::MINKEY;
+    using mongo::PseudoRandom;
+    using std::make_pair;
+    using std::map;
+    using std::pair;
+    using std::set;
+    using std::vector;
+
+    typedef map<BSONObj,int,BSONObjCmp> RangeMap; // max -> shard, the way ChunkRangeMap is kept
+
+    BSONObj key( int x ) { return BSON( "x" << x ); }
+
+    // a random int in [0, max)
+    int nextInt( PseudoRandom& random, int max ) { return ( random.nextInt32() & 0x7fffffff ) % max; }
+
+    // the shards of the ranges covering [min, max], found by walking the map
+    set<int> shardsForRange( const RangeMap& ranges, const BSONObj& min, const BSONObj& max ) {
+        set<int> shards;
+        RangeMap::const_iterator it = ranges.upper_bound( min );
+        RangeMap::const_iterator end = ranges.upper_bound( max );
+        if ( end != ranges.end() ) ++end;
+        for ( ; it != end; ++it )
+            shards.insert( it->second );
+        return shards;
+    }
+
+    // numRanges ranges of width 10 over x, each on a random one of numShards shards
+    void makeRanges( int numRanges, int numShards, RangeMap* map, ChunkRoutingIndex* index ) {
+        PseudoRandom random( 1234 );
+        vector< pair<BSONObj,int> > bounds;
+        for ( int i = 1; i <= numRanges; i++ ) {
+            BSONObj max = i == numRanges ? BSON( "x" << MAXKEY ) : key( i * 10 );
+            int shard = nextInt( random, numShards );
+            bounds.push_back( make_pair( max, shard ) );
+            (*map)[max] = shard;
+        }
+        index->reload( bounds );
+    }
+
+    TEST(ChunkRoutingIndex, Empty) {
+        ChunkRoutingIndex index;
+        ASSERT( index.empty() );
+        ASSERT_EQUALS( -1, index.findShard( key( 5 ) ) );
+    }
+
+    TEST(ChunkRoutingIndex, FindShard) {
+        vector< pair<BSONObj,int> > bounds;
+        bounds.push_back( make_pair( key( 10 ), 0 ) );
+        bounds.push_back( make_pair( key( 20 ), 0 ) );
+        bounds.push_back( make_pair( key( 30 ), 1 ) );
+        bounds.push_back( make_pair( BSON( "x" << MAXKEY ), 2 ) );
+
+        ChunkRoutingIndex index;
+        index.reload( bounds );
+
+        // the first two ranges are merged
+        ASSERT_EQUALS( 3U, index.numRanges() );
+        ASSERT_EQUALS( key( 20 ), index.maxAt( 0 ) );
+        ASSERT_EQUALS( 1, index.shardAt( 1 ) );
+
+        ASSERT_EQUALS( 0, index.findShard( BSON( "x" << MINKEY ) ) );
+        ASSERT_EQUALS( 0, index.findShard( key( 10 ) ) );
+        ASSERT_EQUALS( 1, index.findShard( key( 20 ) ) );
+        ASSERT_EQUALS( 1, index.findShard( key( 29 ) ) );
+        ASSERT_EQUALS( 2, index.findShard( key( 30 ) ) );
+        ASSERT_EQUALS( -1, index.findShard( BSON( "x" << MAXKEY ) ) );
+    }
+
+    TEST(ChunkRoutingIndex, FindShardsForRanges) {
+        vector< pair<BSONObj,int> > bounds;
+        bounds.push_back( make_pair( key( 10 ), 0 ) );
+        bounds.push_back( make_pair( key( 20 ), 1 ) );
+        bounds.push_back( make_pair( key( 30 ), 2 ) );
+        bounds.push_back( make_pair( BSON( "x" << MAXKEY ), 3 ) );
+
+        ChunkRoutingIndex index;
+        index.reload( bounds );
+
+        set<int> shards;
+        ChunkRoutingIndex::BoundList ranges;
+        ranges.push_back( make_pair( key( 5 ), key( 10 ) ) ); // max is inclusive
+        index.findShardsForRanges( ranges, &shards, 4 );
+        ASSERT_EQUALS( 2U, shards.size() );
+        ASSERT( shards.count( 0 ) && shards.count( 1 ) );
+
+        shards.clear();
+        ranges.clear();
+        ranges.push_back( make_pair( key( 35 ), key( 40 ) ) );
+        ranges.push_back( make_pair( key( 1 ), key( 2 ) ) ); // out of order
+        index.findShardsForRanges( ranges, &shards, 4 );
+        ASSERT_EQUALS( 2U, shards.size() );
+        ASSERT( shards.count( 0 ) && shards.count( 3 ) );
+
+        // stops once enough shards are found
+        shards.clear();
+        ranges.clear();
+        ranges.push_back( make_pair( BSON( "x" << MINKEY ), BSON( "x" << MAXKEY ) ) );
+        index.findShardsForRanges( ranges, &shards, 2 );
+        ASSERT_EQUALS( 2U, shards.size() );
+    }
+
+    TEST(ChunkRoutingIndex, MatchesRangeMap) {
+        RangeMap map;
+        ChunkRoutingIndex index;
+        makeRanges( 1000, 7, &map, &index );
+
+        PseudoRandom random( 5678 );
+        for ( int i = 0; i < 2000; i++ ) {
+            int a = nextInt( random, 10020 ) - 10;
+            int b = a + nextInt( random, 200 );
+            BSONObj point = key( a );
+
+            set<int> expected = shardsForRange( map, point, point );
+            ASSERT_EQUALS( 1U, expected.size() );
+            ASSERT_EQUALS( *expected.begin(), index.findShard( point ) );
+
+            set<int> shards;
+            ChunkRoutingIndex::BoundList ranges( 1, make_pair( point, key( b ) ) );
+            index.findShardsForRanges( ranges, &shards, 7 );
+            expected = shardsForRange( map, point, key( b ) );
+            if ( expected.size() < 7 )
+                ASSERT( shards == expected );
+            else
+                ASSERT_EQUALS( 7U, shards.size() );
+        }
+
+        // a batch of points, sorted or not, finds the same shards as one point at a time
+        vector<BSONObj> points;
+        set<int> expected;
+        for ( int i = 0; i < 50; i++ ) {
+            BSONObj point = key( nextInt( random, 10000 ) );
+            points.push_back( point );
+            expected.insert( index.findShard( point ) );
+        }
+        set<int> shards;
+        index.findShardsForPoints( points, &shards, 7 );
+        ASSERT( shards == expected );
+
+        std::sort( points.begin(), points.end(), BSONObjCmp() );
+        shards.clear();
+        index.findShardsForPoints( points, &shards, 7 );
+        ASSERT( shards == expected );
+    }
+
+}
@@ -38,6 +38,7 @@
 #include "mongo/s/client_info.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/config.h"
+#include "mongo/s/cursors.h"
 #include "mongo/s/grid.h"
 #include "mongo/s/interrupt_status_mongos.h"
 #include "mongo/s/strategy.h"
@@ -45,6 +46,7 @@
 #include "mongo/scripting/engine.h"
 #include "mongo/util/net/message.h"
 #include "mongo/util/timer.h"
+#include "mongo/util/version.h"
 
 namespace mongo {
 
@@ -1774,6 +1776,53 @@ namespace mongo {
 
         static const PipelineCommand pipelineCommand;
 
+        /**
+         * @return true if every shard in shards is at least as new as this mongos, and so takes
+         * the cursor option of the aggregate command; a shard of an older version rejects it.
+         * Each shard's answer is remembered for a few minutes, so that a shard upgraded or
+         * downgraded in place is noticed.
+         */
+        static bool shardsSupportAggregateCursors(const set<Shard>& shards) {
+            static const int recheckSecs = 5 * 60;
+            static mongo::mutex mtx("aggregateCursorShards");
+            // connection string -> ( supports cursors, when that was found )
+            static map<string, pair<bool, time_t> > known;
+
+            for (set<Shard>::const_iterator i = shards.begin(); i != shards.end(); ++i) {
+                const string host = i->getConnString();
+                {
+                    scoped_lock lk(mtx);
+                    map<string, pair<bool, time_t> >::const_iterator k = known.find(host);
+                    if (k != known.end() && time(0) - k->second.second < recheckSecs) {
+                        if (!k->second.first)
+                            return false;
+                        continue;
+                    }
+                }
+
+                BSONObj info;
+                bool ok;
+                {
+                    ScopedDbConnection conn(host);
+                    ok = conn->runCommand("admin", BSON("buildinfo" << 1), info);
+                    conn.done();
+                }
+                if (!ok || info["version"].type() != String) {
+                    // try again next time rather than remember a guess
+                    return false;
+                }
+                bool supported = toVersionArray(info["version"].valuestr())
+                                     .woCompare(versionArray, BSONObj(), false) >= 0;
+                {
+                    scoped_lock lk(mtx);
+                    known[host] = make_pair(supported, time(0));
+                }
+                if (!supported)
+                    return false;
+            }
+            return true;
+        }
+
         PipelineCommand::PipelineCommand():
             PublicGridCommand(Pipeline::commandName) {
         }
@@ -1808,8 +1857,23 @@ namespace mongo {
               isn't sharded, pass this on to a mongod.
             */
             DBConfigPtr conf(grid.getDBConfig(dbName , false));
-            if (!conf || !conf->isShardingEnabled() || !conf->isSharded(fullns))
-                return passthrough(conf, cmdObj, result);
+            if (!conf || !conf->isShardingEnabled() || !conf->isSharded(fullns)) {
+                bool ok = passthrough(conf, cmdObj, result);
+
+                // Remember where the cursor lives, so its getMores can be routed there.
+                if (ok && pPipeline->isCursorCommand()) {
+                    BSONObj res = result.asTempObj();
+                    BSONElement cursorElement = res[Pipeline::cursorName];
+                    if (cursorElement.type() == Object) {
+                        long long cursorId = cursorElement.embeddedObject()["id"].numberLong();
+                        if (cursorId) {
+                            cursorCache.storeRef(conf->getPrimary().getConnString(),
+                                                 cursorId, fullns);
+                        }
+                    }
+                }
+                return ok;
+            }
 
             /* split the pipeline into pieces for mongods and this mongos */
             intrusive_ptr<Pipeline> pShardPipeline(
@@ -1823,6 +1887,19 @@ namespace mongo {
                 commandBuilder.append(cmdObj["$queryOptions"]);
             }
 
+            // When the client asked for a cursor, have the shards return cursors too, so their
+            // output is merged as it's needed rather than all held here at once.  Not when the
+            // command may go to a secondary, since the getMores go to the shard's primary, and
+            // not unless every shard knows the option; otherwise they return inline results.
+            if (pPipeline->isCursorCommand() && !pPipeline->isExplain() &&
+                    !(options & QueryOption_SlaveOk)) {
+                set<Shard> shards;
+                conf->getChunkManager(fullns)->getAllShards(shards);
+                if (shardsSupportAggregateCursors(shards)) {
+                    commandBuilder.append(Pipeline::cursorName, BSONObj());
+                }
+            }
+
             BSONObj shardedCommand(commandBuilder.done());
 
             BSONObjBuilder shardQueryBuilder;
@@ -1842,7 +1919,23 @@ namespace mongo {
             pPipeline->addInitialSource(DocumentSourceCommandShards::create(shardResults, pExpCtx));
 
             // Combine the shards' output and finish the pipeline
-            pPipeline->run(result, errmsg);
+            if (!pPipeline->isCursorCommand() || pPipeline->isExplain()) {
+                pPipeline->run(result, errmsg);
+            }
+            else {
+                // mongos doesn't keep aggregation cursors yet, so the merged results all go in
+                // the first batch, and are still subject to the document size limit.
+                BSONObjBuilder mergedBuilder;
+                if (!pPipeline->run(mergedBuilder, errmsg))
+                    return false;
+                BSONObj merged(mergedBuilder.done());
+
+                BSONObjBuilder cursorBuilder(result.subobjStart(Pipeline::cursorName));
+                cursorBuilder.append("id", 0LL);
+                cursorBuilder.append("ns", fullns);
+                cursorBuilder.appendAs(merged["result"], "firstBatch");
+                cursorBuilder.done();
+            }
 
             if (errmsg.length() > 0)
                 return false;
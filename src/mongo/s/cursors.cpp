@@ -93,6 +93,9 @@ namespace mongo {
         replyToQuery( 0, r.p(), r.m(), buffer.buf(), buffer.len(), docCount,
                 _totalSent, hasMore ? getId() : 0 );
 
+        if ( hasMore )
+            settlePrefetches();
+
         return hasMore;
     }
 
@@ -149,6 +152,10 @@ namespace mongo {
         return hasMore;
     }
 
+    void ShardedClientCursor::settlePrefetches() {
+        _cursor->settlePrefetches();
+    }
+
     // ---- CursorCache -----
 
     long long CursorCache::TIMEOUT = 600000;
@@ -63,6 +63,13 @@ namespace mongo {
          */
         bool sendNextBatch( Request& r, int ntoreturn, BufBuilder& buffer, int& docCount );
 
+        /**
+         * Receives the batches the shards were asked for ahead of time, so that the cursor
+         * doesn't hold their connections while it waits for the client's next getMore.  Call
+         * after the reply to a batch has been sent, since it blocks until each shard answers.
+         */
+        void settlePrefetches();
+
         void accessed();
         /** @return idle time in ms */
         long long idleTime( long long now );
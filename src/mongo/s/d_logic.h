@@ -188,6 +188,13 @@ namespace mongo {
 
         static ShardedConnectionInfo* get( bool create );
         static void reset();
+
+        /**
+         * moves the connection's sharding info off of / onto the current thread, for
+         * connections whose requests are not all serviced by the same thread
+         */
+        static ShardedConnectionInfo* release();
+        static void attach( ShardedConnectionInfo* info );
         static void addHook();
 
         bool inForceVersionOkMode() const {
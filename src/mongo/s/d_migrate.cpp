@@ -51,6 +51,7 @@
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/repl/rs_config.h"
 #include "mongo/db/repl/write_concern.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
@@ -90,11 +91,15 @@ namespace mongo {
 
     Tee* migrateLog = new RamLog( "migrate" );
 
+    // number of threads a recipient shard fetches and inserts the initial clone of a chunk with
+    MONGO_EXPORT_SERVER_PARAMETER(migrateCloneThreads, int, 4);
+
     class MoveTimingHelper {
     public:
         MoveTimingHelper( const string& where , const string& ns , BSONObj min , BSONObj max , int total , string& cmdErrmsg )
             : _where( where ) , _ns( ns ) , _next( 0 ) , _total( total ) , _cmdErrmsg( cmdErrmsg ) {
             _nextNote = 0;
+            _lastMillis = 0;
             _b.append( "min" , min );
             _b.append( "max" , max );
         }
@@ -132,7 +137,8 @@ namespace mongo {
             else
                 warning() << "op is null in MoveTimingHelper::done" << migrateLog;
 
-            _b.appendNumber( s , _t.millis() );
+            _lastMillis = _t.millis();
+            _b.appendNumber( s , _lastMillis );
             _t.reset();
 
 #if 0
@@ -145,6 +151,23 @@ namespace mongo {
         }
 
 
+        /**
+         * like done( step ), and records how much data the step moved as
+         * phase : { docs , bytes , docsPerSec , bytesPerSec }
+         */
+        void done( int step , const string& phase , long long docs , long long bytes ) {
+            done( step );
+
+            BSONObjBuilder b( _b.subobjStart( phase ) );
+            b.appendNumber( "docs" , docs );
+            b.appendNumber( "bytes" , bytes );
+            if ( _lastMillis > 0 ) {
+                b.append( "docsPerSec" , docs * 1000.0 / _lastMillis );
+                b.append( "bytesPerSec" , bytes * 1000.0 / _lastMillis );
+            }
+            b.done();
+        }
+
         void note( const string& s ) {
             string field = "note";
             if ( _nextNote > 0 ) {
@@ -166,6 +189,7 @@ namespace mongo {
         int _next;
         int _total; // expected # of steps
         int _nextNote;
+        int _lastMillis; // how long the last step done() took
 
         string _cmdErrmsg;
 
@@ -1156,6 +1180,7 @@ namespace mongo {
             timing.done( 3 );
 
             // 4.
+            BSONObj transferStatus; // the recipient's last report, for its counts
             for ( int i=0; i<86400; i++ ) { // don't want a single chunk move to take more than a day
                 verify( !Lock::isLocked() );
                 // Exponential sleep backoff, up to 1024ms. Don't sleep much on the first few
@@ -1185,6 +1210,7 @@ namespace mongo {
                     return false;
                 }
 
+                transferStatus = res;
                 if ( res["state"].String() == "steady" )
                     break;
 
@@ -1205,7 +1231,13 @@ namespace mongo {
 
                 killCurrentOp.checkForInterrupt();
             }
-            timing.done(4);
+            {
+                BSONObj counts = transferStatus["counts"].isABSONObj() ?
+                                     transferStatus["counts"].Obj() : BSONObj();
+                timing.done( 4 , "transfer" ,
+                             counts["cloned"].numberLong() + counts["catchup"].numberLong() ,
+                             counts["clonedBytes"].numberLong() + counts["catchupBytes"].numberLong() );
+            }
 
             // 5.
             {
@@ -1500,7 +1532,7 @@ namespace mongo {
     class MigrateStatus {
     public:
         
-        MigrateStatus() : m_active("MigrateStatus") { active = false; }
+        MigrateStatus() : m_active("MigrateStatus"), m_clone("MigrateStatus clone") { active = false; }
 
         void prepare() {
             scoped_lock l(m_active); // reading and writing 'active'
@@ -1512,7 +1544,9 @@ namespace mongo {
             numCloned = 0;
             clonedBytes = 0;
             numCatchup = 0;
+            catchupBytes = 0;
             numSteady = 0;
+            steadyBytes = 0;
 
             active = true;
         }
@@ -1619,58 +1653,39 @@ namespace mongo {
 
             {
                 // 3. initial bulk clone
+                // Several threads each fetch a batch with _migrateClone and insert it, so the
+                // donor reads the next batches while this side is still inserting the last one.
                 state = CLONE;
+                cloneFailed = false;
+                cloneLastOp = OpTime();
 
-                while ( true ) {
-                    BSONObj res;
-                    if ( ! conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , res ) ) {  // gets array of objects to copy, in disk order
-                        state = FAIL;
-                        errmsg = "_migrateClone failed: ";
-                        errmsg += res.toString();
-                        error() << errmsg << migrateLog;
-                        conn.done();
-                        return;
-                    }
-
-                    BSONObj arr = res["objects"].Obj();
-                    int thisTime = 0;
-
-                    BSONObjIterator i( arr );
-                    while( i.more() ) {
-                        BSONObj o = i.next().Obj();
-                        {
-                            PageFaultRetryableSection pgrs;
-                            while ( 1 ) {
-                                try {
-                                    Lock::DBWrite lk( ns );
-                                    Helpers::upsert( ns, o, true );
-                                    break;
-                                }
-                                catch ( PageFaultException& e ) {
-                                    e.touch();
-                                }
-                            }
-                        }
-                        thisTime++;
-                        numCloned++;
-                        clonedBytes += o.objsize();
+                const int numThreads = std::max( 1 , (int)migrateCloneThreads );
+                boost::thread_group cloneThreads;
+                for ( int i = 0; i < numThreads; i++ )
+                    cloneThreads.create_thread( boost::bind( &MigrateStatus::cloneThread , this , i ) );
+                cloneThreads.join_all();
 
-                        if ( secondaryThrottle && thisTime > 0 ) {
-                            if ( ! waitForReplication( cc().getLastOp(), 2, 60 /* seconds to wait */ ) ) {
-                                warning() << "secondaryThrottle on, but doc insert timed out after 60 seconds, continuing" << endl;
-                            }
-                        }
-                    }
+                if ( cloneFailed ) {
+                    state = FAIL;
+                    errmsg = cloneErrmsg;
+                    error() << errmsg << migrateLog;
+                    conn.done();
+                    return;
+                }
 
-                    if ( thisTime == 0 )
-                        break;
+                if ( state == ABORT ) {
+                    timing.note( "aborted" );
+                    return;
                 }
 
-                timing.done(3);
+                timing.done( 3 , "clone" , numCloned , clonedBytes );
             }
 
             // if running on a replicated system, we'll need to flush the docs we cloned to the secondaries
-            ReplTime lastOpApplied = cc().getLastOp().asDate();
+            OpTime lastOp = cc().getLastOp();
+            if ( lastOp < cloneLastOp )
+                lastOp = cloneLastOp;
+            ReplTime lastOpApplied = lastOp.asDate();
 
             {
                 // 4. do bulk of mods
@@ -1717,7 +1732,7 @@ namespace mongo {
                     } 
                 }
 
-                timing.done(4);
+                timing.done( 4 , "catchup" , numCatchup , catchupBytes );
             }
 
             { 
@@ -1768,13 +1783,109 @@ namespace mongo {
                     return;
                 }
 
-                timing.done(5);
+                timing.done( 5 , "steady" , numSteady , steadyBytes );
             }
 
             state = DONE;
             conn.done();
         }
 
+        /**
+         * one of the threads of the initial bulk clone; see _go()
+         */
+        void cloneThread( int threadNumber ) {
+            string threadName = str::stream() << "migrateClone" << threadNumber;
+            Client::initThread( threadName.c_str() );
+            if (AuthorizationManager::isAuthEnabled()) {
+                cc().getAuthorizationManager()->grantInternalAuthorization("_migrateThread");
+            }
+
+            try {
+                _cloneBatches();
+            }
+            catch ( std::exception& e ) {
+                _cloneFailed( str::stream() << "migrate clone failed: " << e.what() );
+            }
+            catch ( ... ) {
+                _cloneFailed( "migrate clone failed with unknown exception" );
+            }
+
+            {
+                scoped_lock l( m_clone );
+                if ( cloneLastOp < cc().getLastOp() )
+                    cloneLastOp = cc().getLastOp();
+            }
+            cc().shutdown();
+        }
+
+        /**
+         * fetches and inserts batches until the donor has nothing left to clone, the migration
+         * is aborted, or another clone thread fails
+         */
+        void _cloneBatches() {
+            ScopedDbConnection conn( from );
+
+            while ( state == CLONE && ! _getCloneFailed() ) {
+                BSONObj res;
+                if ( ! conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , res ) ) {  // gets array of objects to copy, in disk order
+                    _cloneFailed( "_migrateClone failed: " + res.toString() );
+                    conn.done();
+                    return;
+                }
+
+                BSONObj arr = res["objects"].Obj();
+                long long thisTime = 0;
+                long long thisTimeBytes = 0;
+
+                BSONObjIterator i( arr );
+                while( i.more() ) {
+                    BSONObj o = i.next().Obj();
+                    {
+                        PageFaultRetryableSection pgrs;
+                        while ( 1 ) {
+                            try {
+                                Lock::DBWrite lk( ns );
+                                Helpers::upsert( ns, o, true );
+                                break;
+                            }
+                            catch ( PageFaultException& e ) {
+                                e.touch();
+                            }
+                        }
+                    }
+                    thisTime++;
+                    thisTimeBytes += o.objsize();
+
+                    if ( secondaryThrottle && thisTime > 0 ) {
+                        if ( ! waitForReplication( cc().getLastOp(), 2, 60 /* seconds to wait */ ) ) {
+                            warning() << "secondaryThrottle on, but doc insert timed out after 60 seconds, continuing" << endl;
+                        }
+                    }
+                }
+
+                {
+                    scoped_lock l( m_clone );
+                    numCloned += thisTime;
+                    clonedBytes += thisTimeBytes;
+                }
+
+                if ( thisTime == 0 )
+                    break;
+            }
+
+            conn.done();
+        }
+
+        void _cloneFailed( const string& msg ) {
+            scoped_lock l( m_clone );
+            if ( cloneFailed )
+                return; // keep the first error
+            cloneFailed = true;
+            cloneErrmsg = msg;
+        }
+
+        bool _getCloneFailed() const { scoped_lock l( m_clone ); return cloneFailed; }
+
         void status( BSONObjBuilder& b ) {
             b.appendBool( "active" , getActive() );
 
@@ -1792,7 +1903,9 @@ namespace mongo {
                 bb.append( "cloned" , numCloned );
                 bb.append( "clonedBytes" , clonedBytes );
                 bb.append( "catchup" , numCatchup );
+                bb.append( "catchupBytes" , catchupBytes );
                 bb.append( "steady" , numSteady );
+                bb.append( "steadyBytes" , steadyBytes );
                 bb.done();
             }
 
@@ -1841,6 +1954,7 @@ namespace mongo {
                                           true ); /*fromMigrate*/
 
                     *lastOpApplied = cx.ctx().getClient()->getLastOp().asDate();
+                    _noteApplied( id.objsize() );
                     didAnything = true;
                 }
             }
@@ -1855,6 +1969,7 @@ namespace mongo {
                     Helpers::upsert( ns , it , true );
 
                     *lastOpApplied = cx.ctx().getClient()->getLastOp().asDate();
+                    _noteApplied( it.objsize() );
                     didAnything = true;
                 }
             }
@@ -1862,6 +1977,18 @@ namespace mongo {
             return didAnything;
         }
 
+        /** counts a transferred mod towards the catchup or the steady phase */
+        void _noteApplied( int bytes ) {
+            if ( state == CATCHUP ) {
+                numCatchup++;
+                catchupBytes += bytes;
+            }
+            else {
+                numSteady++;
+                steadyBytes += bytes;
+            }
+        }
+
         bool opReplicatedEnough( const ReplTime& lastOpApplied ) {
             // if replication is on, try to force enough secondaries to catch up
             // TODO opReplicatedEnough should eventually honor priorities and geo-awareness
@@ -1947,9 +2074,17 @@ namespace mongo {
         long long numCloned;
         long long clonedBytes;
         long long numCatchup;
+        long long catchupBytes;
         long long numSteady;
+        long long steadyBytes;
         bool secondaryThrottle;
 
+        // shared by the initial clone threads
+        mutable mongo::mutex m_clone;
+        bool cloneFailed;
+        string cloneErrmsg;
+        OpTime cloneLastOp; // the last op any clone thread wrote
+
         int slaveCount;
 
         enum State { READY , CLONE , CATCHUP , STEADY , COMMIT_START , DONE , FAIL , ABORT } state;
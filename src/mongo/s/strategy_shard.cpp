@@ -126,6 +126,9 @@ namespace mongo {
 
                 replyToQuery( 0, r.p(), r.m(), buffer.buf(), buffer.len(), docCount,
                         startFrom, hasMore ? cc->getId() : 0 );
+
+                if ( hasMore )
+                    cc->settlePrefetches();
             }
             else{
                 // Remote cursors are stored remotely, we shouldn't need this around.
@@ -252,6 +255,9 @@ namespace mongo {
 
                 replyToQuery( 0, r.p(), r.m(), buffer.buf(), buffer.len(), docCount,
                         startFrom, hasMore ? cursor->getId() : 0 );
+
+                if ( hasMore )
+                    cursor->settlePrefetches();
             }
         }
 
@@ -501,6 +507,193 @@ namespace mongo {
             }
         }
 
+        /**
+         * The inserts of a batch bound for one shard, in the order they came in.
+         */
+        struct ShardInserts {
+
+            ShardInserts() :
+                    size(0), lastIndex(-1)
+            {
+            }
+
+            vector<BSONObj> inserts;
+            int size; // total bytes of inserts
+            int lastIndex; // position of the last of inserts in the batch
+
+        };
+
+        /**
+         * Groups a whole insert batch by shard, reading it from d.
+         *
+         * Returns false, with d reset to the start of the batch, if the batch has a document
+         * without a shard key, or too much data for a single message to some shard.  These batches
+         * need the in-order handling of _getNextInsertGroup().
+         */
+        bool _groupInsertsByShard(DbMessage& d,
+                                  ChunkManagerPtr manager,
+                                  map<Shard, ShardInserts>* byShard,
+                                  map<ChunkPtr, int>* chunkData)
+        {
+            d.markSet();
+
+            for (int i = 0; d.moreJSObjs(); i++) {
+
+                BSONObj o = d.nextJsObj();
+
+                if (!manager->hasShardKey(o)) {
+
+                    // Add an autogenerated _id if it completes the shard key, as above
+                    if (manager->getShardKey().partOfShardKey("_id") && !o.hasField("_id")) {
+                        BSONObjBuilder b;
+                        b.appendOID("_id", 0, true);
+                        b.appendElements(o);
+                        o = b.obj();
+                    }
+
+                    if (!manager->hasShardKey(o)) {
+                        d.markReset();
+                        return false;
+                    }
+                }
+
+                int objSize = o.objsize();
+                ChunkPtr chunk = manager->findChunkForDoc(o);
+                ShardInserts& forShard = (*byShard)[chunk->getShard()];
+
+                // Insert no more than 8MB of data per shard, otherwise the WBL will not work
+                if (forShard.size + objSize > BSONObjMaxUserSize / 2) {
+                    d.markReset();
+                    return false;
+                }
+
+                forShard.inserts.push_back(manager->getShardKey().moveToFront(o));
+                forShard.size += objSize;
+                forShard.lastIndex = i;
+                (*chunkData)[chunk] += objSize;
+            }
+
+            return true;
+        }
+
+        /**
+         * Inserts a continue-on-error batch into a sharded collection with one message per shard.
+         *
+         * The whole batch is grouped by shard first, and the version of every shard connection is
+         * checked before any insert is sent, so a stale config retries the batch from the start.
+         * The inserts are then sent to all the shards without waiting on any of them; as with any
+         * write, the client's getLastError collects the errors from every shard written to.
+         *
+         * Returns false, having inserted nothing, if the batch can't be sent this way.
+         */
+        bool _insertByShard(const string& ns, DbMessage& d, int flags, Request& r)
+        {
+            int retries = 0;
+
+            while (true) {
+
+                ChunkManagerPtr manager;
+                ShardPtr primary;
+                grid.getDBConfig(ns)->getChunkManagerOrPrimary(ns, manager, primary);
+                if (!manager) return false;
+
+                map<Shard, ShardInserts> byShard;
+                map<ChunkPtr, int> chunkData;
+                if (!_groupInsertsByShard(d, manager, &byShard, &chunkData)) return false;
+
+                vector<shared_ptr<ShardConnection> > conns;
+
+                try {
+
+                    //
+                    // CHECK VERSIONS
+                    //
+
+                    for (map<Shard, ShardInserts>::iterator it = byShard.begin();
+                         it != byShard.end(); ++it)
+                    {
+                        conns.push_back(shared_ptr<ShardConnection>(
+                                new ShardConnection(it->first, ns, manager)));
+
+                        // Will throw SCE if we need to reset our version before sending.
+                        conns.back()->setVersion();
+                    }
+                }
+                catch (StaleConfigException& e) {
+
+                    for (size_t i = 0; i < conns.size(); i++) conns[i]->done();
+
+                    _handleRetries("insert", retries, ns,
+                                   byShard.begin()->second.inserts[0], e, r);
+                    retries++;
+
+                    // Go back to the start of the inserts, and regroup them
+                    d.markReset();
+                    continue;
+                }
+
+                //
+                // SEND INSERTS
+                //
+
+                string insertErr;
+                int insertErrIndex = -1;
+                size_t numInserts = 0;
+
+                size_t i = 0;
+                for (map<Shard, ShardInserts>::iterator it = byShard.begin();
+                     it != byShard.end(); ++it, ++i)
+                {
+                    ShardConnection& dbcon = *conns[i];
+                    const ShardInserts& forShard = it->second;
+
+                    LOG(5) << "inserting " << forShard.inserts.size() << " documents to shard "
+                           << it->first << " at version " << manager->getVersion() << endl;
+
+                    try {
+                        dbcon->insert(ns, forShard.inserts, flags);
+                        dbcon.done();
+                        numInserts += forShard.inserts.size();
+                    }
+                    catch (DBException& e) {
+                        // Network error on send, go on with the other shards
+                        dbcon.kill();
+
+                        // Report the error of the shard with the latest document, as mongod
+                        // reports the last error of a continue-on-error batch
+                        if (forShard.lastIndex > insertErrIndex) {
+                            insertErrIndex = forShard.lastIndex;
+                            insertErr = str::stream() << "error inserting "
+                                                      << forShard.inserts.size()
+                                                      << " documents to shard "
+                                                      << it->first.toString() << " at version "
+                                                      << manager->getVersion().toString()
+                                                      << causedBy(e);
+                        }
+                    }
+                }
+
+                globalOpCounters.incInsertInWriteLock(numInserts);
+
+                //
+                // SPLIT CHUNKS IF NEEDED
+                //
+
+                // Should never throw errors!
+                if (r.getClientInfo()->autoSplitOk()) {
+                    for (map<ChunkPtr, int>::iterator it = chunkData.begin();
+                         it != chunkData.end(); ++it)
+                    {
+                        it->first->splitIfShould(it->second);
+                    }
+                }
+
+                if (insertErr.size() > 0) uasserted(16779, insertErr);
+
+                return true;
+            }
+        }
+
         /**
          * This insert function now handes all inserts, unsharded or sharded, through mongos.
          *
@@ -536,6 +729,13 @@ namespace mongo {
 
             bool continueOnError = flags & InsertOption_ContinueOnError;
 
+            // Without continue-on-error the inserts must stop at the first error, so they go one
+            // group at a time; writebacks are replayed the way they were first sent
+            if (continueOnError && !(flags & WriteOption_FromWriteback) &&
+                _insertByShard(ns, d, flags, r)) {
+                return;
+            }
+
             // Sanity check, probably not needed but for safety
             int retries = 0;
 
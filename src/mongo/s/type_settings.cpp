@@ -31,6 +31,7 @@ namespace mongo {
     const BSONField<BSONObj> SettingsType::balancerActiveWindow("activeWindow");
     const BSONField<bool> SettingsType::shortBalancerSleep("_nosleep");
     const BSONField<bool> SettingsType::secondaryThrottle("_secondaryThrottle");
+    const BSONField<int> SettingsType::maxConcurrentMigrations("maxConcurrentMigrations", 1);
 
     SettingsType::SettingsType() {
         clear();
@@ -84,6 +85,11 @@ namespace mongo {
                     return false;
                 }
             }
+            if (_isMaxConcurrentMigrationsSet && !(_maxConcurrentMigrations > 0)) {
+                *errMsg = stream() << maxConcurrentMigrations.name() <<
+                                      " must be greater than zero";
+                return false;
+            }
             return true;
         }
         else {
@@ -103,6 +109,9 @@ namespace mongo {
         }
         if (_isShortBalancerSleepSet) builder.append(shortBalancerSleep(), _shortBalancerSleep);
         if (_isSecondaryThrottleSet) builder.append(secondaryThrottle(), _secondaryThrottle);
+        if (_isMaxConcurrentMigrationsSet) {
+            builder.append(maxConcurrentMigrations(), _maxConcurrentMigrations);
+        }
 
         return builder.obj();
     }
@@ -139,6 +148,11 @@ namespace mongo {
         if (fieldState == FieldParser::FIELD_INVALID) return false;
         _isSecondaryThrottleSet = fieldState == FieldParser::FIELD_SET;
 
+        fieldState = FieldParser::extract(source, maxConcurrentMigrations,
+                                          &_maxConcurrentMigrations, errMsg);
+        if (fieldState == FieldParser::FIELD_INVALID) return false;
+        _isMaxConcurrentMigrationsSet = fieldState == FieldParser::FIELD_SET;
+
         return true;
     }
 
@@ -162,6 +176,9 @@ namespace mongo {
         _secondaryThrottle = false;
         _isSecondaryThrottleSet = false;
 
+        _maxConcurrentMigrations = 0;
+        _isMaxConcurrentMigrationsSet = false;
+
     }
 
     void SettingsType::cloneTo(SettingsType* other) const {
@@ -185,6 +202,9 @@ namespace mongo {
         other->_secondaryThrottle = _secondaryThrottle;
         other->_isSecondaryThrottleSet = _isSecondaryThrottleSet;
 
+        other->_maxConcurrentMigrations = _maxConcurrentMigrations;
+        other->_isMaxConcurrentMigrationsSet = _isMaxConcurrentMigrationsSet;
+
     }
 
     std::string SettingsType::toString() const {
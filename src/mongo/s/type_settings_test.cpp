@@ -83,7 +83,8 @@ namespace {
                            SettingsType::balancerActiveWindow(BSON("start" << "23:00" <<
                                                                    "stop" << "6:00" )) <<
                            SettingsType::shortBalancerSleep(true) <<
-                           SettingsType::secondaryThrottle(true));
+                           SettingsType::secondaryThrottle(true) <<
+                           SettingsType::maxConcurrentMigrations(4));
         ASSERT(settings.parseBSON(objBalancer, &errMsg));
         ASSERT_EQUALS(errMsg, "");
         ASSERT_TRUE(settings.isValid(NULL));
@@ -93,6 +94,22 @@ namespace {
                                                                "stop" << "6:00" ));
         ASSERT_EQUALS(settings.getShortBalancerSleep(), true);
         ASSERT_EQUALS(settings.getSecondaryThrottle(), true);
+        ASSERT_EQUALS(settings.getMaxConcurrentMigrations(), 4);
+    }
+
+    TEST(Validity, MaxConcurrentMigrations) {
+        SettingsType settings;
+        string errMsg;
+        BSONObj objDefault = BSON(SettingsType::key("balancer"));
+        ASSERT(settings.parseBSON(objDefault, &errMsg));
+        ASSERT_TRUE(settings.isValid(NULL));
+        ASSERT_EQUALS(settings.getMaxConcurrentMigrations(), 1);
+
+        BSONObj objZero = BSON(SettingsType::key("balancer") <<
+                               SettingsType::maxConcurrentMigrations(0));
+        ASSERT(settings.parseBSON(objZero, &errMsg));
+        ASSERT_EQUALS(errMsg, "");
+        ASSERT_FALSE(settings.isValid(NULL));
     }
 
     TEST(Validity, BadType) {
@@ -82,6 +82,7 @@ namespace mongo {
         mongo->InstanceTemplate()->SetInternalFieldCount(1);
         v8::Handle<v8::Template> proto = mongo->PrototypeTemplate();
         scope->injectV8Function("find", mongoFind, proto);
+        scope->injectV8Function("cursorFromId", mongoCursorFromId, proto);
         scope->injectV8Function("insert", mongoInsert, proto);
         scope->injectV8Function("remove", mongoRemove, proto);
         scope->injectV8Function("update", mongoUpdate, proto);
@@ -198,6 +199,36 @@ namespace mongo {
         return c;
     }
 
+    /**
+     * JavaScript binding for Mongo.prototype.cursorFromId(namespace, cursorId, batchSize)
+     */
+    v8::Handle<v8::Value> mongoCursorFromId(V8Scope* scope, const v8::Arguments& args) {
+        argumentCheck(args.Length() == 2 || args.Length() == 3, "cursorFromId needs 2 or 3 args")
+        argumentCheck(args[1]->IsNumber() || args[1]->IsObject(),
+                      "2nd arg must be a NumberLong or a number")
+        DBClientBase * conn = getConnection(args);
+        GETNS;
+
+        long long cursorId = args[1]->IsNumber()
+                ? (long long)(args[1]->ToNumber()->Value())
+                : numberLongVal(args[1]->ToObject());
+        int batchSize = args.Length() == 3 ? (int)(args[2]->ToNumber()->Value()) : 0;
+
+        auto_ptr<mongo::DBClientCursor> cursor(
+                new DBClientCursor(conn, ns.get(), cursorId, batchSize, 0));
+
+        v8::Local<v8::Object> mongo = args.This();
+        v8::Function* cons = (v8::Function*)(*(mongo->Get(scope->v8StringData("internalCursor"))));
+        if (!cons) {
+            return v8AssertionException("could not create a cursor");
+        }
+
+        v8::Persistent<v8::Object> c = v8::Persistent<v8::Object>::New(cons->NewInstance());
+        c->SetInternalField(0, v8::External::New(cursor.get()));
+        scope->dbClientCursorTracker.track(c, cursor.release());
+        return c;
+    }
+
     v8::Handle<v8::Value> mongoInsert(V8Scope* scope, const v8::Arguments& args) {
         argumentCheck(args.Length() == 3 ,"insert needs 3 args")
         argumentCheck(args[1]->IsObject() ,"attempted to insert a non-object")
@@ -13,6 +13,8 @@ if ( ! Mongo.prototype ){
 
 if ( ! Mongo.prototype.find )
     Mongo.prototype.find = function( ns , query , fields , limit , skip , batchSize , options ){ throw "find not implemented"; }
+if ( ! Mongo.prototype.cursorFromId )
+    Mongo.prototype.cursorFromId = function( ns , cursorId , batchSize ){ throw "cursorFromId not implemented"; }
 if ( ! Mongo.prototype.insert )
     Mongo.prototype.insert = function( ns , obj ){ throw "insert not implemented"; }
 if ( ! Mongo.prototype.remove )
@@ -362,6 +362,70 @@ DBQuery.prototype.toString = function(){
 
 DBQuery.shellBatchSize = 20;
 
+/**
+ * Iterates the results of a command that returns a cursor, such as
+ * { aggregate : <collection>, pipeline : [ ... ], cursor : {} }: first the batch that came back
+ * with the command, then the rest through getMore.
+ */
+function DBCommandCursor( mongo , cmdResult , batchSize ){
+    if ( cmdResult.ok != 1 )
+        throw "error: " + tojson( cmdResult );
+
+    this._mongo = mongo;
+    this._ns = cmdResult.cursor.ns;
+    this._id = cmdResult.cursor.id;
+    this._batch = cmdResult.cursor.firstBatch.reverse(); // pop() is cheaper than shift()
+    this._batchSize = batchSize || 0;
+    this._cursor = null;
+}
+
+DBCommandCursor.prototype._getMore = function(){
+    if ( ! this._cursor && this._id != 0 )
+        this._cursor = this._mongo.cursorFromId( this._ns , this._id , this._batchSize );
+    return this._cursor;
+}
+
+DBCommandCursor.prototype.hasNext = function(){
+    if ( this._batch.length > 0 )
+        return true;
+    var cursor = this._getMore();
+    return cursor != null && cursor.hasNext();
+}
+
+DBCommandCursor.prototype.next = function(){
+    if ( this._batch.length > 0 )
+        return this._batch.pop();
+    if ( ! this.hasNext() )
+        throw "error hasNext: false";
+
+    var ret = this._cursor.next();
+    if ( ret.$err )
+        throw "error: " + tojson( ret );
+    return ret;
+}
+
+DBCommandCursor.prototype.objsLeftInBatch = function(){
+    if ( this._batch.length > 0 )
+        return this._batch.length;
+    return this._cursor ? this._cursor.objsLeftInBatch() : 0;
+}
+
+DBCommandCursor.prototype.toArray = function(){
+    var a = [];
+    while ( this.hasNext() )
+        a.push( this.next() );
+    return a;
+}
+
+DBCommandCursor.prototype.itcount = function(){
+    var num = 0;
+    while ( this.hasNext() ){
+        num++;
+        this.next();
+    }
+    return num;
+}
+
 /**
  * Query option flag bit constants.
  * @see http://dochub.mongodb.org/core/mongowireprotocol#MongoWireProtocol-OPQUERY
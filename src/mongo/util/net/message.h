@@ -43,7 +43,8 @@ namespace mongo {
         dbQuery = 2004,
         dbGetMore = 2005,
         dbDelete = 2006,
-        dbKillCursors = 2007
+        dbKillCursors = 2007,
+        dbCompressed = 2012  /* wraps another message, see message_compression.h */
     };
 
     bool doesOpGetAResponse( int op );
@@ -59,6 +60,7 @@ namespace mongo {
         case dbGetMore: return "getmore";
         case dbDelete: return "remove";
         case dbKillCursors: return "killcursors";
+        case dbCompressed: return "compressed";
         default:
             massert( 16141, str::stream() << "cannot translate opcode " << op, !op );
             return "";
@@ -177,6 +179,8 @@ namespace mongo {
 
         bool empty() const { return !_buf && _data.empty(); }
 
+        bool isSingleBuffer() const { return _buf != 0; }
+
         int size() const {
             int res = 0;
             if ( _buf ) {
@@ -0,0 +1,198 @@
+// message_compression.cpp
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/util/net/message_compression.h"
+
+#include "mongo/base/counter.h"
+#include "mongo/util/net/message_port.h"
+
+namespace mongo {
+
+    bool networkMessageCompression = false;
+
+    namespace {
+        MessageCompressor* compressor = 0;
+
+        struct DirectionStats {
+            Counter64 messages;
+            Counter64 uncompressedBytes;
+            Counter64 compressedBytes;
+
+            void append( BSONObjBuilder* b , const char* name ) const {
+                BSONObjBuilder sub( b->subobjStart( name ) );
+                sub.appendNumber( "messages" , messages.get() );
+                sub.appendNumber( "uncompressedBytes" , uncompressedBytes.get() );
+                sub.appendNumber( "compressedBytes" , compressedBytes.get() );
+                long long u = uncompressedBytes.get();
+                sub.append( "ratio" , u ? double( compressedBytes.get() ) / u : 1.0 );
+                sub.done();
+            }
+        };
+
+        DirectionStats sentStats;
+        DirectionStats receivedStats;
+    }
+
+    void MessageCompressor::set( MessageCompressor* c ) {
+        verify( ! compressor );
+        compressor = c;
+    }
+
+    const MessageCompressor* MessageCompressor::get() {
+        return compressor;
+    }
+
+    bool compressMessage( const Message& in , Message* out ) {
+        if ( ! compressor || in.empty() || ! in.isSingleBuffer() )
+            return false;
+
+        MsgData* md = in.header();
+        if ( md->len < MinCompressMessageSize || md->operation() == dbCompressed )
+            return false;
+
+        const size_t bodyLen = md->dataLen();
+        const size_t max = sizeof(CompressedMsgHeader) + compressor->maxCompressedLength( bodyLen );
+        char* buf = static_cast<char*>( malloc( max ) );
+        verify( buf );
+
+        CompressedMsgHeader* h = reinterpret_cast<CompressedMsgHeader*>( buf );
+        size_t compressedLen = compressor->compress( md->_data , bodyLen ,
+                                                     buf + sizeof(CompressedMsgHeader) );
+        size_t total = sizeof(CompressedMsgHeader) + compressedLen;
+        if ( total >= (size_t) md->len ) {
+            // didn't help
+            free( buf );
+            return false;
+        }
+
+        h->len = total;
+        h->id = md->id;
+        h->responseTo = md->responseTo;
+        h->opCode = dbCompressed;
+        h->originalOpCode = md->operation();
+        h->uncompressedSize = bodyLen;
+        h->compressorId = compressor->id();
+
+        out->setData( reinterpret_cast<MsgData*>( buf ) , true );
+
+        sentStats.messages.increment();
+        sentStats.uncompressedBytes.increment( md->len );
+        sentStats.compressedBytes.increment( total );
+        return true;
+    }
+
+    bool decompressMessage( Message* m ) {
+        MsgData* md = m->singleData();
+        verify( md->operation() == dbCompressed );
+
+        if ( md->len < (int) sizeof(CompressedMsgHeader) ) {
+            LOG(1) << "compressed message too short: " << md->len << endl;
+            return false;
+        }
+        const CompressedMsgHeader* h = reinterpret_cast<const CompressedMsgHeader*>( md );
+        if ( ! compressor || h->compressorId != compressor->id() ) {
+            LOG(1) << "message compressed with unknown compressor " << (int) h->compressorId << endl;
+            return false;
+        }
+        if ( h->uncompressedSize < 0 ||
+             h->uncompressedSize > MaxMessageSizeBytes - MsgDataHeaderSize ) {
+            LOG(1) << "compressed message too large: " << h->uncompressedSize << endl;
+            return false;
+        }
+
+        const int len = MsgDataHeaderSize + h->uncompressedSize;
+        MsgData* out = static_cast<MsgData*>( malloc( len ) );
+        verify( out );
+        if ( ! compressor->uncompress( reinterpret_cast<const char*>( h + 1 ) ,
+                                       h->len - sizeof(CompressedMsgHeader) ,
+                                       out->_data , h->uncompressedSize ) ) {
+            LOG(1) << "couldn't uncompress message" << endl;
+            free( out );
+            return false;
+        }
+        out->len = len;
+        out->id = h->id;
+        out->responseTo = h->responseTo;
+        out->setOperation( h->originalOpCode );
+
+        receivedStats.messages.increment();
+        receivedStats.compressedBytes.increment( h->len );
+        receivedStats.uncompressedBytes.increment( len );
+
+        m->reset();
+        m->setData( out , true );
+        return true;
+    }
+
+    bool appendCompressionOffer( BSONObjBuilder* isMasterCmd ) {
+        if ( ! compressor || ! networkMessageCompression )
+            return false;
+        isMasterCmd->append( "compression" , BSON_ARRAY( compressor->name() ) );
+        return true;
+    }
+
+    void acceptCompressionReply( const BSONObj& isMasterReply , MessagingPort* port ) {
+        if ( ! compressor || ! networkMessageCompression )
+            return;
+        BSONElement e = isMasterReply["compression"];
+        if ( e.type() != Array )
+            return;
+        BSONObjIterator i( e.Obj() );
+        while ( i.more() ) {
+            BSONElement c = i.next();
+            if ( c.type() == String && str::equals( c.valuestr() , compressor->name() ) ) {
+                port->setCompressMessages( true );
+                return;
+            }
+        }
+    }
+
+    void negotiateCompression( const BSONObj& isMasterCmd , AbstractMessagingPort* port ,
+                               BSONObjBuilder* result ) {
+        if ( ! compressor || ! networkMessageCompression )
+            return;
+        BSONElement e = isMasterCmd["compression"];
+        if ( e.type() != Array )
+            return;
+        MessagingPort* mp = dynamic_cast<MessagingPort*>( port );
+        if ( ! mp )
+            return;
+        BSONObjIterator i( e.Obj() );
+        while ( i.more() ) {
+            BSONElement c = i.next();
+            if ( c.type() == String && str::equals( c.valuestr() , compressor->name() ) ) {
+                mp->setCompressMessages( true );
+                result->append( "compression" , BSON_ARRAY( compressor->name() ) );
+                return;
+            }
+        }
+    }
+
+    void appendMessageCompressionStats( BSONObjBuilder* b ) {
+        if ( ! compressor )
+            return;
+        BSONObjBuilder sub( b->subobjStart( "compression" ) );
+        sub.append( "compressor" , compressor->name() );
+        sub.appendBool( "enabled" , networkMessageCompression );
+        sentStats.append( &sub , "sent" );
+        receivedStats.append( &sub , "received" );
+        sub.done();
+    }
+
+} // namespace mongo
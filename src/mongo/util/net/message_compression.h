@@ -0,0 +1,129 @@
+// message_compression.h
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include "mongo/db/jsobj.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+    class AbstractMessagingPort;
+    class MessagingPort;
+
+    /**
+     * A codec for compressing wire protocol message bodies.
+     *
+     * mongod and mongos register one at startup (see message_compression_snappy.cpp).
+     * Processes that don't, such as applications using the C++ driver, never offer
+     * compression, so their peers never send them compressed messages.
+     */
+    class MessageCompressor {
+    public:
+        virtual ~MessageCompressor() {}
+
+        /** name used when negotiating compression in isMaster */
+        virtual const char* name() const = 0;
+
+        /** identifies the codec in each compressed message */
+        virtual char id() const = 0;
+
+        virtual size_t maxCompressedLength( size_t len ) const = 0;
+
+        /**
+         * @param out must have room for maxCompressedLength( len ) bytes
+         * @return compressed length
+         */
+        virtual size_t compress( const char* in , size_t len , char* out ) const = 0;
+
+        /**
+         * @param out must have room for exactly outLen bytes
+         * @return false if in is corrupt or doesn't uncompress to outLen bytes
+         */
+        virtual bool uncompress( const char* in , size_t len , char* out , size_t outLen ) const = 0;
+
+        /** takes ownership.  call before any connections are made. */
+        static void set( MessageCompressor* c );
+
+        /** @return the registered compressor, or NULL */
+        static const MessageCompressor* get();
+    };
+
+    /**
+     * when true, this process offers message compression to its peers, both when it accepts
+     * and when it makes connections.  set with --setParameter networkMessageCompression=true.
+     */
+    extern bool networkMessageCompression;
+
+    /**
+     * Layout of a dbCompressed message.  The header's id and responseTo are those of the
+     * wrapped message, the rest of which follows the compressed header in compressed form.
+     */
+#pragma pack(1)
+    struct CompressedMsgHeader {
+        int len;
+        int id;
+        int responseTo;
+        int opCode;              // dbCompressed
+        int originalOpCode;
+        int uncompressedSize;    // size of the wrapped message, excluding its header
+        char compressorId;
+    };
+#pragma pack()
+
+    /**
+     * Messages smaller than this aren't worth compressing.
+     */
+    const int MinCompressMessageSize = 512;
+
+    /**
+     * @return true if in was worth compressing, in which case out holds a dbCompressed message
+     *     wrapping it.  in's id and responseTo must already be set.
+     */
+    bool compressMessage( const Message& in , Message* out );
+
+    /**
+     * Replaces a dbCompressed message with the message it wraps.
+     * @return false if m is corrupt or uses a codec we don't have, m is left unchanged
+     */
+    bool decompressMessage( Message* m );
+
+    /**
+     * client side of compression negotiation: adds our offer to an isMaster command.
+     * @return false if we have nothing to offer
+     */
+    bool appendCompressionOffer( BSONObjBuilder* isMasterCmd );
+
+    /**
+     * client side of compression negotiation: starts compressing on port if the server
+     * accepted our offer in its isMaster reply.
+     */
+    void acceptCompressionReply( const BSONObj& isMasterReply , MessagingPort* port );
+
+    /**
+     * server side of compression negotiation: if the client's isMaster command offers a codec
+     * we have, starts compressing replies on port and tells the client in result.
+     */
+    void negotiateCompression( const BSONObj& isMasterCmd , AbstractMessagingPort* port ,
+                               BSONObjBuilder* result );
+
+    /**
+     * for serverStatus network: messages compressed and decompressed, and their sizes
+     */
+    void appendMessageCompressionStats( BSONObjBuilder* b );
+
+} // namespace mongo
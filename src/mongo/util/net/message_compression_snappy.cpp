@@ -0,0 +1,66 @@
+// message_compression_snappy.cpp
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/base/init.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/compress.h"
+#include "mongo/util/net/message_compression.h"
+
+namespace mongo {
+
+    namespace {
+
+        class SnappyMessageCompressor : public MessageCompressor {
+        public:
+            virtual const char* name() const { return "snappy"; }
+
+            virtual char id() const { return 1; }
+
+            virtual size_t maxCompressedLength( size_t len ) const {
+                return mongo::maxCompressedLength( len );
+            }
+
+            virtual size_t compress( const char* in , size_t len , char* out ) const {
+                size_t outLen = 0;
+                rawCompress( in , len , out , &outLen );
+                return outLen;
+            }
+
+            virtual bool uncompress( const char* in , size_t len , char* out , size_t outLen ) const {
+                size_t expected = 0;
+                if ( ! getUncompressedLength( in , len , &expected ) || expected != outLen )
+                    return false;
+                return rawUncompress( in , len , out );
+            }
+        };
+
+        MONGO_INITIALIZER(SnappyMessageCompressor)(InitializerContext* context) {
+            MessageCompressor::set( new SnappyMessageCompressor() );
+            return Status::OK();
+        }
+
+        ExportedServerParameter<bool> NetworkMessageCompressionSetting(
+            ServerParameterSet::getGlobal(),
+            "networkMessageCompression",
+            &networkMessageCompression,
+            true,
+            true );
+    }
+
+} // namespace mongo
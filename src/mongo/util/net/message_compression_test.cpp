@@ -0,0 +1,141 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/util/net/message_compression.h"
+
+#include "mongo/db/cmdline.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/compress.h"
+
+namespace mongo {
+
+    CmdLine cmdLine;
+
+    bool inShutdown() {
+        return false;
+    }
+
+} // namespace mongo
+
+namespace {
+
+    using namespace mongo;
+
+    class TestCompressor : public MessageCompressor {
+    public:
+        virtual const char* name() const { return "test"; }
+        virtual char id() const { return 7; }
+        virtual size_t maxCompressedLength( size_t len ) const {
+            return mongo::maxCompressedLength( len );
+        }
+        virtual size_t compress( const char* in , size_t len , char* out ) const {
+            size_t outLen = 0;
+            rawCompress( in , len , out , &outLen );
+            return outLen;
+        }
+        virtual bool uncompress( const char* in , size_t len , char* out , size_t outLen ) const {
+            size_t expected = 0;
+            if ( ! getUncompressedLength( in , len , &expected ) || expected != outLen )
+                return false;
+            return rawUncompress( in , len , out );
+        }
+    };
+
+    void registerCompressor() {
+        if ( ! MessageCompressor::get() )
+            MessageCompressor::set( new TestCompressor() );
+    }
+
+    void makeMessage( Message* m , const string& body ) {
+        m->setData( dbQuery , body.c_str() , body.size() );
+        m->header()->id = 1234;
+        m->header()->responseTo = 5678;
+    }
+
+    TEST(MessageCompression, RoundTrip) {
+        registerCompressor();
+        Message m;
+        makeMessage( &m , string( 10000 , 'x' ) );
+
+        Message compressed;
+        ASSERT_TRUE( compressMessage( m , &compressed ) );
+        ASSERT_EQUALS( dbCompressed , compressed.operation() );
+        ASSERT_LESS_THAN( compressed.size() , m.size() );
+        ASSERT_EQUALS( 1234 , (int) compressed.header()->id );
+        ASSERT_EQUALS( 5678 , (int) compressed.header()->responseTo );
+
+        ASSERT_TRUE( decompressMessage( &compressed ) );
+        ASSERT_EQUALS( dbQuery , compressed.operation() );
+        ASSERT_EQUALS( m.size() , compressed.size() );
+        ASSERT_EQUALS( 1234 , (int) compressed.header()->id );
+        ASSERT_EQUALS( 5678 , (int) compressed.header()->responseTo );
+        ASSERT_EQUALS( 0 , memcmp( m.singleData()->_data , compressed.singleData()->_data ,
+                                   m.singleData()->dataLen() ) );
+    }
+
+    TEST(MessageCompression, SmallMessagesAreSentAsIs) {
+        registerCompressor();
+        Message m;
+        makeMessage( &m , string( 16 , 'x' ) );
+        Message compressed;
+        ASSERT_FALSE( compressMessage( m , &compressed ) );
+        ASSERT_TRUE( compressed.empty() );
+    }
+
+    TEST(MessageCompression, IncompressibleMessagesAreSentAsIs) {
+        registerCompressor();
+        string body;
+        unsigned x = 12345;
+        for ( int i = 0; i < 4096; i++ ) {
+            x = x * 1103515245 + 12345;
+            body += char( x >> 16 );
+        }
+        Message m;
+        makeMessage( &m , body );
+        Message compressed;
+        ASSERT_FALSE( compressMessage( m , &compressed ) );
+    }
+
+    TEST(MessageCompression, CorruptMessageIsRejected) {
+        registerCompressor();
+        Message m;
+        makeMessage( &m , string( 10000 , 'x' ) );
+        Message compressed;
+        ASSERT_TRUE( compressMessage( m , &compressed ) );
+
+        // claim a different uncompressed size than the payload has
+        reinterpret_cast<CompressedMsgHeader*>( compressed.singleData() )->uncompressedSize += 1;
+        ASSERT_FALSE( decompressMessage( &compressed ) );
+        ASSERT_EQUALS( dbCompressed , compressed.operation() );
+    }
+
+    TEST(MessageCompression, NegotiationRequiresBothSides) {
+        registerCompressor();
+        networkMessageCompression = false;
+        BSONObjBuilder offer;
+        ASSERT_FALSE( appendCompressionOffer( &offer ) );
+
+        networkMessageCompression = true;
+        BSONObjBuilder offer2;
+        ASSERT_TRUE( appendCompressionOffer( &offer2 ) );
+        BSONObj cmd = offer2.obj();
+        ASSERT_EQUALS( "test" , cmd["compression"].Obj().firstElement().String() );
+        networkMessageCompression = false;
+    }
+
+} // namespace
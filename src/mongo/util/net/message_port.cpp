@@ -21,6 +21,7 @@
 #include <time.h>
 
 #include "message.h"
+#include "message_compression.h"
 #include "message_port.h"
 #include "listen.h"
 
@@ -125,18 +126,18 @@ namespace mongo {
     }
 
     MessagingPort::MessagingPort(int fd, const SockAddr& remote) 
-        : psock( new Socket( fd , remote ) ) , piggyBackData(0) {
+        : psock( new Socket( fd , remote ) ) , piggyBackData(0), _compressMessages(false) {
         ports.insert(this);
     }
 
     MessagingPort::MessagingPort( double timeout, int ll ) 
-        : psock( new Socket( timeout, ll ) ) {
+        : psock( new Socket( timeout, ll ) ), _compressMessages(false) {
         ports.insert(this);
         piggyBackData = 0;
     }
 
     MessagingPort::MessagingPort( boost::shared_ptr<Socket> sock )
-        : psock( sock ), piggyBackData( 0 ) {
+        : psock( sock ), piggyBackData( 0 ), _compressMessages(false) {
         ports.insert(this);
     }
 
@@ -202,6 +203,13 @@ again:
 
             guard.Dismiss();
             m.setData(md, true);
+
+            if ( md->operation() == dbCompressed && ! decompressMessage( &m ) ) {
+                LOG( psock->getLogLevel() ) << "recv(): bad compressed message from "
+                                            << remote() << endl;
+                m.reset();
+                return false;
+            }
             return true;
 
         }
@@ -269,6 +277,14 @@ again:
             }
         }
 
+        if ( _compressMessages ) {
+            Message compressed;
+            if ( compressMessage( toSend, &compressed ) ) {
+                compressed.send( *this, "say" );
+                return;
+            }
+        }
+
         toSend.send( *this, "say" );
     }
 
@@ -119,9 +119,17 @@ namespace mongo {
             return psock->getSockCreationMicroSec();
         }
 
+        /**
+         * compress outgoing messages, once the peer has agreed to it (see
+         * message_compression.h).  compressed incoming messages are always accepted.
+         */
+        void setCompressMessages( bool on ) { _compressMessages = on; }
+        bool compressMessages() const { return _compressMessages; }
+
     private:
         
         PiggyBackData * piggyBackData;
+        bool _compressMessages;
         
         // this is the parsed version of remote
         // mutable because its initialized only on call to remote()
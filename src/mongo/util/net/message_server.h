@@ -47,6 +47,27 @@ namespace mongo {
          * called once when a socket is disconnected
          */
         virtual void disconnected( AbstractMessagingPort* p ) = 0;
+
+        /**
+         * @return true if the handler can have a connection's requests serviced by threads
+         *     other than the one that called connected(), using detach() and attach() to
+         *     move its per-connection thread local state.  the epoll listener only
+         *     multiplexes connections for handlers that return true.
+         */
+        virtual bool supportsDetach() const { return false; }
+
+        /**
+         * called after connected() or process() when the connection goes idle.
+         * moves the connection's thread local state off the calling thread.
+         * @return opaque state, handed back to attach()
+         */
+        virtual void* detach( AbstractMessagingPort* p ) { return 0; }
+
+        /**
+         * called before process() or disconnected() on the thread that will service the
+         * connection next.  takes ownership of state.
+         */
+        virtual void attach( AbstractMessagingPort* p , void* state ) {}
     };
 
     class MessageServer {
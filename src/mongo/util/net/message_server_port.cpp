@@ -28,16 +28,301 @@
 
 #include "../../db/cmdline.h"
 #include "../../db/lasterror.h"
+#include "../../db/server_parameters.h"
 #include "../../db/stats/counters.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/concurrency/threadlocal.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/net/ssl_manager.h"
 
 #ifdef __linux__  // TODO: consider making this ifndef _WIN32
+# include <sys/epoll.h>
 # include <sys/resource.h>
 #endif
 
 namespace mongo {
 
+    // number of epoll threads watching idle connections; 0 means one thread per connection
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(netReactorThreads, int, 0);
+    // number of threads servicing requests from connections the reactor found readable
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(netReactorWorkerThreads, int, 16);
+    // most threads servicing a request each while every worker is busy; beyond it requests queue
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(netReactorMaxOverflowThreads, int, 256);
+
+#ifdef __linux__
+    /**
+     * Starts a detached thread running func( arg ) with the stack size of a connection thread.
+     * @return 0, or the error pthread_create failed with
+     */
+    static int startConnectionThread( void* (*func)( void* ) , void* arg ) {
+        pthread_attr_t attrs;
+        pthread_attr_init(&attrs);
+        pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_DETACHED);
+
+        static const size_t STACK_SIZE = 1024*1024; // if we change this we need to update the warning
+
+        struct rlimit limits;
+        verify(getrlimit(RLIMIT_STACK, &limits) == 0);
+        if (limits.rlim_cur > STACK_SIZE) {
+            pthread_attr_setstacksize(&attrs, (DEBUG_BUILD
+                                                ? (STACK_SIZE / 2)
+                                                : STACK_SIZE));
+        } else if (limits.rlim_cur < 1024*1024) {
+            warning() << "Stack size set to " << (limits.rlim_cur/1024) << "KB. We suggest 1MB" << endl;
+        }
+
+        pthread_t thread;
+        int failed = pthread_create(&thread, &attrs, func, arg);
+
+        pthread_attr_destroy(&attrs);
+        return failed;
+    }
+
+    /**
+     * Multiplexes idle connections over a few epoll threads instead of parking a thread on
+     * each one.  When a connection becomes readable it is handed to a fixed size worker pool,
+     * which reads and processes one request and then re-arms the connection.
+     * Connections are registered EPOLLONESHOT so at most one worker services a connection at
+     * a time, which keeps the per connection request ordering of the threaded server.
+     *
+     * A request may hold its worker for a long time: getLastError waiting on w, j or fsync,
+     * an awaitData getMore, an exhaust cursor, or a message whose bytes arrive slowly.  The
+     * request that would release it (a secondary's oplog getMore, say) must not queue behind
+     * it, so when every worker is taken a readable connection gets a thread of its own for
+     * that one request.  Those overflow threads are capped by netReactorMaxOverflowThreads;
+     * past the cap requests wait in the worker pool's queue.
+     */
+    class PortReactor : boost::noncopyable {
+    public:
+        PortReactor( MessageHandler* handler , int nReactors , int nWorkers )
+            : _handler( handler ), _nWorkers( nWorkers ),
+              _maxOverflow( max( 0 , netReactorMaxOverflowThreads ) ), _workers( nWorkers ) {
+            verify( handler->supportsDetach() );
+            for ( int i = 0; i < nReactors; i++ ) {
+                int epfd = epoll_create( 1024 );
+                massert( 16740 , str::stream() << "epoll_create failed: " << errnoWithDescription() ,
+                         epfd >= 0 );
+                _epfds.push_back( epfd );
+                boost::thread thr( boost::bind( &PortReactor::reactorThread , this , i ) );
+            }
+        }
+
+        /**
+         * takes ownership of p.  the caller has already acquired a connection ticket for it.
+         */
+        void add( MessagingPort* p ) {
+            Connection* c = new Connection( p , _epfds[ _next++ % _epfds.size() ] );
+            dispatch( &PortReactor::connect , c );
+        }
+
+    private:
+        struct Connection;
+        typedef void (PortReactor::*Task)( Connection* );
+
+        struct Connection {
+            Connection( MessagingPort* p , int fd ) : port( p ), le( new LastError() ),
+                                                      state( 0 ), epfd( fd ) {
+            }
+            MessagingPort* port;
+            LastError* le;
+            void* state; // handler's detached per connection state
+            int epfd;
+        };
+
+        void reactorThread( int n ) {
+            string threadName = str::stream() << "netReactor" << n;
+            setThreadName( threadName.c_str() );
+            const int maxEvents = 128;
+            struct epoll_event events[maxEvents];
+            while ( ! inShutdown() ) {
+                int ready = epoll_wait( _epfds[n] , events , maxEvents , 1000 );
+                if ( ready < 0 ) {
+                    if ( errno != EINTR )
+                        error() << "epoll_wait failed: " << errnoWithDescription() << endl;
+                    continue;
+                }
+                for ( int i = 0; i < ready; i++ ) {
+                    Connection* c = static_cast<Connection*>( events[i].data.ptr );
+                    dispatch( &PortReactor::service , c );
+                }
+            }
+        }
+
+        /**
+         * runs task for c on a pool worker, or on a thread of its own if every worker is
+         * taken.  _busyWorkers counts tasks given to the pool, so none waits in its queue
+         * unless the overflow threads are at their cap too.
+         */
+        void dispatch( Task task , Connection* c ) {
+            if ( _busyWorkers++ < _nWorkers ) {
+                _workers.schedule( &PortReactor::runOnWorker , this , task , c );
+                return;
+            }
+            _busyWorkers--;
+
+            if ( _overflowThreads++ >= _maxOverflow ) {
+                _overflowThreads--;
+                LOG(1) << "all " << _nWorkers << " net reactor workers and " << _maxOverflow
+                       << " overflow threads busy, queueing the request for a worker" << endl;
+                _busyWorkers++;
+                _workers.schedule( &PortReactor::runOnWorker , this , task , c );
+                return;
+            }
+            LOG(1) << "all " << _nWorkers << " net reactor workers busy, "
+                   << "servicing a request on its own thread" << endl;
+            OverflowParam* param = new OverflowParam( this , task , c );
+            int failed = startConnectionThread( &PortReactor::runOnOwnThread , param );
+            if ( failed ) {
+                delete param;
+                _overflowThreads--;
+                log() << "pthread_create failed: " << errnoWithDescription( failed )
+                      << ", queueing the request for a net reactor worker" << endl;
+                _busyWorkers++;
+                _workers.schedule( &PortReactor::runOnWorker , this , task , c );
+            }
+        }
+
+        void runOnWorker( Task task , Connection* c ) {
+            _holdsWorker.set( true );
+            (this->*task)( c );
+            releaseWorker();
+        }
+
+        /**
+         * a task gives its worker back as soon as its connection is done with, before
+         * re-arming it, so the connection's next request doesn't find every worker busy
+         */
+        void releaseWorker() {
+            if ( _holdsWorker.get() ) {
+                _holdsWorker.set( false );
+                _busyWorkers--;
+            }
+        }
+
+        struct OverflowParam {
+            OverflowParam( PortReactor* r , Task t , Connection* conn )
+                : reactor( r ), task( t ), c( conn ) {
+            }
+            PortReactor* reactor;
+            Task task;
+            Connection* c;
+        };
+
+        static void* runOnOwnThread( void* arg ) {
+            scoped_ptr<OverflowParam> param( static_cast<OverflowParam*>( arg ) );
+            setThreadName( "netReactorOverflow" );
+            ( param->reactor->*param->task )( param->c );
+            param->reactor->_overflowThreads--;
+            return NULL;
+        }
+
+        void connect( Connection* c ) {
+            lastError.reset( c->le );
+            MessagingPort* p = c->port;
+            try {
+                p->psock->setLogLevel(1);
+                _handler->connected( p );
+            }
+            catch ( const DBException& e ) {
+                log() << "DBException setting up connection, closing client connection: " << e << endl;
+                close( c );
+                return;
+            }
+            idle( c , EPOLL_CTL_ADD );
+        }
+
+        void service( Connection* c ) {
+            lastError.reset( c->le );
+            MessagingPort* p = c->port;
+            _handler->attach( p , c->state );
+            c->state = 0;
+
+            Message m;
+            try {
+                p->psock->clearCounters();
+                if ( ! p->recv( m ) ) {
+                    if( !cmdLine.quiet ){
+                        int conns = Listener::globalTicketHolder.used()-1;
+                        const char* word = (conns == 1 ? " connection" : " connections");
+                        log() << "end connection " << p->psock->remoteString()
+                              << " (" << conns << word << " now open)" << endl;
+                    }
+                    close( c );
+                    return;
+                }
+
+                _handler->process( m , p , c->le );
+                networkCounter.hit( p->psock->getBytesIn() , p->psock->getBytesOut() );
+            }
+            catch ( AssertionException& e ) {
+                log() << "AssertionException handling request, closing client connection: " << e << endl;
+                close( c );
+                return;
+            }
+            catch ( SocketException& e ) {
+                log() << "SocketException handling request, closing client connection: " << e << endl;
+                close( c );
+                return;
+            }
+            catch ( const DBException& e ) { // must be right above std::exception to avoid catching subclasses
+                log() << "DBException handling request, closing client connection: " << e << endl;
+                close( c );
+                return;
+            }
+            catch ( std::exception &e ) {
+                error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
+                dbexit( EXIT_UNCAUGHT );
+            }
+            catch ( ... ) {
+                error() << "Uncaught exception, terminating" << endl;
+                dbexit( EXIT_UNCAUGHT );
+            }
+
+            idle( c , EPOLL_CTL_MOD );
+        }
+
+        /** detaches c from the calling worker and (re)arms it with its reactor */
+        void idle( Connection* c , int op ) {
+            c->state = _handler->detach( c->port );
+            lastError.release();
+            releaseWorker();
+
+            struct epoll_event ev;
+            memset( &ev , 0 , sizeof(ev) );
+            ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+            ev.data.ptr = c;
+            if ( epoll_ctl( c->epfd , op , c->port->psock->rawFD() , &ev ) != 0 ) {
+                log() << "epoll_ctl failed, closing client connection: " << errnoWithDescription() << endl;
+                _handler->attach( c->port , c->state );
+                c->state = 0;
+                lastError.reset( c->le );
+                close( c );
+            }
+        }
+
+        /** must be called with c's state attached to the calling thread */
+        void close( Connection* c ) {
+            // closing the fd removes it from the epoll set
+            c->port->shutdown();
+            _handler->disconnected( c->port );
+            lastError.reset( 0 );
+            delete c->port;
+            delete c;
+            Listener::globalTicketHolder.release();
+        }
+
+        MessageHandler* _handler;
+        vector<int> _epfds;
+        AtomicUInt _next;
+        const unsigned _nWorkers;
+        AtomicUInt _busyWorkers;
+        const unsigned _maxOverflow;
+        AtomicUInt _overflowThreads; // overflow threads started and not yet finished
+        ThreadLocalValue<bool> _holdsWorker; // the calling thread is a worker counted busy
+        threadpool::ThreadPool _workers;
+    };
+#endif
+
     class PortMessageServer : public MessageServer , public Listener {
     public:
         /**
@@ -49,6 +334,25 @@ namespace mongo {
          */
         PortMessageServer(  const MessageServer::Options& opts, MessageHandler * handler ) :
             Listener( "" , opts.ipList, opts.port ), _handler(handler) {
+#ifdef __linux__
+            if ( netReactorThreads > 0 ) {
+                bool useSSL = false;
+#ifdef MONGO_SSL
+                // SSL buffers decrypted bytes the poller can't see
+                useSSL = cmdLine.sslOnNormalPorts;
+#endif
+                if ( ! handler->supportsDetach() || useSSL ) {
+                    warning() << "netReactorThreads is not supported by this server configuration, "
+                              << "using one thread per connection" << endl;
+                }
+                else {
+                    log() << "servicing connections with " << netReactorThreads
+                          << " reactor and " << netReactorWorkerThreads << " worker threads" << endl;
+                    _reactor.reset( new PortReactor( handler , netReactorThreads ,
+                                                     max( 1 , netReactorWorkerThreads ) ) );
+                }
+            }
+#endif
         }
 
         virtual void acceptedMP(MessagingPort * p) {
@@ -64,6 +368,13 @@ namespace mongo {
                 return;
             }
 
+#ifdef __linux__
+            if ( _reactor ) {
+                _reactor->add( p );
+                return;
+            }
+#endif
+
             try {
 #ifndef __linux__  // TODO: consider making this ifdef _WIN32
                 {
@@ -71,28 +382,8 @@ namespace mongo {
                     boost::thread thr(boost::bind(&handleIncomingMsg, himParam));
                 }
 #else
-                pthread_attr_t attrs;
-                pthread_attr_init(&attrs);
-                pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_DETACHED);
-
-                static const size_t STACK_SIZE = 1024*1024; // if we change this we need to update the warning
-
-                struct rlimit limits;
-                verify(getrlimit(RLIMIT_STACK, &limits) == 0);
-                if (limits.rlim_cur > STACK_SIZE) {
-                    pthread_attr_setstacksize(&attrs, (DEBUG_BUILD
-                                                        ? (STACK_SIZE / 2)
-                                                        : STACK_SIZE));
-                } else if (limits.rlim_cur < 1024*1024) {
-                    warning() << "Stack size set to " << (limits.rlim_cur/1024) << "KB. We suggest 1MB" << endl;
-                }
-
-
-                pthread_t thread;
                 HandleIncomingMsgParam* himParam = new HandleIncomingMsgParam(p, _handler);
-                int failed = pthread_create(&thread, &attrs, &handleIncomingMsg, himParam);
-
-                pthread_attr_destroy(&attrs);
+                int failed = startConnectionThread(&handleIncomingMsg, himParam);
 
                 if (failed) {
                     log() << "pthread_create failed: " << errnoWithDescription(failed) << endl;
@@ -133,6 +424,9 @@ namespace mongo {
 
     private:
         MessageHandler* _handler;
+#ifdef __linux__
+        scoped_ptr<PortReactor> _reactor;
+#endif
 
         /**
          * Simple holder for threadRun parameters. Should not destroy the objects it holds -
@@ -211,6 +211,9 @@ namespace mongo {
         
         void setTimeout( double secs );
 
+        /** for registering with a poller; don't read or write it directly */
+        int rawFD() const { return _fd; }
+
 #ifdef MONGO_SSL
         /** secures inline */
         void secure( SSLManager * ssl );
@@ -0,0 +1,336 @@
+// persistent_map.h
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace mongo {
+
+    /**
+     * An ordered map whose copies share structure.
+     *
+     * The map is a balanced (AVL) tree of immutable nodes.  Copying a map copies only the pointer
+     * to its root, and a change to one copy rebuilds just the path from the root to the changed
+     * node, so the copies go on sharing every other node.  A copy of a map of n entries which
+     * then has k entries inserted or erased costs O(k log n) time and memory, where a std::map
+     * would cost O(n).
+     *
+     * The interface is the part of std::map used on read-mostly maps: iteration and lookups,
+     * insert() and erase().  The values can't be modified in place, as they may be shared, so
+     * there is no operator[]; erase and insert instead.  Like std::map, a change invalidates the
+     * iterators of the map changed, but not those of its copies.
+     *
+     * Copies may be read from different threads, but a copy must not be changed while it is read.
+     */
+    template< typename K, typename V, typename Cmp = std::less<K> >
+    class PersistentMap {
+    public:
+        typedef K key_type;
+        typedef V mapped_type;
+        typedef std::pair<const K, V> value_type;
+        typedef Cmp key_compare;
+
+    private:
+        struct Node;
+        typedef boost::shared_ptr<const Node> NodePtr;
+
+        struct Node {
+            Node( const value_type& v, const NodePtr& l, const NodePtr& r )
+                : value( v ), left( l ), right( r ),
+                  height( 1 + std::max( heightOf( l ), heightOf( r ) ) ) {}
+
+            const value_type value;
+            const NodePtr left;
+            const NodePtr right;
+            const int height;
+        };
+
+        static int heightOf( const NodePtr& n ) { return n ? n->height : 0; }
+
+        // An AVL tree of n nodes is less than 1.45 * log2(n + 2) high, so this covers any size
+        // which fits in memory.
+        static const int kMaxHeight = 64;
+
+    public:
+
+        /**
+         * Iterates in key order.  It keeps the path from the root to its node, so it needs no
+         * parent pointers in the (shared) nodes.
+         */
+        class const_iterator : public std::iterator< std::bidirectional_iterator_tag,
+                                                     const value_type > {
+        public:
+            const_iterator() : _root( NULL ), _depth( 0 ) {}
+
+            const value_type& operator*() const { return _path[_depth - 1]->value; }
+            const value_type* operator->() const { return &_path[_depth - 1]->value; }
+
+            const_iterator& operator++() {
+                const Node* n = _path[_depth - 1];
+                if ( n->right ) {
+                    _pushLeftmost( n->right.get() );
+                    return *this;
+                }
+                // climb until we come up from a left child
+                while ( --_depth > 0 && _path[_depth - 1]->right.get() == n )
+                    n = _path[_depth - 1];
+                return *this;
+            }
+
+            const_iterator& operator--() {
+                if ( _depth == 0 ) {
+                    // from end() to the last entry
+                    _pushRightmost( _root );
+                    return *this;
+                }
+                const Node* n = _path[_depth - 1];
+                if ( n->left ) {
+                    _pushRightmost( n->left.get() );
+                    return *this;
+                }
+                // climb until we come up from a right child
+                while ( --_depth > 0 && _path[_depth - 1]->left.get() == n )
+                    n = _path[_depth - 1];
+                return *this;
+            }
+
+            const_iterator operator++( int ) { const_iterator i = *this; ++*this; return i; }
+            const_iterator operator--( int ) { const_iterator i = *this; --*this; return i; }
+
+            bool operator==( const const_iterator& other ) const { return _node() == other._node(); }
+            bool operator!=( const const_iterator& other ) const { return _node() != other._node(); }
+
+        private:
+            friend class PersistentMap;
+
+            explicit const_iterator( const Node* root ) : _root( root ), _depth( 0 ) {}
+
+            const Node* _node() const { return _depth ? _path[_depth - 1] : NULL; }
+
+            void _push( const Node* n ) { _path[_depth++] = n; }
+
+            void _pushLeftmost( const Node* n ) {
+                for ( ; n; n = n->left.get() )
+                    _push( n );
+            }
+
+            void _pushRightmost( const Node* n ) {
+                for ( ; n; n = n->right.get() )
+                    _push( n );
+            }
+
+            const Node* _root;
+            const Node* _path[kMaxHeight];
+            int _depth;
+        };
+
+        typedef const_iterator iterator;
+
+        explicit PersistentMap( const Cmp& cmp = Cmp() ) : _size( 0 ), _cmp( cmp ) {}
+
+        const_iterator begin() const {
+            const_iterator it( _root.get() );
+            it._pushLeftmost( _root.get() );
+            return it;
+        }
+
+        const_iterator end() const { return const_iterator( _root.get() ); }
+
+        bool empty() const { return _size == 0; }
+        size_t size() const { return _size; }
+
+        const_iterator find( const K& k ) const {
+            const_iterator it = lower_bound( k );
+            if ( it != end() && _cmp( k, it->first ) )
+                return end();
+            return it;
+        }
+
+        /** @return the first entry whose key is not less than k */
+        const_iterator lower_bound( const K& k ) const {
+            const_iterator it( _root.get() );
+            int found = 0;
+            for ( const Node* n = _root.get(); n; ) {
+                it._push( n );
+                if ( _cmp( n->value.first, k ) ) {
+                    n = n->right.get();
+                }
+                else {
+                    found = it._depth;
+                    n = n->left.get();
+                }
+            }
+            it._depth = found;
+            return it;
+        }
+
+        /** @return the first entry whose key is greater than k */
+        const_iterator upper_bound( const K& k ) const {
+            const_iterator it( _root.get() );
+            int found = 0;
+            for ( const Node* n = _root.get(); n; ) {
+                it._push( n );
+                if ( _cmp( k, n->value.first ) ) {
+                    found = it._depth;
+                    n = n->left.get();
+                }
+                else {
+                    n = n->right.get();
+                }
+            }
+            it._depth = found;
+            return it;
+        }
+
+        /**
+         * Inserts v unless its key is already in the map.
+         * @return whether v was inserted
+         */
+        bool insert( const value_type& v ) {
+            bool inserted = false;
+            _root = _insert( _root, v, &inserted );
+            if ( inserted )
+                _size++;
+            return inserted;
+        }
+
+        /** @return the number of entries erased, 0 or 1 */
+        size_t erase( const K& k ) {
+            bool erased = false;
+            _root = _erase( _root, k, &erased );
+            if ( ! erased )
+                return 0;
+            _size--;
+            return 1;
+        }
+
+        /** Erases the entries in [first, last), in O(m log n) for m entries. */
+        void erase( const_iterator first, const_iterator last ) {
+            std::vector<K> keys;
+            for ( ; first != last; ++first )
+                keys.push_back( first->first );
+            for ( size_t i = 0; i < keys.size(); i++ )
+                erase( keys[i] );
+        }
+
+        void clear() {
+            _root.reset();
+            _size = 0;
+        }
+
+        void swap( PersistentMap& other ) {
+            _root.swap( other._root );
+            std::swap( _size, other._size );
+            std::swap( _cmp, other._cmp );
+        }
+
+    private:
+        static NodePtr _make( const value_type& v, const NodePtr& l, const NodePtr& r ) {
+            return boost::make_shared<Node>( v, l, r );
+        }
+
+        // Makes a node of v, l and r, rotating if the heights of l and r differ by two.
+        static NodePtr _balance( const value_type& v, const NodePtr& l, const NodePtr& r ) {
+            const int hl = heightOf( l );
+            const int hr = heightOf( r );
+
+            if ( hl > hr + 1 ) {
+                if ( heightOf( l->left ) >= heightOf( l->right ) )
+                    return _make( l->value, l->left, _make( v, l->right, r ) );
+                const NodePtr& lr = l->right;
+                return _make( lr->value,
+                              _make( l->value, l->left, lr->left ),
+                              _make( v, lr->right, r ) );
+            }
+
+            if ( hr > hl + 1 ) {
+                if ( heightOf( r->right ) >= heightOf( r->left ) )
+                    return _make( r->value, _make( v, l, r->left ), r->right );
+                const NodePtr& rl = r->left;
+                return _make( rl->value,
+                              _make( v, l, rl->left ),
+                              _make( r->value, rl->right, r->right ) );
+            }
+
+            return _make( v, l, r );
+        }
+
+        NodePtr _insert( const NodePtr& n, const value_type& v, bool* inserted ) const {
+            if ( ! n ) {
+                *inserted = true;
+                return _make( v, NodePtr(), NodePtr() );
+            }
+
+            if ( _cmp( v.first, n->value.first ) ) {
+                NodePtr l = _insert( n->left, v, inserted );
+                return *inserted ? _balance( n->value, l, n->right ) : n;
+            }
+            if ( _cmp( n->value.first, v.first ) ) {
+                NodePtr r = _insert( n->right, v, inserted );
+                return *inserted ? _balance( n->value, n->left, r ) : n;
+            }
+            return n;
+        }
+
+        NodePtr _erase( const NodePtr& n, const K& k, bool* erased ) const {
+            if ( ! n )
+                return n;
+
+            if ( _cmp( k, n->value.first ) ) {
+                NodePtr l = _erase( n->left, k, erased );
+                return *erased ? _balance( n->value, l, n->right ) : n;
+            }
+            if ( _cmp( n->value.first, k ) ) {
+                NodePtr r = _erase( n->right, k, erased );
+                return *erased ? _balance( n->value, n->left, r ) : n;
+            }
+
+            *erased = true;
+            if ( ! n->left )
+                return n->right;
+            if ( ! n->right )
+                return n->left;
+
+            // replace n by the first entry of its right subtree
+            const Node* next = NULL;
+            NodePtr r = _eraseFirst( n->right, &next );
+            return _balance( next->value, n->left, r );
+        }
+
+        // Erases the first entry under n, and sets *first to its node, which n keeps alive.
+        static NodePtr _eraseFirst( const NodePtr& n, const Node** first ) {
+            if ( ! n->left ) {
+                *first = n.get();
+                return n->right;
+            }
+            NodePtr l = _eraseFirst( n->left, first );
+            return _balance( n->value, l, n->right );
+        }
+
+        NodePtr _root;
+        size_t _size;
+        Cmp _cmp;
+    };
+
+}
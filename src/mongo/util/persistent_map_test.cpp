@@ -0,0 +1,187 @@
+// persistent_map_test.cpp
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/unittest/unittest.h"
+
+#include <map>
+
+#include "mongo/platform/random.h"
+#include "mongo/util/persistent_map.h"
+
+namespace {
+    using namespace mongo;
+
+    typedef PersistentMap<int,int> IntMap;
+    typedef std::map<int,int> StdMap;
+
+    int nextInt( PseudoRandom& random, int max ) { return ( random.nextInt32() & 0x7fffffff ) % max; }
+
+    // checks that m holds exactly what expected holds, walking both ways
+    void assertSame( const StdMap& expected, const IntMap& m ) {
+        ASSERT_EQUALS( expected.size(), m.size() );
+        ASSERT_EQUALS( expected.empty(), m.empty() );
+
+        IntMap::const_iterator it = m.begin();
+        for ( StdMap::const_iterator e = expected.begin(); e != expected.end(); ++e, ++it ) {
+            ASSERT( it != m.end() );
+            ASSERT_EQUALS( e->first, it->first );
+            ASSERT_EQUALS( e->second, it->second );
+        }
+        ASSERT( it == m.end() );
+
+        for ( StdMap::const_reverse_iterator e = expected.rbegin(); e != expected.rend(); ++e ) {
+            --it;
+            ASSERT_EQUALS( e->first, it->first );
+        }
+        ASSERT( it == m.begin() );
+    }
+
+    TEST( PersistentMapTest, Empty ) {
+        IntMap m;
+        ASSERT( m.empty() );
+        ASSERT( m.begin() == m.end() );
+        ASSERT( m.find( 1 ) == m.end() );
+        ASSERT( m.lower_bound( 1 ) == m.end() );
+        ASSERT_EQUALS( 0U, m.erase( 1 ) );
+    }
+
+    TEST( PersistentMapTest, Basic ) {
+        IntMap m;
+        ASSERT( m.insert( std::make_pair( 20, 2 ) ) );
+        ASSERT( m.insert( std::make_pair( 10, 1 ) ) );
+        ASSERT( m.insert( std::make_pair( 30, 3 ) ) );
+        ASSERT( ! m.insert( std::make_pair( 20, 5 ) ) ); // already there
+        ASSERT_EQUALS( 3U, m.size() );
+
+        ASSERT_EQUALS( 2, m.find( 20 )->second );
+        ASSERT( m.find( 25 ) == m.end() );
+        ASSERT_EQUALS( 20, m.lower_bound( 20 )->first );
+        ASSERT_EQUALS( 30, m.upper_bound( 20 )->first );
+        ASSERT_EQUALS( 10, m.lower_bound( 5 )->first );
+        ASSERT( m.upper_bound( 30 ) == m.end() );
+
+        ASSERT_EQUALS( 1U, m.erase( 20 ) );
+        ASSERT_EQUALS( 0U, m.erase( 20 ) );
+        ASSERT_EQUALS( 30, m.upper_bound( 10 )->first );
+
+        m.erase( m.begin(), m.end() );
+        ASSERT( m.empty() );
+    }
+
+    TEST( PersistentMapTest, MatchesStdMap ) {
+        PseudoRandom random( 42 );
+        StdMap expected;
+        IntMap m;
+
+        for ( int i = 0; i < 20000; i++ ) {
+            int k = nextInt( random, 1000 );
+            if ( nextInt( random, 3 ) ) {
+                bool inserted = expected.insert( std::make_pair( k, i ) ).second;
+                ASSERT_EQUALS( inserted, m.insert( std::make_pair( k, i ) ) );
+            }
+            else {
+                ASSERT_EQUALS( expected.erase( k ), m.erase( k ) );
+            }
+
+            int probe = nextInt( random, 1100 ) - 50;
+            StdMap::const_iterator lb = expected.lower_bound( probe );
+            StdMap::const_iterator ub = expected.upper_bound( probe );
+            ASSERT_EQUALS( lb == expected.end(), m.lower_bound( probe ) == m.end() );
+            ASSERT_EQUALS( ub == expected.end(), m.upper_bound( probe ) == m.end() );
+            if ( lb != expected.end() )
+                ASSERT_EQUALS( lb->first, m.lower_bound( probe )->first );
+            if ( ub != expected.end() )
+                ASSERT_EQUALS( ub->first, m.upper_bound( probe )->first );
+
+            if ( i % 1000 == 0 )
+                assertSame( expected, m );
+        }
+        assertSame( expected, m );
+
+        // erase a range from the middle
+        IntMap::const_iterator first = m.lower_bound( 300 );
+        IntMap::const_iterator last = m.lower_bound( 700 );
+        m.erase( first, last );
+        expected.erase( expected.lower_bound( 300 ), expected.lower_bound( 700 ) );
+        assertSame( expected, m );
+    }
+
+    TEST( PersistentMapTest, CopiesAreIndependent ) {
+        StdMap expected;
+        IntMap m;
+        for ( int i = 0; i < 1000; i++ ) {
+            expected.insert( std::make_pair( i, i ) );
+            m.insert( std::make_pair( i, i ) );
+        }
+
+        IntMap copy = m;
+        IntMap::const_iterator it = m.find( 500 );
+
+        for ( int i = 0; i < 1000; i += 2 )
+            copy.erase( i );
+        copy.insert( std::make_pair( 5000, 0 ) );
+
+        // the original, and iterators into it, are untouched
+        assertSame( expected, m );
+        ASSERT_EQUALS( 500, it->first );
+        ASSERT_EQUALS( 501, (++it)->first );
+
+        ASSERT_EQUALS( 501U, copy.size() );
+        ASSERT( copy.find( 500 ) == copy.end() );
+        ASSERT( copy.find( 5000 ) != copy.end() );
+
+        m.clear();
+        ASSERT_EQUALS( 501U, copy.size() );
+        ASSERT_EQUALS( 1, copy.begin()->first );
+    }
+
+    TEST( PersistentMapTest, StaysBalanced ) {
+        // ascending inserts are the worst case for an unbalanced tree
+        IntMap m;
+        for ( int i = 0; i < 1 << 20; i++ )
+            m.insert( std::make_pair( i, i ) );
+        ASSERT_EQUALS( 1U << 20, m.size() );
+        ASSERT_EQUALS( 12345, m.find( 12345 )->second );
+        ASSERT_EQUALS( ( 1 << 20 ) - 1, ( --m.end() )->first );
+    }
+
+    // A copy of a large map followed by a few changes, as when a ChunkManager is reloaded after a
+    // few splits, still shares the nodes of nearly every entry with the original.
+    TEST( PersistentMapTest, CopySharesUnchangedEntries ) {
+        const int numEntries = 20000;
+        IntMap persistent;
+        for ( int i = 0; i < numEntries; i++ ) {
+            persistent.insert( std::make_pair( i, i ) );
+        }
+
+        PseudoRandom random( 7 );
+        IntMap copy = persistent;
+        for ( int i = 0; i < 100; i++ ) {
+            int k = nextInt( random, numEntries );
+            copy.erase( k );
+            copy.insert( std::make_pair( k, -1 ) );
+        }
+        ASSERT_EQUALS( persistent.size(), copy.size() );
+        int shared = 0;
+        for ( IntMap::const_iterator a = persistent.begin(), b = copy.begin();
+              a != persistent.end(); ++a, ++b ) {
+            if ( &*a == &*b )
+                shared++;
+        }
+        ASSERT_GREATER_THAN( shared, numEntries * 9 / 10 );
+    }
+}
@@ -69,6 +69,26 @@ namespace mongo {
             _cvNoLongerEmpty.notify_one();
         }
 
+        /**
+         * Pushes the items of [begin, end) in order, taking the lock once.  Waits until they all
+         * fit, or until the queue is empty so that a run larger than the queue still goes in.
+         */
+        template<typename Iter>
+        void pushAll(Iter begin, Iter end) {
+            size_t total = 0;
+            for (Iter i = begin; i != end; ++i)
+                total += _getSize(*i);
+
+            scoped_lock l( _lock );
+            while (_currentSize > 0 && _currentSize + total >= _maxSize) {
+                _cvNoLongerFull.wait( l.boost() );
+            }
+            for (Iter i = begin; i != end; ++i)
+                _queue.push( *i );
+            _currentSize += total;
+            _cvNoLongerEmpty.notify_all();
+        }
+
         bool empty() const {
             scoped_lock l( _lock );
             return _queue.empty();